@@ -0,0 +1,465 @@
+/******************************************************************************************************/
+// Sensor Archive
+/******************************************************************************************************/
+#include "src/Archive.h"
+#include "src/History.h"
+#include "src/Config.h"
+#include "src/Sensi.h"
+#include "src/Print.h"
+
+// External Variables
+extern Settings      mySettings;       // Config
+extern unsigned long yieldTime;        // Sensi
+extern char          tmpStr[256];      // Sensi
+extern bool          fsOK;             // Sensi
+extern bool          timeSynced;       // NTP
+extern const char    historyNames[HISTORY_CHANNELS][HISTORY_NAMELENGTH] PROGMEM; // History
+extern HistorySource historySources[HISTORY_CHANNELS];
+
+// Values are stored as float in units of the last decimal shown for the channel, e.g. 2345 for 23.45C.
+// Whole numbers leave the low mantissa bits zero, so the XOR of consecutive values is short.
+// Changing the decimals of a channel in historySources needs a new ARCHIVE_MAGIC.
+const float archiveScales[] = {1.0, 10.0, 100.0, 1000.0};
+
+uint8_t       archiveBuffer[ARCHIVE_BLOCKSIZE];                        // records not yet written
+ArchiveCodec  archiveEncoder = { archiveBuffer, 0, 0, 0, 0, 0, 0, {}, {}, {} }; // writes archiveBuffer
+unsigned long archiveBytes = 0;                                        // [bytes] in segments
+
+// Export, one at a time
+uint8_t       archiveReadBuffer[ARCHIVE_BLOCKSIZE];                    // block being exported
+ArchiveCodec  archiveDecoder = { archiveReadBuffer, 0, 0, 0, 0, 0, 0, {}, {}, {} }; // reads archiveReadBuffer
+File          archiveIndexFile;                                        // segment being exported
+File          archiveDataFile;                                         //
+uint32_t      archiveFrom;                                             // [s] epoch, first record exported
+uint32_t      archiveTo;                                               // [s] epoch, last record exported
+uint32_t      archiveDay;                                              // segment being exported, days since epoch
+uint32_t      archiveColumns;                                          // channels of export
+uint8_t       archiveFormat;                                           // ArchiveFormats
+int8_t        archiveField;                                            // next channel of line, -1 at start of line
+bool          archiveInHeader;                                         // CSV header line is being exported
+bool          archiveExportRAM;                                        // records in RAM are exported last
+
+/******************************************************************************************************/
+// Initialize
+/******************************************************************************************************/
+
+void initializeArchive() {
+  if (!fsOK) { return; }
+  LittleFS.mkdir(ARCHIVE_DIR);
+  archiveBytes = 0;
+  uint16_t segments = 0;
+  Dir dir = LittleFS.openDir(ARCHIVE_DIR);
+  while (dir.next()) {
+    archiveBytes += dir.fileSize();
+    if (dir.fileName().endsWith(".dat")) { segments++; }
+  }
+  if (mySettings.debuglevel > 0) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Archive: %u days, %lu bytes"), segments, archiveBytes);
+    R_printSerialTelnetLogln(tmpStr);
+  }
+}
+
+/******************************************************************************************************/
+// Compression
+/******************************************************************************************************/
+
+void archivePutBits(ArchiveCodec *codec, uint32_t value, uint8_t n) {
+  for (int8_t i=n-1; i>=0; i--) {
+    uint8_t *byte = &codec->data[codec->bit >> 3];
+    uint8_t  mask = 0x80 >> (codec->bit & 7);
+    if ((value >> i) & 1) { *byte |= mask; } else { *byte &= ~mask; }
+    codec->bit++;
+  }
+}
+
+uint32_t archiveGetBits(ArchiveCodec *codec, uint8_t n) {
+  uint32_t value = 0;
+  for (uint8_t i=0; i<n; i++) {
+    if (codec->bit >= ARCHIVE_BLOCKSIZE*8) { return value; }  // corrupted block
+    value = (value << 1) | ((codec->data[codec->bit >> 3] >> (7 - (codec->bit & 7))) & 1);
+    codec->bit++;
+  }
+  return value;
+}
+
+// worst case bits of a record: 4+32 time, 2+5+5+32 each value
+uint16_t archiveRecordBits(uint32_t channels) {
+  uint16_t bits = 36;
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) { if (channels & (1UL << i)) { bits += 44; } }
+  return bits;
+}
+
+void archiveEncode(ArchiveCodec *codec, uint32_t time, const uint32_t *values) {
+  if (codec->bit == 0) {                                   // first record, time in header, values raw
+    codec->start = time;
+    codec->delta = ARCHIVE_INTERVAL;
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+      if ((codec->channels & (1UL << i)) == 0) { continue; }
+      archivePutBits(codec, values[i], 32);
+      codec->value[i]    = values[i];
+      codec->leading[i]  = 0xFF;                           // no window yet
+      codec->trailing[i] = 0;
+    }
+  } else {
+    int32_t delta = (int32_t)(time - codec->time);
+    int32_t dod   = delta - codec->delta;
+    if      (dod == 0)                      { archivePutBits(codec, 0b0, 1); }
+    else if ((dod >=   -63) && (dod <=   64)) { archivePutBits(codec, 0b10,   2); archivePutBits(codec, dod +   63,  7); }
+    else if ((dod >=  -255) && (dod <=  256)) { archivePutBits(codec, 0b110,  3); archivePutBits(codec, dod +  255,  9); }
+    else if ((dod >= -2047) && (dod <= 2048)) { archivePutBits(codec, 0b1110, 4); archivePutBits(codec, dod + 2047, 12); }
+    else                                      { archivePutBits(codec, 0b1111, 4); archivePutBits(codec, (uint32_t)dod, 32); }
+    codec->delta = delta;
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+      if ((codec->channels & (1UL << i)) == 0) { continue; }
+      uint32_t x = values[i] ^ codec->value[i];
+      if (x == 0) {
+        archivePutBits(codec, 0b0, 1);                     // same value
+      } else {
+        uint8_t leading  = __builtin_clz(x);
+        uint8_t trailing = __builtin_ctz(x);
+        if ( (codec->leading[i] != 0xFF) && (leading >= codec->leading[i]) && (trailing >= codec->trailing[i]) ) {
+          archivePutBits(codec, 0b10, 2);                  // fits window of previous value
+          archivePutBits(codec, x >> codec->trailing[i], 32 - codec->leading[i] - codec->trailing[i]);
+        } else {
+          uint8_t length = 32 - leading - trailing;
+          archivePutBits(codec, 0b11, 2);
+          archivePutBits(codec, leading, 5);
+          archivePutBits(codec, length - 1, 5);
+          archivePutBits(codec, x >> trailing, length);
+          codec->leading[i]  = leading;
+          codec->trailing[i] = trailing;
+        }
+      }
+      codec->value[i] = values[i];
+    }
+  }
+  codec->time = time;
+  codec->records++;
+}
+
+// decodes next record into codec->time and codec->value
+void archiveDecode(ArchiveCodec *codec) {
+  if (codec->bit == 0) {
+    codec->time  = codec->start;
+    codec->delta = ARCHIVE_INTERVAL;
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+      if ((codec->channels & (1UL << i)) == 0) { continue; }
+      codec->value[i]    = archiveGetBits(codec, 32);
+      codec->leading[i]  = 0xFF;
+      codec->trailing[i] = 0;
+    }
+  } else {
+    int32_t dod;
+    if      (archiveGetBits(codec, 1) == 0) { dod = 0; }
+    else if (archiveGetBits(codec, 1) == 0) { dod = (int32_t)archiveGetBits(codec,  7) -   63; }
+    else if (archiveGetBits(codec, 1) == 0) { dod = (int32_t)archiveGetBits(codec,  9) -  255; }
+    else if (archiveGetBits(codec, 1) == 0) { dod = (int32_t)archiveGetBits(codec, 12) - 2047; }
+    else                                    { dod = (int32_t)archiveGetBits(codec, 32); }
+    codec->delta += dod;
+    codec->time  += codec->delta;
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+      if ((codec->channels & (1UL << i)) == 0) { continue; }
+      if (archiveGetBits(codec, 1) == 0) { continue; }    // same value
+      if (archiveGetBits(codec, 1) == 0) {
+        if (codec->leading[i] == 0xFF) { continue; }       // corrupted block
+        codec->value[i] ^= archiveGetBits(codec, 32 - codec->leading[i] - codec->trailing[i]) << codec->trailing[i];
+      } else {
+        uint8_t leading  = archiveGetBits(codec, 5);
+        uint8_t length   = archiveGetBits(codec, 5) + 1;
+        uint8_t trailing = (leading + length <= 32) ? 32 - leading - length : 0;
+        codec->value[i] ^= archiveGetBits(codec, length) << trailing;
+        codec->leading[i]  = leading;
+        codec->trailing[i] = trailing;
+      }
+    }
+  }
+  if (codec->records > 0) { codec->records--; }
+}
+
+/******************************************************************************************************/
+// Update
+/******************************************************************************************************/
+
+// /archive/YYYYMMDD.dat
+void archiveSegmentName(uint32_t day, const char *extension, char *name, size_t len) {
+  time_t    t = (time_t)day * 86400;
+  struct tm date;
+  gmtime_r(&t, &date);
+  snprintf_P(name, len, PSTR("%s/%04d%02d%02d.%s"), ARCHIVE_DIR, date.tm_year+1900, date.tm_mon+1, date.tm_mday, extension);
+}
+
+void updateArchive() {
+  if (!fsOK || !timeSynced) { return; }
+  uint32_t now      = (uint32_t)time(NULL);
+  uint32_t channels = 0;
+  uint32_t values[HISTORY_CHANNELS];
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    uint16_t count = historyCount(i, 1);
+    if (count == 0) { continue; }
+    float min, mean, max;
+    channels |= 1UL << i;
+    if (historySample(i, 1, count-1, &min, &mean, &max)) {
+      float scaled = roundf(mean * archiveScales[historySources[i].decimals]);
+      memcpy(&values[i], &scaled, sizeof(values[i]));
+    } else {
+      values[i] = ARCHIVE_NODATA;
+    }
+  }
+  if (channels == 0) { return; }
+
+  // a block holds one day and one set of channels, time only moves forward within a block
+  if ( (archiveEncoder.bit > 0) &&
+       ( (channels != archiveEncoder.channels) ||
+         (now/86400 != archiveEncoder.start/86400) ||
+         (now <= archiveEncoder.time) ||
+         (archiveEncoder.bit + archiveRecordBits(channels) > ARCHIVE_BLOCKSIZE*8) ) ) {
+    flushArchive();
+  }
+  if (archiveEncoder.bit == 0) { archiveEncoder.channels = channels; }
+  archiveEncode(&archiveEncoder, now, values);
+
+  if ( (now - archiveEncoder.start >= ARCHIVE_FLUSHINTERVAL) ||
+       (archiveEncoder.bit + archiveRecordBits(channels) > ARCHIVE_BLOCKSIZE*8) ) {
+    flushArchive();
+  }
+}
+
+void flushArchive() {
+  if (archiveEncoder.bit == 0) { return; }
+  char name[32];
+  ArchiveBlockHeader header = { ARCHIVE_MAGIC, (uint16_t)((archiveEncoder.bit + 7) / 8), archiveEncoder.channels,
+                                archiveEncoder.start, archiveEncoder.records, 0 };
+  archiveEncoder.bit     = 0;
+  archiveEncoder.records = 0;
+  if (!fsOK) { return; }
+
+  // block first, an index entry only points to complete blocks
+  archiveSegmentName(header.start/86400, "dat", name, sizeof(name));
+  File dataFile = LittleFS.open(name, "a");
+  if (!dataFile) {
+    if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("Archive: could not open segment")); }
+    return;
+  }
+  ArchiveIndexEntry entry = { header.start, archiveEncoder.time, header.channels, (uint32_t)dataFile.size() };
+  bool ok = (dataFile.write((const uint8_t *)&header, sizeof(header)) == sizeof(header)) &&
+            (dataFile.write(archiveBuffer, header.length) == header.length);
+  dataFile.close();
+  archiveBytes += sizeof(header) + header.length;
+  if (ok) {
+    archiveSegmentName(header.start/86400, "idx", name, sizeof(name));
+    File indexFile = LittleFS.open(name, "a");
+    if (indexFile) {
+      indexFile.write((const uint8_t *)&entry, sizeof(entry));
+      indexFile.close();
+      archiveBytes += sizeof(entry);
+    }
+  }
+  if ((mySettings.debuglevel == 3) && ok) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Archive: %u records in %u bytes"), header.records, header.length);
+    R_printSerialTelnetLogln(tmpStr);
+  }
+  trimArchive(header.start/86400);
+}
+
+// remove oldest segments until the archive fits, the segment of today is kept
+void trimArchive(uint32_t today) {
+  char   name[32];
+  char   oldest[16];
+  char   current[32];
+  FSInfo info;
+  archiveSegmentName(today, "dat", current, sizeof(current));
+  while (true) {
+    bool full = (archiveBytes > ARCHIVE_BUDGET);
+    if (!full && LittleFS.info(info)) { full = (info.totalBytes - info.usedBytes < ARCHIVE_RESERVE); }
+    if (!full) { break; }
+    oldest[0] = '\0';
+    Dir dir = LittleFS.openDir(ARCHIVE_DIR);
+    while (dir.next()) {
+      String fileName = dir.fileName();
+      if (fileName.endsWith(".dat") && ( (oldest[0] == '\0') || (strcmp(fileName.c_str(), oldest) < 0) )) {
+        strlcpy(oldest, fileName.c_str(), sizeof(oldest));
+      }
+    }
+    snprintf_P(name, sizeof(name), PSTR("%s/%s"), ARCHIVE_DIR, oldest);
+    if ( (oldest[0] == '\0') || (strcmp(name, current) == 0) ) { break; }
+    for (uint8_t i=0; i<2; i++) {
+      if (i == 1) { strcpy(name + strlen(name) - 3, "idx"); }
+      File file = LittleFS.open(name, "r");
+      if (file) { archiveBytes -= (file.size() < archiveBytes) ? file.size() : archiveBytes; file.close(); }
+      LittleFS.remove(name);
+    }
+    if (mySettings.debuglevel > 0) {
+      snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Archive: removed %s"), oldest);
+      R_printSerialTelnetLogln(tmpStr);
+    }
+    yieldTime += yieldOS();
+  }
+}
+
+/******************************************************************************************************/
+// Export
+/******************************************************************************************************/
+// CSV:    time,scd30.CO2,scd30.rH,...      NDJSON: {"time": 1767225660, "scd30.CO2": 412, ...}
+//         1767225660,412,45.20,...
+// time is the epoch in seconds at the end of the minute, empty or null if the sensor had no reading.
+// The export reads one block at a time, the caller sends the fields as they are produced.
+
+bool archiveOpen(uint32_t from, uint32_t to, uint8_t format) {
+  char              name[32];
+  ArchiveIndexEntry entry;
+  uint32_t          now = (uint32_t)time(NULL);
+  if (to > now) { to = now; }
+  if (to/86400 - from/86400 > ARCHIVE_MAXDAYS) { from = (to/86400 - ARCHIVE_MAXDAYS) * 86400; }
+  archiveIndexFile.close();
+  archiveDataFile.close();
+  archiveFrom      = from;
+  archiveTo        = to;
+  archiveFormat    = format;
+  archiveDay       = from/86400;
+  archiveField     = -1;
+  archiveInHeader  = (format == ARCHIVE_CSV);
+  archiveDecoder.records = 0;
+
+  // columns are the channels of all blocks in the time range
+  archiveColumns = 0;
+  for (uint32_t day = from/86400; fsOK && (day <= to/86400); day++) {
+    archiveSegmentName(day, "idx", name, sizeof(name));
+    if (!LittleFS.exists(name)) { continue; }
+    File indexFile = LittleFS.open(name, "r");
+    while (indexFile.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry)) {
+      if ( (entry.end >= from) && (entry.start <= to) ) { archiveColumns |= entry.channels; }
+    }
+    indexFile.close();
+    yieldTime += yieldOS();
+  }
+  archiveExportRAM = (archiveEncoder.bit > 0) && (archiveEncoder.time >= from) && (archiveEncoder.start <= to);
+  if (archiveExportRAM) { archiveColumns |= archiveEncoder.channels; }
+  return (archiveColumns != 0);
+}
+
+bool archiveLoadBlock(uint32_t offset) {
+  ArchiveBlockHeader header;
+  if (!archiveDataFile.seek(offset, SeekSet)) { return false; }
+  if (archiveDataFile.read((uint8_t *)&header, sizeof(header)) != sizeof(header)) { return false; }
+  if ( (header.magic != ARCHIVE_MAGIC) || (header.length > ARCHIVE_BLOCKSIZE) ) { return false; }
+  if (archiveDataFile.read(archiveReadBuffer, header.length) != header.length) { return false; }
+  archiveDecoder.bit      = 0;
+  archiveDecoder.records  = header.records;
+  archiveDecoder.channels = header.channels;
+  archiveDecoder.start    = header.start;
+  return true;
+}
+
+// next block overlapping the time range, segments in order of days, then the records in RAM
+bool archiveNextBlock() {
+  char              name[32];
+  ArchiveIndexEntry entry;
+  while (true) {
+    if (archiveIndexFile) {
+      while (archiveIndexFile.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry)) {
+        if ( (entry.end < archiveFrom) || (entry.start > archiveTo) ) { continue; }
+        if (archiveLoadBlock(entry.offset)) { return true; }
+      }
+      archiveIndexFile.close();
+      archiveDataFile.close();
+      archiveDay++;
+    }
+    if (archiveDay > archiveTo/86400) { break; }
+    archiveSegmentName(archiveDay, "idx", name, sizeof(name));
+    if (fsOK && LittleFS.exists(name)) {
+      archiveIndexFile = LittleFS.open(name, "r");
+      archiveSegmentName(archiveDay, "dat", name, sizeof(name));
+      archiveDataFile  = LittleFS.open(name, "r");
+    }
+    if (!archiveIndexFile || !archiveDataFile) { archiveIndexFile.close(); archiveDataFile.close(); archiveDay++; }
+  }
+  if (archiveExportRAM) {
+    archiveExportRAM = false;
+    if (archiveEncoder.bit == 0) { return false; }        // was written in the meantime
+    memcpy(archiveReadBuffer, archiveBuffer, (archiveEncoder.bit + 7) / 8);
+    archiveDecoder.bit      = 0;
+    archiveDecoder.records  = archiveEncoder.records;
+    archiveDecoder.channels = archiveEncoder.channels;
+    archiveDecoder.start    = archiveEncoder.start;
+    return true;
+  }
+  return false;
+}
+
+bool archiveNextRecord() {
+  while (true) {
+    while (archiveDecoder.records > 0) {
+      archiveDecode(&archiveDecoder);
+      if ( (archiveDecoder.time >= archiveFrom) && (archiveDecoder.time <= archiveTo) ) { return true; }
+    }
+    if (!archiveNextBlock()) { return false; }
+    yieldTime += yieldOS();
+  }
+}
+
+size_t archiveExport(char *payLoad, size_t len) {
+  int l = 0;
+  while (l == 0) {
+    if (archiveField < 0) {                                // start of line
+      if (archiveInHeader) {
+        l = snprintf_P(payLoad, len, PSTR("time"));
+      } else {
+        if (!archiveNextRecord()) { return 0; }
+        l = snprintf_P(payLoad, len, (archiveFormat == ARCHIVE_CSV) ? PSTR("%lu") : PSTR("{\"time\": %lu"), (unsigned long)archiveDecoder.time);
+      }
+      archiveField = 0;
+      break;
+    }
+    while ( (archiveField < HISTORY_CHANNELS) && ((archiveColumns & (1UL << archiveField)) == 0) ) { archiveField++; }
+    if (archiveField >= HISTORY_CHANNELS) {                // end of line
+      l = snprintf_P(payLoad, len, ((archiveFormat == ARCHIVE_CSV) || archiveInHeader) ? PSTR("\n") : PSTR("}\n"));
+      archiveField    = -1;
+      archiveInHeader = false;
+      break;
+    }
+    uint8_t i = archiveField++;
+    char    name[HISTORY_NAMELENGTH];
+    if (archiveInHeader) {
+      strncpy_P(name, historyNames[i], sizeof(name));
+      l = snprintf_P(payLoad, len, PSTR(",%s"), name);
+      break;
+    }
+    float   value;
+    memcpy(&value, &archiveDecoder.value[i], sizeof(value));
+    bool    valid    = ((archiveDecoder.channels & (1UL << i)) != 0) && !isnan(value);
+    uint8_t decimals = historySources[i].decimals;
+    if (archiveFormat == ARCHIVE_CSV) {
+      if (valid) { l = snprintf_P(payLoad, len, PSTR(",%.*f"), decimals, value / archiveScales[decimals]); }
+      else       { l = snprintf_P(payLoad, len, PSTR(",")); }
+    } else if ((archiveDecoder.channels & (1UL << i)) != 0) {  // channels not in block are left out
+      strncpy_P(name, historyNames[i], sizeof(name));
+      if (valid) { l = snprintf_P(payLoad, len, PSTR(", \"%s\": %.*f"), name, decimals, value / archiveScales[decimals]); }
+      else       { l = snprintf_P(payLoad, len, PSTR(", \"%s\": null"), name); }
+    }
+  }
+  return (l < 0) ? 0 : ( ((size_t)l < len) ? (size_t)l : len-1 );
+}
+
+/******************************************************************************************************/
+// Print
+/******************************************************************************************************/
+
+void printArchive() {
+  if (!fsOK) { printSerialTelnetLogln(F("LittleFS not mounted")); return; }
+  printSerialTelnetLogln(F("Segment        Bytes  Blocks"));
+  Dir dir = LittleFS.openDir(ARCHIVE_DIR);
+  while (dir.next()) {
+    String fileName = dir.fileName();
+    if (!fileName.endsWith(".idx")) { continue; }
+    char   name[32];
+    snprintf_P(name, sizeof(name), PSTR("%s/%s"), ARCHIVE_DIR, fileName.c_str());
+    strcpy(name + strlen(name) - 3, "dat");
+    File   dataFile = LittleFS.open(name, "r");
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%.8s %10lu %7lu"), fileName.c_str(),
+               dataFile ? (unsigned long)dataFile.size() : 0UL, (unsigned long)(dir.fileSize() / sizeof(ArchiveIndexEntry)));
+    dataFile.close();
+    printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+  }
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%lu bytes, %u records in RAM"), archiveBytes, archiveEncoder.records);
+  printSerialTelnetLogln(tmpStr);
+}
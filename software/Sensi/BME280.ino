@@ -10,6 +10,7 @@
 #include "src/Config.h"
 #include "src/Quality.h"
 #include "src/Print.h"
+#include "src/Scheduler.h"
 
 //////// ===================================================
 float          bme280_pressure = -1.;                      // pressure from sensor
@@ -20,9 +21,8 @@ float          bme280_pressure24hrs = 0.0;                 // average pressure l
 float          alphaBME280;                                // poorman's low pass filter for f_cutoff = 1 day
 bool           bme280_avail = false;                       // do we hace the sensor?
 bool           bme280NewData = false;                      // is there new data
-bool           bme280NewDataHandeled = false;              // have we handeled the new data?
 bool           bme280NewDataWS = false;                    // is there new data for websocket
-long           bme280_measuretime = 0;                     // computed time it takes to complete the measurements and to finish standby
+unsigned long  bme280_measuretime = 0;                     // computed time it takes to complete the measurements and to finish standby
 bool           BMEhum_avail = false;                       // no humidity sensor if we have BMP instead of BME
 uint8_t        bme280_error_cnt = 0;                       // give a few retiries if error data length occurs while reading sensor values
 uint8_t        bme280_i2c[2];                              // the pins for the i2c port, set during initialization
@@ -42,6 +42,7 @@ extern Settings      mySettings;   // Config
 extern bool          fastMode;     // Sensi
 extern bool          intervalNewData;
 extern bool          availNewData;
+extern uint32_t      sampleSequence; // Sensi
 extern unsigned long lastYield;    // Sensi
 extern unsigned long currentTime;  // Sensi
 extern char          tmpStr[256];       // Sensi
@@ -129,7 +130,7 @@ bool initializeBME280() {
     else if (bme280.settings.tStandby == 6) { tmp = tmp + 10.0; }
     else if (bme280.settings.tStandby == 7) { tmp = tmp + 20.0; }
   }
-  bme280_measuretime = long(tmp);
+  bme280_measuretime = (unsigned long)(tmp);
 
   // make sure we dont attempt reading faster than it takes the sensor to complete a reading
   if (bme280_measuretime > intervalBME280) {intervalBME280 = bme280_measuretime;}
@@ -228,6 +229,7 @@ bool updateBME280() {
       if (mySettings.debuglevel >= 2) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BM[E/P]280: T, P read in %ldms"), (millis()-startMeasurementBME280)); R_printSerialTelnetLogln(tmpStr); }
       bme280NewData = true;
       bme280NewDataWS = true;
+      sampleSequence++;
       lastBME280 = currentTime;
 
       // update average daily pressure      
@@ -267,6 +269,22 @@ bool updateBME280() {
   return success;
 }
 
+/******************************************************************************************************/
+// Next BME280 step
+/******************************************************************************************************/
+// [ms] until updateBME280 has something to do
+
+unsigned long nextBME280() {
+  switch(stateBME280) {
+    case IS_SLEEPING:    { return dueIn(lastBME280, intervalBME280); }
+    case IS_BUSY:        { return dueIn(lastBME280, bme280_measuretime); }
+    case IS_MEASURING:   { return dueIn(lastBME280, intervalBME280); }
+    case DATA_AVAILABLE: { return 0; }
+    case HAS_ERROR:      { return dueIn(errorRecBME280, 0); }
+    default:             { return intervalPoll; }
+  }
+}
+
 /******************************************************************************************************/
 // JSON BME280
 /******************************************************************************************************/
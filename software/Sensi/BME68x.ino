@@ -13,10 +13,10 @@
 #include "src/Config.h"
 #include "src/Quality.h"
 #include "src/Print.h"
+#include "src/Scheduler.h"
 
 bool           bme68x_avail = false;                        // do we hace the sensor?
 bool           bme68xNewData = false;                       // do we have new data?
-bool           bme68xNewDataHandeled = false;               // have we handeled the new data?
 bool           bme68xNewDataWS = false;                     // do we have new data for websocket
 uint8_t        bme68x_i2c[2];                               // the pins for the i2c port, set during initialization
 uint8_t        bme68x_error_cnt = 0;                        // give a few retiries if error data length occurs while reading sensor values
@@ -39,6 +39,7 @@ bme68xData     bme68x;                                      // global data struc
 extern Settings      mySettings;   // Config
 extern bool          intervalNewData;
 extern bool          availNewData;
+extern uint32_t      sampleSequence; // Sensi
 extern bool          fastMode;     // Sensi
 extern bool          BMEhum_avail; // BME280
 extern unsigned long lastYield;    // Sensi
@@ -150,6 +151,7 @@ bool updateBME68x() {
       if (readDataBME68x()== true) {
         bme68xNewData = true;
         bme68xNewDataWS = true;
+        sampleSequence++;
         stateBME68x = IS_IDLE;
         bme68x_error_cnt = 0;
       } else {
@@ -199,6 +201,22 @@ bool updateBME68x() {
   return (success);
 }
 
+/******************************************************************************************************/
+// Next BME68x step
+/******************************************************************************************************/
+// [ms] until updateBME68x has something to do
+
+unsigned long nextBME68x() {
+  switch(stateBME68x) {
+    case IS_SLEEPING:    { return dueIn(lastBME68x, intervalBME68x); }
+    case IS_IDLE:        { return dueIn(lastBME68x, intervalBME68x); }
+    case IS_BUSY:        { return dueIn(endTimeBME68x, 0); }
+    case DATA_AVAILABLE: { return 0; }
+    case HAS_ERROR:      { return dueIn(errorRecBME68x, 0); }
+    default:             { return intervalPoll; }
+  }
+}
+
 bool startMeasurementsBME68x(){
 
   switchI2C(bme68x_port, bme68x_i2c[0], bme68x_i2c[1], bme68x_i2cspeed, bme68x_i2cClockStretchLimit);
@@ -12,10 +12,10 @@
 #include "src/Config.h"
 #include "src/Quality.h"
 #include "src/Print.h"
+#include "src/Scheduler.h"
 
 bool                   ccs811_avail = false;               // do we have this sensor?
 bool                   ccs811NewData = false;              // do we have new data
-bool                   ccs811NewDataHandeled = false;      // have we handeled the new data?
 bool                   ccs811NewDataWS = false;            // do we have new data for websocket
 uint8_t                ccs811_i2c[2];                      // the pins for the i2c port, set during initialization
 uint8_t                ccs811Mode;                         // operation mode, see above 
@@ -30,7 +30,7 @@ unsigned long          intervalCCS811Humidity;             // update the humidit
 unsigned long          intervalCCS811;                     // to check if interrupt timed out
 unsigned long          errorRecCCS811;                     // when did we attempt to recover sensor
 unsigned long          startMeasurementCCS811;
-unsigned long          ccs811_lastError;
+unsigned long          ccs811_lastError = currentTime;
 volatile unsigned long lastCCS811Interrupt;                // last time we update Humidity on sensor
 
 TwoWire               *ccs811_port =0;                     // pointer to the i2c port, might be useful for other microcontrollers
@@ -42,11 +42,13 @@ extern Settings      mySettings;   // Config
 extern bool          fastMode;     // Sensi
 extern bool          intervalNewData;
 extern bool          availNewData;
+extern uint32_t      sampleSequence; // Sensi
 extern unsigned long lastYield;    // Sensi
 extern unsigned long currentTime;  // Sensi
 extern char          tmpStr[256];       // Sensi
 extern bool          bme68x_avail; // bme68x
 extern unsigned long tmpTime;      // Sensi
+extern int           taskIDCCS811;      // Sensi
 
 /******************************************************************************************************/
 // Interrupt Handler CCS811
@@ -59,6 +61,7 @@ void ICACHE_RAM_ATTR handleCCS811Interrupt() {             // interrupt service
       stateCCS811 = IS_WAKINGUP;                           // update the sensor state
       lastCCS811Interrupt = millis();
     }
+    notifyTask(taskIDCCS811);                              // run the sensor task
     // if (mySettings.debuglevel == 10) { R_printSerialTelnetLogln(F("CCS811: interrupt occured")); } // usually no serial in ISR
 }
 
@@ -189,6 +192,7 @@ bool updateCCS811() {
         if (mySettings.debuglevel >= 2) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811: eCO2, tVOC read in %ldms"), (millis()-startMeasurementCCS811)); R_printSerialTelnetLogln(tmpStr); }
         ccs811NewData=true;
         ccs811NewDataWS=true;
+        sampleSequence++;
         uint8_t error = ccs811.getErrorRegister();
         if (mySettings.debuglevel > 0) {
           if (error == 0xFF) { R_printSerialTelnetLogln(F("CCS811: failed to read ERROR_ID register")); }
@@ -291,7 +295,7 @@ bool updateCCS811() {
           if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("CCS811: reinitialization attempts exceeded, CCS811: no longer available")); }
           break;
         } // give up after ERROR_COUNT tries
-        ccs811_lastError;
+        ccs811_lastError = currentTime;
 
         // trying to recover sensor, reinitialize it
         if (initializeCCS811()) {
@@ -308,6 +312,21 @@ bool updateCCS811() {
   return success;
 }
 
+/******************************************************************************************************/
+// Next CCS811 step
+/******************************************************************************************************/
+// [ms] until updateCCS811 has something to do, the interrupt wakes the task when data is ready
+
+unsigned long nextCCS811() {
+  switch(stateCCS811) {
+    case IS_WAKINGUP:    { return dueIn(lastCCS811Interrupt, 1); }
+    case DATA_AVAILABLE: { return 0; }
+    case IS_IDLE:        { return dueIn(lastCCS811, INTERVAL_TIMEOUT_FACTOR*intervalCCS811); }
+    case HAS_ERROR:      { return dueIn(errorRecCCS811, 0); }
+    default:             { return INTERVAL_TIMEOUT_FACTOR*intervalCCS811; }
+  }
+}
+
 /******************************************************************************************************/
 // JSON CCS811
 /******************************************************************************************************/
@@ -3,229 +3,592 @@
 /******************************************************************************************************/
 #include "src/Config.h"
 #include "src/Sensi.h"
+#include "src/Print.h"
 
 const unsigned int eepromAddress = 0;                      // 
 unsigned long      lastSaveSettings;                       // last time we updated EEPROM, should occur every couple days
 unsigned long      lastSaveSettingsJSON;                   // last time we updated JSON, should occur every couple days
 
 Settings           mySettings;                             // the settings
+Settings           storedSettings;                         // the settings as stored in the journal
+size_t             settingsJournalSize = 0;                // [bytes] of journal file
+const unsigned int settingsRecordAddress = i2cTopologyAddress - sizeof(SettingsRecord); // header of settings in EEPROM
 
 // External variables
+extern const unsigned int i2cTopologyAddress;  // I2C
 extern bool fsOK;
 extern unsigned long yieldTime;
+extern char          tmpStr[256];
 
 // Save and Read Settings
 // Uses JSON structure on LittleFS Filespace
 //
-// These routines are not used for boot-up
-// JSON saving settings to LittelFS regularly resulted in system crashes.
-// The JSON conversion might complete but opening and writting the file does not.
+// These routines are not used for boot-up.
+// The JSON text is produced and parsed field by field with the table below, there is no JsonDocument
+// and no heap is needed. The file is written to a temporary file and renamed over Sensi.json.
+
+#define SETTING(KEY, TYPE, MEMBER) { KEY, TYPE, offsetof(Settings, MEMBER), sizeof(((Settings *)0)->MEMBER) }
+#define SETTING_BAND(CHANNEL, I)   SETTING("band." CHANNEL, SETTING_FLOAT, telemetryBands[I].absolute), \
+                                   SETTING("bandPercent." CHANNEL, SETTING_FLOAT, telemetryBands[I].relative)
+#define SETTING_TIMING(SENSOR, I)  SETTING("minInterval." SENSOR, SETTING_UNSIGNED, telemetryTimings[I].minInterval), \
+                                   SETTING("heartbeat." SENSOR, SETTING_UNSIGNED, telemetryTimings[I].maxSilence)
+
+const SettingsField settingsFields[] PROGMEM = {
+  SETTING("runTime",                       SETTING_UNSIGNED, runTime),                       // keep track of total sensor run time
+  SETTING("debuglevel",                    SETTING_UNSIGNED, debuglevel),                    // amount of debug output on serial port
+
+  SETTING("baselineSGP30_valid",           SETTING_UNSIGNED, baselineSGP30_valid),           // 0xF0 = valid
+  SETTING("baselineeCO2_SGP30",            SETTING_UNSIGNED, baselineeCO2_SGP30),            //
+  SETTING("baselinetVOC_SGP30",            SETTING_UNSIGNED, baselinetVOC_SGP30),            //
+  SETTING("baselineCCS811_valid",          SETTING_UNSIGNED, baselineCCS811_valid),          // 0xF0 = valid
+  SETTING("baselineCCS811",                SETTING_UNSIGNED, baselineCCS811),                // baseline is an internal value, not ppm
+  SETTING("tempOffset_SCD30_valid",        SETTING_UNSIGNED, tempOffset_SCD30_valid),        // 0xF0 = valid
+  SETTING("tempOffset_SCD30",              SETTING_FLOAT,    tempOffset_SCD30),              // in C
+  SETTING("forcedCalibration_SCD30_valid", SETTING_UNSIGNED, forcedCalibration_SCD30_valid), // 0xF0 = valid, not used
+  SETTING("forcedCalibration_SCD30",       SETTING_FLOAT,    forcedCalibration_SCD30),       // not used
+  SETTING("tempOffset_MLX_valid",          SETTING_UNSIGNED, tempOffset_MLX_valid),          // 0xF0 = valid
+  SETTING("tempOffset_MLX",                SETTING_FLOAT,    tempOffset_MLX),                // in C
+  SETTING("emissivity_MLX",                SETTING_FLOAT,    emissivity),                    // 0..1
+
+  SETTING("useWiFi",                       SETTING_BOOL,     useWiFi),                       // use/not use WiFi and MQTT
+  SETTING("ssid1",                         SETTING_STRING,   ssid1),                         // WiFi SSID 32 bytes max
+  SETTING("pw1",                           SETTING_STRING,   pw1),                           // WiFi passwrod 64 chars max
+  SETTING("ssid2",                         SETTING_STRING,   ssid2),                         // 2nd set of WiFi credentials
+  SETTING("pw2",                           SETTING_STRING,   pw2),                           //
+  SETTING("ssid3",                         SETTING_STRING,   ssid3),                         // 3rd set of WiFi credentials
+  SETTING("pw3",                           SETTING_STRING,   pw3),                           //
+
+  SETTING("useMQTT",                       SETTING_BOOL,     useMQTT),                       // provide MQTT data
+  SETTING("mqtt_server",                   SETTING_STRING,   mqtt_server),                   // your mqtt server
+  SETTING("mqtt_username",                 SETTING_STRING,   mqtt_username),                 // username for MQTT server, leave blank if no password
+  SETTING("mqtt_password",                 SETTING_STRING,   mqtt_password),                 // password for MQTT server
+  SETTING("sendMQTTimmediate",             SETTING_BOOL,     sendMQTTimmediate),             // true: update MQTT right away when new data is availablk, otherwise send one unified message
+  SETTING("mqtt_fallback",                 SETTING_STRING,   mqtt_fallback),                 // your fallback mqtt server if initial server fails, useful when on private home network
+  SETTING("mqtt_mainTopic",                SETTING_STRING,   mqtt_mainTopic),                // name of this sensing device for mqtt broker
+  SETTING("mqtt_interval",                 SETTING_FLOAT,    intervalMQTT),                  // time in between MQTT updates
+  SETTING("mqttEncoding",                  SETTING_UNSIGNED, mqttEncoding),                  // 0: JSON, 1: MessagePack sensor messages
+  SETTING("mqttMessageRate",               SETTING_UNSIGNED, mqttMessageRate),               // [1/s] immediate messages
+  SETTING("mqttBurst",                     SETTING_UNSIGNED, mqttBurst),                     // [messages] saved up budget
+  SETTING("mqttByteRate",                  SETTING_UNSIGNED, mqttByteRate),                  // [bytes/s] immediate messages
+  SETTING("queueMessageRate",              SETTING_UNSIGNED, queueMessageRate),              // [1/s] queue drain
+  SETTING("queueByteRate",                 SETTING_UNSIGNED, queueByteRate),                 // [bytes/s] queue drain
+
+  SETTING_BAND("scd30.CO2",   HISTORY_SCD30_CO2),    SETTING_BAND("scd30.rH",    HISTORY_SCD30_RH),    SETTING_BAND("scd30.T",  HISTORY_SCD30_T),
+  SETTING_BAND("sgp30.eCO2",  HISTORY_SGP30_ECO2),   SETTING_BAND("sgp30.tVOC",  HISTORY_SGP30_TVOC),
+  SETTING_BAND("ccs811.eCO2", HISTORY_CCS811_ECO2),  SETTING_BAND("ccs811.tVOC", HISTORY_CCS811_TVOC),
+  SETTING_BAND("sps30.PM1",   HISTORY_SPS30_PM1),    SETTING_BAND("sps30.PM2",   HISTORY_SPS30_PM2),
+  SETTING_BAND("sps30.PM4",   HISTORY_SPS30_PM4),    SETTING_BAND("sps30.PM10",  HISTORY_SPS30_PM10),
+  SETTING_BAND("bme280.p",    HISTORY_BME280_P),     SETTING_BAND("bme280.rH",   HISTORY_BME280_RH),   SETTING_BAND("bme280.T", HISTORY_BME280_T),
+  SETTING_BAND("bme68x.p",    HISTORY_BME68X_P),     SETTING_BAND("bme68x.rH",   HISTORY_BME68X_RH),   SETTING_BAND("bme68x.T", HISTORY_BME68X_T),
+  SETTING_BAND("bme68x.resistance", HISTORY_BME68X_RESISTANCE),
+  SETTING_BAND("mlx.To",      HISTORY_MLX_TO),       SETTING_BAND("mlx.Ta",      HISTORY_MLX_TA),
+  SETTING_TIMING("scd30",  TELEMETRY_SENSOR_SCD30),  SETTING_TIMING("sgp30",  TELEMETRY_SENSOR_SGP30),  SETTING_TIMING("ccs811", TELEMETRY_SENSOR_CCS811),
+  SETTING_TIMING("sps30",  TELEMETRY_SENSOR_SPS30),  SETTING_TIMING("bme280", TELEMETRY_SENSOR_BME280), SETTING_TIMING("bme68x", TELEMETRY_SENSOR_BME68X),
+  SETTING_TIMING("mlx",    TELEMETRY_SENSOR_MLX),
+
+  SETTING("useLCD",                        SETTING_BOOL,     useLCD),                        // use/not use LCD even if it is connected
+  SETTING("LCDdisplayType",                SETTING_UNSIGNED, LCDdisplayType),                // LCD screen layout
+  SETTING("consumerLCD",                   SETTING_BOOL,     notused),                       // simplified display
+  SETTING("useBacklight",                  SETTING_BOOL,     useBacklight),                  // backlight on/off
+  SETTING("useBacklightNight",             SETTING_BOOL,     useBacklightNight),             // backlight at night on/off
+  SETTING("useBlinkNight",                 SETTING_BOOL,     useBlinkNight),                 // backlight blinking at night on/off
+  SETTING("nightBegin",                    SETTING_UNSIGNED, nightBegin),                    // minutes from midnight when to stop changing backlight because of low airquality
+  SETTING("nightEnd",                      SETTING_UNSIGNED, nightEnd),                      // minutes from midnight when to start changing backight because of low airquality
+
+  SETTING("useSCD30",                      SETTING_BOOL,     useSCD30),                      // ...
+  SETTING("useSPS30",                      SETTING_BOOL,     useSPS30),                      // ...
+  SETTING("useSGP30",                      SETTING_BOOL,     useSGP30),                      // ...
+  SETTING("useMAX30",                      SETTING_BOOL,     useMAX30),                      // ...
+  SETTING("useMLX",                        SETTING_BOOL,     useMLX),                        // ...
+  SETTING("useBME68x",                     SETTING_BOOL,     useBME68x),                     // ...
+  SETTING("useCCS811",                     SETTING_BOOL,     useCCS811),                     // ...
+  SETTING("useBME280",                     SETTING_BOOL,     useBME280),                     // ...
+  SETTING("avgP",                          SETTING_FLOAT,    avgP),                          // averagePressure
+  SETTING("altitude",                      SETTING_FLOAT,    altitude),                      // altitude of current location in meters
+
+  SETTING("useWeather",                    SETTING_BOOL,     useWeather),                    // connect to open weather
+  SETTING("weatherApiKey",                 SETTING_STRING,   weatherApiKey),                 // api key created on open weather
+  SETTING("weatherCity",                   SETTING_STRING,   weatherCity),                   // city
+  SETTING("weatherCountryCode",            SETTING_STRING,   weatherCountryCode),            // country
+
+  SETTING("useHTTP",                       SETTING_BOOL,     useHTTP),                       // provide webserver
+  SETTING("wsEncoding",                    SETTING_UNSIGNED, wsEncoding),                    // 0: JSON, 1: MessagePack sensor messages on websocket
+  SETTING("useOTA",                        SETTING_BOOL,     useOTA),                        // porivude over the air programming
+  SETTING("usemDNS",                       SETTING_BOOL,     usemDNS),                       // provide mDNS
+  SETTING("useHTTPUpdater",                SETTING_BOOL,     useHTTPUpdater),                // use HTTP updating
+  SETTING("useTelnet",                     SETTING_BOOL,     useTelnet),                     // use Telnet for Serial
+  SETTING("useSerial",                     SETTING_BOOL,     useSerial),                     // use USB for Serial
+  SETTING("useLog",                        SETTING_BOOL,     useLog),                        // keep copy of seriel and telnet prints in log file
+
+  SETTING("useNTP",                        SETTING_BOOL,     useNTP),                        // want network time
+  SETTING("ntpServer",                     SETTING_STRING,   ntpServer),                     // ntp server
+  SETTING("ntpFallback",                   SETTING_STRING,   ntpFallback),                   // ntp allback server
+  SETTING("timeZone",                      SETTING_STRING,   timeZone),                      // time zone according second column in https://raw.githubusercontent.com/nayarsystems/posix_tz_db/master/zones.csv
+  SETTING("rebootMinute",                  SETTING_SIGNED,   rebootMinute)                   // if sensor error, when should we attempt rebooting in minutes after midnight?
+};
+
+#define SETTINGS_FIELDS (sizeof(settingsFields) / sizeof(SettingsField))
 
 void saveConfiguration(const Settings &config) {
-  if (ESP.getMaxFreeBlockSize() > JSONSIZE) {
-    if (fsOK) { // file system is mounted
-      // Allocate a temporary JsonDocument
-      // Use arduinojson.org/assistant to compute the capacity.
-      D_printSerialTelnet(F("D:JSON:1.."));
-      //StaticJsonDocument<JSONSIZE> doc;
-      DynamicJsonDocument doc(JSONSIZE);
-    
-      doc["runTime"]                      = config.runTime;                                  // keep track of total sensor run time
-      doc["debuglevel"]                   = config.debuglevel;                               // amount of debug output on serial port
-    
-      doc["baselineSGP30_valid"]          = config.baselineSGP30_valid;                      // 0xF0 = valid
-      doc["baselineeCO2_SGP30"]           = config.baselineeCO2_SGP30;                       //
-      doc["baselinetVOC_SGP30"]           = config.baselinetVOC_SGP30;                       //
-      doc["baselineCCS811_valid"]         = config.baselineCCS811_valid;                     // 0xF0 = valid
-      doc["baselineCCS811"]               = config.baselineCCS811;                           // baseline is an internal value, not ppm
-      doc["tempOffset_SCD30_valid"]       = config.tempOffset_SCD30_valid;                   // 0xF0 = valid
-      doc["tempOffset_SCD30"]             = config.tempOffset_SCD30;                         // in C
-      doc["forcedCalibration_SCD30_valid"]= config.forcedCalibration_SCD30_valid;            // 0xF0 = valid, not used as the sensor is not designed to prepoluate its internal calibration
-      doc["forcedCalibration_SCD30"]      = config.forcedCalibration_SCD30;                  // not used
-      doc["tempOffset_MLX_valid"]         = config.tempOffset_MLX_valid;                     // 0xF0 = valid
-      doc["tempOffset_MLX"]               = config.tempOffset_MLX;                           // in C
-      doc["emissivity_MLX"]               = config.emissivity;                               // 0..1
-      
-      D_printSerialTelnet(F("D:JSON:2.."));
-      //yieldTime += yieldOS(); 
-    
-      doc["useWiFi"]                      = config.useWiFi;                                  // use/not use WiFi and MQTT
-      doc["ssid1"]                        = config.ssid1;                                    // WiFi SSID 32 bytes max
-      doc["pw1"]                          = config.pw1;                                      // WiFi passwrod 64 chars max
-      doc["ssid2"]                        = config.ssid2;                                    // 2nd set of WiFi credentials
-      doc["pw2"]                          = config.pw2;                                      //
-      doc["ssid3"]                        = config.ssid3;                                    // 3rd set of WiFi credentials
-      doc["pw3"]                          = config.pw3;                                      //
-  
-      D_printSerialTelnet(F("D:JSON:3.."));
-      //yieldTime += yieldOS(); 
-    
-      doc["useMQTT"]                      = config.useMQTT;                                  // provide MQTT data
-      doc["mqtt_server"]                  = config.mqtt_server;                              // your mqtt server
-      doc["mqtt_username"]                = config.mqtt_username;                            // username for MQTT server, leave blank if no password
-      doc["mqtt_password"]                = config.mqtt_password;                            // password for MQTT server
-      doc["sendMQTTimmediate"]            = config.sendMQTTimmediate;                        // true: update MQTT right away when new data is availablk, otherwise send one unified message
-      doc["mqtt_fallback"]                = config.mqtt_fallback;                            // your fallback mqtt server if initial server fails, useful when on private home network
-      doc["mqtt_mainTopic"]               = config.mqtt_mainTopic;                           // name of this sensing device for mqtt broker
-      doc["mqtt_interval"]                = config.intervalMQTT;                             // time in between MQTT updates
-    
-      doc["useLCD"]                       = config.useLCD;                                   // use/not use LCD even if it is connected
-      doc["LCDdisplayType"]               = config.LCDdisplayType;                           // LCD screen layout
-      doc["consumerLCD"]                  = config.notused;                                  // simplified display
-      doc["useBacklight"]                 = config.useBacklight;                             // backlight on/off
-      doc["useBacklightNight"]            = config.useBacklightNight;                        // backlight at night on/off
-      doc["useBlinkNight"]                = config.useBlinkNight;                            // backlight blinking at night on/off
-      doc["nightBegin"]                   = config.nightBegin;                               // minutes from midnight when to stop changing backlight because of low airquality
-      doc["nightEnd"]                     = config.nightEnd;                                 // minutes from midnight when to start changing backight because of low airquality
-  
-      D_printSerialTelnet(F("D:JSON:4.."));
-      //yieldTime += yieldOS(); 
-    
-      doc["useSCD30"]                     = config.useSCD30;                                 // ...
-      doc["useSPS30"]                     = config.useSPS30;                                 // ...
-      doc["useSGP30"]                     = config.useSGP30;                                 // ...
-      doc["useMAX30"]                     = config.useMAX30;                                 // ...
-      doc["useMLX"]                       = config.useMLX;                                   // ...
-      doc["useBME68x"]                    = config.useBME68x;                                // ...
-      doc["useCCS811"]                    = config.useCCS811;                                // ...
-      doc["useBME280"]                    = config.useBME280;                                // ...
-      doc["avgP"]                         = config.avgP;                                     // averagePressure
-
-      doc["useWeather"]                   = config.useWeather;                               // connect to open weather
-      doc["weatherApiKey"]                = config.weatherApiKey;                            // api key created on open weather
-      doc["weatherCity"]                  = config.weatherCity;                              // city
-      doc["weatherCountryCode"]           = config.weatherCountryCode;                       // city
-      
-      doc["useHTTP"]                      = config.useHTTP;                                  // provide webserver
-      doc["useOTA"]                       = config.useOTA;                                   // porivude over the air programming
-      doc["usemDNS"]                      = config.usemDNS;                                  // provide mDNS
-      doc["useHTTPUpdater"]               = config.useHTTPUpdater;                           // use HTTP updating 
-      doc["useTelnet"]                    = config.useTelnet;                                // use Telnet for Serial
-      doc["useSerial"]                    = config.useSerial;                                // use USB for Serial
-      doc["useLog"]                       = config.useLog;                                   // keep copy of seriel and telnet prints in log file
-    
-      D_printSerialTelnet(F("D:JSON:5.."));
-      //yieldTime += yieldOS(); 
-
-      doc["useNTP"]                       = config.useNTP;                                   // want network time
-      doc["ntpServer"]                    = config.ntpServer;                                // ntp server
-      doc["ntpFallback"]                  = config.ntpFallback;                              // ntp allback server
-      doc["timeZone"]                     = config.timeZone;                                 // time zone according second column in https://raw.githubusercontent.com/nayarsystems/posix_tz_db/master/zones.csv
-      doc["rebootMinute"]                 = config.rebootMinute;                             // if sensor error, when should we attempt rebooting in minutes after midnight?
-    
-      //serializeJsonPretty(doc, Serial);  Serial.println();
-      
-      D_printSerialTelnet(F("D:JSON:O.."));
-      yieldTime += yieldOS(); 
-
-      // Open file for writing
-      #if defined(DEBUG)
-      snprintf_P(tmpStr, sizeof(tmpStr),PSTR("\r\nFilename is: %s"),"/Sensi.json"); printSerialTelnetln(tmpStr);
-      snprintf_P(tmpStr, sizeof(tmpStr),PSTR("Free Heap Size: %dbytes Heap Fragmentation: %d%% Max Block Size: %dbytes"), ESP.getFreeHeap(), ESP.getHeapFragmentation(), ESP.getMaxFreeBlockSize()); printSerialTelnetln(tmpStr);
-      #endif
-      File cfgFile = LittleFS.open("/Sensi.json", "w+");
-      if (!cfgFile) { printSerialTelnetLogln(F("Failed to create file")); return; }
-      else {
-        D_printSerialTelnetln(F("DBG:JSON Serialze to File.."));
-        // Serialize JSON to file      
-        if (serializeJsonPretty(doc, cfgFile) == 0) { printSerialTelnetLogln(F("Failed to write to file")); }
-        D_printSerialTelnet(F("DBG:JSON CLOSE.."));
-        // Close the file
-        cfgFile.close();
+  char   line[128];
+  size_t l;
+  bool   ok = true;
+  if (!fsOK) { return; }                                   // file system is not mounted
+  File cfgFile = LittleFS.open("/Sensi.json.tmp", "w");
+  if (!cfgFile) { printSerialTelnetLogln(F("Failed to create file")); return; }
+  for (uint16_t i=0; (l = settingsJSON(i, config, line, sizeof(line))) > 0; i++) {
+    if (cfgFile.write((const uint8_t *)line, l) != l) { ok = false; break; }
+  }
+  cfgFile.close();
+  if (ok) { ok = LittleFS.rename("/Sensi.json.tmp", "/Sensi.json"); }
+  if (!ok) { 
+    LittleFS.remove("/Sensi.json.tmp");
+    printSerialTelnetLogln(F("Failed to write to file")); 
+  }
+  yieldTime += yieldOS(); 
+}
+
+void loadConfiguration(Settings &config) {
+  char           chunk[SETTINGS_JSONCHUNK];
+  int            n;
+  bool           ok = true;
+  SettingsParser parser;
+  if (!fsOK) { return; }
+  if (!LittleFS.exists("/Sensi.json")) { printSerialTelnetLogln(F("Config file does not exist")); return; }
+  File cfgFile = LittleFS.open("/Sensi.json", "r");
+  beginSettingsParser(&parser);
+  while ( ok && ((n = cfgFile.read((uint8_t *)chunk, sizeof(chunk))) > 0) ) {
+    ok = parseSettingsJSON(&parser, chunk, n, config);
+    yieldTime += yieldOS(); 
+  }
+  cfgFile.close();
+  if (parser.state != PARSE_DONE) { printSerialTelnetLogln(F("Failed to read file, settings before the error were loaded")); }
+}
+
+/******************************************************************************************************/
+// Settings JSON
+/******************************************************************************************************/
+
+unsigned long settingsUnsigned(const uint8_t *member, uint8_t size) {
+  switch (size) {
+    case 1:  { return *member; }
+    case 2:  { uint16_t value; memcpy(&value, member, sizeof(value)); return value; }
+    case 4:  { uint32_t value; memcpy(&value, member, sizeof(value)); return value; }
+    default: { unsigned long value; memcpy(&value, member, sizeof(value)); return value; }
+  }
+}
+
+long settingsSigned(const uint8_t *member, uint8_t size) {
+  switch (size) {
+    case 1:  { return (int8_t)*member; }
+    case 2:  { int16_t value; memcpy(&value, member, sizeof(value)); return value; }
+    case 4:  { int32_t value; memcpy(&value, member, sizeof(value)); return value; }
+    default: { long value; memcpy(&value, member, sizeof(value)); return value; }
+  }
+}
+
+// stores the low bytes of value, works for signed and unsigned members
+void settingsSetInteger(uint8_t *member, uint8_t size, unsigned long value) {
+  switch (size) {
+    case 1:  { *member = (uint8_t)value; break; }
+    case 2:  { uint16_t v = value; memcpy(member, &v, sizeof(v)); break; }
+    case 4:  { uint32_t v = value; memcpy(member, &v, sizeof(v)); break; }
+    default: { memcpy(member, &value, sizeof(value)); break; }
+  }
+}
+
+// JSON string escapes, stops at the end of payload
+size_t settingsEscape(const char *str, size_t size, char *payLoad, size_t len) {
+  size_t l = 0;
+  for (size_t i=0; (i < size) && (str[i] != '\0'); i++) {
+    char    escaped[7];
+    uint8_t n;
+    if      ( (str[i] == '"') || (str[i] == '\\') ) { escaped[0] = '\\'; escaped[1] = str[i]; n = 2; }
+    else if ((uint8_t)str[i] < 0x20)                { n = snprintf_P(escaped, sizeof(escaped), PSTR("\\u%04x"), (uint8_t)str[i]); }
+    else                                            { escaped[0] = str[i]; n = 1; }
+    if (l + n >= len) { break; }
+    memcpy(payLoad + l, escaped, n);
+    l += n;
+  }
+  if (len > 0) { payLoad[l] = '\0'; }
+  return l;
+}
+
+size_t settingsJSON(uint16_t index, const Settings &config, char *payLoad, size_t len) {
+  int l;
+  if (index == 0)                    { l = snprintf_P(payLoad, len, PSTR("{\n")); }
+  else if (index == SETTINGS_FIELDS+1) { l = snprintf_P(payLoad, len, PSTR("}\n")); }
+  else if (index > SETTINGS_FIELDS+1)  { return 0; }
+  else {
+    SettingsField  field;
+    memcpy_P(&field, &settingsFields[index-1], sizeof(field));
+    const uint8_t *member    = (const uint8_t *)&config + field.offset;
+    const char    *separator = (index < SETTINGS_FIELDS) ? "," : "";
+    switch (field.type) {
+      case SETTING_BOOL:     { l = snprintf_P(payLoad, len, PSTR("  \"%s\": %s%s\n"),  field.key, (*member) ? "true" : "false", separator); break; }
+      case SETTING_UNSIGNED: { l = snprintf_P(payLoad, len, PSTR("  \"%s\": %lu%s\n"), field.key, settingsUnsigned(member, field.size), separator); break; }
+      case SETTING_SIGNED:   { l = snprintf_P(payLoad, len, PSTR("  \"%s\": %ld%s\n"), field.key, settingsSigned(member, field.size), separator); break; }
+      case SETTING_FLOAT:    { float value; memcpy(&value, member, sizeof(value));
+                               if (!isfinite(value)) { value = 0.0; }
+                               l = snprintf_P(payLoad, len, PSTR("  \"%s\": %.7g%s\n"), field.key, value, separator);
+                               if ( (l > 0) && ((size_t)l < len) && (strtof(strchr(payLoad, ':')+1, NULL) != value) ) {  // 9 digits always read back the same float
+                                 l = snprintf_P(payLoad, len, PSTR("  \"%s\": %.9g%s\n"), field.key, value, separator);
+                               }
+                               break; }
+      default:               { l = snprintf_P(payLoad, len, PSTR("  \"%s\": \""), field.key);
+                               if ( (l < 0) || ((size_t)l >= len) ) { break; }
+                               l += settingsEscape((const char *)member, field.size, payLoad+l, len-l-3);
+                               l += snprintf_P(payLoad+l, len-l, PSTR("\"%s\n"), separator); break; }
+    }
+  }
+  return (l < 0) ? 0 : ( ((size_t)l < len) ? (size_t)l : len-1 );
+}
+
+void beginSettingsParser(SettingsParser *parser) {
+  memset(parser, 0, sizeof(SettingsParser));
+  parser->state = PARSE_OBJECT;
+}
+
+void applySetting(SettingsParser *parser, Settings &config, bool isString) {
+  SettingsField field;
+  if (!isString && (strcmp(parser->value, "null") == 0)) { return; }
+  for (uint8_t i=0; i<SETTINGS_FIELDS; i++) {
+    if (strcmp_P(parser->key, settingsFields[i].key) != 0) { continue; }
+    memcpy_P(&field, &settingsFields[i], sizeof(field));
+    uint8_t *member = (uint8_t *)&config + field.offset;
+    switch (field.type) {
+      case SETTING_BOOL:     { *member = ( (strcmp(parser->value, "true") == 0) || (strtol(parser->value, NULL, 10) != 0) ) ? 1 : 0; break; }
+      case SETTING_UNSIGNED: { settingsSetInteger(member, field.size, strtoul(parser->value, NULL, 10)); break; }
+      case SETTING_SIGNED:   { settingsSetInteger(member, field.size, (unsigned long)strtol(parser->value, NULL, 10)); break; }
+      case SETTING_FLOAT:    { float value = strtof(parser->value, NULL); memcpy(member, &value, sizeof(value)); break; }
+      default:               { strlcpy((char *)member, parser->value, field.size); break; }
+    }
+    parser->fields++;
+    return;
+  }
+}
+
+// adds character to key or value, too long text is cut
+void settingsParserAppend(SettingsParser *parser, char c) {
+  if (parser->state == PARSE_KEYSTRING) {
+    if (parser->keyLength   < SETTINGS_KEYLENGTH-1)   { parser->key[parser->keyLength++]     = c; }
+  } else {
+    if (parser->valueLength < SETTINGS_VALUELENGTH-1) { parser->value[parser->valueLength++] = c; }
+  }
+}
+
+bool parseSettingsJSON(SettingsParser *parser, const char *data, size_t len, Settings &config) {
+  for (size_t i=0; i<len; i++) {
+    char c = data[i];
+    bool space = isspace((uint8_t)c);
+    switch (parser->state) {
+
+      case PARSE_OBJECT: {
+        if (c == '{') { parser->state = PARSE_KEY; } else if (!space) { parser->state = PARSE_ERROR; }
+        break;
+      }
+
+      case PARSE_KEY: {                                    // also skips the comma after a value
+        if      (c == '"')                  { parser->state = PARSE_KEYSTRING; parser->keyLength = 0; }
+        else if (c == '}')                  { parser->state = PARSE_DONE; }
+        else if ( (c != ',') && !space )    { parser->state = PARSE_ERROR; }
+        break;
+      }
+
+      case PARSE_KEYSTRING:
+      case PARSE_STRING: {
+        if (parser->unicode > 0) {                         // \uXXXX, characters beyond 8 bits become ?
+          parser->code = (parser->code << 4) | (isdigit((uint8_t)c) ? c - '0' : (tolower((uint8_t)c) - 'a' + 10));
+          if (--parser->unicode == 0) { settingsParserAppend(parser, (parser->code < 0x100) ? (char)parser->code : '?'); }
+        } else if (parser->escape) {
+          parser->escape = false;
+          switch (c) {
+            case 'b': { settingsParserAppend(parser, '\b'); break; }
+            case 'f': { settingsParserAppend(parser, '\f'); break; }
+            case 'n': { settingsParserAppend(parser, '\n'); break; }
+            case 'r': { settingsParserAppend(parser, '\r'); break; }
+            case 't': { settingsParserAppend(parser, '\t'); break; }
+            case 'u': { parser->unicode = 4; parser->code = 0; break; }
+            default:  { settingsParserAppend(parser, c); break; }
+          }
+        } else if (c == '\\') {
+          parser->escape = true;
+        } else if (c == '"') {
+          if (parser->state == PARSE_KEYSTRING) {
+            parser->key[parser->keyLength] = '\0';
+            parser->state = PARSE_COLON;
+          } else {
+            parser->value[parser->valueLength] = '\0';
+            applySetting(parser, config, true);
+            parser->state = PARSE_KEY;
+          }
+        } else {
+          settingsParserAppend(parser, c);
+        }
+        break;
+      }
+
+      case PARSE_COLON: {
+        if (c == ':') { parser->state = PARSE_VALUE; } else if (!space) { parser->state = PARSE_ERROR; }
+        break;
+      }
+
+      case PARSE_VALUE: {
+        parser->valueLength = 0;
+        if      (c == '"')                  { parser->state = PARSE_STRING; }
+        else if ( (c == '{') || (c == '[') ) { parser->state = PARSE_SKIP; parser->depth = 1; parser->inString = false; }
+        else if (!space)                    { parser->state = PARSE_LITERAL; settingsParserAppend(parser, c); }
+        break;
       }
-      yieldTime += yieldOS(); 
+
+      case PARSE_LITERAL: {                                // number, true, false, null
+        if ( (c == ',') || (c == '}') || space ) {
+          parser->value[parser->valueLength] = '\0';
+          applySetting(parser, config, false);
+          parser->state = (c == '}') ? PARSE_DONE : PARSE_KEY;
+        } else {
+          settingsParserAppend(parser, c);
+        }
+        break;
+      }
+
+      case PARSE_SKIP: {                                   // nested object or array
+        if (parser->inString) {
+          if      (parser->escape) { parser->escape = false; }
+          else if (c == '\\')      { parser->escape = true; }
+          else if (c == '"')       { parser->inString = false; }
+        } else if (c == '"')                    { parser->inString = true; }
+        else if ( (c == '{') || (c == '[') )    { parser->depth++; }
+        else if ( (c == '}') || (c == ']') )    { if (--parser->depth == 0) { parser->state = PARSE_KEY; } }
+        break;
+      }
+
+      case PARSE_DONE:  { return true; }
+      default:          { return false; }
     }
   }
+  return (parser->state != PARSE_ERROR);
 }
 
-void loadConfiguration(Settings &config) {
-  if (ESP.getMaxFreeBlockSize() > JSONSIZE) {
-    if (fsOK) {
-      if (LittleFS.exists("/Sensi.json")) {
-        // Open file for reading
-        File cfgFile = LittleFS.open("/Sensi.json", "r");
-      
-        // Allocate a temporary JsonDocument
-        // Use arduinojson.org/v6/assistant to compute the capacity.
-        DynamicJsonDocument doc(JSONSIZE);
-      
-        // Deserialize the JSON document
-        DeserializationError error = deserializeJson(doc, cfgFile);
-        if (error) { printSerialTelnetLogln(F("Failed to read file, using default configuration")); }
-      
-        config.runTime                = doc["runTime"]                              | 0;
-        config.debuglevel             = doc["debuglevel"]                           | 1;
-      
-        config.baselineSGP30_valid    = doc["baselineSGP30_valid"]                  | 0x00;
-        config.baselineeCO2_SGP30     = doc["baselineeCO2_SGP30"]                   | 0;
-        config.baselinetVOC_SGP30     = doc["baselinetVOC_SGP30"]                   | 0;
-        config.baselineCCS811_valid   = doc["baselineCCS811_valid"]                 | 0x00;
-        config.baselineCCS811         = doc["baselineCCS811"]                       | 0;
-        config.tempOffset_SCD30_valid = doc["tempOffset_SCD30_valid"]               | 0x00;
-        config.tempOffset_SCD30       = doc["tempOffset_SCD30"]                     | 0.01;
-        config.forcedCalibration_SCD30_valid = doc["forcedCalibration_SCD30_valid"] | 0x00;
-        config.forcedCalibration_SCD30 = doc["forcedCalibration_SCD30"]             | 0.0;
-        config.tempOffset_MLX_valid   = doc["tempOffset_MLX_valid"]                 | 0x00;
-        config.tempOffset_MLX         = doc["tempOffset_MLX"]                       | 0.0;
-        config.emissivity             = doc["emissivity_MLX"]                       | 0.98;
-      
-        config.useWiFi                = doc["useWiFi"]                              | true;
-        strlcpy(config.ssid1,           doc["ssid1"]                                | "MEDDEV", sizeof(config.ssid1));
-        strlcpy(config.pw1,             doc["pw1"]                                  | "", sizeof(config.pw1));
-        strlcpy(config.ssid2,           doc["ssid2"]                                | "UAGUest", sizeof(config.ssid2));
-        strlcpy(config.pw2,             doc["pw2"]                                  | "", sizeof(config.pw3));
-        strlcpy(config.ssid3,           doc["ssid3"]                                | "MuchoCoolioG", sizeof(config.ssid3));
-        strlcpy(config.pw3,             doc["pw3"]                                  | "", sizeof(config.pw3));
-      
-        config.useMQTT                = doc["useMQTT"]                              | false;
-        strlcpy(config.mqtt_server,     doc["mqtt_server"]                          | "my.mqqtt.server.org", sizeof(config.mqtt_server));
-        strlcpy(config.mqtt_username,   doc["mqtt_username"]                        | "mqtt", sizeof(config.mqtt_username));
-        strlcpy(config.mqtt_password,   doc["mqtt_password"]                        | "", sizeof(config.mqtt_password));
-        strlcpy(config.mqtt_fallback,   doc["mqtt_fallback"]                        | "192.168.1.1", sizeof(config.mqtt_password));
-        strlcpy(config.mqtt_mainTopic,  doc["mqtt_mainTopic"]                       | "Senso", sizeof(config.mqtt_mainTopic));
-        config.sendMQTTimmediate =      doc["sendMQTTimmediate"]                    | true;
-        config.intervalMQTT           = doc["mqtt_interval"]                        | 1.0;
-                
-        config.useLCD                 = doc["useLCD"]                               | true;
-        config.notused                = doc["consumerLCD"]                          | true;
-        config.LCDdisplayType         = doc["LCDdisplayType"]                       | 0;
-        config.useBacklight           = doc["useBacklight"]                         | true;
-        config.useBacklightNight      = doc["useBacklightNight"]                    | false;
-        config.useBlinkNight          = doc["useBlinkNight"]                        | false;
-        config.nightBegin             = doc["nightBegin"]                           | 1320;
-        config.nightEnd               = doc["nightEnd"]                             | 420;
-      
-        config.useSCD30               = doc["useSCD30"]                             | true;
-        config.useSPS30               = doc["useSPS30"]                             | true;
-        config.useSGP30               = doc["useSGP30"]                             | true;
-        config.useMAX30               = doc["useMAX30"]                             | true;
-        config.useMLX                 = doc["useMLX"]                               | true;
-        config.useBME68x              = doc["useBME68x"]                            | true;
-        config.useCCS811              = doc["useCCS811"]                            | true;
-        config.useBME280              = doc["useBME280"]                            | false;
-        config.avgP                   = doc["avgP"]                                 | 90000.0;
-
-        config.useWeather             = doc["useWeather"]                           | false;
-        strlcpy(config.weatherApiKey,   doc["weatherApiKey"]                        | "", sizeof(config.weatherApiKey));
-        strlcpy(config.weatherCity,     doc["weatherCity"]                          | "Tucson", sizeof(config.weatherCity));
-        strlcpy(config.weatherCountryCode, doc["weatherCountryCode"]                | "US", sizeof(config.weatherCountryCode));
-
-        config.useHTTP                = doc["useHTTP"]                              | true;
-        config.useOTA                 = doc["useOTA"]                               | false;
-        config.usemDNS                = doc["usemDNS"]                              | true;
-        config.useHTTPUpdater         = doc["useHTTPUpdater"]                       | false;
-        config.useTelnet              = doc["useTelnet"]                            | false;
-        config.useSerial              = doc["useSerial"]                            | true;
-        config.useLog                 = doc["useLog"]                               | false;
-        
-        config.useNTP                 = doc["useNTP"]                               | true;
-        strlcpy(config.ntpServer,       doc["ntpServer"]                            | "us.pool.ntp.org", sizeof(config.ntpServer));
-        strlcpy(config.ntpFallback,     doc["ntpFallback"]                          | "us.pool.ntp.org", sizeof(config.ntpFallback));
-        strlcpy(config.timeZone,        doc["timeZone"]                             | "MST7", sizeof(config.timeZone));
-        config.rebootMinute           = doc["rebootMinute"]                         | -1;
-      
-        cfgFile.close();   // Close the file 
-      } else { printSerialTelnetLogln(F("Config file does not exist")); }
+/******************************************************************************************************/
+// Settings Journal
+/******************************************************************************************************/
+
+// CRC-16/CCITT
+uint16_t settingsCRC(uint16_t crc, const uint8_t *data, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit=0; bit<8; bit++) { crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1); }
+  }
+  return crc;
+}
+
+uint16_t settingsRecordCRC(SettingsRecord record, const uint8_t *data) {
+  record.crc = 0;
+  return settingsCRC(settingsCRC(0xFFFF, (const uint8_t *)&record, sizeof(record)), data, record.length);
+}
+
+bool writeSettingsRecord(File &file, uint16_t offset, uint16_t length, const uint8_t *data) {
+  SettingsRecord record = { SETTINGS_MAGIC, SETTINGS_VERSION, offset, length, 0 };
+  record.crc = settingsRecordCRC(record, data);
+  return (file.write((const uint8_t *)&record, sizeof(record)) == sizeof(record)) &&
+         (file.write(data, length) == length);
+}
+
+// reads the bytes following a record once to check its CRC, then returns to them
+bool settingsRecordValid(File &file, const SettingsRecord &record) {
+  uint8_t        chunk[32];
+  SettingsRecord header = record;
+  size_t         start  = file.position();
+  header.crc = 0;
+  uint16_t crc = settingsCRC(0xFFFF, (const uint8_t *)&header, sizeof(header));
+  for (uint16_t done=0; done < record.length; ) {
+    uint16_t n = (record.length - done < (uint16_t)sizeof(chunk)) ? record.length - done : (uint16_t)sizeof(chunk);
+    if (file.read(chunk, n) != n) { return false; }
+    crc   = settingsCRC(crc, chunk, n);
+    done += n;
+  }
+  return (crc == record.crc) && file.seek(start);
+}
+
+// Fields are only appended to Settings, a field of the current layout that ends within the length of an
+// older snapshot is taken over from the journal, the others keep their value, e.g. the default.
+void migrateSettings(Settings &config, const uint8_t *stored, uint16_t length) {
+  SettingsField field;
+  for (uint8_t i=0; i<SETTINGS_FIELDS; i++) {
+    memcpy_P(&field, &settingsFields[i], sizeof(field));
+    if ((uint32_t)field.offset + field.size <= length) { memcpy((uint8_t *)&config + field.offset, stored + field.offset, field.size); }
+  }
+}
+
+bool loadSettings(Settings &config) {
+  SettingsRecord record;
+  uint8_t       *stored  = (uint8_t *)&storedSettings;
+  uint16_t       records = 0;
+  uint8_t        version = 0;                              // layout of snapshot
+  uint16_t       length  = 0;                              // of snapshot
+  if (!fsOK) {                                             // no file system, settings are kept in EEPROM
+    loadSettingsEEPROM(config);
+    return true;
+  }
+  settingsJournalSize = 0;                                 // next save starts a new journal unless this one is valid
+  if (!LittleFS.exists(SETTINGS_JOURNAL)) { return false; }
+  File file = LittleFS.open(SETTINGS_JOURNAL, "r");
+  if (!file) { return false; }
+
+  // snapshot, then changed fields applied to storedSettings, records are checked before they are applied
+  while (file.read((uint8_t *)&record, sizeof(record)) == sizeof(record)) {
+    bool valid = (record.magic == SETTINGS_MAGIC) &&
+                 ( (records > 0) ? ( (record.version == version) && ((uint32_t)record.offset + record.length <= length) )
+                                 : ( (record.version > 0) && (record.version <= SETTINGS_VERSION) && (record.offset == 0) &&
+                                     ( (record.version == SETTINGS_VERSION) ? (record.length == sizeof(Settings))
+                                                                            : (record.length <= sizeof(Settings)) ) ) ) &&
+                 settingsRecordValid(file, record) &&
+                 (file.read(stored + record.offset, record.length) == record.length);
+    if (!valid) { break; }
+    if (records == 0) { version = record.version; length = record.length; }
+    if (version == SETTINGS_VERSION) { memcpy((uint8_t *)&config + record.offset, stored + record.offset, record.length); }
+    records++;
+  }
+  bool complete = (file.position() == file.size());
+  size_t size   = file.size();
+  file.close();
+  if (records == 0) { return false; }
+  if (mySettings.debuglevel > 1) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings: %u journal records replayed"), records);
+    R_printSerialLogln(tmpStr);
+  }
+  if (version != SETTINGS_VERSION) {                       // older layout, rewrite as current snapshot
+    migrateSettings(config, stored, length);
+    if (mySettings.debuglevel > 0) {
+      snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings: journal of version %u migrated"), version);
+      R_printSerialLogln(tmpStr);
     }
+    compactSettings(config);
+  } else if (!complete) {                                  // records after a bad one would never be replayed
+    if (mySettings.debuglevel > 0) { R_printSerialLogln(F("Settings: journal damaged, compacting")); }
+    compactSettings(config);
+  } else {
+    settingsJournalSize = size;
   }
+  return true;
+}
+
+// Settings in EEPROM, with the header of a snapshot record when this firmware wrote them.
+// Fields are taken field by field like from a journal of an older layout.
+bool loadSettingsEEPROM(Settings &config) {
+  SettingsRecord record;
+  EEPROM.get(eepromAddress, storedSettings);
+  EEPROM.get(settingsRecordAddress, record);
+  bool     valid  = (record.magic == SETTINGS_MAGIC) && (record.version > 0) && (record.version <= SETTINGS_VERSION) &&
+                    (record.offset == 0) && (record.length <= sizeof(Settings)) &&
+                    (settingsRecordCRC(record, (const uint8_t *)&storedSettings) == record.crc);
+  uint16_t length = valid ? record.length : SETTINGS_EEPROMLENGTH;
+  migrateSettings(config, (const uint8_t *)&storedSettings, length);
+  sanitizeSettings(config);
+  memcpy(&storedSettings, &config, sizeof(Settings));
+  return valid;
+}
+
+// Without file system the settings are written to EEPROM with the header of a snapshot record
+bool saveSettingsEEPROM(const Settings &config) {
+  SettingsRecord record = { SETTINGS_MAGIC, SETTINGS_VERSION, 0, sizeof(Settings), 0 };
+  record.crc = settingsRecordCRC(record, (const uint8_t *)&config);
+  SettingsRecord stored = { 0, 0, 0, 0, 0 };
+  EEPROM.get(settingsRecordAddress, stored);
+  if ( (memcmp(&stored, &record, sizeof(record)) == 0) && (memcmp(&storedSettings, &config, sizeof(Settings)) == 0) ) { return true; }
+  EEPROM.put(eepromAddress, config);
+  EEPROM.put(settingsRecordAddress, record);
+  bool ok = EEPROM.commit();
+  if (ok) { memcpy(&storedSettings, &config, sizeof(Settings)); }
+  if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(ok ? F("Settings: written to EEPROM") : F("Settings: EEPROM failed to commit")); }
+  return ok;
+}
+
+bool saveSettings(const Settings &config) {
+  const uint8_t *current = (const uint8_t *)&config;
+  const uint8_t *stored  = (const uint8_t *)&storedSettings;
+  if (!fsOK) { return saveSettingsEEPROM(config); }
+  if (settingsJournalSize == 0) { return compactSettings(config); }
+
+  // count bytes needed for changed ranges, ranges closer than SETTINGS_GAP are merged
+  size_t needed = 0;
+  for (size_t i=0, start=0, end=0; i<=sizeof(Settings); i++) {
+    bool changed = (i < sizeof(Settings)) && (current[i] != stored[i]);
+    if (changed)  { if (end == 0) { start = i; } end = i + 1; }
+    if ( (end > 0) && ( (i == sizeof(Settings)) || (i >= end + SETTINGS_GAP) ) ) { needed += sizeof(SettingsRecord) + end - start; end = 0; }
+  }
+  if (needed == 0) { return true; }
+  if (settingsJournalSize + needed > SETTINGS_JOURNALSIZE) { return compactSettings(config); }
+
+  File file = LittleFS.open(SETTINGS_JOURNAL, "a");
+  if (!file) { return false; }
+  bool ok = true;
+  for (size_t i=0, start=0, end=0; ok && (i<=sizeof(Settings)); i++) {
+    bool changed = (i < sizeof(Settings)) && (current[i] != stored[i]);
+    if (changed)  { if (end == 0) { start = i; } end = i + 1; }
+    if ( (end > 0) && ( (i == sizeof(Settings)) || (i >= end + SETTINGS_GAP) ) ) {
+      ok  = writeSettingsRecord(file, start, end - start, current + start);
+      end = 0;
+    }
+  }
+  settingsJournalSize = file.size();
+  file.close();
+  if (ok) { memcpy(&storedSettings, &config, sizeof(Settings)); }
+  if (mySettings.debuglevel > 1) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings: %u bytes appended to journal"), (unsigned int)needed);
+    R_printSerialTelnetLogln(tmpStr);
+  }
+  return ok;
+}
+
+bool compactSettings(const Settings &config) {
+  if (!fsOK) { return saveSettingsEEPROM(config); }
+  File file = LittleFS.open(SETTINGS_COMPACT, "w");
+  if (!file) { return false; }
+  bool ok = writeSettingsRecord(file, 0, sizeof(Settings), (const uint8_t *)&config);
+  file.close();
+  if (ok) { ok = LittleFS.rename(SETTINGS_COMPACT, SETTINGS_JOURNAL); }
+  if (ok) {
+    memcpy(&storedSettings, &config, sizeof(Settings));
+    settingsJournalSize = sizeof(SettingsRecord) + sizeof(Settings);
+    if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("Settings: journal compacted")); }
+  } else {
+    LittleFS.remove(SETTINGS_COMPACT);
+    if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("Settings: could not write journal")); }
+  }
+  return ok;
+}
+
+// When EEPROM is used for the first time, it has random content.
+// A boolen seems to use one byte of memory in the EEPROM and when you read from EEPROM to a boolen variable 
+// it can become uint_8. When the program sets these boolean values from true to false, it will convert 
+// from true=255 to 254 and not to 0/false.
+// Settings from the EEPROM need any non zero value for boolean settings forced to true.
+// Settings replayed from the journal were validated and do not need this.
+void sanitizeSettings(Settings &config) {
+  if (config.useLCD            > 0) { config.useLCD            = true; } else { config.useLCD              = false; }
+  if (config.useWiFi           > 0) { config.useWiFi           = true; } else { config.useWiFi             = false; }
+  if (config.useSCD30          > 0) { config.useSCD30          = true; } else { config.useSCD30            = false; }
+  if (config.useSPS30          > 0) { config.useSPS30          = true; } else { config.useSPS30            = false; }
+  if (config.useMAX30          > 0) { config.useMAX30          = true; } else { config.useMAX30            = false; }
+  if (config.useMLX            > 0) { config.useMLX            = true; } else { config.useMLX              = false; }
+  if (config.useBME68x         > 0) { config.useBME68x         = true; } else { config.useBME68x           = false; }
+  if (config.useBME280         > 0) { config.useBME280         = true; } else { config.useBME280           = false; }
+  if (config.useCCS811         > 0) { config.useCCS811         = true; } else { config.useCCS811           = false; }
+  if (config.sendMQTTimmediate > 0) { config.sendMQTTimmediate = true; } else { config.sendMQTTimmediate   = false; }
+  if (config.notused           > 0) { config.notused           = true; } else { config.notused             = false; }
+  if (config.useBacklight      > 0) { config.useBacklight      = true; } else { config.useBacklight        = false; }
+  if (config.useBacklightNight > 0) { config.useBacklightNight = true; } else { config.useBacklightNight   = false; }
+  if (config.useBlinkNight     > 0) { config.useBlinkNight     = true; } else { config.useBlinkNight       = false; }
+  if (config.useHTTP           > 0) { config.useHTTP           = true; } else { config.useHTTP             = false; }
+  if (config.useHTTPUpdater    > 0) { config.useHTTPUpdater    = true; } else { config.useHTTPUpdater      = false; }
+  if (config.useNTP            > 0) { config.useNTP            = true; } else { config.useNTP              = false; }
+  if (config.useMQTT           > 0) { config.useMQTT           = true; } else { config.useMQTT             = false; }
+  if (config.useOTA            > 0) { config.useOTA            = true; } else { config.useOTA              = false; }
+  if (config.usemDNS           > 0) { config.usemDNS           = true; } else { config.usemDNS             = false; }
+  if (config.useTelnet         > 0) { config.useTelnet         = true; } else { config.useTelnet           = false; }
+  if (config.useSerial         > 0) { config.useSerial         = true; } else { config.useSerial           = false; }
+  if (config.useLog            > 0) { config.useLog            = true; } else { config.useLog              = false; }
+  if (config.useWeather        > 0) { config.useWeather        = true; } else { config.useWeather          = false; }
 }
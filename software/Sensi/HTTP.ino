@@ -5,31 +5,78 @@
 #include "src/HTTP.h"
 #include "src/Sensi.h"
 #include "src/Config.h"
-#include "src/bme280.h"
-#include "src/bme68x.h"
-#include "src/ccs811.h"
-#include "src/scd30.h"
-#include "src/sgp30.h"
-#include "src/sps30.h"
+#include "src/BME280.h"
+#include "src/BME68x.h"
+#include "src/CCS811.h"
+#include "src/SCD30.h"
+#include "src/SGP30.h"
+#include "src/SPS30.h"
 #include "src/Weather.h"
 #include "src/MLX.h"
 #include "src/MAX30.h"
 #include "src/Print.h"
+#include "src/Profile.h"
+#include "src/History.h"
+#include "src/Archive.h"
+#include "src/Telemetry.h"
 
 // #define intervalHTTP      100                  // NOT USER, NO LOOP DELAY, We check for HTTP requests every 0.1 seconds
 unsigned long lastHTTP;                           // last time we checked for http requests
 volatile      WiFiStates stateHTTP = IS_WAITING;  // keeping track of webserver state
 String        getContentType(String filename);    // convert the file extension to the MIME type
 
-ESP8266WebServer httpServer(80);                           // Server on port 80
+NonBlockingWebServer httpServer(80);                       // Server on port 80, never waits for a browser
+uint32_t archiveRequest = 0;                               // request streaming the archive, it has one export cursor
 
 // Extern variables
 extern unsigned long yieldTime;        // Sensi
 extern unsigned long lastYield;        // Sensi
 extern Settings      mySettings;       // Config
 extern unsigned long currentTime;      // Sensi
-extern unsigned long AllmaxUpdateHTTP; // Sensi
 extern char          tmpStr[256];           // Sensi
+extern uint32_t      sampleSequence;        // Sensi
+extern bool          fsOK;                  // Sensi
+extern bool          bme280_avail;          // BME280
+extern bool          bme68x_avail;          // BME68x
+extern bool          ccs811_avail;          // CCS811
+extern bool          scd30_avail;           // SCD30
+extern bool          sgp30_avail;           // SGP30
+extern bool          sps30_avail;           // SPS30
+extern bool          therm_avail;           // MLX
+extern bool          max30_avail;           // MAX30
+extern bool          weather_avail;         // Weather
+
+HTTPFile httpFiles[HTTP_MAXFILES];                 // web assets on LittleFS
+uint8_t  httpFileCount = 0;
+
+const char httpMimeExtensions[][6] PROGMEM = {
+  ".htm", ".html", ".css", ".js", ".png", ".gif", ".jpg", ".ico", ".xml", ".json", ".pdf", ".zip", ".gz"};
+const uint8_t httpExtensionMime[] PROGMEM = {
+  HTTP_MIME_HTML, HTTP_MIME_HTML, HTTP_MIME_CSS, HTTP_MIME_JS, HTTP_MIME_PNG, HTTP_MIME_GIF, HTTP_MIME_JPEG, HTTP_MIME_ICON,
+  HTTP_MIME_XML, HTTP_MIME_JSON, HTTP_MIME_PDF, HTTP_MIME_ZIP, HTTP_MIME_GZIP};
+const char httpMimeTypes[HTTP_MIMETYPES][HTTP_MIMELENGTH] PROGMEM = {
+  "text/html", "text/css", "application/javascript", "image/png", "image/gif", "image/jpeg", "image/x-icon",
+  "text/plain", "text/xml", "text/json", "application/x-pdf", "application/x-zip", "application/x-gzip"};
+
+const char httpBlockNames[HTTP_APIBLOCKS][HTTP_APINAMELENGTH] PROGMEM = {
+  "system", "time", "date", "hostname", "ip", "bme280", "bme68x", "ccs811", "scd30", "sgp30", "sps30", "mlx", "max30", "weather"};
+
+const HTTPBlock httpBlocks[HTTP_APIBLOCKS] = {
+  { NULL,           systemJSON   },
+  { NULL,           timeJSON     },
+  { NULL,           dateJSON     },
+  { NULL,           hostnameJSON },
+  { NULL,           ipJSON       },
+  { &bme280_avail,  bme280JSON   },
+  { &bme68x_avail,  bme68xJSON   },
+  { &ccs811_avail,  ccs811JSON   },
+  { &scd30_avail,   scd30JSON    },
+  { &sgp30_avail,   sgp30JSON    },
+  { &sps30_avail,   sps30JSON    },
+  { &therm_avail,   mlxJSON      },
+  { &max30_avail,   max30JSON    },
+  { &weather_avail, weatherJSON  }
+};
 
 //Example web applications
 //  https://www.mischianti.org/2020/05/24/rest-server-on-esp8266-and-esp32-get-and-json-formatter-part-2/
@@ -71,10 +118,17 @@ void initializeHTTP(){
   httpServer.on("/wifi",     handleWiFi);          
   httpServer.on("/config",   handleConfig);
   httpServer.on("/system",   handleSystem);
+  httpServer.on("/profile",  handleProfile);
+  httpServer.on("/history",  handleHistory);
+  httpServer.on("/archive",  handleArchive);
+  httpServer.on("/schema",   handleSchema);
+  httpServer.on("/api/all",  handleAPIAll);
   httpServer.on("/edit",     handleEdit);
   httpServer.on("/upload",   HTTP_GET, []() { if (!handleFileRead("/upload.htm")) httpServer.send(404, "text/plain", "404: Not Found"); });        
   httpServer.on("/upload",   HTTP_POST, [](){ httpServer.send(200); }, handleFileUpload );
   httpServer.onNotFound(     handleNotFound);      // When a client requests an unknown URI (i.e. something other than "/"), call function "handleNotFound"
+  const char *headerKeys[] = {"If-None-Match"};
+  httpServer.collectHeaders(headerKeys, 1);        // request headers are dropped unless collected
   delay(50); lastYield = millis();
 }
 
@@ -100,10 +154,11 @@ void updateHTTP() {
       if ((currentTime - lastHTTP) >= intervalWiFi) {        
         lastHTTP = currentTime;
         D_printSerialTelnet(F("D:U:HTTP:S.."));
+        indexFiles();
         httpServer.begin();                              // Start server
         if (mySettings.debuglevel  > 0) { R_printSerialTelnetLogln(F("HTTP Server: initialized")); }
         stateHTTP = CHECK_CONNECTION;
-        AllmaxUpdateHTTP = 0;
+        resetProfile(PROFILE_HTTP);
       }
       break;
     }
@@ -132,11 +187,98 @@ void handleAnimation() {
   if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: animation request received")); }
 }
 
+// Current settings in the layout of Sensi.json, streamed line by line from settingsJSON
 void handleConfig() {
-  handleFileRead("/Sensi.json"); 
+  char   HTTPpayloadStr[256];
+  size_t l = 0, n;
+  httpServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  httpServer.send(200, "text/json", "");
+  for (uint16_t i=0; ; i++) {
+    n = settingsJSON(i, mySettings, HTTPpayloadStr+l, sizeof(HTTPpayloadStr)-l);
+    if ( (l > 0) && (l + n >= sizeof(HTTPpayloadStr)-1) ) { // line did not fit, send what we have and repeat it
+      httpServer.sendContent(HTTPpayloadStr, l);
+      l = 0;
+      yieldTime += yieldOS();
+      n = settingsJSON(i, mySettings, HTTPpayloadStr, sizeof(HTTPpayloadStr));
+    }
+    if (n == 0) { break; }
+    l += n;
+  }
+  if (l > 0) { httpServer.sendContent(HTTPpayloadStr, l); }
+  httpServer.sendContent("");                      // end of chunked transfer
   if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: config request received")); }
 }
 
+// Keys and scaling of the MessagePack sensor messages
+void handleSchema() {
+  char HTTPpayloadStr[TELEMETRY_SCHEMALENGTH];
+  httpServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  httpServer.send(200, "text/json", "");
+  for (uint8_t i=0; i<TELEMETRY_SCHEMAFIELDS; i++) {
+    size_t l = telemetrySchemaJSON(i, HTTPpayloadStr, sizeof(HTTPpayloadStr));
+    httpServer.sendContent(HTTPpayloadStr, l);
+  }
+  httpServer.sendContent("");                      // end of chunked transfer
+  if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: schema request received")); }
+}
+
+// /api/all?fields=scd30,time
+// { "system": {...}, "queue": {...}, "time": {...}, "date": {...}, "hostname": "...", "ip": "...", "scd30": {...}, ...}
+// Each block is the single endpoint's object without its braces, sent as separate chunk
+void handleAPIAll() {
+  char     HTTPpayloadStr[HTTP_APIBLOCKLENGTH];
+  char     etag[24];
+  uint16_t blocks = apiFields(httpServer.arg("fields").c_str());
+  for (uint8_t i=0; i<HTTP_APIBLOCKS; i++) {
+    if (!apiBlockAvailable(i)) { blocks &= ~(1U << i); }
+  }
+  httpServer.sendHeader("Cache-Control", "no-cache");  // browser revalidates with If-None-Match
+  if ((blocks & HTTP_VOLATILEBLOCKS) == 0) {           // heap, queue and seconds change without a new sample
+    snprintf_P(etag, sizeof(etag), PSTR("W/\"%lu-%x\""), (unsigned long)sampleSequence, blocks);
+    httpServer.sendHeader("ETag", etag);
+    if (httpServer.header("If-None-Match") == etag) {
+      httpServer.send(304);
+      if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: api request received. Not modified")); }
+      return;
+    }
+  }
+  httpServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  httpServer.send(200, "text/json", "{");
+  bool first = true;
+  for (uint8_t i=0; i<HTTP_APIBLOCKS; i++) {
+    if ((blocks & (1U << i)) == 0) { continue; }
+    httpBlocks[i].json(HTTPpayloadStr, sizeof(HTTPpayloadStr));
+    char  *start = strchr(HTTPpayloadStr, '{');                 // strip the braces of the single endpoint
+    char  *end   = strrchr(HTTPpayloadStr, '}');
+    if ((start == NULL) || (end <= start)) { continue; }
+    *start = first ? ' ' : ',';
+    httpServer.sendContent(start, end - start);
+    first = false;
+    yieldTime += yieldOS();
+  }
+  httpServer.sendContent("}");
+  httpServer.sendContent("");                      // end of chunked transfer
+  if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: api request received")); }
+}
+
+bool apiBlockAvailable(uint8_t block) {
+  return (httpBlocks[block].avail == NULL) || *httpBlocks[block].avail;
+}
+
+uint16_t apiFields(const char *fields) {
+  if (*fields == '\0') { return (1U << HTTP_APIBLOCKS) - 1; }
+  uint16_t blocks = 0;
+  while (*fields != '\0') {
+    size_t n = strcspn(fields, ",");
+    for (uint8_t i=0; i<HTTP_APIBLOCKS; i++) {
+      if ((n == strlen_P(httpBlockNames[i])) && (strncmp_P(fields, httpBlockNames[i], n) == 0)) { blocks |= 1U << i; }
+    }
+    fields += n;
+    if (*fields == ',') { fields++; }
+  }
+  return blocks;
+}
+
 void handleNotFound(){
   if (!handleFileRead(httpServer.uri())) {    // check if the file exists in the flash memory, if so, send it
    String message = "File Not Found \r\n\n";
@@ -162,15 +304,118 @@ void handleEdit(){
   yieldTime += yieldOS(); 
 }
 
-// { "system": { "freeheap": 30000, "heapfragmentation": 33, "maxfreeblock": 30000,"maxlooptime": 10000}}
+// { "system": { "freeheap": 30000, "heapfragmentation": 33, "maxfreeblock": 30000,"maxlooptime": 10000}, "queue": {"depth": 0, ...}}
 void handleSystem() {
-  char HTTPpayloadStr[128];  
+  char HTTPpayloadStr[256];  
   systemJSON(HTTPpayloadStr, sizeof(HTTPpayloadStr));
   httpServer.send(200, "text/json", HTTPpayloadStr);
   if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("HTTP: system request received. Sent: %u"), strlen(HTTPpayloadStr)); R_printSerialTelnetLogln(tmpStr); }
   yieldTime += yieldOS(); 
 }
 
+// { "profile": { "Time&Date": {"count": 1234, "avg": 123, "p50": 128, "p95": 512, "p99": 1024, "max": 900, "hist": [1,2,...,16]}, "WiFi": {...}, ...}}
+// Too large for a single buffer, subsystems are produced as the browser takes them, as many as fit in one chunk
+void handleProfile() {
+  httpServer.sendChunked(200, "text/json", [i = -1](char *payLoad, size_t len) mutable -> size_t {
+    size_t l = 0;
+    if (i < 0) {
+      l = snprintf_P(payLoad, len, PSTR("{ \"profile\": {"));
+      i = 0;
+    }
+    while ((i < NUMPROFILES) && (l < len - 320)) {          // a subsystem takes at most 320 chars
+      payLoad[l] = (i == 0) ? ' ' : ',';
+      profileJSON(i++, payLoad+l+1, 319);
+      l += strlen(payLoad+l);
+    }
+    if ((i == NUMPROFILES) && (l < len - 3)) {
+      l += snprintf_P(payLoad+l, len-l, PSTR("}}"));
+      i++;
+    }
+    return l;
+  });
+  if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: profile request received")); }
+  yieldTime += yieldOS(); 
+}
+
+// /history?ch=scd30.CO2&res=60
+// { "history": { "ch": "scd30.CO2", "res": 60, "age": 12, "fields": ["min","mean","max"], "data": [[400,410,420],...]}}
+// without ch: { "history": { "scd30.CO2": [{"res": 1, "n": 120, "depth": 600}, ...], ...}}
+// Samples are produced from the history rings as the browser takes them, many samples in one chunk
+void handleHistory() {
+  char   HTTPpayloadStr[256];
+  if (httpServer.hasArg("ch") == false) {
+    httpServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    httpServer.send(200, "text/json", "{ \"history\": {");
+    bool first = true;
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+      if (historyCount(i, 0) == 0) { continue; }
+      HTTPpayloadStr[0] = first ? ' ' : ',';
+      historyChannelJSON(i, HTTPpayloadStr+1, sizeof(HTTPpayloadStr)-1);
+      httpServer.sendContent(HTTPpayloadStr);
+      first = false;
+    }
+    httpServer.sendContent("}}");
+  } else {
+    int8_t channel = historyChannel(httpServer.arg("ch").c_str());
+    if (channel < 0) {
+      httpServer.send(404, "text/plain", "404: Channel not recorded");
+      return;
+    }
+    uint8_t  tier  = historyTier(httpServer.hasArg("res") ? strtoul(httpServer.arg("res").c_str(), NULL, 10) : 60);
+    uint16_t count = historyCount(channel, tier);
+    // a sample recorded while the browser is still reading shifts the ring by one, the header tells the age at the start
+    httpServer.sendChunked(200, "text/json", [channel, tier, count, i = -1](char *payLoad, size_t len) mutable -> size_t {
+      size_t l = 0;
+      if (i < 0) {
+        historyHeaderJSON(channel, tier, payLoad, len);
+        l = strlen(payLoad);
+        i = 0;
+      }
+      while ((i < count) && (l < len - 32)) {               // a sample takes at most 30 chars
+        if (i > 0) { payLoad[l++] = ','; }
+        l += historySampleJSON(channel, tier, i++, payLoad+l, len-l);
+      }
+      if ((i == count) && (l < len - 4)) {
+        l += snprintf_P(payLoad+l, len-l, PSTR("]}}"));
+        i++;
+      }
+      return l;
+    });
+    if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: history request received")); }
+    yieldTime += yieldOS();
+    return;
+  }
+  httpServer.sendContent("");                      // end of chunked transfer
+  if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: history request received")); }
+  yieldTime += yieldOS(); 
+}
+
+// /archive?from=1767225600&to=1767312000&format=csv  time range as epoch [s], default last 24 hours, csv or ndjson
+// Records are decoded as the browser takes them, one export at a time
+void handleArchive() {
+  if (httpServer.active(archiveRequest)) {
+    httpServer.sendHeader("Retry-After", "5");
+    httpServer.send(503, "text/plain", "503: Archive export in progress");
+    return;
+  }
+  uint32_t to     = httpServer.hasArg("to")   ? strtoul(httpServer.arg("to").c_str(),   NULL, 10) : (uint32_t)time(NULL);
+  uint32_t from   = httpServer.hasArg("from") ? strtoul(httpServer.arg("from").c_str(), NULL, 10) : to - 86400;
+  uint8_t  format = (httpServer.arg("format") == "ndjson") ? ARCHIVE_NDJSON : ARCHIVE_CSV;
+  if (!archiveOpen(from, to, format)) {
+    httpServer.send(404, "text/plain", "404: No data in time range");
+    return;
+  }
+  archiveRequest = httpServer.requestId();
+  httpServer.sendChunked(200, (format == ARCHIVE_CSV) ? "text/csv" : "application/x-ndjson", [](char *payLoad, size_t len) -> size_t {
+    size_t l = 0;
+    size_t n;
+    while ((l < len - 48) && ((n = archiveExport(payLoad+l, len-l)) > 0)) { l += n; } // a field takes at most 40 chars
+    return l;
+  });
+  if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("HTTP: archive request received")); }
+  yieldTime += yieldOS(); 
+}
+
 // { "time": { "hour": 20, "minute": 19, "second": 18, "microsecond": 648567}}
 void handleTime() {
   char HTTPpayloadStr[96]; 
@@ -302,35 +547,150 @@ void handleWeather() {
 }
 
 String getContentType(String filename){
-  if (httpServer.hasArg("download"))  return "application/octet-stream";
-  else if(filename.endsWith(".htm"))  return "text/html";
-  else if(filename.endsWith(".html")) return "text/html";
-  else if(filename.endsWith(".css"))  return "text/css";
-  else if(filename.endsWith(".js"))   return "application/javascript";
-  else if(filename.endsWith(".png"))  return "image/png";
-  else if(filename.endsWith(".gif"))  return "image/gif";
-  else if(filename.endsWith(".jpg"))  return "image/jpeg";
-  else if(filename.endsWith(".ico"))  return "image/x-icon";
-  else if(filename.endsWith(".xml"))  return "text/xml";
-  else if(filename.endsWith(".json")) return "text/json";
-  else if(filename.endsWith(".pdf"))  return "application/x-pdf";
-  else if(filename.endsWith(".zip"))  return "application/x-zip";
-  else if(filename.endsWith(".gz"))   return "application/x-gzip";
-  return "text/plain";
+  if (httpServer.hasArg("download")) { return "application/octet-stream"; }
+  char type[HTTP_MIMELENGTH];
+  strncpy_P(type, httpMimeTypes[mimeType(filename.c_str())], sizeof(type));
+  return type;
+}
+
+uint8_t mimeType(const char *path) {
+  const char *extension = strrchr(path, '.');
+  if (extension == NULL) { return HTTP_MIME_TEXT; }
+  for (uint8_t i=0; i<sizeof(httpExtensionMime); i++) {
+    if (strcmp_P(extension, httpMimeExtensions[i]) == 0) { return pgm_read_byte(&httpExtensionMime[i]); }
+  }
+  return HTTP_MIME_TEXT;
+}
+
+// One pass over the root directory, the hash reads each asset once. A compressed version replaces the plain one.
+void indexFiles() {
+  char    path[HTTP_PATHLENGTH];
+  httpFileCount = 0;
+  if (!fsOK) { return; }
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    if (dir.isDirectory()) { continue; }
+    snprintf_P(path, sizeof(path), PSTR("/%s"), dir.fileName().c_str());
+    if (strchr(path+1, '/') != NULL) { continue; }                      // not in root
+    size_t l  = strlen(path);
+    bool   gz = (l > 3) && (strcmp_P(path+l-3, PSTR(".gz")) == 0);
+    if (gz) { path[l-3] = '\0'; }
+    uint8_t mime = mimeType(path);
+    if (mime > HTTP_MIME_CACHED) { continue; }
+    int8_t i = fileIndex(path);
+    if (i < 0) {
+      if (httpFileCount >= HTTP_MAXFILES) {
+        if (mySettings.debuglevel > 0) { R_printSerialTelnetLog(F("HTTP: file index full, not indexed: ")); printSerialTelnetLogln(path); }
+        continue;
+      }
+      i = httpFileCount++;
+    } else if (httpFiles[i].gz && !gz) {
+      continue;                                                         // compressed version already indexed
+    }
+    File file = dir.openFile("r");
+    hashFile(&httpFiles[i], path, gz, mime, file);
+    file.close();
+    yieldTime += yieldOS();
+  }
+  if (mySettings.debuglevel > 0) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("HTTP: %u files indexed"), httpFileCount); R_printSerialTelnetLogln(tmpStr); }
+}
+
+// After an upload, write or delete only the asset touched is hashed again, or dropped when neither version is left
+void indexFile(const char *name) {
+  char    path[HTTP_PATHLENGTH];
+  char    gzPath[HTTP_PATHLENGTH+3];
+  if (!fsOK) { return; }
+  strlcpy(path, name, sizeof(path));
+  size_t  l = strlen(path);
+  if ((l > 3) && (strcmp_P(path+l-3, PSTR(".gz")) == 0)) { path[l-3] = '\0'; }
+  if ((path[0] != '/') || (strchr(path+1, '/') != NULL)) { return; }  // not in root
+  uint8_t mime = mimeType(path);
+  if (mime > HTTP_MIME_CACHED) { return; }
+  int8_t  i = fileIndex(path);
+  snprintf_P(gzPath, sizeof(gzPath), PSTR("%s.gz"), path);
+  bool    gz = LittleFS.exists(gzPath);
+  File    file = LittleFS.open(gz ? gzPath : path, "r");
+  if (!file) {
+    if (i >= 0) { httpFiles[i] = httpFiles[--httpFileCount]; }          // last entry takes its place
+    return;
+  }
+  if (i < 0) {
+    if (httpFileCount >= HTTP_MAXFILES) {
+      if (mySettings.debuglevel > 0) { R_printSerialTelnetLog(F("HTTP: file index full, not indexed: ")); printSerialTelnetLogln(path); }
+      file.close();
+      return;
+    }
+    i = httpFileCount++;
+  }
+  hashFile(&httpFiles[i], path, gz, mime, file);
+  file.close();
+  yieldTime += yieldOS();
+}
+
+void hashFile(HTTPFile *f, const char *path, bool gz, uint8_t mime, File &file) {
+  uint8_t buf[256];
+  int     n;
+  strlcpy(f->path, path, sizeof(f->path));
+  f->gz   = gz;
+  f->mime = mime;
+  f->hash = 2166136261UL;
+  f->size = 0;
+  while ((n = file.read(buf, sizeof(buf))) > 0) {
+    for (int j=0; j<n; j++) { f->hash = (f->hash ^ buf[j]) * 16777619UL; }
+    f->size += n;
+  }
+}
+
+int8_t fileIndex(const char *path) {
+  for (uint8_t i=0; i<httpFileCount; i++) {
+    if (strcmp(path, httpFiles[i].path) == 0) { return i; }
+  }
+  return -1;
+}
+
+// false when the asset is gone, nothing has been sent then and the caller looks it up on LittleFS
+bool sendIndexedFile(uint8_t index) {
+  HTTPFile *f = &httpFiles[index];
+  char      etag[12];
+  char      path[HTTP_PATHLENGTH+3];
+  snprintf_P(etag, sizeof(etag), PSTR("\"%08lx\""), (unsigned long)f->hash);
+  if (f->mime == HTTP_MIME_HTML) {
+    strcpy_P(tmpStr, PSTR("no-cache"));
+  } else {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("max-age=%lu"), (unsigned long)HTTP_ASSETAGE);
+  }
+  if (httpServer.header("If-None-Match") == etag) {
+    httpServer.sendHeader("ETag", etag);
+    httpServer.sendHeader("Cache-Control", tmpStr);
+    httpServer.send(304);
+    if (mySettings.debuglevel == 3) { R_printSerialTelnetLog(F("HTTP: not modified: ")); printSerialTelnetLogln(f->path); }
+    return true;
+  }
+  snprintf_P(path, sizeof(path), f->gz ? PSTR("%s.gz") : PSTR("%s"), f->path);
+  File file = LittleFS.open(path, "r");
+  if (!file) {                                                          // changed since it was indexed
+    indexFile(path);
+    return false;
+  }
+  httpServer.sendHeader("ETag", etag);
+  httpServer.sendHeader("Cache-Control", tmpStr);
+  httpServer.streamFile(file, getContentType(f->path));               // sent as the client takes it, the server closes the file
+  yieldTime += yieldOS(); 
+  return true;
 }
 
 // send the right file to the client (if it exists)
 bool handleFileRead(String filePath) { 
   if (mySettings.debuglevel == 3) { R_printSerialTelnetLog(F("handleFileRead: ")); printSerialTelnetLog(filePath); }
   if (filePath.endsWith("/")) filePath += "index.htm";                // If a folder is requested, send the index file
+  int8_t index = fileIndex(filePath.c_str());
+  if ((index >= 0) && sendIndexedFile(index)) { return true; }
   String contentType = getContentType(filePath);                      // Get the MIME type
   String filePathWithGz = filePath + ".gz";                           // Also check for compressed version
   if (LittleFS.exists(filePathWithGz) || LittleFS.exists(filePath)) { // If either file exists
     if(LittleFS.exists(filePathWithGz)) {filePath = filePathWithGz;}  // If there's a compressed version available, use the compressed version
     File file = LittleFS.open(filePath, "r");                         // Open it
-    size_t sent = httpServer.streamFile(file, contentType);           // And send it to the client
-    if (sent != file.size()) { if (mySettings.debuglevel > 0) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("HTTP: Error sent less data than expected: %lu %lu"), sent, file.size()); R_printSerialTelnetLogln(tmpStr); } }
-    file.close();                                                     // Then close the file again
+    httpServer.streamFile(file, contentType);                         // And send it as the client takes it, the server closes the file
     yieldTime += yieldOS(); 
     return true;
   } else {
@@ -346,7 +706,7 @@ bool handleFileRead(String filePath) {
 void handleFileUpload() { // upload a new file to the SPIFFS
   HTTPUpload& upload = httpServer.upload();
   String upfilePath;
-  File uploadFile;
+  static File uploadFile;                                             // kept open from start to end of the upload
   if (upload.status == UPLOAD_FILE_START) {
     upfilePath = upload.filename;
     if (!upfilePath.startsWith("/")) upfilePath = "/" + upfilePath;
@@ -373,6 +733,9 @@ void handleFileUpload() { // upload a new file to the SPIFFS
   } else if (upload.status == UPLOAD_FILE_END) {
     if (uploadFile) {                                                 // If the file was successfully created
       uploadFile.close();                                             // Close the file again
+      upfilePath = upload.filename;
+      if (!upfilePath.startsWith("/")) upfilePath = "/" + upfilePath;
+      indexFile(upfilePath.c_str());                                  // hash the new version, or the .gz it removed
       if (mySettings.debuglevel == 3) {
         snprintf_P(tmpStr, sizeof(tmpStr), PSTR("handleFileUpload Size: %lu"), upload.totalSize); 
         R_printSerialTelnetLogln(tmpStr);
@@ -5,6 +5,7 @@
 #include "src/HTTPUpdater.h"
 #include "src/Sensi.h"
 #include "src/Config.h"
+#include "src/Profile.h"
 
 // #define intervalHTTPUpdater 1000
 //
@@ -23,7 +24,6 @@ extern unsigned long lastYield;        // Sensi
 extern Settings      mySettings;       // Config
 extern unsigned long currentTime;      // Sensi
 extern char          tmpStr[256];           // Sensi
-extern unsigned long maxUpdateHTTPUPDATER; // Sensi
 
 void initializeHTTPUpdater() {
   D_printSerialTelnet(F("D:U:HTTPUpdater:IN.."));
@@ -59,7 +59,7 @@ void updateHTTPUpdater() {
         }
         if (mySettings.debuglevel  > 0) { R_printSerialTelnetLogln(F("HTTP Update Server: initialized")); }
         stateHTTPUpdater = CHECK_CONNECTION;
-        maxUpdateHTTPUPDATER = 0;
+        resetProfile(PROFILE_HTTPUPDATER);
       }
       break;
     }
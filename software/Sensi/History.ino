@@ -0,0 +1,354 @@
+/******************************************************************************************************/
+// Sensor History
+/******************************************************************************************************/
+#include "src/History.h"
+#include "src/Config.h"
+#include "src/Sensi.h"
+#include "src/Print.h"
+#include "src/SCD30.h"
+#include "src/SGP30.h"
+#include "src/CCS811.h"
+#include "src/SPS30.h"
+#include "src/BME280.h"
+#include "src/BME68x.h"
+#include "src/MLX.h"
+
+// External Variables
+extern Settings      mySettings;       // Config
+extern unsigned long yieldTime;        // Sensi
+extern char          tmpStr[256];      // Sensi
+extern bool          scd30_avail;      // SCD30
+extern uint16_t      scd30_ppm;
+extern float         scd30_hum;
+extern float         scd30_temp;
+extern bool          sgp30_avail;      // SGP30
+extern SGP30         sgp30;
+extern bool          ccs811_avail;     // CCS811
+extern CCS811        ccs811;
+extern bool          sps30_avail;      // SPS30
+extern sps30_measurement valSPS30;
+extern bool          bme280_avail;     // BME280
+extern float         bme280_pressure;
+extern float         bme280_hum;
+extern float         bme280_temp;
+extern bool          bme68x_avail;     // BME68x
+extern bme68xData    bme68x;
+extern bool          therm_avail;      // MLX
+extern IRTherm       therm;
+extern float         mlxOffset;
+
+const HistoryTier historyTiers[HISTORY_TIERS] = {
+  {    1,  600, 60, 1},                                    // 10 minutes of readings, at least 1 minute
+  {   60, 1440, 60, 3},                                    // 24 hours of min, mean, max, at least 1 hour
+  { 3600,  168, 24, 3}                                     // 1 week of min, mean, max, at least 1 day
+};
+
+const char historyNames[HISTORY_CHANNELS][HISTORY_NAMELENGTH] PROGMEM = {
+  "scd30.CO2", "scd30.rH", "scd30.T",
+  "sgp30.eCO2", "sgp30.tVOC", "ccs811.eCO2", "ccs811.tVOC",
+  "sps30.PM1", "sps30.PM2", "sps30.PM4", "sps30.PM10",
+  "bme280.p", "bme280.rH", "bme280.T",
+  "bme68x.p", "bme68x.rH", "bme68x.T", "bme68x.resistance",
+  "mlx.To", "mlx.Ta"};
+
+// units as in the JSON of the sensor, pressure in hPa, resistance in Ohm
+HistorySource historySources[HISTORY_CHANNELS] = {
+  { &scd30_avail,  []() -> float { return float(scd30_ppm); },              1.0,    0.0, 0 },
+  { &scd30_avail,  []() -> float { return scd30_hum; },                     0.01,   0.0, 2 },
+  { &scd30_avail,  []() -> float { return scd30_temp; },                    0.01,   0.0, 2 },
+  { &sgp30_avail,  []() -> float { return float(sgp30.CO2); },              1.0,    0.0, 0 },
+  { &sgp30_avail,  []() -> float { return float(sgp30.TVOC); },             1.0,    0.0, 0 },
+  { &ccs811_avail, []() -> float { return float(ccs811.getCO2()); },        1.0,    0.0, 0 },
+  { &ccs811_avail, []() -> float { return float(ccs811.getTVOC()); },       1.0,    0.0, 0 },
+  { &sps30_avail,  []() -> float { return valSPS30.mc_1p0; },               0.1,    0.0, 1 },
+  { &sps30_avail,  []() -> float { return valSPS30.mc_2p5; },               0.1,    0.0, 1 },
+  { &sps30_avail,  []() -> float { return valSPS30.mc_4p0; },               0.1,    0.0, 1 },
+  { &sps30_avail,  []() -> float { return valSPS30.mc_10p0; },              0.1,    0.0, 1 },
+  { &bme280_avail, []() -> float { return bme280_pressure/100.0; },         0.1, 1000.0, 1 },
+  { &bme280_avail, []() -> float { return bme280_hum; },                    0.01,   0.0, 2 },
+  { &bme280_avail, []() -> float { return bme280_temp; },                   0.01,   0.0, 2 },
+  { &bme68x_avail, []() -> float { return bme68x.pressure/100.0; },         0.1, 1000.0, 1 },
+  { &bme68x_avail, []() -> float { return bme68x.humidity; },               0.01,   0.0, 2 },
+  { &bme68x_avail, []() -> float { return bme68x.temperature; },            0.01,   0.0, 2 },
+  { &bme68x_avail, []() -> float { return bme68x.gas_resistance; },       100.0,    0.0, 0 },
+  { &therm_avail,  []() -> float { return therm.object()+mlxOffset; },      0.01,   0.0, 2 },
+  { &therm_avail,  []() -> float { return therm.ambient(); },               0.01,   0.0, 2 }
+};
+
+int16_t       historyMemory[HISTORY_BUDGET/sizeof(int16_t)];          // samples of all rings
+HistoryRing   historyRings[HISTORY_CHANNELS][HISTORY_TIERS];          //
+uint32_t      historySeconds = 0;                                      // samples taken since initialization
+
+/******************************************************************************************************/
+// Initialize
+/******************************************************************************************************/
+
+void initializeHistory() {
+  memset(historyRings, 0, sizeof(historyRings));
+  historySeconds = 0;
+  allocateHistory();
+}
+
+// Rings that hold samples keep their order in memory and move down as they are shortened,
+// rings of channels without memory are placed after them.
+void allocateHistory() {
+  uint8_t active = 0;
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) { if (*historySources[i].avail || (historyRings[i][0].depth > 0)) { active++; } }
+  if (active == 0) { return; }
+
+  // ring memory is split evenly among channels, within a channel the coarsest tier is sized first
+  uint16_t depths[HISTORY_TIERS];
+  historyDepths((sizeof(historyMemory)/sizeof(int16_t)) / active, depths);
+
+  // rings with memory in the order of their data, lowest first
+  uint32_t       used = 0;
+  const int16_t *last = NULL;
+  while (true) {
+    HistoryRing *next = NULL;
+    uint8_t      tier = 0;
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+      for (uint8_t t=0; t<HISTORY_TIERS; t++) {
+        HistoryRing *ring = &historyRings[i][t];
+        if ( (ring->depth == 0) || ((last != NULL) && (ring->data <= last)) ) { continue; }
+        if ( (next == NULL) || (ring->data < next->data) ) { next = ring; tier = t; }
+      }
+    }
+    if (next == NULL) { break; }
+    last = next->data;
+    uint32_t depth = depths[tier];
+    if (depth > next->depth) { depth = next->depth; }      // rings only shrink, the move stays below the old data
+    historyMove(next, tier, &historyMemory[used], depth);
+    used += depth*historyTiers[tier].values;
+  }
+
+  // channels of sensors that became available
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if (*historySources[i].avail == false) { continue; }
+    for (uint8_t t=0; t<HISTORY_TIERS; t++) {
+      HistoryRing *ring = &historyRings[i][t];
+      if (ring->depth > 0) { continue; }
+      uint32_t depth = depths[t];
+      if (used + depth*historyTiers[t].values > sizeof(historyMemory)/sizeof(int16_t)) { break; } // out of memory, channel keeps its finer tiers
+      memset(ring, 0, sizeof(HistoryRing));
+      ring->data  = &historyMemory[used];
+      ring->depth = depth;
+      used += depth*historyTiers[t].values;
+    }
+  }
+
+  if (mySettings.debuglevel > 0) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("History: %u channels, %lus readings, %lumin and %luh min/mean/max"),
+               active, (unsigned long)historyCoverage(0), (unsigned long)historyCoverage(1) / 60, (unsigned long)historyCoverage(2) / 3600);
+    R_printSerialTelnetLogln(tmpStr);
+  }
+}
+
+// Depths of the tiers of a channel with share samples. From the coarsest tier down, each tier takes up to its
+// nominal depth and leaves the minimum of the finer tiers, the finest tier gets the rest.
+void historyDepths(uint32_t share, uint16_t *depths) {
+  uint32_t reserved = 0;                                   // minimum of the finer tiers
+  for (uint8_t t=0; t<HISTORY_TIERS; t++) { reserved += (uint32_t)historyTiers[t].minimum * historyTiers[t].values; }
+  if (share < reserved) {
+    for (uint8_t t=0; t<HISTORY_TIERS; t++) {
+      uint32_t depth = (uint32_t)historyTiers[t].minimum * share / reserved;
+      depths[t] = (depth == 0) ? 1 : depth;
+    }
+    return;
+  }
+  for (int8_t t=HISTORY_TIERS-1; t>=0; t--) {
+    reserved -= (uint32_t)historyTiers[t].minimum * historyTiers[t].values;
+    uint32_t depth = (share - reserved) / historyTiers[t].values;
+    if (depth > historyTiers[t].depth) { depth = historyTiers[t].depth; }
+    depths[t] = depth;
+    share -= depth * historyTiers[t].values;
+  }
+}
+
+void historyReverse(int16_t *data, uint32_t len) {
+  for (uint32_t i=0; i<len/2; i++) { int16_t v = data[i]; data[i] = data[len-1-i]; data[len-1-i] = v; }
+}
+
+// move ring to data with depth samples, the newest samples are kept
+void historyMove(HistoryRing *ring, uint8_t tier, int16_t *data, uint16_t depth) {
+  if ( (ring->data == data) && (ring->depth == depth) ) { return; }
+  uint8_t values = historyTiers[tier].values;
+  if (ring->count == ring->depth) {                        // full ring, rotate the oldest sample from head to the start
+    uint32_t k   = (uint32_t)ring->head * values;
+    uint32_t len = (uint32_t)ring->depth * values;
+    historyReverse(ring->data, k);
+    historyReverse(ring->data + k, len - k);
+    historyReverse(ring->data, len);
+  }                                                        // otherwise the oldest sample is at the start
+  uint16_t keep = (ring->count < depth) ? ring->count : depth;
+  memmove(data, ring->data + (uint32_t)(ring->count - keep) * values, (uint32_t)keep * values * sizeof(int16_t));
+  ring->data  = data;
+  ring->depth = depth;
+  ring->count = keep;
+  ring->head  = keep % depth;
+}
+
+// a channel added when memory ran short can have shorter rings than the others
+uint32_t historyCoverage(uint8_t tier) {
+  uint32_t depth = UINT32_MAX;
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if (historyRings[i][0].depth == 0) { continue; }
+    if (historyRings[i][tier].depth < depth) { depth = historyRings[i][tier].depth; }
+  }
+  return (depth == UINT32_MAX) ? 0 : depth * historyTiers[tier].interval;
+}
+
+/******************************************************************************************************/
+// Update
+/******************************************************************************************************/
+
+int16_t historyEncode(uint8_t channel) {
+  HistorySource *source = &historySources[channel];
+  if (*source->avail == false) { return HISTORY_NODATA; }
+  float raw = (source->read() - source->offset) / source->scale;
+  if (isnan(raw)) { return HISTORY_NODATA; }
+  if (raw >  32767.) { raw =  32767.; }
+  if (raw < -32767.) { raw = -32767.; }                    // -32768 is HISTORY_NODATA
+  return (int16_t)lroundf(raw);
+}
+
+float historyDecode(uint8_t channel, int16_t raw) {
+  return float(raw) * historySources[channel].scale + historySources[channel].offset;
+}
+
+// close the interval of a tier, store min, mean and max of the readings accumulated
+void historyPush(HistoryRing *ring, uint8_t tier) {
+  int16_t *sample = &ring->data[ring->head * historyTiers[tier].values];
+  int16_t  mean   = (ring->n > 0) ? (int16_t)(ring->sum / (int32_t)ring->n) : HISTORY_NODATA;
+  if (historyTiers[tier].values == 1) {
+    sample[0] = mean;
+  } else {
+    sample[0] = (ring->n > 0) ? ring->min : HISTORY_NODATA;
+    sample[1] = mean;
+    sample[2] = (ring->n > 0) ? ring->max : HISTORY_NODATA;
+  }
+  ring->head = (ring->head + 1) % ring->depth;
+  if (ring->count < ring->depth) { ring->count++; }
+  ring->sum = 0;
+  ring->n   = 0;
+}
+
+bool updateHistory() {
+  historySeconds++;
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if (historyRings[i][0].depth == 0) { continue; }
+    int16_t raw = historyEncode(i);
+    for (uint8_t t=0; t<HISTORY_TIERS; t++) {
+      HistoryRing *ring = &historyRings[i][t];
+      if (ring->depth == 0) { break; }
+      if (raw != HISTORY_NODATA) {
+        if ( (ring->n == 0) || (raw < ring->min) ) { ring->min = raw; }
+        if ( (ring->n == 0) || (raw > ring->max) ) { ring->max = raw; }
+        ring->sum += raw;
+        ring->n++;
+      }
+      if ((historySeconds % historyTiers[t].interval) == 0) { historyPush(ring, t); }
+    }
+  }
+  return ((historySeconds % historyTiers[1].interval) == 0);
+}
+
+/******************************************************************************************************/
+// Read
+/******************************************************************************************************/
+
+int8_t historyChannel(const char *name) {
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if ( (strcmp_P(name, historyNames[i]) == 0) && (historyRings[i][0].depth > 0) ) { return i; }
+  }
+  return -1;
+}
+
+uint8_t historyTier(unsigned long resolution) {
+  for (uint8_t t=0; t<HISTORY_TIERS; t++) { if (historyTiers[t].interval >= resolution) { return t; } }
+  return HISTORY_TIERS-1;
+}
+
+uint16_t historyCount(uint8_t channel, uint8_t tier) {
+  if ( (channel >= HISTORY_CHANNELS) || (tier >= HISTORY_TIERS) ) { return 0; }
+  return historyRings[channel][tier].count;
+}
+
+bool historySample(uint8_t channel, uint8_t tier, uint16_t index, float *min, float *mean, float *max) {
+  if (index >= historyCount(channel, tier)) { return false; }
+  HistoryRing *ring    = &historyRings[channel][tier];
+  uint8_t      values  = historyTiers[tier].values;
+  int16_t     *sample  = &ring->data[((ring->head + ring->depth - ring->count + index) % ring->depth) * values];
+  int16_t      rawMean = sample[values == 1 ? 0 : 1];
+  if (rawMean == HISTORY_NODATA) { return false; }
+  *mean = historyDecode(channel, rawMean);
+  *min  = (values == 1) ? *mean : historyDecode(channel, sample[0]);
+  *max  = (values == 1) ? *mean : historyDecode(channel, sample[2]);
+  return true;
+}
+
+/******************************************************************************************************/
+// JSON
+/******************************************************************************************************/
+// { "history": { "ch": "scd30.CO2", "res": 60, "age": 12, "fields": ["min","mean","max"], "data": [[400,410,420],null,...]}}
+// data is oldest first, the newest sample ended age seconds ago, null if the sensor had no reading
+// The caller sends the header, the samples separated by commas and closes with "]}}"
+
+void historyHeaderJSON(uint8_t channel, uint8_t tier, char *payLoad, size_t len) {
+  char name[HISTORY_NAMELENGTH];
+  strncpy_P(name, historyNames[channel], sizeof(name));
+  snprintf_P(payLoad, len, PSTR("{ \"history\": { \"ch\": \"%s\", \"res\": %u, \"age\": %lu, \"fields\": %s, \"data\": ["),
+             name,
+             historyTiers[tier].interval,
+             (unsigned long)(historySeconds % historyTiers[tier].interval),
+             (historyTiers[tier].values == 1) ? "[\"value\"]" : "[\"min\",\"mean\",\"max\"]");
+}
+
+size_t historySampleJSON(uint8_t channel, uint8_t tier, uint16_t index, char *payLoad, size_t len) {
+  float   min, mean, max;
+  uint8_t decimals = historySources[channel].decimals;
+  int     l;
+  if (historySample(channel, tier, index, &min, &mean, &max) == false) {
+    l = snprintf_P(payLoad, len, PSTR("null"));
+  } else if (historyTiers[tier].values == 1) {
+    l = snprintf_P(payLoad, len, PSTR("%.*f"), decimals, mean);
+  } else {
+    l = snprintf_P(payLoad, len, PSTR("[%.*f,%.*f,%.*f]"), decimals, min, decimals, mean, decimals, max);
+  }
+  return (l < 0) ? 0 : ( ((size_t)l < len) ? (size_t)l : len-1 );
+}
+
+// "scd30.CO2": [{"res": 1, "n": 120, "depth": 600}, ...]
+void historyChannelJSON(uint8_t channel, char *payLoad, size_t len) {
+  char   name[HISTORY_NAMELENGTH];
+  strncpy_P(name, historyNames[channel], sizeof(name));
+  size_t l = snprintf_P(payLoad, len, PSTR("\"%s\": ["), name);
+  for (uint8_t t=0; (t<HISTORY_TIERS) && (l<len); t++) {
+    l += snprintf_P(payLoad+l, len-l, PSTR("%s{\"res\": %u, \"n\": %u, \"depth\": %u}"),
+                    (t == 0) ? "" : ", ",
+                    historyTiers[t].interval,
+                    historyRings[channel][t].count,
+                    historyRings[channel][t].depth);
+  }
+  if (l < len) { strlcat(payLoad, "]", len); }
+}
+
+/******************************************************************************************************/
+// Print
+/******************************************************************************************************/
+
+void printHistory() {
+  char name[HISTORY_NAMELENGTH];
+  printSerialTelnetLogln(F("Channel             Readings     Minutes       Hours"));
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if (historyRings[i][0].depth == 0) { continue; }
+    strncpy_P(name, historyNames[i], sizeof(name));
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%-18s %4u/%-4u   %4u/%-4u   %4u/%-4u"), name,
+               historyRings[i][0].count, historyRings[i][0].depth,
+               historyRings[i][1].count, historyRings[i][1].depth,
+               historyRings[i][2].count, historyRings[i][2].depth);
+    printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+  }
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%-18s %7lus %8lumin %9luh"), "Covered",
+             (unsigned long)historyCoverage(0), (unsigned long)historyCoverage(1) / 60, (unsigned long)historyCoverage(2) / 3600);
+  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+}
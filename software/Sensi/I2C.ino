@@ -0,0 +1,421 @@
+/******************************************************************************************************/
+// I2C Topology
+/******************************************************************************************************/
+#include "src/I2C.h"
+#include "src/Config.h"
+#include "src/Sensi.h"
+#include "src/Print.h"
+#include "src/Profile.h"
+#include "src/Scheduler.h"
+#include "src/History.h"
+#include "src/LCD.h"
+#include "src/MAX30.h"
+#include "src/SGP30.h"
+#include "src/MLX.h"
+#include "src/CCS811.h"
+#include "src/SCD30.h"
+#include "src/SPS30.h"
+#include "src/BME280.h"
+#include "src/BME68x.h"
+
+I2CTopology        i2cTopology;                            // devices found on the i2c pins
+I2CTransaction    *i2cQueue = NULL;                        // transactions waiting for their response
+uint16_t           i2cStarting = 0;                        // sensors found while running, bit per i2cSensors entry, their task initializes them
+const unsigned int i2cTopologyAddress = EEPROM_SIZE - sizeof(I2CTopology); // end of EEPROM, settings grow from the beginning
+
+// dont search on ports used for data ready or interrupt signaling
+// Wemos: 16, 5, 4, 0, 2, 14, 12, 13 = D0, D1, D2, D3, D4, D5, D6, D7
+const uint8_t      i2cPorts[] = {5, 4, 0, 2, 14, 12};
+const char         i2cPortNames[6][3] = {"D1", "D2", "D3", "D4", "D5", "D6"};
+
+// External Variables
+extern Settings      mySettings;       // Config
+extern unsigned long yieldTime;        // Sensi
+extern char          tmpStr[256];      // Sensi
+extern TwoWire       myWire;           // Sensi
+extern unsigned long i2cSwitches;      // Sensi
+extern unsigned long i2cSwitchesSkipped;
+extern bool          lcd_avail;        // LCD
+extern uint8_t       lcd_i2c[2];
+extern TwoWire      *lcd_port;
+extern bool          max30_avail;      // MAX30
+extern uint8_t       max30_i2c[2];
+extern TwoWire      *max30_port;
+extern bool          sgp30_avail;      // SGP30
+extern uint8_t       sgp30_i2c[2];
+extern TwoWire      *sgp30_port;
+extern bool          therm_avail;      // MLX
+extern uint8_t       mlx_i2c[2];
+extern TwoWire      *mlx_port;
+extern bool          ccs811_avail;     // CCS811
+extern uint8_t       ccs811_i2c[2];
+extern TwoWire      *ccs811_port;
+extern bool          scd30_avail;      // SCD30
+extern uint8_t       scd30_i2c[2];
+extern TwoWire      *scd30_port;
+extern bool          sps30_avail;      // SPS30
+extern uint8_t       sps30_i2c[2];
+extern TwoWire      *sps30_port;
+extern bool          bme280_avail;     // BME280
+extern uint8_t       bme280_i2c[2];
+extern TwoWire      *bme280_port;
+extern bool          bme68x_avail;     // BME68x
+extern uint8_t       bme68x_i2c[2];
+extern TwoWire      *bme68x_port;
+extern int           taskIDI2CQueue;   // Sensi
+extern int           taskIDSCD30, taskIDSGP30, taskIDCCS811, taskIDSPS30, taskIDBME280, taskIDBME68x, taskIDMLX, taskIDMAX30;
+
+// Supported sensors and their addresses
+I2CSensor i2cSensors[] = {
+  {0x20, &lcd_avail,    lcd_i2c,    &lcd_port,    &mySettings.useLCD,    initializeLCD,    NULL},          // LCD display Adafruit
+  {0x27, &lcd_avail,    lcd_i2c,    &lcd_port,    &mySettings.useLCD,    initializeLCD,    NULL},          // LCD display PCF8574
+  {0x57, &max30_avail,  max30_i2c,  &max30_port,  &mySettings.useMAX30,  initializeMAX30,  &taskIDMAX30},  // MAX 30105 Pulseox & Particle
+  {0x58, &sgp30_avail,  sgp30_i2c,  &sgp30_port,  &mySettings.useSGP30,  initializeSGP30,  &taskIDSGP30},  // Senserion TVOC eCO2
+  {0x5A, &therm_avail,  mlx_i2c,    &mlx_port,    &mySettings.useMLX,    initializeMLX,    &taskIDMLX},    // MLX IR sensor
+  {0x5B, &ccs811_avail, ccs811_i2c, &ccs811_port, &mySettings.useCCS811, initializeCCS811, &taskIDCCS811}, // Airquality CO2 tVOC
+  {0x61, &scd30_avail,  scd30_i2c,  &scd30_port,  &mySettings.useSCD30,  initializeSCD30,  &taskIDSCD30},  // Senserion CO2
+  {0x69, &sps30_avail,  sps30_i2c,  &sps30_port,  &mySettings.useSPS30,  initializeSPS30,  &taskIDSPS30},  // Senserion Particle
+  {0x76, &bme280_avail, bme280_i2c, &bme280_port, &mySettings.useBME280, initializeBME280, &taskIDBME280}, // Bosch Temp, Humidity, Pressure
+  {0x77, &bme68x_avail, bme68x_i2c, &bme68x_port, &mySettings.useBME68x, initializeBME68x, &taskIDBME68x}  // Bosch Temp, Humidity, Pressure, VOC
+};
+const uint8_t numI2CSensors = sizeof(i2cSensors) / sizeof(I2CSensor);
+
+/******************************************************************************************************/
+// Support Routines
+/******************************************************************************************************/
+
+uint16_t i2cChecksum(const I2CTopology &topology) {
+  const uint8_t *data = (const uint8_t *)&topology;
+  uint16_t sum1 = 0, sum2 = 0;
+  for (size_t i = 0; i < offsetof(I2CTopology, checksum); i++) {
+    sum1 = (sum1 + data[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+  return (sum2 << 8) | sum1;
+}
+
+void clearI2CTopology() {
+  memset(&i2cTopology, 0, sizeof(i2cTopology));            // padding is part of checksum
+  i2cTopology.valid = I2C_TOPOLOGY_VALID;
+}
+
+I2CSensor *findI2CSensor(uint8_t address) {
+  for (uint8_t i = 0; i < numI2CSensors; i++) {
+    if (i2cSensors[i].address == address) { return &i2cSensors[i]; }
+  }
+  return NULL;
+}
+
+bool inI2CTopology(uint8_t address) {
+  for (uint8_t i = 0; i < i2cTopology.numDevices; i++) {
+    if (i2cTopology.devices[i].address == address) { return true; }
+  }
+  return false;
+}
+
+// Adds device to topology and connects the sensor to its pins
+// With initialize the sensor task is woken to make it ready, otherwise setup() takes care of it
+void addI2CDevice(uint8_t address, uint8_t sda, uint8_t scl, bool initialize) {
+  if (i2cTopology.numDevices >= I2C_MAXDEVICES) { return; }
+  I2CEntry *entry = &i2cTopology.devices[i2cTopology.numDevices++];
+  entry->address = address;
+  entry->sda     = sda;
+  entry->scl     = scl;
+
+  I2CSensor *sensor = findI2CSensor(address);
+  if (sensor == NULL) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Found unknonw device - %d!"), address);
+    R_printSerialLog(tmpStr);
+    return;
+  }
+  if (initialize && *sensor->avail) { return; }           // already running
+  *sensor->avail = true;
+  *sensor->port  = &myWire;
+  sensor->i2c[0] = sda;
+  sensor->i2c[1] = scl;
+  if (initialize) {
+    if (!*sensor->use) {
+      *sensor->avail = false;
+    } else if (sensor->task != NULL) {
+      *sensor->avail = false;                              // not updated before its task initialized it
+      i2cStarting |= 1 << (sensor - i2cSensors);
+      wakeTask(*sensor->task, 0);
+    } else {
+      if (sensor->initialize() == false) { *sensor->avail = false; }
+      resetI2C();                                          // driver called begin() on the port
+    }
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("I2C: device 0x%02X at SDA %d SCL %d %s"), address, sda, scl,
+               (!*sensor->use) ? "not used" : ((*sensor->avail) ? "initialized" : "found"));
+    R_printSerialTelnetLogln(tmpStr);
+  }
+}
+
+// Called by a sensor task before its update, initializes the sensor when the probe found it
+// true if it did, the task is woken again to start the state machine
+bool startI2CSensor(int task) {
+  if (i2cStarting == 0) { return false; }
+  for (uint8_t i = 0; i < numI2CSensors; i++) {
+    I2CSensor *sensor = &i2cSensors[i];
+    if ( !(i2cStarting & (1 << i)) || (sensor->task == NULL) || (*sensor->task != task) ) { continue; }
+    i2cStarting &= ~(1 << i);
+    *sensor->avail = true;
+    if (sensor->initialize() == false) { *sensor->avail = false; }
+    resetI2C();                                            // driver called begin() on the port
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("I2C: device 0x%02X %s"), sensor->address, (*sensor->avail) ? "initialized" : "failed to initialize");
+    R_printSerialTelnetLogln(tmpStr);
+    if (*sensor->avail) {
+      allocateHistory();                                   // new sensor gets history, recorded history is kept
+      wakeTask(task, 0);
+    }
+    return true;
+  }
+  return false;
+}
+
+/******************************************************************************************************/
+// Store
+/******************************************************************************************************/
+
+bool loadI2CTopology() {
+  EEPROM.get(i2cTopologyAddress, i2cTopology);
+  if ( (i2cTopology.valid != I2C_TOPOLOGY_VALID) || (i2cTopology.numDevices > I2C_MAXDEVICES) || (i2cTopology.checksum != i2cChecksum(i2cTopology)) ) {
+    if (mySettings.debuglevel > 0) { R_printSerialLogln(F("I2C topology not valid")); }
+    clearI2CTopology();
+    return false;
+  }
+  return true;
+}
+
+bool saveI2CTopology() {
+  i2cTopology.checksum = i2cChecksum(i2cTopology);
+  EEPROM.put(i2cTopologyAddress, i2cTopology);
+  if (EEPROM.commit()) {
+    if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("I2C topology saved")); }
+    return true;
+  } else {
+    if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("EEPROM failed to commit")); }
+    return false;
+  }
+}
+
+/******************************************************************************************************/
+// Probe
+/******************************************************************************************************/
+
+// Connects the stored devices, at boot the sensors are initialized by setup()
+bool verifyI2CTopology() {
+  I2CTopology stored = i2cTopology;
+  clearI2CTopology();
+  for (uint8_t i = 0; i < stored.numDevices; i++) {
+    I2CEntry *entry = &stored.devices[i];
+    switchI2C(&myWire, entry->sda, entry->scl, I2C_SCANSPEED, I2C_SCANSTRETCH);
+    if (checkI2C(entry->address, &myWire) == false) {
+      snprintf_P(tmpStr, sizeof(tmpStr), PSTR("I2C: device 0x%02X missing at SDA %d SCL %d"), entry->address, entry->sda, entry->scl);
+      R_printSerialLogln(tmpStr);
+      return false;
+    }
+    addI2CDevice(entry->address, entry->sda, entry->scl, false);
+  }
+  if (mySettings.debuglevel > 0) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("I2C: %d devices at stored pins"), i2cTopology.numDevices);
+    R_printSerialLogln(tmpStr);
+  }
+  return (i2cTopology.numDevices > 0);
+}
+
+// Check which devices are attached to the I2C pins, this self configures our connections to the sensors
+void scanI2C(bool initialize) {
+  clearI2CTopology();
+  for (uint8_t i = 0; i < sizeof(i2cPorts); i++) {
+    for (uint8_t j = 0; j < sizeof(i2cPorts); j++) {
+      if (i != j) {
+        snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Scanning (SDA:SCL) - %s:%s"), i2cPortNames[i], i2cPortNames[j]);
+        R_printSerialLogln(tmpStr);
+        switchI2C(&myWire, i2cPorts[i], i2cPorts[j], I2C_SCANSPEED, I2C_SCANSTRETCH);
+        for (uint8_t address = 1; address < 127; address++ )  {
+          if (checkI2C(address, &myWire)) { addI2CDevice(address, i2cPorts[i], i2cPorts[j], initialize); }
+        }
+        yieldTime += yieldOS();
+      }
+    }
+  }
+}
+
+// Supported sensors are only probed on the pin pairs that already have devices
+bool probeI2C() {
+  bool added = false;
+  uint8_t numDevices = i2cTopology.numDevices;
+  for (uint8_t s = 0; s < numI2CSensors; s++) {
+    uint8_t address = i2cSensors[s].address;
+    if (inI2CTopology(address)) { continue; }
+    for (uint8_t i = 0; i < numDevices; i++) {
+      uint8_t sda = i2cTopology.devices[i].sda;
+      uint8_t scl = i2cTopology.devices[i].scl;
+      bool tested = false;                                 // same pins as a previous device
+      for (uint8_t k = 0; k < i; k++) {
+        if ( (i2cTopology.devices[k].sda == sda) && (i2cTopology.devices[k].scl == scl) ) { tested = true; break; }
+      }
+      if (tested) { continue; }
+      switchI2C(&myWire, sda, scl, I2C_SCANSPEED, I2C_SCANSTRETCH);
+      if (checkI2C(address, &myWire)) {
+        addI2CDevice(address, sda, scl, true);
+        added = true;
+        break;
+      }
+    }
+  }
+  return added;
+}
+
+/******************************************************************************************************/
+// Tasks
+/******************************************************************************************************/
+
+void addI2CTasks(unsigned long interval) {
+  I2CTask i2cTasks[] = {
+    {taskSCD30,  PROFILE_SCD30,  scd30_i2c,  &taskIDSCD30},
+    {taskSGP30,  PROFILE_SGP30,  sgp30_i2c,  &taskIDSGP30},
+    {taskCCS811, PROFILE_CCS811, ccs811_i2c, &taskIDCCS811},
+    {taskSPS30,  PROFILE_SPS30,  sps30_i2c,  &taskIDSPS30},
+    {taskBME280, PROFILE_BME280, bme280_i2c, &taskIDBME280},
+    {taskBME68x, PROFILE_BME68X, bme68x_i2c, &taskIDBME68x},
+    {taskMLX,    PROFILE_MLX,    mlx_i2c,    &taskIDMLX},
+    {taskMAX30,  PROFILE_MAX30,  max30_i2c,  &taskIDMAX30}
+  };
+  const uint8_t numTasks = sizeof(i2cTasks) / sizeof(I2CTask);
+  // insertion sort keeps the order of sensors on the same pins
+  for (uint8_t i = 1; i < numTasks; i++) {
+    I2CTask task = i2cTasks[i];
+    uint16_t pins = (task.i2c[0] << 8) | task.i2c[1];
+    int8_t j = i - 1;
+    while ( (j >= 0) && (((i2cTasks[j].i2c[0] << 8) | i2cTasks[j].i2c[1]) > pins) ) {
+      i2cTasks[j+1] = i2cTasks[j];
+      j--;
+    }
+    i2cTasks[j+1] = task;
+  }
+  for (uint8_t i = 0; i < numTasks; i++) {
+    *i2cTasks[i].id = addTask(i2cTasks[i].run, interval, i2cTasks[i].profile);
+    wakeTask(*i2cTasks[i].id, 0);                          // state machine wakes it from now on
+  }
+}
+
+void printI2CTopology() {
+  printSerialTelnetLogln();
+  R_printSerialTelnetLogln(FPSTR(doubleSeparator)); yieldTime += yieldOS();
+  for (uint8_t i = 0; i < i2cTopology.numDevices; i++) {
+    I2CEntry  *entry  = &i2cTopology.devices[i];
+    I2CSensor *sensor = findI2CSensor(entry->address);
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("I2C 0x%02X SDA %2d SCL %2d %s"), entry->address, entry->sda, entry->scl,
+               (sensor == NULL) ? "unknown" : ((*sensor->avail) ? "available" : "not available"));
+    printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+  }
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Port switched %lu times, %lu times already configured"), i2cSwitches, i2cSwitchesSkipped);
+  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+  printSerialTelnetLogln(FPSTR(doubleSeparator)); yieldTime += yieldOS();
+}
+
+/******************************************************************************************************/
+// Split Phase Transactions
+/******************************************************************************************************/
+
+bool queueI2C(I2CTransaction *transaction, uint16_t command, unsigned long wait, uint8_t words) {
+  I2CTransaction **link = &i2cQueue;
+  while (*link != NULL) {
+    if (*link == transaction) { return false; }           // previous response not read yet
+    link = &(*link)->next;
+  }
+  if (words > I2C_MAXWORDS) { transaction->state = I2C_FAILED; return false; }
+  transaction->command        = command;
+  transaction->wait           = wait;
+  transaction->responseLength = words;
+  switchI2C(transaction->port, transaction->i2c[0], transaction->i2c[1], transaction->speed, transaction->stretch);
+  transaction->port->beginTransmission(transaction->address);
+  transaction->port->write(command >> 8);
+  transaction->port->write(command & 0xFF);
+  if (transaction->port->endTransmission() != 0) { transaction->state = I2C_FAILED; return false; } // sensor did not ACK
+  if (words == 0) { transaction->state = I2C_DONE; return true; }
+  transaction->readTime = micros() + wait;
+  transaction->state    = I2C_WAITING;
+  transaction->task     = currentTask();
+  transaction->next     = NULL;
+  *link = transaction;                                     // append, queue is read in order
+  wakeTask(taskIDI2CQueue, (wait + 999) / 1000);
+  return true;
+}
+
+// Command with argument words and without response, e.g. start or reset. Nothing is queued, the caller
+// waits the execution time of the command in its state machine before it talks to the sensor again.
+bool writeI2C(I2CTransaction *transaction, uint16_t command, const uint16_t *args, uint8_t nArgs) {
+  switchI2C(transaction->port, transaction->i2c[0], transaction->i2c[1], transaction->speed, transaction->stretch);
+  transaction->port->beginTransmission(transaction->address);
+  transaction->port->write(command >> 8);
+  transaction->port->write(command & 0xFF);
+  for (uint8_t i = 0; i < nArgs; i++) { sensirionWriteWord(*transaction->port, args[i]); }
+  return (transaction->port->endTransmission() == 0);
+}
+
+void readI2C(I2CTransaction *transaction) {
+  switchI2C(transaction->port, transaction->i2c[0], transaction->i2c[1], transaction->speed, transaction->stretch);
+  uint8_t bytes = transaction->responseLength * SENSIRION_WORD_SIZE;
+  if (transaction->port->requestFrom(transaction->address, bytes) != bytes) { transaction->state = I2C_FAILED; return; }
+  if (sensirionReadWords(*transaction->port, transaction->response, transaction->responseLength)) { transaction->state = I2C_DONE; }
+  else                                                                                            { transaction->state = I2C_FAILED; }
+}
+
+void runI2C() {
+  I2CTransaction **link = &i2cQueue;
+  long wait = -1;                                          // [us] until next response is due
+  while (*link != NULL) {
+    I2CTransaction *transaction = *link;
+    long remaining = (long)(transaction->readTime - micros());
+    if ( remaining <= 0 ) {
+      *link = transaction->next;                           // remove from queue
+      readI2C(transaction);
+      wakeTask(transaction->task, 0);
+    } else {
+      if ( (wait < 0) || (remaining < wait) ) { wait = remaining; }
+      link = &transaction->next;
+    }
+  }
+  if (wait >= 0) { wakeTask(taskIDI2CQueue, (wait + 999) / 1000); }
+}
+
+// Sensirion data ready flag followed by read measurement
+//   readyCommand 0 reads the measurement right away, e.g. after the data ready interrupt
+//   the measurement words remain in the transaction until the next call
+uint8_t readI2CMeasurement(I2CTransaction *transaction, uint16_t readyCommand, uint16_t readCommand, unsigned long wait, uint8_t words) {
+  switch (transaction->state) {
+    case I2C_IDLE: {
+      bool queued;
+      if (readyCommand != 0) { queued = queueI2C(transaction, readyCommand, wait, 1); }
+      else                   { queued = queueI2C(transaction, readCommand,  wait, words); }
+      if (queued) { return I2C_PENDING; }
+      transaction->state = I2C_IDLE;
+      return I2C_NOACK;
+    }
+    case I2C_WAITING: {
+      return I2C_PENDING;
+    }
+    case I2C_DONE: {
+      if ( (readyCommand != 0) && (transaction->command == readyCommand) ) {
+        if (i2cWord(transaction, 0) == 0) { transaction->state = I2C_IDLE; return I2C_NODATA; }
+        if (queueI2C(transaction, readCommand, wait, words)) { return I2C_PENDING; }
+        transaction->state = I2C_IDLE;
+        return I2C_NOACK;
+      }
+      transaction->state = I2C_IDLE;
+      return I2C_DATA;
+    }
+    default: {
+      transaction->state = I2C_IDLE;
+      return I2C_NOACK;
+    }
+  }
+}
+
+uint16_t i2cCommand(const I2CTransaction *transaction) { return transaction->command; }
+
+uint16_t i2cWord(const I2CTransaction *transaction, uint8_t index)  { return transaction->response[index]; }
+uint32_t i2cLong(const I2CTransaction *transaction, uint8_t index)  { return sensirionUint32(&transaction->response[index]); }
+float    i2cFloat(const I2CTransaction *transaction, uint8_t index) { return sensirionFloat(&transaction->response[index]); }
@@ -7,12 +7,12 @@
 #include "src/Config.h"
 #include "src/Quality.h"
 #include "src/WiFi.h"
-#include "src/bme280.h"
-#include "src/bme68x.h"
-#include "src/ccs811.h"
-#include "src/scd30.h"
-#include "src/sgp30.h"
-#include "src/sps30.h"
+#include "src/BME280.h"
+#include "src/BME68x.h"
+#include "src/CCS811.h"
+#include "src/SCD30.h"
+#include "src/SGP30.h"
+#include "src/SPS30.h"
 #include "src/Weather.h"
 #include "src/MLX.h"
 #include "src/MAX30.h"
@@ -98,6 +98,7 @@ bool initializeLCD() {
   lcd.begin(20, 4, *lcd_port);
   if (mySettings.useBacklight == true) { lcd.setBacklight(255);  lastLCDInten = true; } else { lcd.setBacklight(0);   lastLCDInten = false; }
 #endif
+  resetI2C();                                              // driver called begin() on the port
   if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("LCD initialized")); }
   delay(50); lastYield = millis();
 
@@ -135,7 +136,6 @@ bool updateSinglePageLCDwTime() {
   float myP    = -9999.;
   
   char myCO2_warning[]  = "N";
-  char myTemp_warning[] = "N";
   char myHum_warning[]  = "N";
   char mydP_warning[]   = "N";
   char myPM25_warning[] = "N";
@@ -193,9 +193,6 @@ bool updateSinglePageLCDwTime() {
   if (myCO2 > 0.) { checkCO2(myCO2, qualityMessage, 1); }                     else { strncpy(qualityMessage, myNaN, 1); }
   myCO2_warning[0] = qualityMessage[0];
     
-  if (myTemp > -100.) { checkAmbientTemperature(myTemp, qualityMessage, 1); } else { strncpy(qualityMessage, myNaN, 1); }
-  myTemp_warning[0] = qualityMessage[0];
-
   if (myHum >= 0.) { checkHumidity(myHum, qualityMessage, 1); }               else { strncpy(qualityMessage, myNaN, 1); }
   myHum_warning[0] = qualityMessage[0];
   
@@ -227,7 +224,7 @@ bool updateSinglePageLCDwTime() {
   if (myTemp > -100.) {
     if ( (myTemp < 100.0) && (myTemp > 0.0)) { 
       snprintf_P(lcdbuf, sizeof(lcdbuf), PSTR("%4.1fC"), myTemp);
-      strncpy(&lcdDisplay[1][15], lcdbuf, 6); // without Null char
+      strncpy(&lcdDisplay[1][15], lcdbuf, 5); // without Null char
     } if (myTemp > 100.0) { 
       snprintf_P(lcdbuf, sizeof(lcdbuf), PSTR("%5.1fC"), myTemp);
       strncpy(&lcdDisplay[1][14], lcdbuf, 6); // without Null char
@@ -6,7 +6,7 @@
 #include "src/Config.h"
 #include "src/Quality.h"
 
-const long            intervalMAX30  = 1000;               // readout intervall in ms
+const unsigned long   intervalMAX30  = 1000;               // readout intervall in ms
 bool                  max30_avail    = false;              // do we have sensor?
 bool                  max30NewData   = false;              // do we have new data?
 bool                  max30NewDataWS = false;              // do we have new data for websocket
@@ -10,13 +10,13 @@
 #include "src/Config.h"
 #include "src/Quality.h"
 #include "src/Print.h"
+#include "src/Scheduler.h"
 
 // reading a black surface should give the same value as room temperature measuresd with other sensors
 // measuring wall or ceiling differs from room temp
 float                 mlxOffset = 1.4;                     // offset to adjust for sensor inaccuracy,
 bool                  therm_avail = false;                 // do we hav e the sensor?
 bool                  mlxNewData = false;                  // do we have new data
-bool                  mlxNewDataHandeled = false;          // have we handeled the new data?
 bool                  mlxNewDataWS = false;                // do we have new data for websocket
 uint8_t               mlx_i2c[2];                          // the pins for the i2c port, set during initialization
 unsigned long         intervalMLX = 1000;                  // readout intervall in ms, 250ms minimum
@@ -35,6 +35,7 @@ IRTherm               therm;                               // the IR thermal sen
 extern bool           fastMode;         // Sensi
 extern bool           intervalNewData;
 extern bool           availNewData;
+extern uint32_t       sampleSequence;   // Sensi
 extern unsigned long  yieldTime;        // Sensi
 extern unsigned long  lastYield;        // Sensi
 extern Settings       mySettings;       // Config
@@ -123,6 +124,7 @@ bool updateMLX() {
             therm_error_cnt = 0;
             mlxNewData = true;
             mlxNewDataWS = true;
+            sampleSequence++;
           }
           if (fastMode == false) {
             therm.sleep();
@@ -189,6 +191,20 @@ bool updateMLX() {
   return success;
 }
 
+/******************************************************************************************************/
+// Next MLX step
+/******************************************************************************************************/
+// [ms] until updateMLX has something to do
+
+unsigned long nextMLX() {
+  switch(stateMLX) {
+    case IS_MEASURING:   { return dueIn(lastMLX, intervalMLX); }
+    case IS_SLEEPING:    { return dueIn(lastMLX, sleepTimeMLX); }
+    case HAS_ERROR:      { return dueIn(errorRecMLX, 0); }
+    default:             { return intervalPoll; }
+  }
+}
+
 /******************************************************************************************************/
 // JSON MLX
 /******************************************************************************************************/
@@ -14,6 +14,8 @@
 #include "src/SPS30.h"
 #include "src/Weather.h"
 #include "src/Print.h"
+#include "src/Profile.h"
+#include "src/Telemetry.h"
 
 bool          mqtt_connected = false;                      // is mqtt server connected?
 bool          mqtt_sent = false;                           // did we publish data?
@@ -21,15 +23,24 @@ bool          mqtt_useregular = true;                      // want to be on regu
 bool          mqtt_onfallback = true;                      // did fallback connect?
 bool          mqtt_onregular = true;                       // did regular connect?
 bool          availNewData = true;                         // 
-bool          availNewDataHandeled = false;                //
 bool          intervalNewData = true;                      // 
-bool          intervalNewDataHandeled = false;
-bool          systemNewDataHandeled = false;               // update system status on mqtt
+bool          systemNewData = true;                        // update system status on mqtt
+char          mqttTopicStr[64];                            // main topic, slash and suffix of last publish
+uint8_t       mqttTopicLength = 0;                         // of main topic and slash
 unsigned long intervalMQTTreconnect = intervalMQTTconnect; //
 unsigned long intervalMQTT = intervalMQTTSlow;             // automatically set during setup
 unsigned long lastMQTTPublish;                             // last time we published mqtt data
 unsigned long lastMQTTStatusPublish;                       // last time we published mqtt sensor availability data
 unsigned long lastMQTT;                                    // last time we checked if mqtt is connected
+unsigned long mqttMessageRate = MQTT_MESSAGERATE;          // [1/s] sustained rate of immediate messages
+unsigned long mqttByteRate = MQTT_BYTERATE;                // [bytes/s]
+unsigned long mqttBurst = MQTT_BURST;                      // [messages] saved up budget
+unsigned long mqttMessageTokens = MQTT_BURST * 1000;       // [1/1000 message] budget
+unsigned long mqttByteTokens = MQTT_BYTERATE * 1000;       // [1/1000 byte] budget
+unsigned long lastMQTTTokens = 0;                          // [ms] budget was updated
+uint8_t       mqttNextTopic = 0;                           // round robin starts here
+MQTTTopicStats mqttTopicStats[MQTT_TOPICS];                // age at publish
+char          mqttPayload[MQTT_PAYLOADSIZE];               // message being built, used by the topics and the queue one after the other
 
 volatile WiFiStates stateMQTT = IS_WAITING;                // keeping track of MQTT state
 WiFiClient    mqttWiFiClient;                              // The WiFi interface
@@ -38,13 +49,13 @@ PubSubClient  mqttClient(mqttWiFiClient);                  // The MQTT interface
 // Extern variables
 extern unsigned long yieldTime;        // Sensi
 extern unsigned long lastYield;        // Sensi
-extern unsigned long AllmaxUpdateMQTT; // Sensi
 extern Settings      mySettings;       // Config
 extern unsigned long currentTime;      // Sensi
 extern char          tmpStr[256];           // Sensi
+extern uint8_t       mqttEncoding;          // Telemetry
+extern const uint32_t telemetryChannels[TELEMETRY_SENSORS];
 
 extern bool          bme280NewData;
-extern bool          bme280NewDataHandeled;
 extern bool          bme280_avail;        // bme68x
 extern float         bme280_pressure;
 extern float         bme280_pressure24hrs;
@@ -56,7 +67,6 @@ extern float         bme280_temp;
 extern bool          bme68x_avail;        // bm680
 extern bme68xData    bme68x; 
 extern bool          bme68xNewData;
-extern bool          bme68xNewDataHandeled;
 extern Bme68x        bme68xSensor; 
 extern float         bme68x_pressure24hrs;//
 extern unsigned long intervalBME68x;
@@ -64,8 +74,6 @@ extern float         bme68x_ah;
 
 extern bool          scd30_avail;         // scd30
 extern bool          scd30NewData;
-extern bool          scd30NewDataHandeled;
-extern bool          scd30NewDataHandeled;
 extern unsigned long intervalSCD30;
 extern uint16_t      scd30_ppm;
 extern float         scd30_hum;
@@ -73,32 +81,27 @@ extern float         scd30_temp;
 
 extern bool          ccs811_avail;        // ccs811
 extern bool          ccs811NewData;
-extern bool          ccs811NewDataHandeled;
 extern CCS811        ccs811;      
 extern uint8_t       ccs811Mode;
 
 extern bool          sgp30_avail;         // sgp30
 extern bool          sgp30NewData;
-extern bool          sgp30NewDataHandeled;
 extern unsigned long intervalSGP30; 
 extern SGP30         sgp30;
 
 extern bool          sps30_avail;         // sps30
 extern bool          sps30NewData;
-extern bool          sps30NewDataHandeled;
 extern unsigned long intervalSPS30;
 extern sps30_measurement valSPS30;
 
 extern bool          therm_avail;         // MLX
 extern bool          mlxNewData;
-extern bool          mlxNewDataHandeled;
 extern unsigned long intervalMLX;
 extern IRTherm       therm;
 extern float         mlxOffset;
 
 extern bool          weather_avail;       // weather
 extern bool          weatherNewData;
-extern bool          weatherNewDataHandeled;                       // have we handeled the new data?
 
 extern clientData    weatherData;
 extern volatile WiFiStates stateWeather;
@@ -131,7 +134,8 @@ void updateMQTT() {
 // Operation:
 //   Wait until WiFi connection is established
 //   Set the MQTT server
-//   Connect with either username or no username
+//   Connect with either username or no username, without waiting for the broker
+//   Wait for the broker to accept the connection while the other tasks run
 //   If connection did not work, attempt connection to fallback server
 //   Once connection is stablished, periodically check if still connected
 //   If connection lost go back to setting up MQTT server
@@ -152,6 +156,7 @@ void updateMQTT() {
       if ((currentTime - lastMQTT) >= intervalMQTTreconnect) {
         D_printSerialTelnet(F("D:U:MQTT:S.."));
         lastMQTT = currentTime;
+        mqtt_connected = false;
         
         if ( mqtt_useregular ) {
           mqttClient.setServer(mySettings.mqtt_server, MQTT_PORT);          // start connection to server
@@ -159,46 +164,54 @@ void updateMQTT() {
             snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Connecting to MQTT: %s"), mySettings.mqtt_server); 
             R_printSerialTelnetLogln(tmpStr); 
           }
-          mqtt_connected = false;
-          // connect to server with or without username password
-          if (strlen(mySettings.mqtt_username) > 0)   { mqtt_connected = mqttClient.connect(mqttClientID, mySettings.mqtt_username, mySettings.mqtt_password); } // crashes here
-          else                                        { mqtt_connected = mqttClient.connect(mqttClientID); }
-          if ( mqtt_connected ) { mqtt_onregular = true; } else { mqtt_onregular = false; }
         } else {
           mqttClient.setServer(mySettings.mqtt_fallback, MQTT_PORT);
           if (mySettings.debuglevel > 0) { 
-            snprintf_P(tmpStr, sizeof(tmpStr), "Connecting to MQTT: %s", mySettings.mqtt_fallback); 
+            snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Connecting to MQTT: %s"), mySettings.mqtt_fallback); 
             R_printSerialTelnetLogln(tmpStr);
           }
-          if (strlen(mySettings.mqtt_username) > 0) { mqtt_connected = mqttClient.connect(mqttClientID, mySettings.mqtt_username, mySettings.mqtt_password); }
-          else                                      { mqtt_connected = mqttClient.connect(mqttClientID); }          
-          if ( mqtt_connected ) { mqtt_onfallback = true; } else { mqtt_onfallback = false; }
- 
         }
-
-        // go slower if both server can not be reached
-        if ( (mqtt_onregular == false) && (mqtt_onfallback == false) ) {
-          intervalMQTTreconnect = intervalMQTTconnect * 4;
-        } else {
-          intervalMQTTreconnect = intervalMQTTconnect;
-        } 
-
-        if (mqtt_connected == true) {
-          // publish connection status
-          char MQTTtopicStr[64];                                     // String allocated for MQTT topic 
-          snprintf_P(MQTTtopicStr,sizeof(MQTTtopicStr),PSTR("%s/status"),mySettings.mqtt_mainTopic);
-          mqttClient.publish(MQTTtopicStr, "up");
-          if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("MQTT: connected successfully")); }
-          stateMQTT = CHECK_CONNECTION;  // advance to connection monitoring and publishing
-          AllmaxUpdateMQTT = 0;
-        } else {  
-          // connection failed, switch server
-          mqtt_useregular = !mqtt_useregular;
-          if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("MQTT: conenction attempt failed, switching to fallback")); }
-        } // failed connectig, repeat starting up
+        // connect to server with or without username password, CONNACK is awaited in IS_CONNECTING
+        if (strlen(mySettings.mqtt_username) > 0) { mqttClient.connectAsync(mqttClientID, mySettings.mqtt_username, mySettings.mqtt_password); }
+        else                                      { mqttClient.connectAsync(mqttClientID); }
+        stateMQTT = IS_CONNECTING;
       } //interval time
       break;
     }
+
+    case IS_CONNECTING : { //---------------------
+      D_printSerialTelnet(F("D:U:MQTT:IC.."));
+      mqtt_connected = mqttClient.loop();
+      if ( !mqtt_connected && (mqttClient.state() == MQTT_CONNECTING) ) { break; }   // broker has not answered yet
+
+      if ( mqtt_useregular ) { mqtt_onregular = mqtt_connected; } else { mqtt_onfallback = mqtt_connected; }
+
+      // go slower if both server can not be reached
+      if ( (mqtt_onregular == false) && (mqtt_onfallback == false) ) {
+        intervalMQTTreconnect = intervalMQTTconnect * 4;
+      } else {
+        intervalMQTTreconnect = intervalMQTTconnect;
+      } 
+
+      if (mqtt_connected == true) {
+        // publish connection status
+        mqttClient.publish(mqttTopic(PSTR("status")), "up");
+        if (mqttEncoding == TELEMETRY_MSGPACK) { publishTelemetrySchema(); }
+        if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("MQTT: connected successfully")); }
+        stateMQTT = CHECK_CONNECTION;  // advance to connection monitoring and publishing
+        resetProfile(PROFILE_MQTT);
+      } else {  
+        // connection failed, switch server
+        mqtt_useregular = !mqtt_useregular;
+        if (mySettings.debuglevel > 0) { 
+          snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT: conenction attempt failed with state %d, switching to fallback"), mqttClient.state()); 
+          R_printSerialTelnetLogln(tmpStr);
+        }
+        lastMQTT = currentTime;
+        stateMQTT = START_UP;          // failed connectig, repeat starting up
+      }
+      break;
+    }
     
     case CHECK_CONNECTION : { //---------------------
       //if ((currentTime - lastMQTT) >= intervalMQTT) {
@@ -222,181 +235,161 @@ void updateMQTT() {
 // Update MQTT Message
 /******************************************************************************************************/
 void updateMQTTMessage() {
-  char MQTTtopicStr[64];
   mqtt_sent = false;
 
-  if ( (currentTime - lastMQTTPublish) > intervalMQTT ) { // wait for interval time, sending lots of MQTT messages breaks the software
+  // --------------------- this sends new data to mqtt server as soon as its available ----------------
+  if (mySettings.sendMQTTimmediate) {
+    mqtt_sent = publishTopicsMQTT();                       // as many as the token buckets allow
+  }
+
+  // --------------- this creates single message ---------------------------------------------------------
+  else if ( (currentTime - lastMQTTPublish) >= intervalMQTT ) { // wait for interval time, sending lots of MQTT messages breaks the software
+    if (mqttEncoding == TELEMETRY_MSGPACK) { publishTelemetryMQTT(mqttTopic(PSTR("data/all")), TELEMETRY_ALL); }
+    else { publishAllMQTT(mqttTopic(PSTR("data/all"))); } // payload is written straight into the socket
     lastMQTTPublish = currentTime;
+    mqtt_sent = true;
+    yieldTime += yieldOS(); 
+  } // end send single message
+  
+  // --------------- debug status ---------------------------------------------------------
+  if (mqtt_sent == true) {
+    if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("MQTT: published data")); }
+  }
+}
 
-    // --------------------- this sends new data to mqtt server as soon as its available ----------------
-    if (mySettings.sendMQTTimmediate) {
-      
-      char MQTTpayloadStr[512]; 
-
-      // might need to limit system status update also
-      if (!systemNewDataHandeled)  {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/status/system"),mySettings.mqtt_mainTopic);
-        systemJSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        mqtt_sent = true;
-        systemNewDataHandeled = true;
-        yieldTime += yieldOS(); 
-          
-      } else if (scd30NewData && !scd30NewDataHandeled )  {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/scd30"),mySettings.mqtt_mainTopic);
-        scd30JSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        scd30NewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("SCD30 MQTT updated")); }
-        mqtt_sent = true;
-        scd30NewDataHandeled = true;
-        yieldTime += yieldOS(); 
-    
-      } else if (sgp30NewData && !sgp30NewDataHandeled) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/sgp30"),mySettings.mqtt_mainTopic);
-        sgp30JSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        sgp30NewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("SGP30 MQTT updated")); }      
-        mqtt_sent = true;
-        sgp30NewDataHandeled = true;
-        yieldTime += yieldOS(); 
-
-      } else if (sps30NewData && !sps30NewDataHandeled) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/sps30"),mySettings.mqtt_mainTopic);
-        sps30JSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        sps30NewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("SPS30 MQTT updated")); }      
-        mqtt_sent = true;
-        sps30NewDataHandeled = true;
-        yieldTime += yieldOS(); 
-      
-      } else if (ccs811NewData && !ccs811NewDataHandeled) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/ccs811"),mySettings.mqtt_mainTopic);
-        ccs811JSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        ccs811NewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("CCS811 MQTT updated")); }      
-        mqtt_sent = true;
-        ccs811NewDataHandeled = true;
-        yieldTime += yieldOS(); 
-
-      } else if (bme68xNewData && !bme68xNewDataHandeled) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/bme68x"),mySettings.mqtt_mainTopic);
-        bme68xJSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        bme68xNewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("BME68x MQTT updated")); }
-        mqtt_sent = true;
-        bme68xNewDataHandeled = true;
-        yieldTime += yieldOS(); 
-      
-      } else if (bme280NewData && !bme280NewDataHandeled) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/bme280"),mySettings.mqtt_mainTopic);
-        bme280JSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        bme280NewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("BME280 MQTT updated")); }
-        mqtt_sent = true;
-        bme280NewDataHandeled = true;
-        yieldTime += yieldOS(); 
-      
-      } else if (mlxNewData && !mlxNewDataHandeled) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/mlx"),mySettings.mqtt_mainTopic);
-        mlxJSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        mlxNewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("MLX MQTT updated")); }
-        mqtt_sent = true;
-        mlxNewDataHandeled = true;
-        yieldTime += yieldOS();
-
-      } else if (weatherNewData && !weatherNewDataHandeled) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/data/weather"),mySettings.mqtt_mainTopic);
-        weatherJSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        weatherNewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("Weather MQTT updated")); }
-        mqtt_sent = true;
-        weatherNewDataHandeled = true;
-        yieldTime += yieldOS(); 
-      
-      } else if (availNewData && !availNewDataHandeled) { // update sensor status every mninute
-        snprintf_P(MQTTtopicStr,sizeof(MQTTtopicStr),PSTR("%s/status/sensors"),mySettings.mqtt_mainTopic);
-        snprintf_P(MQTTpayloadStr,sizeof(MQTTpayloadStr), PSTR("{\"mlx_avail\":%d,\"lcd_avail\":%d,\"ccs811_avail\":%d,\"sgp30_avail\":%d,\"scd30_avail\":%d,\"sps30_avail\":%d,\"bme68x_avail\":%d,\"bme280_avail\":%d,\"ntp_avail\":%d}"),
-                  therm_avail, lcd_avail, ccs811_avail, sgp30_avail, scd30_avail, sps30_avail, bme68x_avail, bme280_avail, ntp_avail);
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        availNewData = false;
-        mqtt_sent = true;
-        availNewDataHandeled = true;
-        yieldTime += yieldOS(); 
-
-      } else if (intervalNewData && !intervalNewDataHandeled) { // send sensor polling once at boot up
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/status/intervals"),mySettings.mqtt_mainTopic);
-        snprintf_P(MQTTpayloadStr,sizeof(MQTTpayloadStr), PSTR("{\"mlx_interval\":%lu,\"lcd_interval\":%lu,\"ccs811_mode\":%hhu,\"sgp30_interval\":%lu,\"scd30_interval\":%lu,\"sps30_interval\":%lu,\"bme68x_interval\":%lu,\"bme280_interval\":%lu}"),
-                  intervalMLX, intervalLCD, ccs811Mode, intervalSGP30, intervalSCD30, intervalSPS30, intervalBME68x, intervalBME280);
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        intervalNewData = false;
-        intervalNewDataHandeled = true;
-        yieldTime += yieldOS(); 
+/******************************************************************************************************/
+// Pending Topics
+/******************************************************************************************************/
 
-      } else {
-        // we have handeled all outstanding new data requests
-        scd30NewDataHandeled    = false;
-        sgp30NewDataHandeled    = false;
-        sps30NewDataHandeled    = false;
-        ccs811NewDataHandeled   = false;
-        bme68xNewDataHandeled   = false;
-        bme280NewDataHandeled   = false;
-        mlxNewDataHandeled      = false;
-        weatherNewDataHandeled  = false;
-        availNewDataHandeled    = false;
-        intervalNewDataHandeled = false;
-        systemNewDataHandeled   = false;
-      }
+void availJSONMQTT(char *payload, size_t len) {
+  snprintf_P(payload, len, PSTR("{\"mlx_avail\":%d,\"lcd_avail\":%d,\"ccs811_avail\":%d,\"sgp30_avail\":%d,\"scd30_avail\":%d,\"sps30_avail\":%d,\"bme68x_avail\":%d,\"bme280_avail\":%d,\"ntp_avail\":%d}"),
+             therm_avail, lcd_avail, ccs811_avail, sgp30_avail, scd30_avail, sps30_avail, bme68x_avail, bme280_avail, ntp_avail);
+}
 
-      // when minute changed, dont queue and send right away
-      if (timeNewData) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/status/time"),mySettings.mqtt_mainTopic);
-        timeJSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        timeNewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("Time MQTT updated")); }
-        mqtt_sent = true;
-        yieldTime += yieldOS(); 
-      }
+void intervalJSONMQTT(char *payload, size_t len) {
+  snprintf_P(payload, len, PSTR("{\"mlx_interval\":%lu,\"lcd_interval\":%lu,\"ccs811_mode\":%hhu,\"sgp30_interval\":%lu,\"scd30_interval\":%lu,\"sps30_interval\":%lu,\"bme68x_interval\":%lu,\"bme280_interval\":%lu}"),
+             intervalMLX, intervalLCD, ccs811Mode, intervalSGP30, intervalSCD30, intervalSPS30, intervalBME68x, intervalBME280);
+}
 
-      // when day changed, dont queue and send right away
-      if (dateNewData) {
-        snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr),PSTR("%s/status/date"),mySettings.mqtt_mainTopic);
-        dateJSONMQTT(MQTTpayloadStr, sizeof(MQTTpayloadStr));
-        mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-        dateNewData = false;
-        if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("Date MQTT updated")); }
-        mqtt_sent = true;
-        yieldTime += yieldOS(); 
-      }
-      
-    } // end send immidiate
-
-    // --------------- this creates single message ---------------------------------------------------------
-    else {
-      char MQTTpayloadStr[1024];                            // String allocated for MQTT message
-      updateMQTTpayload(MQTTpayloadStr, sizeof(MQTTpayloadStr));                    // creating payload String
-      snprintf_P(MQTTtopicStr, sizeof(MQTTtopicStr), PSTR("%s/data/all"),mySettings.mqtt_mainTopic);
-      if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(MQTTpayloadStr);}      
-      yieldTime += yieldOS(); 
-      mqttClient.publish(MQTTtopicStr, MQTTpayloadStr);
-      lastMQTTPublish = currentTime;
-      mqtt_sent = true;
-      yieldTime += yieldOS(); 
-    } // end send single message
+const char mqttTopicNames[MQTT_TOPICS][MQTT_TOPICLENGTH] PROGMEM = {
+  "status/system", "data/scd30", "data/sgp30", "data/sps30", "data/ccs811", "data/bme68x", "data/bme280", "data/mlx",
+  "data/weather", "status/sensors", "status/intervals", "status/time", "status/date"};
+
+const MQTTTopic mqttTopics[MQTT_TOPICS] = {
+  { &systemNewData,   systemJSONMQTT,   -1 },
+  { &scd30NewData,    scd30JSONMQTT,    TELEMETRY_SENSOR_SCD30  },
+  { &sgp30NewData,    sgp30JSONMQTT,    TELEMETRY_SENSOR_SGP30  },
+  { &sps30NewData,    sps30JSONMQTT,    TELEMETRY_SENSOR_SPS30  },
+  { &ccs811NewData,   ccs811JSONMQTT,   TELEMETRY_SENSOR_CCS811 },
+  { &bme68xNewData,   bme68xJSONMQTT,   TELEMETRY_SENSOR_BME68X },
+  { &bme280NewData,   bme280JSONMQTT,   TELEMETRY_SENSOR_BME280 },
+  { &mlxNewData,      mlxJSONMQTT,      TELEMETRY_SENSOR_MLX    },
+  { &weatherNewData,  weatherJSONMQTT,  -1 },
+  { &availNewData,    availJSONMQTT,    -1 },
+  { &intervalNewData, intervalJSONMQTT, -1 },
+  { &timeNewData,     timeJSONMQTT,     -1 },
+  { &dateNewData,     dateJSONMQTT,     -1 }
+};
+
+// Budget grows by the rates each millisecond, like the queue drain
+bool publishTopicsMQTT() {
+  unsigned long now     = millis();
+  unsigned long elapsed = now - lastMQTTTokens;
+  lastMQTTTokens = now;
+  if (elapsed > 60000) { elapsed = 60000; }
+  mqttMessageTokens += elapsed * mqttMessageRate;
+  mqttByteTokens    += elapsed * mqttByteRate;
+  if (mqttMessageTokens > mqttBurst    * 1000) { mqttMessageTokens = mqttBurst    * 1000; }
+  if (mqttByteTokens    > mqttByteRate * 1000) { mqttByteTokens    = mqttByteRate * 1000; }
+
+  // readings inside their deadband are dropped, the age of a topic starts when its flag is first seen
+  for (uint8_t i=0; i<MQTT_TOPICS; i++) {
+    if (mqttTopics[i].sensor >= 0) { telemetryFilter(TELEMETRY_MQTT, mqttTopics[i].sensor, mqttTopics[i].pending); }
+    if (!*mqttTopics[i].pending) {
+      mqttTopicStats[i].waiting = false;                  // dropped without a publish, the next reading starts a new age
+    } else if (!mqttTopicStats[i].waiting) {
+      mqttTopicStats[i].waiting = true;
+      mqttTopicStats[i].since   = currentTime;
+    }
   }
-  
-  // --------------- debug status ---------------------------------------------------------
-  if (mqtt_sent == true) {
-    if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("MQTT: published data")); }
+
+  char   *payload = mqttPayload;
+  bool    sent = false;
+  uint8_t n;
+  for (n=0; (n < MQTT_TOPICS) && (mqttMessageTokens >= 1000); n++) {
+    uint8_t i = (mqttNextTopic + n) % MQTT_TOPICS;
+    if (!*mqttTopics[i].pending) { continue; }
+
+    // a message larger than one second of budget goes out when the budget is full
+    // the length of the previous message is checked first, the payload is only built when it can be sent
+    bool   msgpack = (mqttTopics[i].sensor >= 0) && (mqttEncoding == TELEMETRY_MSGPACK);
+    size_t length  = mqttTopicStats[i].length;
+    if ( (mqttByteTokens < length * 1000) && (mqttByteTokens < mqttByteRate * 1000) ) { break; }
+    if (msgpack) { length = telemetryMsgPack(telemetryChannels[mqttTopics[i].sensor], (uint8_t *)payload, TELEMETRY_MAXSIZE); }
+    else         { mqttTopics[i].json(payload, sizeof(mqttPayload)); length = strlen(payload); }
+    mqttTopicStats[i].length = length;
+    if ( (mqttByteTokens < length * 1000) && (mqttByteTokens < mqttByteRate * 1000) ) { break; }
+
+    bool ok;
+    if (msgpack) {
+      MQTTFragment fragment = { (const uint8_t *)payload, (unsigned int)length, false };
+      ok = mqttClient.publishv(mqttTopic(mqttTopicNames[i]), &fragment, 1, false);
+    } else {
+      ok = publishMQTT(mqttTopic(mqttTopicNames[i]), payload);
+    }
+    if (!ok) { break; }                                     // stays pending
+
+    *mqttTopics[i].pending = false;
+    if (mqttTopics[i].sensor >= 0) { telemetrySent(TELEMETRY_MQTT, mqttTopics[i].sensor); }
+    mqttMessageTokens -= 1000;
+    mqttByteTokens     = (mqttByteTokens > length * 1000) ? mqttByteTokens - length * 1000 : 0;
+
+    MQTTTopicStats *stats = &mqttTopicStats[i];
+    unsigned long   age   = currentTime - stats->since;
+    stats->waiting = false;
+    stats->lastAge = age;
+    stats->meanAge = (stats->sent == 0) ? age : stats->meanAge - stats->meanAge / 8 + age / 8;
+    if (age > stats->maxAge) { stats->maxAge = age; }
+    stats->sent++;
+    if (mySettings.debuglevel == 3) {
+      char name[MQTT_TOPICLENGTH];
+      strncpy_P(name, mqttTopicNames[i], sizeof(name));
+      snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT: %s updated after %lu ms"), name, age); R_printSerialTelnetLogln(tmpStr);
+    }
+    sent = true;
+    yieldTime += yieldOS();
+  }
+  mqttNextTopic = (mqttNextTopic + n) % MQTT_TOPICS;      // the next pass starts where this one stopped
+  return sent;
+}
+
+// {"rate":4,"burst":8,"byterate":2048,"maxage":1200,"worst":"data/scd30"}
+void topicsJSONMQTT(char *payload, size_t len) {
+  uint8_t worst = 0;
+  for (uint8_t i=1; i<MQTT_TOPICS; i++) { if (mqttTopicStats[i].maxAge > mqttTopicStats[worst].maxAge) { worst = i; } }
+  char name[MQTT_TOPICLENGTH];
+  strncpy_P(name, mqttTopicNames[worst], sizeof(name));
+  snprintf_P(payload, len, PSTR("{\"rate\":%lu,\"burst\":%lu,\"byterate\":%lu,\"maxage\":%lu,\"worst\":\"%s\"}"),
+             mqttMessageRate, mqttBurst, mqttByteRate, mqttTopicStats[worst].maxAge, name);
+}
+
+void printTopicsMQTT() {
+  char name[MQTT_TOPICLENGTH];
+  printSerialTelnetLogln(F("Topic                  Sent  Age [ms]:  last    mean     max"));
+  for (uint8_t i=0; i<MQTT_TOPICS; i++) {
+    strncpy_P(name, mqttTopicNames[i], sizeof(name));
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%-18s %8lu %15lu %7lu %7lu%s"), name, (unsigned long)mqttTopicStats[i].sent,
+               mqttTopicStats[i].lastAge, mqttTopicStats[i].meanAge, mqttTopicStats[i].maxAge, mqttTopicStats[i].waiting ? " pending" : "");
+    printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+  }
+}
+
+void resetTopicsMQTT() {
+  for (uint8_t i=0; i<MQTT_TOPICS; i++) {
+    mqttTopicStats[i].sent    = 0;
+    mqttTopicStats[i].lastAge = 0;
+    mqttTopicStats[i].meanAge = 0;
+    mqttTopicStats[i].maxAge  = 0;
   }
 }
 
@@ -406,52 +399,92 @@ void updateMQTTMessage() {
 
   // NEED TO FIX THIS TO MATCH MQTT ENTRIES OF SINGLE SENSOR UPDATES
 
-void updateMQTTpayload(char *payload, size_t len) {
-  char tmpbuf[24];
-  strcpy(payload, "{");
-  if (scd30_avail && mySettings.useSCD30)   { // ==CO2===========================================================
-    strncat(payload,"\"scd30_CO2\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4dppm"),  int(scd30_ppm));                strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload)); 
-    strncat(payload,"\"scd30_rH\":",       len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4.1f%%"),     scd30_hum);                 strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"scd30_T\":",        len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%+5.1fC"),     scd30_temp);                strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-  }  // end if avail scd30
-  if (bme68x_avail && mySettings.useBME68x) { // ===rH,T,aQ=================================================
-    strncat(payload,"\"bme68x_p\":",       len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4dbar"),(int)(bme68x.pressure/100.0));    strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload)); 
-    strncat(payload,"\"bme68x_rH\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4.1f%%"),     bme68x.humidity);           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"bme68x_aH\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4.1fg"),      bme68x_ah);                 strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"bme68x_T\":",       len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%+5.1fC"),     bme68x.temperature);        strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"bme68x_aq\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%dOhm"),       bme68x.gas_resistance);     strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-  } // end if avail bme68x
-  if (bme280_avail && mySettings.useBME280) { // ===rH,T,aQ=================================================
-    strncat(payload,"\"bme280_p\":",       len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4dbar"),(int)(bme280_pressure/100.0));    strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload)); 
-    strncat(payload,"\"bme280_rH\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4.1f%%"),     bme280_hum);                strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"bme280_aH\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4.1fg"),      bme280_ah);                 strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"bme280_T\":",       len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%+5.1fC"),     bme280_temp);               strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-  } // end if avail bme68x
-  if (sgp30_avail && mySettings.useSGP30)   { // ===CO2,tVOC=================================================
-    strncat(payload,"\"sgp30_CO2\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4dppm"),      sgp30.CO2);                 strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sgp30_tVOC\":",     len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4dppb"),      sgp30.TVOC);                strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-  } // end if avail sgp30
-  if (ccs811_avail && mySettings.useCCS811) { // ===CO2,tVOC=================================================
-    strncat(payload,"\"ccs811_CO2\":",     len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4dppm"),      ccs811.getCO2());           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"ccs811_tVOC\":",    len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%4dppb"),      ccs811.getTVOC());          strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-  } // end if avail ccs811
-  if (sps30_avail && mySettings.useSPS30)   { // ===Particle=================================================
-    strncat(payload,"\"sps30_PM1\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0fµg/m3"),  valSPS30.mc_1p0);           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_PM2\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0fµg/m3"),  valSPS30.mc_2p5);           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_PM4\":",      len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0fµg/m3"),  valSPS30.mc_4p0);           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_nPM10\":",    len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0fµg/m3"),  valSPS30.mc_10p0);          strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_nPM0\":",     len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0f#/m3"),   valSPS30.nc_0p5);           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_nPM2\":",     len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0f#/m3"),   valSPS30.nc_2p5);           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_nPM4\":",     len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0f#/m3"),   valSPS30.nc_4p0);           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_nPM10\":",    len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0f#/m3"),   valSPS30.nc_10p0);          strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"sps30_PartSize\":", len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%3.0fµm"),     valSPS30.typical_particle_size); strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-  }// end if avail SPS30
-  if (therm_avail && mySettings.useMLX)     { // ====To,Ta================================================
-    strncat(payload,"\"MLX_To\":",         len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%+5.1fC"),    (therm.object()+mlxOffset)); strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-    strncat(payload,"\"MLX_Ta\":",         len-strlen(payload)); snprintf_P(tmpbuf, sizeof(tmpbuf), PSTR("%+5.1fC"),     therm.ambient());           strncat(payload,tmpbuf, len-strlen(payload)); strncat(payload,", ", len-strlen(payload));
-  }// end if avail  MLX
-  strncat(payload, "}",                    len-strlen(payload));
-} // update MQTT
+// One field of the /data/all message, field 0 opens and the last field closes the message.
+// Fields of sensors that are not available have length 0.
+size_t allJSONMQTT(uint8_t field, char *payload, size_t len) {
+  int l = 0;
+  switch (field) {
+    case  0: { l = snprintf_P(payload, len, PSTR("{")); break; }
+    // ==CO2===========================================================
+    case  1: { if (scd30_avail && mySettings.useSCD30)   { l = snprintf_P(payload, len, PSTR("\"scd30_CO2\":%4dppm, "),       int(scd30_ppm)); }                     break; }
+    case  2: { if (scd30_avail && mySettings.useSCD30)   { l = snprintf_P(payload, len, PSTR("\"scd30_rH\":%4.1f%%, "),       scd30_hum); }                          break; }
+    case  3: { if (scd30_avail && mySettings.useSCD30)   { l = snprintf_P(payload, len, PSTR("\"scd30_T\":%+5.1fC, "),        scd30_temp); }                         break; }
+    // ===rH,T,aQ=================================================
+    case  4: { if (bme68x_avail && mySettings.useBME68x) { l = snprintf_P(payload, len, PSTR("\"bme68x_p\":%4dbar, "),        (int)(bme68x.pressure/100.0)); }       break; }
+    case  5: { if (bme68x_avail && mySettings.useBME68x) { l = snprintf_P(payload, len, PSTR("\"bme68x_rH\":%4.1f%%, "),      bme68x.humidity); }                    break; }
+    case  6: { if (bme68x_avail && mySettings.useBME68x) { l = snprintf_P(payload, len, PSTR("\"bme68x_aH\":%4.1fg, "),       bme68x_ah); }                          break; }
+    case  7: { if (bme68x_avail && mySettings.useBME68x) { l = snprintf_P(payload, len, PSTR("\"bme68x_T\":%+5.1fC, "),       bme68x.temperature); }                 break; }
+    case  8: { if (bme68x_avail && mySettings.useBME68x) { l = snprintf_P(payload, len, PSTR("\"bme68x_aq\":%dOhm, "),        (int)bme68x.gas_resistance); }         break; }
+    // ===rH,T,aQ=================================================
+    case  9: { if (bme280_avail && mySettings.useBME280) { l = snprintf_P(payload, len, PSTR("\"bme280_p\":%4dbar, "),        (int)(bme280_pressure/100.0)); }       break; }
+    case 10: { if (bme280_avail && mySettings.useBME280) { l = snprintf_P(payload, len, PSTR("\"bme280_rH\":%4.1f%%, "),      bme280_hum); }                         break; }
+    case 11: { if (bme280_avail && mySettings.useBME280) { l = snprintf_P(payload, len, PSTR("\"bme280_aH\":%4.1fg, "),       bme280_ah); }                          break; }
+    case 12: { if (bme280_avail && mySettings.useBME280) { l = snprintf_P(payload, len, PSTR("\"bme280_T\":%+5.1fC, "),       bme280_temp); }                        break; }
+    // ===CO2,tVOC=================================================
+    case 13: { if (sgp30_avail && mySettings.useSGP30)   { l = snprintf_P(payload, len, PSTR("\"sgp30_CO2\":%4dppm, "),       sgp30.CO2); }                          break; }
+    case 14: { if (sgp30_avail && mySettings.useSGP30)   { l = snprintf_P(payload, len, PSTR("\"sgp30_tVOC\":%4dppb, "),      sgp30.TVOC); }                         break; }
+    // ===CO2,tVOC=================================================
+    case 15: { if (ccs811_avail && mySettings.useCCS811) { l = snprintf_P(payload, len, PSTR("\"ccs811_CO2\":%4dppm, "),      ccs811.getCO2()); }                    break; }
+    case 16: { if (ccs811_avail && mySettings.useCCS811) { l = snprintf_P(payload, len, PSTR("\"ccs811_tVOC\":%4dppb, "),     ccs811.getTVOC()); }                   break; }
+    // ===Particle=================================================
+    case 17: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_PM1\":%3.0fµg/m3, "),   valSPS30.mc_1p0); }                    break; }
+    case 18: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_PM2\":%3.0fµg/m3, "),   valSPS30.mc_2p5); }                    break; }
+    case 19: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_PM4\":%3.0fµg/m3, "),   valSPS30.mc_4p0); }                    break; }
+    case 20: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_nPM10\":%3.0fµg/m3, "), valSPS30.mc_10p0); }                   break; }
+    case 21: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_nPM0\":%3.0f#/m3, "),   valSPS30.nc_0p5); }                    break; }
+    case 22: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_nPM2\":%3.0f#/m3, "),   valSPS30.nc_2p5); }                    break; }
+    case 23: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_nPM4\":%3.0f#/m3, "),   valSPS30.nc_4p0); }                    break; }
+    case 24: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_nPM10\":%3.0f#/m3, "),  valSPS30.nc_10p0); }                   break; }
+    case 25: { if (sps30_avail && mySettings.useSPS30)   { l = snprintf_P(payload, len, PSTR("\"sps30_PartSize\":%3.0fµm, "), valSPS30.typical_particle_size); }     break; }
+    // ====To,Ta================================================
+    case 26: { if (therm_avail && mySettings.useMLX)     { l = snprintf_P(payload, len, PSTR("\"MLX_To\":%+5.1fC, "),         (therm.object()+mlxOffset)); }         break; }
+    case 27: { if (therm_avail && mySettings.useMLX)     { l = snprintf_P(payload, len, PSTR("\"MLX_Ta\":%+5.1fC, "),         therm.ambient()); }                    break; }
+    case 28: { l = snprintf_P(payload, len, PSTR("}")); break; }
+    default: { break; }
+  }
+  if (l < 0) { return 0; }
+  return ((size_t)l < len) ? (size_t)l : len-1;
+}
+
+// The message is written into the socket field by field.
+// The first pass only adds up the length, MQTT needs it in the header before the payload.
+bool publishAllMQTT(const char *topic) {
+  char   payload[MQTT_ALLCHUNK];
+  size_t length = 0;
+  size_t l = 0;
+  for (uint8_t i=0; i<MQTT_ALLFIELDS; i++) { length += allJSONMQTT(i, payload, MQTT_ALLFIELDLENGTH); }
+  if (!mqttClient.beginPublish(topic, length, false)) { return false; }
+  if (mySettings.debuglevel == 3) { R_printSerialTelnetLog(F("")); }
+  for (uint8_t i=0; i<MQTT_ALLFIELDS; i++) {
+    if (l > sizeof(payload) - MQTT_ALLFIELDLENGTH) {       // next field might not fit
+      mqttClient.write((const uint8_t *)payload, l);
+      if (mySettings.debuglevel == 3) { printSerialTelnetLog(payload); }
+      l = 0;
+    }
+    l += allJSONMQTT(i, payload+l, MQTT_ALLFIELDLENGTH);
+  }
+  mqttClient.write((const uint8_t *)payload, l);
+  if (mySettings.debuglevel == 3) { printSerialTelnetLogln(payload); }
+  return (mqttClient.endPublish() == 1);
+}
+
+// The payload is handed to the client as fragment, unlike publish() it is not limited by the client buffer size
+bool publishMQTT(const char *topic, const char *payload) {
+  MQTTFragment fragment = { (const uint8_t *)payload, (unsigned int)strlen(payload), false };
+  return mqttClient.publishv(topic, &fragment, 1, false);
+}
+
+// Topic is main topic and suffix, the main topic part is only rebuilt when the setting changed
+const char *mqttTopic(const char *suffix) {
+  if ( (mqttTopicLength == 0) || 
+       (strncmp(mqttTopicStr, mySettings.mqtt_mainTopic, mqttTopicLength-1) != 0) || 
+       (mySettings.mqtt_mainTopic[mqttTopicLength-1] != '\0') ) {
+    mqttTopicLength = snprintf_P(mqttTopicStr, sizeof(mqttTopicStr), PSTR("%s/"), mySettings.mqtt_mainTopic);
+  }
+  strncpy_P(mqttTopicStr + mqttTopicLength, suffix, sizeof(mqttTopicStr) - mqttTopicLength);
+  mqttTopicStr[sizeof(mqttTopicStr)-1] = '\0';
+  return mqttTopicStr;
+}
 
 /******************************************************************************************************/
 // MQTT Call Back in case we receive MQTT message from network
@@ -5,12 +5,13 @@
 #include "src/WiFi.h"
 #include "src/Sensi.h"
 #include "src/Print.h"
+#include "src/Profile.h"
+#include "src/Archive.h"
 
 // Extern variables
 extern unsigned long yieldTime;        // Sensi
 extern unsigned long lastYield;        // Sensi
 extern unsigned long lastOTA;          // WiFi
-extern unsigned long AllmaxUpdateOTA;  // Sensi
 extern Settings      mySettings;       // Config
 extern unsigned long currentTime;      // Sensi
 extern char          tmpStr[256];      // Sensi
@@ -24,6 +25,9 @@ void onstartOTA() {
     if (ArduinoOTA.getCommand() == U_FLASH) { R_printSerialTelnetLogln(F("OTA: starting sketch")); }
     else { R_printSerialTelnetLogln(F("OTA: starting filesystem")); }  // U_SPIFFS, LittleFS
  }
+ flushArchive();
+ flushQueue();
+ flushLog();
  LittleFS.end();
  otaInProgress = true;
 }
@@ -96,7 +100,7 @@ void updateOTA() {
         ArduinoOTA.begin(true);                            //start and use mDNS
         if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("OTA: ready")); }
         stateOTA = CHECK_CONNECTION;
-        AllmaxUpdateOTA = 0;
+        resetProfile(PROFILE_OTA);
       } // currentTime
       break;
     } // startup
@@ -12,6 +12,15 @@ extern bool          telnetConnected;
 extern ESPTelnet     Telnet;
 extern File          logFile;
 extern tm           *localTime;
+extern time_t        actualTime;
+
+char          logBuffer[LOGBUFFERSIZE];                    // log entries not yet written
+size_t        logHead  = 0;                                // next byte is written here
+size_t        logCount = 0;                                // bytes buffered
+unsigned long logDropped = 0;                              // entries that did not fit
+char          logStamp[24];                                // time stamp prefix of entries
+size_t        logStampLength = 0;                          //
+time_t        logStampTime = 0;                            // actualTime of logStamp
 
 /******************************************************************************************************/
 // Printing Options for Serial, Telnet, Logfile
@@ -24,7 +33,7 @@ extern tm           *localTime;
 // Printing to log file adds time stamp
 /******************************************************************************************************/
 
-void printSerial(char* str) {
+void printSerial(const char* str) {
   if ( mySettings.useSerial ) { Serial.print(str); }
 }
 
@@ -32,7 +41,7 @@ void printSerial(String str) {
   if ( mySettings.useSerial ) { Serial.print(str); }
 }
 
-void printSerialln(char* str) {
+void printSerialln(const char* str) {
   if ( mySettings.useSerial ) { Serial.print(str); Serial.print("\r\n"); }
 }
 
@@ -44,7 +53,7 @@ void printSerialln(String str) {
   if ( mySettings.useSerial ) { Serial.print(str); Serial.print("\r\n"); }
 }
 
-void printTelnet(char* str) {
+void printTelnet(const char* str) {
   if ( mySettings.useTelnet && telnetConnected ) { Telnet.print(str); } 
 }
 
@@ -52,7 +61,7 @@ void printTelnet(String str) {
   if ( mySettings.useTelnet && telnetConnected ) { Telnet.print(str); } 
 }
 
-void printTelnetln(char* str) {
+void printTelnetln(const char* str) {
   if ( mySettings.useTelnet && telnetConnected ) { Telnet.print(str); Telnet.print("\r\n"); } 
 }
 
@@ -64,85 +73,95 @@ void printTelnetln() {
   if ( mySettings.useTelnet && telnetConnected ) { Telnet.print("\r\n"); } 
 }
 
-void printLog(char* str) {
-  if ( mySettings.useLog ) { 
-    if ( !logFile ) { logFile = LittleFS.open("/Sensi.log", "a"); }  // we close log file regularly in main loop
-    if (  logFile ) { 
-      char buf[24];
-      snprintf_P(buf,sizeof(buf),PSTR("%2d.%2d.%2d %2d:%2d:%2d "), 
-              (localTime->tm_mon+1), 
-               localTime->tm_mday,
-              (localTime->tm_year%100),
-               localTime->tm_hour, 
-               localTime->tm_min,    
-               localTime->tm_sec);
-      logFile.print(buf); 
-      logFile.print(str); }
-  }
+void printLog(const char* str) {
+  if ( mySettings.useLog ) { appendLog(str, strlen(str), false); }
 }
 
-void printLogln(char* str) {
-  if ( mySettings.useLog ) { 
-    if ( !logFile ) { logFile = LittleFS.open("/Sensi.log", "a"); }  // we close log file regularly in main loop
-    if (  logFile ) { 
-      char buf[24];
-      snprintf_P(buf,sizeof(buf),PSTR("%2d.%2d.%2d %2d:%2d:%2d "), 
-              (localTime->tm_mon+1), 
-               localTime->tm_mday,
-              (localTime->tm_year%100),
-               localTime->tm_hour, 
-               localTime->tm_min,    
-               localTime->tm_sec);
-      logFile.print(buf); 
-      logFile.print(str); 
-      logFile.print("\r\n"); }
-  }
+void printLogln(const char* str) {
+  if ( mySettings.useLog ) { appendLog(str, strlen(str), true); }
 }
 
 void printLog(String str) {
-  if ( mySettings.useLog ) { 
-    if ( !logFile ) { logFile = LittleFS.open("/Sensi.log", "a"); }  // we close log file regularly in main loop
-    if (  logFile ) { 
-      char buf[24];
-      snprintf_P(buf,sizeof(buf),PSTR("%2d.%2d.%2d %2d:%2d:%2d "), 
-              (localTime->tm_mon+1), 
-               localTime->tm_mday,
-              (localTime->tm_year%100),
-               localTime->tm_hour, 
-               localTime->tm_min,    
-               localTime->tm_sec);
-      logFile.print(buf); 
-      logFile.print(str); }
-  }
+  if ( mySettings.useLog ) { appendLog(str.c_str(), str.length(), false); }
 }
 
 void printLogln(String str) {
-  if ( mySettings.useLog ) { 
-    if ( !logFile ) { logFile = LittleFS.open("/Sensi.log", "a"); }  // we close log file regularly in main loop
-    if (  logFile ) { 
-      char buf[24];
-      snprintf_P(buf,sizeof(buf),PSTR("%2d.%2d.%2d %2d:%2d:%2d "), 
-              (localTime->tm_mon+1), 
-               localTime->tm_mday,
-              (localTime->tm_year%100),
-               localTime->tm_hour, 
-               localTime->tm_min,    
-               localTime->tm_sec);
-      logFile.print(buf); 
-      logFile.print(str); 
-      logFile.print("\r\n"); 
-    }
-  }
+  if ( mySettings.useLog ) { appendLog(str.c_str(), str.length(), true); }
 }
 
 void printLogln() {
-  if ( mySettings.useLog ) { 
-    if ( !logFile ) { logFile = LittleFS.open("/Sensi.log", "a"); }  // we close log file regularly in main loop
-    if (  logFile ) { logFile.print("\r\n"); }                       // only if we were able to open logfile
+  if ( mySettings.useLog ) { appendLog("", 0, true); }
+}
+
+/******************************************************************************************************/
+// Log Buffer
+/******************************************************************************************************/
+// Log entries are collected in a RAM ring and written to /Sensi.log in batches,
+// when LOGFLUSHSIZE bytes are buffered and the loop is idle, by taskLogFile, when the ring is full and before reboot.
+// Entries that do not fit after a flush are dropped and counted, the count is written to the log with the next flush.
+// The time stamp is formatted once per second.
+
+void appendLog(const char* str, size_t len, bool newLine) {
+  if ( (len > 0) && (logStampTime != actualTime) ) {
+    logStampLength = snprintf_P(logStamp, sizeof(logStamp), PSTR("%2d.%2d.%2d %2d:%2d:%2d "),
+                                (localTime->tm_mon+1),
+                                 localTime->tm_mday,
+                                (localTime->tm_year%100),
+                                 localTime->tm_hour,
+                                 localTime->tm_min,
+                                 localTime->tm_sec);
+    logStampTime = actualTime;
+  }
+  size_t total = ((len > 0) ? logStampLength + len : 0) + (newLine ? 2 : 0);
+  if (total > LOGBUFFERSIZE - logCount) { flushLog(); }                 // ring is full
+  if (total > LOGBUFFERSIZE - logCount) { logDropped++; return; }
+  if (len > 0) {
+    appendLogBytes(logStamp, logStampLength);
+    appendLogBytes(str, len);
+  }
+  if (newLine) { appendLogBytes("\r\n", 2); }
+}
+
+void appendLogBytes(const char* data, size_t len) {
+  size_t first = LOGBUFFERSIZE - logHead;                               // bytes until end of ring
+  if (first > len) { first = len; }
+  memcpy(&logBuffer[logHead], data, first);
+  memcpy(&logBuffer[0], data + first, len - first);
+  logHead   = (logHead + len) % LOGBUFFERSIZE;
+  logCount += len;
+}
+
+size_t logBuffered() {
+  return logCount;
+}
+
+// write buffered entries, start new log file when it grew beyond LOGFILESIZE
+void flushLog() {
+  if ( (logCount == 0) && (logDropped == 0) ) { return; }
+  logFile = LittleFS.open("/Sensi.log", "a");
+  if ( !logFile ) { return; }                                          // entries stay buffered
+  size_t tail  = (logHead + LOGBUFFERSIZE - logCount) % LOGBUFFERSIZE;  // oldest byte
+  size_t first = LOGBUFFERSIZE - tail;
+  if (first > logCount) { first = logCount; }
+  logFile.write((const uint8_t *)&logBuffer[tail], first);
+  logFile.write((const uint8_t *)&logBuffer[0], logCount - first);
+  logCount = 0;
+  if (logDropped > 0) {
+    char buf[48];
+    snprintf_P(buf, sizeof(buf), PSTR("%s%lu log entries dropped\r\n"), logStamp, logDropped);
+    logFile.write((const uint8_t *)buf, strlen(buf));
+    logDropped = 0;
+  }
+  if (logFile.size() > LOGFILESIZE) {
+    logFile.close();
+    LittleFS.remove("/Sensi.bak");
+    LittleFS.rename("/Sensi.log", "/Sensi.bak");
+  } else {
+    logFile.close();
   }
 }
 
-void printSerialTelnet(char* str) {
+void printSerialTelnet(const char* str) {
   printTelnet(str);
   printSerial(str);
 }
@@ -152,7 +171,7 @@ void printSerialTelnet(String str) {
   printSerial(str);
 }
 
-void printSerialTelnetln(char* str) {
+void printSerialTelnetln(const char* str) {
   printTelnetln(str);
   printSerialln(str);
 }
@@ -163,7 +182,7 @@ void printSerialTelnetln(String str) {
 }
 
 
-void printSerialTelnetLog(char* str) {
+void printSerialTelnetLog(const char* str) {
   printTelnet(str);
   printLog(str);
   printSerial(str);
@@ -175,7 +194,7 @@ void printSerialTelnetLog(String str) {
   printSerial(str);
 }
 
-void printSerialTelnetLogln(char* str) {
+void printSerialTelnetLogln(const char* str) {
   printTelnetln(str);
   printLogln(str);
   printSerialln(str);
@@ -193,7 +212,7 @@ void printSerialTelnetLogln() {
   printSerialln();
 }
 
-void printSerialLog(char* str) {
+void printSerialLog(const char* str) {
   printLog(str);
   printSerial(str);
 }
@@ -203,7 +222,7 @@ void printSerialLog(String str) {
   printSerial(str);
 }
 
-void printSerialLogln(char* str) {
+void printSerialLogln(const char* str) {
   printLogln(str);
   printSerialln(str);
 }
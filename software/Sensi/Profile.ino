@@ -0,0 +1,125 @@
+/******************************************************************************************************/
+// Execution Time Profiling
+/******************************************************************************************************/
+#include "src/Profile.h"
+#include "src/Config.h"
+#include "src/Sensi.h"
+#include "src/Print.h"
+
+Profile       profiles[NUMPROFILES];
+
+const char    profileNames[NUMPROFILES][13] PROGMEM = {"Time&Date", "WiFi", "OTA", "NTP", "MQTT", "WebSocket", "HTTP", "HTTPupd",
+                                                       "mDNS", "Telnet", "Weather",
+                                                       "SCD30", "SGP30", "CCS811", "SPS30", "BME280", "BME68x", "MLX", "MAX30",
+                                                       "MQTTmsg", "WSmsg", "LCD", "Input", "RunTime", "EEPROM", "LogFile",
+                                                       "Baseline", "AllGood", "Blink", "Reboot", "I2C", "I2Cqueue", "History", "SysStatus"};
+
+// External Variables
+extern Settings      mySettings;       // Config
+extern unsigned long yieldTime;        // Sensi
+extern char          tmpStr[256];      // Sensi
+
+/******************************************************************************************************/
+// Record
+/******************************************************************************************************/
+
+void recordProfile(uint8_t id, unsigned long duration) {
+  if (id >= NUMPROFILES) { return; }
+  Profile *profile = &profiles[id];
+  profile->count++;
+  profile->sum += duration;
+  if (profile->max < duration) { profile->max = duration; }
+
+  // bucket is the number of significant bits above PROFILEMINTIME
+  uint8_t       b = 0;
+  unsigned long v = duration / PROFILEMINTIME;
+  while ( v && (b < PROFILEBUCKETS-1) ) { v >>= 1; b++; }
+
+  if (profile->bucket[b] == 0xFFFF) {
+    for (uint8_t i=0; i<PROFILEBUCKETS; i++) { profile->bucket[i] >>= 1; }
+  }
+  profile->bucket[b]++;
+}
+
+void resetProfile(uint8_t id) {
+  if (id >= NUMPROFILES) { return; }
+  memset(&profiles[id], 0, sizeof(Profile));
+}
+
+/******************************************************************************************************/
+// Evaluate
+/******************************************************************************************************/
+
+unsigned long profilePercentile(uint8_t id, uint8_t percent) {
+  if (id >= NUMPROFILES) { return 0; }
+  Profile *profile = &profiles[id];
+  uint32_t total = 0;
+  for (uint8_t i=0; i<PROFILEBUCKETS; i++) { total += profile->bucket[i]; }
+  if (total == 0) { return 0; }
+
+  uint32_t target = (total * percent + 99) / 100;          // rounded up
+  uint32_t cumulative = 0;
+  for (uint8_t i=0; i<PROFILEBUCKETS; i++) {
+    cumulative += profile->bucket[i];
+    if (cumulative >= target) {
+      unsigned long upper = (unsigned long)PROFILEMINTIME << i;
+      // last bucket is open ended, no execution took longer than max
+      if ( (i == PROFILEBUCKETS-1) || (upper > profile->max) ) { upper = profile->max; }
+      return upper;
+    }
+  }
+  return profile->max;
+}
+
+const char *profileName(uint8_t id) {
+  if (id >= NUMPROFILES) { return PSTR("n.a."); }
+  return profileNames[id];
+}
+
+/******************************************************************************************************/
+// Print
+/******************************************************************************************************/
+// Times are displayed in ms, subsystems that did not run are omitted
+
+void printProfiles() {
+  printSerialTelnetLogln(F("Subsystem       Count    Avg    p50    p95    p99    Max [ms]"));
+  for (uint8_t i=0; i<NUMPROFILES; i++) {
+    Profile *profile = &profiles[i];
+    if (profile->count == 0) { continue; }
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%-12s %8lu %6.1f %6.1f %6.1f %6.1f %6.1f"),
+               profileNames[i],
+               (unsigned long)profile->count,
+               float(profile->sum / profile->count)/1000.,
+               float(profilePercentile(i, 50))/1000.,
+               float(profilePercentile(i, 95))/1000.,
+               float(profilePercentile(i, 99))/1000.,
+               float(profile->max)/1000.);
+    printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+  }
+}
+
+/******************************************************************************************************/
+// JSON
+/******************************************************************************************************/
+// "SCD30": {"count": 1234, "avg": 123, "p50": 128, "p95": 512, "p99": 1024, "max": 900, "hist": [1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16]}
+// times are in [us], histogram bucket i ends at PROFILEMINTIME << i
+// Creates one member of the profile object, the caller joins the subsystems
+
+void profileJSON(uint8_t id, char *payLoad, size_t len) {
+  if (id >= NUMPROFILES) { payLoad[0] = '\0'; return; }
+  Profile *profile = &profiles[id];
+  char hist[7*PROFILEBUCKETS];
+  size_t l = 0;
+  for (uint8_t i=0; (i<PROFILEBUCKETS) && (l<sizeof(hist)); i++) {
+    l += snprintf_P(hist+l, sizeof(hist)-l, (i==0) ? PSTR("%u") : PSTR(",%u"), profile->bucket[i]);
+  }
+  snprintf_P(payLoad, len, PSTR("\"%s\": {\"count\": %lu, \"avg\": %lu, \"p50\": %lu, \"p95\": %lu, \"p99\": %lu, \"max\": %lu, \"hist\": [%s]}"),
+             profileNames[id],
+             (unsigned long)profile->count,
+             (profile->count > 0) ? (unsigned long)(profile->sum / profile->count) : 0UL,
+             profilePercentile(id, 50),
+             profilePercentile(id, 95),
+             profilePercentile(id, 99),
+             (unsigned long)profile->max,
+             hist);
+}
@@ -0,0 +1,276 @@
+/******************************************************************************************************/
+// MQTT Queue
+/******************************************************************************************************/
+#include "src/Queue.h"
+#include "src/History.h"
+#include "src/MQTT.h"
+#include "src/Config.h"
+#include "src/Sensi.h"
+#include "src/Print.h"
+
+// External Variables
+extern Settings      mySettings;       // Config
+extern unsigned long yieldTime;        // Sensi
+extern char          tmpStr[256];      // Sensi
+extern bool          fsOK;             // Sensi
+extern bool          timeSynced;       // NTP
+extern PubSubClient  mqttClient;       // MQTT
+extern char          mqttPayload[MQTT_PAYLOADSIZE];
+extern const char    historyNames[HISTORY_CHANNELS][HISTORY_NAMELENGTH] PROGMEM; // History
+extern HistorySource historySources[HISTORY_CHANNELS];
+
+uint8_t       queueBuffer[QUEUE_RAMSIZE];                              // records not published and not in file
+uint16_t      queueHead = 0;                                           // next record is written here
+uint16_t      queueTail = 0;                                           // next record to publish
+uint32_t      queueRAMRecords = 0;                                     // records in RAM
+uint32_t      queueFileRecords = 0;                                    // records in file not published
+uint32_t      queueFileSize = 0;                                       // [bytes]
+uint32_t      queueFileRead = 0;                                       // [bytes] of file published
+unsigned long queueDropped = 0;                                        // records lost because the file was full
+unsigned long queuePublished = 0;                                      // records sent after reconnect
+unsigned long queueMessageRate = QUEUE_MESSAGERATE;                    // [1/s] drain rate
+unsigned long queueByteRate = QUEUE_BYTERATE;                          // [bytes/s] drain rate
+unsigned long queueMessageTokens = 0;                                  // [1/1000 message] budget
+unsigned long queueByteTokens = 0;                                     // [1/1000 byte] budget
+unsigned long lastQueueDrain = 0;                                      // [ms] budget was updated
+QueueSent     queueSent[MQTT_MAX_INFLIGHT];                            // oldest records published and waiting for PUBACK
+uint8_t       queueSentCount = 0;                                      //
+
+/******************************************************************************************************/
+// Initialize
+/******************************************************************************************************/
+
+// A queue file left from before the reset is sent again from the start
+void initializeQueue() {
+  QueueRecord record;
+  if (!fsOK || !LittleFS.exists(QUEUE_FILE)) { return; }
+  File file = LittleFS.open(QUEUE_FILE, "r");
+  queueFileSize = file.size();
+  while (file.read((uint8_t *)&record, sizeof(record)) == sizeof(record)) {
+    uint32_t next = file.position() + __builtin_popcount(record.channels) * sizeof(float);
+    if (next > queueFileSize) { break; }                   // record cut short by reset
+    file.seek(next, SeekSet);
+    queueFileRecords++;
+  }
+  file.close();
+  if (mySettings.debuglevel > 0) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT queue: %u records waiting"), queueFileRecords);
+    R_printSerialTelnetLogln(tmpStr);
+  }
+}
+
+/******************************************************************************************************/
+// Queue
+/******************************************************************************************************/
+
+void updateQueue() {
+  if (!timeSynced) { return; }
+  QueueRecord record = { (uint32_t)time(NULL), 0 };
+  float       values[HISTORY_CHANNELS];
+  uint8_t     n = 0;
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    uint16_t count = historyCount(i, 1);
+    if (count == 0) { continue; }
+    float min, mean, max;
+    record.channels |= 1UL << i;
+    values[n++] = historySample(i, 1, count-1, &min, &mean, &max) ? mean : NAN;
+  }
+  if (record.channels == 0) { return; }
+
+  size_t size = sizeof(record) + n * sizeof(float);
+  if (queueHead + size > QUEUE_RAMSIZE) { flushQueue(); }
+  if (queueHead + size > QUEUE_RAMSIZE) { queueDropped++; return; }
+  memcpy(queueBuffer + queueHead, &record, sizeof(record));
+  memcpy(queueBuffer + queueHead + sizeof(record), values, n * sizeof(float));
+  queueHead += size;
+  queueRAMRecords++;
+}
+
+// Records in RAM are newer than the ones in the file, they are appended
+void flushQueue() {
+  if (queueTail > 0) {                                     // published part of RAM is free again
+    memmove(queueBuffer, queueBuffer + queueTail, queueHead - queueTail);
+    queueHead -= queueTail;
+    queueTail  = 0;
+  }
+  if ( (queueHead == 0) || !fsOK ) { return; }
+  if (queueFileSize + queueHead > QUEUE_FILESIZE) {
+    queueDropped  += queueRAMRecords - queueSentRAM();
+    queueSentCount = queueSentFile();                      // client still delivers the records it holds
+  } else {
+    File file = LittleFS.open(QUEUE_FILE, "a");
+    if (!file) { return; }
+    size_t written = file.write(queueBuffer, queueHead);
+    file.close();
+    if (written != queueHead) {
+      if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("MQTT queue: could not write file")); }
+      return;
+    }
+    queueFileSize    += queueHead;
+    queueFileRecords += queueRAMRecords;
+  }
+  queueHead = 0;
+  queueRAMRecords = 0;
+  yieldTime += yieldOS();
+}
+
+uint32_t queueDepth() { return queueFileRecords + queueRAMRecords; }
+
+/******************************************************************************************************/
+// Drain
+/******************************************************************************************************/
+
+// Records published and waiting for PUBACK are the oldest ones, those in the file come first
+uint8_t queueSentFile() { return (queueSentCount < queueFileRecords) ? queueSentCount : queueFileRecords; }
+uint8_t queueSentRAM()  { return queueSentCount - queueSentFile(); }
+
+uint32_t queueSentBytes(uint8_t first, uint8_t last) {
+  uint32_t bytes = 0;
+  for (uint8_t i=first; i<last; i++) { bytes += queueSent[i].size; }
+  return bytes;
+}
+
+// Oldest record not published yet, from the file first. Returns its size in the queue, 0 if there is none.
+size_t peekQueue(QueueRecord *record, float *values) {
+  uint8_t inFile = queueSentFile();
+  if (queueFileRecords > inFile) {
+    File   file = LittleFS.open(QUEUE_FILE, "r");
+    size_t size = 0;
+    if (file && file.seek(queueFileRead + queueSentBytes(0, inFile), SeekSet) && (file.read((uint8_t *)record, sizeof(QueueRecord)) == sizeof(QueueRecord))) {
+      size_t n = __builtin_popcount(record->channels) * sizeof(float);
+      if ((size_t)file.read((uint8_t *)values, n) == n) { size = sizeof(QueueRecord) + n; }
+    }
+    file.close();
+    if (size == 0) {                                       // file is damaged, skip the rest of it
+      queueDropped    += queueFileRecords - inFile;
+      memmove(queueSent, queueSent + inFile, (queueSentCount - inFile) * sizeof(QueueSent)); // client still delivers the records it holds
+      queueSentCount  -= inFile;
+      queueFileRecords = 0;
+      queueFileRead    = queueFileSize;
+    }
+    return size;
+  }
+  if (queueRAMRecords > queueSentRAM()) {
+    uint32_t offset = queueTail + queueSentBytes(inFile, queueSentCount);
+    memcpy(record, queueBuffer + offset, sizeof(QueueRecord));
+    size_t n = __builtin_popcount(record->channels) * sizeof(float);
+    memcpy(values, queueBuffer + offset + sizeof(QueueRecord), n);
+    return sizeof(QueueRecord) + n;
+  }
+  return 0;
+}
+
+void popQueue(size_t size) {
+  if (queueFileRecords > 0) {
+    queueFileRead += size;
+    queueFileRecords--;
+  } else if (queueRAMRecords > 0) {
+    queueTail += size;
+    queueRAMRecords--;
+    if (queueRAMRecords == 0) { queueHead = 0; queueTail = 0; }
+  }
+  if ( (queueFileRecords == 0) && (queueFileSize > 0) ) { // file is sent
+    LittleFS.remove(QUEUE_FILE);
+    queueFileSize = 0;
+    queueFileRead = 0;
+  }
+}
+
+// Records leave the queue in order once the broker acknowledged them
+uint8_t ackQueue() {
+  uint8_t acked = 0;
+  while ( (acked < queueSentCount) && !mqttClient.isInflight(queueSent[acked].msgId) ) {
+    popQueue(queueSent[acked].size);
+    acked++;
+  }
+  memmove(queueSent, queueSent + acked, (queueSentCount - acked) * sizeof(QueueSent));
+  queueSentCount -= acked;
+  queuePublished += acked;
+  return acked;
+}
+
+// One field of the queued message, field 0 opens with the time, then one field per channel, last field closes
+size_t queueRecordJSON(const QueueRecord *record, const float *values, uint8_t field, char *payload, size_t len) {
+  int     l = 0;
+  uint8_t n = __builtin_popcount(record->channels);
+  if (field == 0) {
+    l = snprintf_P(payload, len, PSTR("{\"time\":%lu"), (unsigned long)record->time);
+  } else if (field <= n) {
+    uint8_t channel = 0;                                   // channel of field-th set bit
+    for (uint8_t k=0; channel<HISTORY_CHANNELS; channel++) {
+      if ( (record->channels & (1UL << channel)) && (++k == field) ) { break; }
+    }
+    char name[HISTORY_NAMELENGTH];
+    strncpy_P(name, historyNames[channel], sizeof(name));
+    float value = values[field-1];
+    if (isnan(value)) { l = snprintf_P(payload, len, PSTR(",\"%s\":null"), name); }
+    else              { l = snprintf_P(payload, len, PSTR(",\"%s\":%.*f"), name, historySources[channel].decimals, value); }
+  } else if (field == n+1) {
+    l = snprintf_P(payload, len, PSTR("}"));
+  }
+  if (l < 0) { return 0; }
+  return ((size_t)l < len) ? (size_t)l : len-1;
+}
+
+// The message is assembled for a QoS 1 publish, the client keeps a copy until its PUBACK arrives
+bool publishQueueRecord(const QueueRecord *record, const float *values, size_t length) {
+  size_t  l = 0;
+  uint8_t fields = __builtin_popcount(record->channels) + 2;
+  for (uint8_t i=0; i<fields; i++) { l += queueRecordJSON(record, values, i, mqttPayload+l, QUEUE_PAYLOADSIZE-l); }
+  return (l == length) && mqttClient.publish(mqttTopic(PSTR("data/queued")), (const uint8_t *)mqttPayload, l, false, 1);
+}
+
+// Budget grows by the rate each second and holds at most one second of it
+bool drainQueue() {
+  unsigned long now     = millis();
+  unsigned long elapsed = now - lastQueueDrain;
+  lastQueueDrain = now;
+  bool acked = (ackQueue() > 0);
+  if (acked && (queueDepth() == 0)) {                      // backlog is delivered, report how it went
+    queueJSON(tmpStr, sizeof(tmpStr));
+    publishMQTT(mqttTopic(PSTR("status/queue")), tmpStr);
+    if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("MQTT queue: sent")); }
+  }
+  if (queueDepth() == 0) { return false; }
+  if (elapsed > 1000) { elapsed = 1000; }
+  queueMessageTokens += elapsed * queueMessageRate;
+  queueByteTokens    += elapsed * queueByteRate;
+  if (queueMessageTokens > queueMessageRate * 1000) { queueMessageTokens = queueMessageRate * 1000; }
+  if (queueByteTokens    > queueByteRate    * 1000) { queueByteTokens    = queueByteRate    * 1000; }
+
+  QueueRecord record;
+  float       values[HISTORY_CHANNELS];
+  char        field[QUEUE_FIELDLENGTH];
+  bool        sent = false;
+  size_t      size;
+  while ( (queueMessageTokens >= 1000) && (queueSentCount < MQTT_MAX_INFLIGHT) && ((size = peekQueue(&record, values)) > 0) ) {
+    size_t  length = 0;
+    uint8_t fields = __builtin_popcount(record.channels) + 2;
+    for (uint8_t i=0; i<fields; i++) { length += queueRecordJSON(&record, values, i, field, sizeof(field)); }
+    // a message larger than one second of budget goes out when the budget is full
+    if ( (queueByteTokens < length * 1000) && (queueByteTokens < queueByteRate * 1000) ) { break; }
+    if (!publishQueueRecord(&record, values, length)) {
+      if ( (queueSentCount == 0) && (mqttClient.getInflight() == 0) && mqttClient.connected() ) { // does not fit even when the client is idle
+        popQueue(size);
+        queueDropped++;
+      }
+      break;
+    }
+    queueSent[queueSentCount++] = { mqttClient.getLastMsgId(), (uint16_t)size };
+    queueMessageTokens -= 1000;
+    queueByteTokens     = (queueByteTokens > length * 1000) ? queueByteTokens - length * 1000 : 0;
+    sent = true;
+    yieldTime += yieldOS();
+  }
+  return sent;
+}
+
+/******************************************************************************************************/
+// Metrics
+/******************************************************************************************************/
+
+// {"depth":12,"ram":4,"file":8,"dropped":0,"published":1440,"rate":2,"byterate":1024}
+void queueJSON(char *payload, size_t len) {
+  snprintf_P(payload, len, PSTR("{\"depth\":%u,\"ram\":%u,\"file\":%u,\"dropped\":%lu,\"published\":%lu,\"rate\":%lu,\"byterate\":%lu}"),
+             queueDepth(), queueRAMRecords, queueFileRecords, queueDropped, queuePublished, queueMessageRate, queueByteRate);
+}
@@ -17,6 +17,8 @@
 #include "src/Sensi.h"
 #include "src/Quality.h"
 #include "src/Print.h"
+#include "src/I2C.h"
+#include "src/Scheduler.h"
 
 uint16_t      scd30_ppm = 0;                               // co2 concentration from sensor
 float         scd30_temp = -999.;                          // temperature from sensor
@@ -24,7 +26,6 @@ float         scd30_hum = -1.;                             // humidity from sens
 float         scd30_ah = -1.;                              // absolute humidity, calculated
 bool          scd30_avail = false;                         // do we have this sensor?
 bool          scd30NewData = false;                        // do we have new data?
-bool          scd30NewDataHandeled = false;                // have we handeled the new data?
 bool          scd30NewDataWS = false;                      // do we have new data for websocket
 uint8_t       scd30_i2c[2];                                // the pins for the i2c port, set during initialization
 uint8_t       scd30_error_cnt = 0;
@@ -40,16 +41,19 @@ const int     SCD30interruptPin = SCD30_RDY;               //
 volatile  SensorStates stateSCD30 = IS_IDLE;               // keeping track of sensor state
 TwoWire *scd30_port =0;                                    // pointer to the i2c port, might be useful for other microcontrollers
 SCD30 scd30;                                               // the sensor
+I2CTransaction scd30Transaction;                           // split phase data ready and measurement reads
 
 // External Variables
 extern Settings      mySettings;   // Config
 extern bool          fastMode;     // Sensi
 extern bool          intervalNewData;
 extern bool          availNewData;
+extern uint32_t      sampleSequence; // Sensi
 extern bool          BMEhum_avail; // BME280
 extern unsigned long lastYield;    // Sensi
 extern unsigned long currentTime;  // Sensi
 extern char          tmpStr[256];       // Sensi
+extern int           taskIDSCD30;       // Sensi
 
 extern bool          bme68x_avail; // bme680
 extern TwoWire      *bme68x_port;  
@@ -63,6 +67,7 @@ extern float         bme280_pressure;
 
 void ICACHE_RAM_ATTR handleSCD30Interrupt() {              // Interrupt service routine when data ready is signaled
   stateSCD30 = DATA_AVAILABLE;                             // advance the sensor state
+  notifyTask(taskIDSCD30);                                 // run the sensor task
   /* if (mySettings.debuglevel == 4) {                        // for debugging, usually no Serial.print in ISR
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30: interrupt occured")); 
     R_printSerialTelnetLogln(tmpStr);  
@@ -86,6 +91,12 @@ bool initializeSCD30() {
   pinMode(SCD30interruptPin , INPUT);                      // interrupt scd30
   attachInterrupt(digitalPinToInterrupt(SCD30interruptPin),  handleSCD30Interrupt,  RISING);
   
+  scd30Transaction.port    = scd30_port;
+  scd30Transaction.i2c     = scd30_i2c;
+  scd30Transaction.speed   = scd30_i2cspeed;
+  scd30Transaction.stretch = scd30_i2cClockStretchLimit;
+  scd30Transaction.address = SCD30_ADDRESS;
+
   switchI2C(scd30_port, scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed, scd30_i2cClockStretchLimit);
   if (scd30.begin(*scd30_port, true)) {                    // start with autocalibration
     scd30.setMeasurementInterval(uint16_t(intervalSCD30/1000));
@@ -103,7 +114,7 @@ bool initializeSCD30() {
     return(false);
   }
   if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SCD30: initialized")); }
-  delay(50); lastYield = millis();
+  lastSCD30Busy = currentTime;                             // IS_BUSY reads after intervalSCD30Busy, no need to wait here
   return(true);
 }
 
@@ -132,12 +143,10 @@ bool updateSCD30 () {
     case IS_MEASURING : { // used when RDY pin interrupt is not enabled
       if ((currentTime - lastSCD30) >= intervalSCD30) {
         D_printSerialTelnet(F("D:U:SCD30:IM.."));
-        switchI2C(scd30_port, scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed, scd30_i2cClockStretchLimit);
-        startMeasurementSCD30 = millis();
-        if (scd30.dataAvailable()) {
-          scd30_ppm  = scd30.getCO2(); 
-          scd30_temp = scd30.getTemperature();
-          scd30_hum  = scd30.getHumidity();
+        if (scd30Transaction.state == I2C_IDLE) { startMeasurementSCD30 = millis(); }
+        uint8_t result = readSCD30();
+        if (result == I2C_PENDING) { break; }
+        if (result == I2C_DATA) {
           lastSCD30  = currentTime;
           if (mySettings.debuglevel >= 2) { 
             snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30: CO2, rH, T read in %ldms"), (millis()-startMeasurementSCD30)); 
@@ -145,6 +154,7 @@ bool updateSCD30 () {
           }
           scd30NewData = true;
           scd30NewDataWS = true;
+          sampleSequence++;
         } else {
           if (mySettings.debuglevel == 4) { R_printSerialTelnetLogln(F("SCD30: data not yet available")); }
         }
@@ -155,10 +165,8 @@ bool updateSCD30 () {
     case IS_BUSY: { // used to bootup sensor when RDY pin interrupt is enabled
       if ((currentTime - lastSCD30Busy) > intervalSCD30Busy) {
         D_printSerialTelnet(F("D:U:SCD30:IB.."));
-        switchI2C(scd30_port, scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed, scd30_i2cClockStretchLimit);
-        if (scd30.dataAvailable()) {
-          scd30.readMeasurement();
-        } // without reading data, RDY pin will remain high and no interrupt will occur
+        // without reading data, RDY pin will remain high and no interrupt will occur
+        if (readSCD30() == I2C_PENDING) { break; }
         lastSCD30Busy = currentTime;
         if (mySettings.debuglevel == 4) { R_printSerialTelnetLogln(F("SCD30: is busy")); }
       }
@@ -167,17 +175,20 @@ bool updateSCD30 () {
     
     case DATA_AVAILABLE : { // used to obtain data when RDY pin interrupt is used
       D_printSerialTelnet(F("D:U:SCD30:DA.."));
-      switchI2C(scd30_port, scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed, scd30_i2cClockStretchLimit);
-      startMeasurementSCD30 = millis();
-      scd30_ppm  = scd30.getCO2();
-      scd30_temp = scd30.getTemperature();
-      scd30_hum  = scd30.getHumidity();
-      float tmp = 273.15 + scd30_temp;
-      scd30_ah = scd30_hum * 13.246 / tmp * exp(19.854 - 5423.0/tmp); // [gr/m^3]
-      if ( (scd30_ah<0) | (scd30_ah>40.0) ) { scd30_ah = -1.0; } // make sure its reasonable
+      if (scd30Transaction.state == I2C_IDLE) { startMeasurementSCD30 = millis(); }
+      uint8_t result = readI2CMeasurement(&scd30Transaction, 0, COMMAND_READ_MEASUREMENT, SCD30_COMMAND_DELAY, 6); // data ready was signaled
+      if (result == I2C_PENDING) { break; }
+      if (result != I2C_DATA) {
+        stateSCD30 = HAS_ERROR;
+        errorRecSCD30 = currentTime + 5000;
+        if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("SCD30: error reading data")); }
+        break;
+      }
+      getSCD30Values();
       lastSCD30  = currentTime;
       scd30NewData = true;
       scd30NewDataWS = true;
+      sampleSequence++;
       stateSCD30 = IS_IDLE; 
       if (mySettings.debuglevel >= 2) { 
         snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30: CO2, rH, T read in %ldms"), (millis()-startMeasurementSCD30)); 
@@ -191,10 +202,14 @@ bool updateSCD30 () {
       // wait for intrrupt to occur, 
       // if interrupt timed out, obtain data manually
       if ( (currentTime - lastSCD30) > (INTERVAL_TIMEOUT_FACTOR*intervalSCD30) ) {
-        if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("SCD30: interrupt timeout occured")); }
-        switchI2C(scd30_port, scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed, scd30_i2cClockStretchLimit);
-        if (scd30.dataAvailable()) { 
-          stateSCD30 = DATA_AVAILABLE; 
+        if ( (mySettings.debuglevel > 0) && (scd30Transaction.state == I2C_IDLE) ) { R_printSerialTelnetLogln(F("SCD30: interrupt timeout occured")); }
+        uint8_t result = readSCD30();
+        if (result == I2C_PENDING) { break; }
+        if (result == I2C_DATA) {
+          lastSCD30  = currentTime;
+          scd30NewData = true;
+          scd30NewDataWS = true;
+          sampleSequence++;
           scd30_error_cnt = 0;
         } else {
           stateSCD30 = HAS_ERROR;
@@ -204,10 +219,11 @@ bool updateSCD30 () {
         }
       }
 
-      // update pressure if available
+      // update pressure if available, the pressure was read by the other sensor, write it on the SCD30 pins
+      if (scd30Transaction.state == I2C_WAITING) { break; }
       if (bme68x_avail && mySettings.useBME68x) { // update pressure settings
         if ((currentTime - lastPressureSCD30) >= intervalPressureSCD30) {
-          switchI2C(bme68x_port, bme68x_i2c[0], bme68x_i2c[1], bme68x_i2cspeed, bme68x_i2cClockStretchLimit);
+          switchI2C(scd30_port, scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed, scd30_i2cClockStretchLimit);
           scd30.setAmbientPressure(uint16_t(bme68x.pressure/100.0));  // update with value from pressure sensor, needs to be mbar
           lastPressureSCD30 = currentTime;
           if (mySettings.debuglevel >= 2) { 
@@ -217,7 +233,7 @@ bool updateSCD30 () {
        }
       } else if ((bme280_avail && mySettings.useBME280)) {
         if ((currentTime - lastPressureSCD30) >= intervalPressureSCD30) {
-          switchI2C(bme280_port, bme280_i2c[0], bme280_i2c[1], bme280_i2cspeed, bme280_i2cClockStretchLimit);
+          switchI2C(scd30_port, scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed, scd30_i2cClockStretchLimit);
           scd30.setAmbientPressure(uint16_t(bme280_pressure/100.0));  // pressure is in Pa and scd30 needs mBar
           lastPressureSCD30 = currentTime;
           if (mySettings.debuglevel >= 2) { 
@@ -261,6 +277,48 @@ bool updateSCD30 () {
   return success;
 }
 
+/******************************************************************************************************/
+// Next SCD30 step
+/******************************************************************************************************/
+// [ms] until updateSCD30 has something to do
+// While a transaction is waiting the I2C queue wakes the task, the interrupt wakes it when data is ready
+
+unsigned long nextSCD30() {
+  if (scd30Transaction.state == I2C_WAITING) { return intervalSCD30; }
+  switch(stateSCD30) {
+    case IS_MEASURING:   { return dueIn(lastSCD30, intervalSCD30); }
+    case IS_BUSY:        { return dueIn(lastSCD30Busy, intervalSCD30Busy); }
+    case DATA_AVAILABLE: { return 0; }
+    case IS_IDLE: {
+      unsigned long next = dueIn(lastSCD30, INTERVAL_TIMEOUT_FACTOR*intervalSCD30);
+      if ( (bme68x_avail && mySettings.useBME68x) || (bme280_avail && mySettings.useBME280) ) {
+        unsigned long pressure = dueIn(lastPressureSCD30, intervalPressureSCD30);
+        if (pressure < next) { next = pressure; }
+      }
+      return next;
+    }
+    case HAS_ERROR:      { return dueIn(errorRecSCD30, 0); }
+    default:             { return intervalPoll; }
+  }
+}
+
+// Data ready flag followed by measurement, values are updated when I2C_DATA is returned
+uint8_t readSCD30() {
+  uint8_t result = readI2CMeasurement(&scd30Transaction, COMMAND_GET_DATA_READY, COMMAND_READ_MEASUREMENT, SCD30_COMMAND_DELAY, 6);
+  if (result == I2C_DATA) { getSCD30Values(); }
+  return result;
+}
+
+// CO2, temperature and humidity are IEEE754 floats in the measurement response
+void getSCD30Values() {
+  scd30_ppm  = uint16_t(i2cFloat(&scd30Transaction, 0));
+  scd30_temp = i2cFloat(&scd30Transaction, 2);
+  scd30_hum  = i2cFloat(&scd30Transaction, 4);
+  float tmp = 273.15 + scd30_temp;
+  scd30_ah = scd30_hum * 13.246 / tmp * exp(19.854 - 5423.0/tmp); // [gr/m^3]
+  if ( (scd30_ah<0) | (scd30_ah>40.0) ) { scd30_ah = -1.0; } // make sure its reasonable
+}
+
 void scd30JSON(char *payLoad, size_t len){
   const char * str = "{ \"scd30\": ";
   size_t l = strlen(str);
@@ -16,10 +16,10 @@
 #include "src/Sensi.h"
 #include "src/Quality.h"
 #include "src/Print.h"
+#include "src/Scheduler.h"
 
 bool          sgp30_avail  = false;                        // do we have this sensor
 bool          sgp30NewData = false;                        // do we have new data
-bool          sgp30NewDataHandeled = false;                // have we handeled the new data?
 bool          sgp30NewDataWS = false;                      // do we have new data for websocket
 bool          baslineSGP30_valid = false;
 uint8_t       sgp30_i2c[2];                                // the pins for the i2c port, set during initialization
@@ -42,6 +42,7 @@ extern Settings      mySettings;   // Config
 extern bool          fastMode;     // Sensi
 extern bool          intervalNewData;
 extern bool          availNewData;
+extern uint32_t      sampleSequence; // Sensi
 extern unsigned long currentTime;  // Sensi
 extern char          tmpStr[256];  // Sensi
 extern bool          bme68x_avail;
@@ -199,6 +200,7 @@ bool updateSGP30() {
           }
           sgp30NewData = true;
           sgp30NewDataWS = true;
+          sampleSequence++;
           sgp30_error_cnt = 0;
         }
         lastSGP30 = currentTime;
@@ -261,6 +263,28 @@ bool updateSGP30() {
   return(success);
 }
 
+/******************************************************************************************************/
+// Next SGP30 step
+/******************************************************************************************************/
+// [ms] until updateSGP30 has something to do
+
+unsigned long nextSGP30() {
+  switch(stateSGP30) {
+    case SGP30_IS_MEASURING: {
+      unsigned long next     = dueIn(lastSGP30,         intervalSGP30);
+      unsigned long humidity = dueIn(lastSGP30Humidity, intervalSGP30Humidity);
+      unsigned long baseline = dueIn(lastSGP30Baseline, intervalSGP30Baseline);
+      if (humidity < next) { next = humidity; }
+      if (baseline < next) { next = baseline; }
+      return next;
+    }
+    case SGP30_WAITING_FOR_MEASUREMENT: { return dueIn(lastSGP30, 12); }
+    case SGP30_WAITING_FOR_BASELINE:    { return dueIn(lastSGP30, 10); }
+    case SGP30_HAS_ERROR:               { return dueIn(errorRecSGP30, 0); }
+    default:                            { return intervalPoll; }
+  }
+}
+
 /******************************************************************************************************/
 // JSON SGP30
 /******************************************************************************************************/
@@ -17,12 +17,15 @@
 #include "src/Sensi.h"
 #include "src/Quality.h"
 #include "src/Print.h"
+#include "src/I2C.h"
+#include "src/Scheduler.h"
 
 unsigned long intervalSPS30 = 0;                           // measurement interval
 unsigned long timeSPS30Stable;                             // time when readings are stable, is adjusted automatically based on particle counts
 unsigned long lastSPS30;                                   // last time we interacted with sensor
 unsigned long wakeSPS30;                                   // time when wakeup was issued
 unsigned long wakeTimeSPS30;                               // time when sensor is supposed to be woken up
+unsigned long wakeDelaySPS30 = SPS30_WAKE_DELAY;           // [ms] IS_WAKINGUP waits after wake up or reset
 unsigned long timeToStableSPS30;                           // how long it takes to get stable readings, automatically pupulated based on total particles
 unsigned long errorRecSPS30;
 unsigned long startMeasurementSPS30;
@@ -30,8 +33,8 @@ unsigned long sps30_lastError;
 
 bool     sps30_avail = false;                              // do we have this sensor?
 bool     sps30NewData = false;                             // do we have new data to display?
-bool     sps30NewDataHandeled = false;                     // have we handeled the new data?
 bool     sps30NewDataWS = false;                           // do we have new data for websocket
+bool     sps30_busReset = false;                           // sensor and bus were reset because the probe failed
 
 uint8_t  sps30_i2c[2];                                     // the pins for the i2c port, set during initialization
 uint8_t  sps30_error_cnt = 0;                              // give a few retries with rebooting
@@ -43,6 +46,7 @@ uint32_t sps30_st;                                         // sps30 status regis
 TwoWire *sps30_port = 0;                                   // pointer to the i2c port, might be useful for other microcontrollers
 SPS30    sps30;                                            // the particle sensor
 sps30_measurement valSPS30;                                // will hold the readings from sensor
+I2CTransaction sps30Transaction;                           // split phase data ready and measurement reads
 volatile SensorStates stateSPS30 = IS_BUSY;                // sensor state
 
 // External Variables
@@ -50,8 +54,8 @@ extern Settings      mySettings;   // Config
 extern bool          fastMode;     // Sensi
 extern bool          intervalNewData;
 extern bool          availNewData;
+extern uint32_t      sampleSequence; // Sensi
 extern bool          BMEhum_avail; // BME280
-extern unsigned long lastYield;    // Sensi
 extern unsigned long currentTime;  // Sensi
 extern char          tmpStr[256];  // Sensi
 
@@ -61,13 +65,13 @@ extern char          tmpStr[256];  // Sensi
 
 // Initialize
 //   Start i2c port
-//   Probe for sensor (obtain version information), if not successful software reset and probe again
-//   Reset
+//   Probe for sensor (obtain version information), if not successful reset sensor and i2c bus and probe again
+//     in HAS_ERROR after SPS30_BUSRESET_DELAY
 //   Get Serialnumber
 //   Get Productname
 //   Get Version information
-//   Get Autoclean interval, if not 7 days set to 7 days
-//   Start, new data is created every 1 seconds
+//   Get Autoclean interval
+//   Reset, IS_WAKINGUP starts measurements after SPS30_RESET_DELAY, new data is created every 1 seconds
 
 bool initializeSPS30() { 
 
@@ -80,11 +84,17 @@ bool initializeSPS30() {
     R_printSerialTelnetLogln(tmpStr); 
   }
 
+  sps30Transaction.port    = sps30_port;
+  sps30Transaction.i2c     = sps30_i2c;
+  sps30Transaction.speed   = sps30_i2cspeed;
+  sps30Transaction.stretch = sps30_i2cClockStretchLimit;
+  sps30Transaction.address = SPS30_ADDRESS;
+
   switchI2C(sps30_port, sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit);
   sps30.begin(sps30_port);
 
   if ( sps30.probe() ) {
-
+    sps30_busReset = false;
     if (mySettings.debuglevel > 0) {
       printSerialTelnetLogln(F("SPS30: detected"));
       snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: serial: %s major: %d minor: %d"), 
@@ -95,64 +105,26 @@ bool initializeSPS30() {
       snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: driver: %s"), sps30.driver_version()); 
       printSerialTelnetLogln(tmpStr);
     }
+  } else if (sps30_busReset == false) {
+    // reset sensor and bus, HAS_ERROR probes again once they restarted
+    if (mySettings.debuglevel > 0) { printSerialTelnetln(F("SPS30: could not probe / connect. resetting SPS30 and I2C")); }
+    writeI2C(&sps30Transaction, SPS30_RESET, NULL, 0);
+    if ( sps30.i2c_general_call_reset() ) { if (mySettings.debuglevel > 0) { printSerialTelnetln(F("SPS30: reset I2C bus")); } } 
+    else                                  { if (mySettings.debuglevel > 0) { printSerialTelnetln(F("SPS30: could not reset I2C bus")); } }
+    switchI2C(sps30_port, sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit);
+    sps30_busReset = true;
+    stateSPS30 = HAS_ERROR;
+    errorRecSPS30 = currentTime + SPS30_BUSRESET_DELAY;
+    return(true);
   } else {
-    // reset
-    if ( sps30.reset() ) { if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: reset")); } }
-    else                 { if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: could not reset")); } }
-
-    // probe again
-    if ( sps30.probe() ) {
-
-      if (mySettings.debuglevel > 0) {
-        printSerialTelnetLogln(F("SPS30: detected"));
-        snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: serial: %s major: %d minor: %d"), 
-                  sps30.serial_number(), sps30.fw_major(), sps30.fw_minor()); 
-        printSerialTelnetLogln(tmpStr);
-        snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: product type: %s"), sps30.product_type()); 
-        printSerialTelnetLogln(tmpStr);
-        snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: driver: %s"), sps30.driver_version()); 
-        printSerialTelnetLogln(tmpStr);
-      }
-    } else {
-      if (mySettings.debuglevel > 0) { printSerialTelnetln(F("SPS30: could not probe / connect. resetting I2C")); }
-      if ( sps30.i2c_general_call_reset() ) { if (mySettings.debuglevel > 0) { printSerialTelnetln(F("SPS30: reset I2C bus")); } } 
-      else                                  { if (mySettings.debuglevel > 0) { printSerialTelnetln(F("SPS30: could not reset I2C bus")); } }
-      switchI2C(sps30_port, sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit);
-      delay(2000);
-      
-      // probe again
-      if ( sps30.probe() ) {
-        if (mySettings.debuglevel > 0) {
-          printSerialTelnetLogln(F("SPS30: detected"));
-          snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: serial: %s major: %d minor: %d"), 
-                    sps30.serial_number(), sps30.fw_major(), sps30.fw_minor()); 
-          printSerialTelnetLogln(tmpStr);
-          snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: product type: %s"), sps30.product_type()); 
-          printSerialTelnetLogln(tmpStr);
-          snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: driver: %s"), sps30.driver_version()); 
-          printSerialTelnetLogln(tmpStr);
-        }
-      } else {
-        if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: could not probe / connect. giving up")); }
-        stateSPS30 = HAS_ERROR;
-        errorRecSPS30 = currentTime + 12000;
-        return(false);        
-      }
-    } // end attempt probe recover
-  } // end probe
-  
-  // reset
-  if ( sps30.reset() ) { 
-    if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: reset")); }
-    delay(100); lastYield = millis();
-  } else { 
-    if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: could not reset")); }
+    sps30_busReset = false;
+    if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: could not probe / connect. giving up")); }
     stateSPS30 = HAS_ERROR;
     errorRecSPS30 = currentTime + 12000;
-    return(false);
-  }
+    return(false);        
+  } // end probe
   
-  // get cleaning interval
+  // get cleaning interval, the sensor answers right away before the reset
   if ( sps30.get_fan_auto_cleaning_interval(&sps30AutoCleanInterval) ) {
     if (mySettings.debuglevel > 0) {
       snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30: auto clean interval: %us"), sps30AutoCleanInterval); 
@@ -162,22 +134,21 @@ bool initializeSPS30() {
     if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: coulnd not obtain autoclean information"));  }
   }
 
-  // Start the device, it will create internal readings every 1 sec
-  if ( sps30.start_measurement() ) { // takes 20ms
-    if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: measurement started")); }
-    stateSPS30 = IS_BUSY; 
-    sps30_timeout_cnt = 0;
+  // reset, measurements are started by IS_WAKINGUP once the sensor accepts commands again
+  if ( writeI2C(&sps30Transaction, SPS30_RESET, NULL, 0) ) { 
+    if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: reset")); }
   } else { 
-    if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: could NOT start measurement")); }
+    if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: could not reset")); }
     stateSPS30 = HAS_ERROR;
     errorRecSPS30 = currentTime + 12000;
     return(false);
   }
-
-  lastSPS30 = currentTime;
+  wakeSPS30 = currentTime;
+  wakeDelaySPS30 = SPS30_RESET_DELAY;
+  stateSPS30 = IS_WAKINGUP;
+  sps30_timeout_cnt = 0;
 
   if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: initialized")); }
-  delay(50); lastYield = millis();
   return(true);
 }
 
@@ -209,7 +180,7 @@ bool initializeSPS30() {
 //   got to state IS_WAKINGUP
 //
 // IS_WAKINGUP
-//   wait 50ms
+//   wait 50ms after wake up, 100ms after reset
 //   start measurements
 //   go to state IS_BUSY
 //
@@ -227,21 +198,15 @@ bool updateSPS30() {
 
       if ( (currentTime - lastSPS30) > 1000 ) { // start command needs 20ms to complete but it takes 1 sec to produce data
         D_printSerialTelnet(F("D:U:SPS30:IB.."));
-        switchI2C(sps30_port, sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit);
-        
-        //check if data available
-        if ( sps30.read_data_ready(&sps30_data_ready) ) {
-          if (mySettings.debuglevel == 5)  { R_printSerialTelnetLogln(F("SPS30: checked for data")); }
-        } else { 
-          if (mySettings.debuglevel > 0)  { R_printSerialTelnetLogln(F("SPS30: error checking for data")); }
-          stateSPS30 = HAS_ERROR; 
-          errorRecSPS30 = currentTime + 12000; 
-          break; 
-        }
+
+        // check if data available and read data
+        uint8_t result = readSPS30();
+        if (result == I2C_PENDING) { break; }
+        if (mySettings.debuglevel == 5)  { R_printSerialTelnetLogln(F("SPS30: checked for data")); }
+        sps30_data_ready = (result != I2C_NODATA);
 
         if (sps30_data_ready) { 
-          // read data
-          if ( sps30.read_measurement(&valSPS30) ) { 
+          if ( result == I2C_DATA ) { 
             if (mySettings.debuglevel >= 2)  { R_printSerialTelnetLogln(F("SPS30: data read")); }
 
             // adjust time to get stable readings, it takes longer  with lower concentration to get a precise reading
@@ -297,24 +262,19 @@ bool updateSPS30() {
 
       if (currentTime >= timeSPS30Stable) {
         D_printSerialTelnet(F("D:U:SPS30:WS.."));
-        switchI2C(sps30_port, sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit);
 
-        //check if data available
-        if ( sps30.read_data_ready(&sps30_data_ready) ) {
-          if (mySettings.debuglevel == 5)  { R_printSerialTelnetLogln(F("SPS30: checked for data")); }
-        } else { 
-          if (mySettings.debuglevel > 0 )  { R_printSerialTelnetLogln(F("SPS30: error checking for data")); }
-          stateSPS30 = HAS_ERROR; 
-          errorRecSPS30 = currentTime + 12000; 
-          break; 
-        }
+        // check if data available and read data
+        uint8_t result = readSPS30();
+        if (result == I2C_PENDING) { break; }
+        if (mySettings.debuglevel == 5)  { R_printSerialTelnetLogln(F("SPS30: checked for data")); }
+        sps30_data_ready = (result != I2C_NODATA);
 
         if (sps30_data_ready) { 
-          // read data
-          if ( sps30.read_measurement(&valSPS30) ) { 
+          if ( result == I2C_DATA ) { 
             if (mySettings.debuglevel >= 2)  { R_printSerialTelnetLogln(F("SPS30: data read")); }
             sps30NewData   = true;
             sps30NewDataWS = true;
+            sampleSequence++;
             sps30_error_cnt = 0;
             sps30_timeout_cnt = 0;
             lastSPS30 = currentTime; 
@@ -417,6 +377,7 @@ bool updateSPS30() {
         switchI2C(sps30_port, sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit);
         if ( sps30.wake_up() ) { // takes 5ms
           wakeSPS30 = currentTime;
+          wakeDelaySPS30 = SPS30_WAKE_DELAY;
           stateSPS30 = IS_WAKINGUP;
         } else {
           if (mySettings.debuglevel > 0) { printSerialTelnetLogln(F("SPS30: error could not wakeup")); }
@@ -432,11 +393,10 @@ bool updateSPS30() {
     case IS_WAKINGUP : {  // ------------------  startup the sensor
       if (mySettings.debuglevel == 5) { R_printSerialTelnetLogln(F("SPS30: is waking up")); }
 
-      if ((currentTime - wakeSPS30) >= 50) { // Give some time (50ms)to wake up 
+      if ((currentTime - wakeSPS30) >= wakeDelaySPS30) { // Give some time to wake up 
         D_printSerialTelnet(F("D:U:SPS30:IW.."));
-        switchI2C(sps30_port, sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit);
-        
-        if ( sps30.start_measurement() ) { 
+        const uint16_t format = SPS30_FLOATFORMAT;
+        if ( writeI2C(&sps30Transaction, SPS30_START, &format, 1) ) { // IS_BUSY waits 1s for the first data
           if (mySettings.debuglevel == 5) { R_printSerialTelnetLogln(F("SPS30: measurement started")); }
           stateSPS30 = IS_BUSY; 
           sps30_timeout_cnt = 0;
@@ -466,8 +426,10 @@ bool updateSPS30() {
         sps30_lastError = currentTime;
 
         if ( initializeSPS30() ) {
-          sps30_error_cnt = 0;
-          if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("SPS30: recovered")); }
+          if (stateSPS30 != HAS_ERROR) {                   // not waiting for the bus reset
+            sps30_error_cnt = 0;
+            if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("SPS30: recovered")); }
+          }
         } else {
           if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("SPS30: could not recover")); }
           stateSPS30 = HAS_ERROR; 
@@ -488,9 +450,45 @@ bool updateSPS30() {
   return success;
 }
 
+/******************************************************************************************************/
+// Next SPS30 step
+/******************************************************************************************************/
+// [ms] until updateSPS30 has something to do, while a transaction is waiting the I2C queue wakes the task
+
+unsigned long nextSPS30() {
+  if (sps30Transaction.state == I2C_WAITING) { return intervalSPS30; }
+  switch(stateSPS30) {
+    case IS_BUSY:        { return dueIn(lastSPS30, 1000); }
+    case WAIT_STABLE:    { return dueIn(timeSPS30Stable, 0); }
+    case IS_IDLE:        { return 0; }
+    case IS_SLEEPING:    { return dueIn(wakeTimeSPS30, 0); }
+    case IS_WAKINGUP:    { return dueIn(wakeSPS30, wakeDelaySPS30); }
+    case HAS_ERROR:      { return dueIn(errorRecSPS30, 0); }
+    default:             { return intervalPoll; }
+  }
+}
+
 /******************************************************************************************************/
 // JSON SPS30
 /******************************************************************************************************/
+// Data ready flag followed by measurement, valSPS30 is updated when I2C_DATA is returned
+uint8_t readSPS30() {
+  uint8_t result = readI2CMeasurement(&sps30Transaction, SPS30_DATAREADY, SPS30_MEASUREMENT, SPS30_COMMAND_DELAY, 20);
+  if (result == I2C_DATA) {
+    valSPS30.mc_1p0  = i2cFloat(&sps30Transaction,  0);
+    valSPS30.mc_2p5  = i2cFloat(&sps30Transaction,  2);
+    valSPS30.mc_4p0  = i2cFloat(&sps30Transaction,  4);
+    valSPS30.mc_10p0 = i2cFloat(&sps30Transaction,  6);
+    valSPS30.nc_0p5  = i2cFloat(&sps30Transaction,  8);
+    valSPS30.nc_1p0  = i2cFloat(&sps30Transaction, 10);
+    valSPS30.nc_2p5  = i2cFloat(&sps30Transaction, 12);
+    valSPS30.nc_4p0  = i2cFloat(&sps30Transaction, 14);
+    valSPS30.nc_10p0 = i2cFloat(&sps30Transaction, 16);
+    valSPS30.typical_particle_size = i2cFloat(&sps30Transaction, 18);
+  }
+  return result;
+}
+
 void sps30JSON(char *payLoad, size_t len){
   const char * str = "{ \"sps30\": ";
   size_t l = strlen(str);
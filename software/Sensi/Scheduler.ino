@@ -0,0 +1,182 @@
+/******************************************************************************************************/
+// Task Scheduler
+/******************************************************************************************************/
+#include "src/Scheduler.h"
+#include "src/Profile.h"
+#include "src/Config.h"
+#include "src/Sensi.h"
+#include "src/Print.h"
+
+Task          tasks[MAXTASKS];                             // registered tasks
+uint8_t       taskHeap[MAXTASKS];                          // task ids, ordered by deadline, earliest first
+uint8_t       numTasks = 0;
+int           runningTask = -1;                            // task being executed
+bool          wakePending = false;                         // running task asked to run before its interval
+unsigned long wakeTime;                                    // [ms] when running task wants to run again
+volatile bool taskNotified[MAXTASKS];                      // set by interrupt service routines
+volatile bool anyNotified = false;
+
+// External Variables
+extern Settings      mySettings;       // Config
+extern unsigned long currentTime;      // Sensi
+extern unsigned long yieldTime;        // Sensi
+extern char          tmpStr[256];      // Sensi
+
+/******************************************************************************************************/
+// Heap Helpers
+/******************************************************************************************************/
+// Deadlines are compared by their difference so that the millis() roll over after 49 days is handled.
+// Tasks with same deadline run in the order they were registered, the I2C tasks are registered by pin pair.
+// Tasks due at different times are not regrouped, the order must not depend on currentTime or the heap breaks.
+// The running task stays at the top of the heap until it is rescheduled.
+
+bool taskBefore(uint8_t a, uint8_t b) {
+  if (a == runningTask) { return true; }
+  if (b == runningTask) { return false; }
+  long diff = (long)(tasks[a].next - tasks[b].next);
+  if (diff == 0) { return (a < b); }
+  return (diff < 0);
+}
+
+void taskSiftDown(uint8_t pos) {
+  for (;;) {
+    uint8_t smallest = pos;
+    uint8_t left  = 2*pos + 1;
+    uint8_t right = 2*pos + 2;
+    if ( (left  < numTasks) && taskBefore(taskHeap[left],  taskHeap[smallest]) ) { smallest = left; }
+    if ( (right < numTasks) && taskBefore(taskHeap[right], taskHeap[smallest]) ) { smallest = right; }
+    if (smallest == pos) { return; }
+    uint8_t tmp = taskHeap[pos]; taskHeap[pos] = taskHeap[smallest]; taskHeap[smallest] = tmp;
+    pos = smallest;
+  }
+}
+
+void taskSiftUp(uint8_t pos) {
+  while (pos > 0) {
+    uint8_t parent = (pos - 1) / 2;
+    if ( !taskBefore(taskHeap[pos], taskHeap[parent]) ) { return; }
+    uint8_t tmp = taskHeap[pos]; taskHeap[pos] = taskHeap[parent]; taskHeap[parent] = tmp;
+    pos = parent;
+  }
+}
+
+/******************************************************************************************************/
+// Register Tasks
+/******************************************************************************************************/
+// First execution is one interval after registration, same as setting lastX = currentTime
+
+int addTask(void (*run)(void), unsigned long interval, uint8_t profile) {
+  if (numTasks >= MAXTASKS) {
+    if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("Scheduler: too many tasks")); }
+    return -1;
+  }
+  uint8_t id = numTasks;
+  tasks[id].run        = run;
+  tasks[id].interval   = interval;
+  tasks[id].next       = millis() + interval;
+  tasks[id].overruns   = 0;
+  tasks[id].profile    = profile;
+  taskHeap[numTasks++] = id;
+  taskSiftUp(numTasks - 1);
+  return id;
+}
+
+void setTaskInterval(int id, unsigned long interval) {
+  if ( (id >= 0) && (id < numTasks) ) { tasks[id].interval = interval; }
+}
+
+/******************************************************************************************************/
+// Wake Tasks
+/******************************************************************************************************/
+// A task can only be moved earlier. The running task is rescheduled after it returns, its wake up time is kept until then.
+
+int currentTask() { return runningTask; }
+
+void wakeTask(int id, unsigned long delay) {
+  if ( (id < 0) || (id >= numTasks) ) { return; }
+  unsigned long when = millis() + delay;
+  if (id == runningTask) {
+    if ( !wakePending || ((long)(when - wakeTime) < 0) ) { wakeTime = when; wakePending = true; }
+    return;
+  }
+  if ( (long)(when - tasks[id].next) >= 0 ) { return; } // already due earlier
+  tasks[id].next = when;
+  for (uint8_t pos = 0; pos < numTasks; pos++) {
+    if (taskHeap[pos] == id) { taskSiftUp(pos); return; }
+  }
+}
+
+void ICACHE_RAM_ATTR notifyTask(int id) {
+  if ( (id < 0) || (id >= MAXTASKS) ) { return; }
+  taskNotified[id] = true;
+  anyNotified = true;
+}
+
+unsigned long dueIn(unsigned long since, unsigned long wait) {
+  long remaining = (long)(since + wait - currentTime);
+  return (remaining >= 0) ? (unsigned long)remaining + 1 : intervalPoll;
+}
+
+/******************************************************************************************************/
+// Run Tasks
+/******************************************************************************************************/
+// Executes the tasks that are due, earliest deadline first.
+// A task is rescheduled one interval after it started, or earlier if it woke itself up.
+// Tasks notified from interrupts are woken before the heap is looked at.
+
+void runTasks() {
+  unsigned long deltaTask;
+  while (numTasks > 0) {
+    if (anyNotified) {
+      anyNotified = false;
+      for (uint8_t i = 0; i < numTasks; i++) {
+        if (taskNotified[i]) { taskNotified[i] = false; wakeTask(i, 0); }
+      }
+    }
+    uint8_t id = taskHeap[0];
+    Task *task = &tasks[id];
+    currentTime = millis();
+    if ( (long)(currentTime - task->next) < 0 ) { break; } // nothing else is due
+
+    unsigned long startTask = currentTime;
+    runningTask = id;
+    wakePending = false;
+    {
+      ProfileTimer profileTimer(task->profile);
+      task->run();
+      deltaTask = profileTimer.elapsed() / 1000;
+    }
+
+    if (deltaTask > TASKBUDGET) {
+      task->overruns++;
+      if (mySettings.debuglevel > 1) {
+        snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Scheduler: %s exceeded budget: %lums"), profileName(task->profile), deltaTask);
+        R_printSerialTelnetLogln(tmpStr);
+      }
+    }
+
+    task->next = startTask + task->interval;
+    if ( wakePending && ((long)(wakeTime - task->next) < 0) ) { task->next = wakeTime; }
+    runningTask = -1;
+    taskSiftDown(0);
+    yieldTime += yieldOS();
+  }
+}
+
+long timeToNextTask() {
+  if ( (numTasks == 0) || anyNotified ) { return 0; }
+  long wait = (long)(tasks[taskHeap[0]].next - millis());
+  return (wait > 0) ? wait : 0;
+}
+
+/******************************************************************************************************/
+// Print Tasks
+/******************************************************************************************************/
+
+void printTasks() {
+  printSerialTelnetLogln(F("Task          Interval Overruns"));
+  for (uint8_t i=0; i<numTasks; i++) {
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%-12s %8lu %8lu"), profileName(tasks[i].profile), tasks[i].interval, tasks[i].overruns);
+    printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+  }
+}
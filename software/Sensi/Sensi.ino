@@ -11,6 +11,7 @@
 //                                                  https://github.com/uutzinger/SparkFun_SCD30_Arduino_Library.git
 //  - SGP30 Senserion VOC, eCO2,                    Sparkfun library, replaced byte with uint8_t, 
 //                                                  https://github.com/uutzinger/SparkFun_SGP30_Arduino_Library.git
+//  - Sensirion word protocol and CRC table         shared by the SCD30, SGP30 and SPS30 drivers, libraries/Sensirion_Protocol
 //  - BME68x Bosch Temp, Humidity, Pressure, VOC,   Bosch Arduino library, 
 //                                                  https://github.com/BoschSensortec/Bosch-BME68x-Library
 //  - BM[E/P]280 Bosch Temp, [Humidity,] Pressure   Sparkfun library, replaced byte with uint8_t, 
@@ -49,8 +50,8 @@
 //  Check help-screen (send ? in terminal)
 //  3 wifi passwords and 2 mqtt servers.
 //  NPT server
-//  Settings are stored in EEPROM.
-//  Settings are saved every couple of hours in EEPROM.
+//  Settings are stored in a journal on LittleFS, the EEPROM copy of earlier versions is read once.
+//  Changed settings are saved every hour.
 //
 // Wifi:
 //  - Scans network for known ssid, attempts connection with username password, if disconnected, attempts reconnection.
@@ -109,6 +110,8 @@
 // Software implementation:
 //  The sensor driver is divided into intializations and update section.
 //  The updates are implemented as state machines and called on regular basis in the main loop.
+//  Each update is registered as task with the scheduler. The main loop only runs the tasks that are due and 
+//  idles until the next deadline.
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // This software is provided as is, no warranty on its proper operation is implied. Use it at your own risk.
@@ -119,6 +122,27 @@
 // Sometime:       Support for TFT display
 // Sometime:       Add support for xxx4x sensors from Sensirion, ENS160, BME688...
 //
+// 2026 October:   Deadline driven task scheduler replaces polling of all subsystems in main loop
+//                 Execution time histograms with percentiles replace max update times, /profile endpoint
+//                 Linux host build with simulated sensors and network in tests/ for benchmarking
+//                 I2C devices found are stored in EEPROM, full pin scan only if a device is missing
+//                 switchI2C only reconfigures the port when pins or clock change, sensor tasks grouped by pins
+//                 Split phase i2c transactions, SCD30 and SPS30 readings no longer wait for the sensor
+//                 Sensirion CRC lookup table and word decoding shared by SCD30, SGP30 and SPS30
+//                 Sensor history in RAM at 1 s, 1 min and 1 h resolution, /history endpoint
+//                 Compressed archive of minute means on LittleFS, one segment per day, /archive CSV and NDJSON export
+//                 Log entries buffered in RAM and written to LittleFS in batches
+//                 Settings journal on LittleFS with CRC, only changed fields are appended, saved hourly
+//                 Sensi.json is written and parsed field by field from a table, no JSON document on the heap
+//                 MQTT /data/all is streamed into the socket, no 1 KB payload on the stack
+//                 MQTT store and forward queue in RAM and LittleFS, drained at a limited rate after reconnect
+//                 MessagePack sensor messages on MQTT and WebSocket, selected per transport, schema topic and /schema
+//                 Deadband, minimum interval and heartbeat per sensor channel for MQTT and WebSocket messages
+//                 MQTT immediate mode sends pending topics round robin under a token bucket, age at publish per topic
+//                 /api/all returns all sensor blocks in one response with ETag and 304, dashboard polls it once
+//                 Dashboard is pushed over the websocket, snapshot on connect, resume after reconnect with the last seq
+//                 Web assets on LittleFS indexed at HTTP start with hash, strong ETag, 304 and cache headers
+//                 Non blocking HTTP server, several browsers with keep-alive, files and chunked responses sent as the browser takes them
 // 2022 Novemeber: Rewrote serial input command system and menu, SGP30 fixes
 // 2022 October:   Print and delete files on LittleFS, telnet fix, manually set average pressure, jsondate fix,
 //                 throttle MQTT, MQTT interval setting, BME680 not start detection.
@@ -207,6 +231,13 @@
 #define yieldFunction() yield()       // just yield, would be desired
 //#define yieldFunction()             // no yield
 
+// Idle -------
+// The main loop runs the tasks that are due and then idles until the next deadline.
+// ESP8266: delay() services WiFi and the OS and allows the modem to sleep in between.
+#define MAXIDLE 10                    // longest idle period in ms, should not exceed intervalNetService
+#define idleFunction(X) delay(X)      // options are delay(X) and empty for busy polling
+//#define idleFunction(X)             // no idle
+
 /************************************************************************************************************************************/
 // You should not need to change variables and constants below this line.
 // Runtime changes to this software are enabled through the terminal.
@@ -251,6 +282,13 @@ char tmpStr[256];  // universal buffer for formatting texT
 #include "src/Weather.h" // --- Open Weather dou
 #include "src/LCD.h"     // --- Display 
 #include "src/Print.h"   // --- Printing
+#include "src/Scheduler.h" // --- Task scheduling
+#include "src/Profile.h"   // --- Execution time statistics
+#include "src/I2C.h"       // --- I2C device topology
+#include "src/History.h"   // --- Sensor history at several resolutions
+#include "src/Archive.h"   // --- Sensor history on LittleFS
+#include "src/Queue.h"     // --- MQTT store and forward
+#include "src/Telemetry.h" // --- Binary sensor messages
 
 /************************************************************************************************************************************/
 // Sensor Configuration
@@ -275,6 +313,14 @@ TwoWire myWire = TwoWire(); //  inintialize the two wire system.
 // an other i2c bus. Unfortunately ESP8266 Arduino supports only one i2c instance because the wire 
 // library calls twi.h for which only one instance can run.
 // Each time we commounicte with a device we need to set SDA and SCL pins.
+// switchI2C keeps track of the current configuration and only reconfigures the port when pins or clock change.
+TwoWire      *i2cPort           = NULL;                    // port, pins and clock the port was last switched to
+int           i2cPortSDA        = -1;                      //
+int           i2cPortSCL        = -1;                      //
+uint32_t      i2cPortSpeed      = 0;                       //
+uint32_t      i2cPortStretch    = 0;                       //
+unsigned long i2cSwitches       = 0;                       // pins were reassigned
+unsigned long i2cSwitchesSkipped= 0;                       // port was already configured
 
 /************************************************************************************************************************************/
 // Healthy Airquality
@@ -308,6 +354,16 @@ unsigned long lastTime;                                    // last time we updat
 unsigned long intervalLoop;                                // desired frequency to update device states
 unsigned long intervalRuntime;                             // how often do we update the uptime counter of the system
 unsigned long lastSYS;                                     // determines desired frequency to update system information on serial port
+int           taskIDBlink = -1;                            // blink task changes its own interval
+int           taskIDI2CQueue = -1;                         // woken when a transaction is queued
+int           taskIDSCD30 = -1;                            // sensor tasks are woken by their state machine
+int           taskIDSGP30 = -1;
+int           taskIDCCS811 = -1;
+int           taskIDSPS30 = -1;
+int           taskIDBME280 = -1;
+int           taskIDBME68x = -1;
+int           taskIDMLX = -1;
+int           taskIDMAX30 = -1;
 unsigned long tmpTime;                                     // temporary variable to measures execution times
 long          myDelay;                                     // main loop delay, automatically computed
 long          myDelayMin = 1000;                           // minium delay over the last couple seconds, if less than 0, ESP8266 can not keep up with
@@ -327,72 +383,6 @@ unsigned long yieldTimeMin = 1000;
 unsigned long yieldTimeMax = 0;
 unsigned long yieldTimeMaxAllTime=0;
 
-unsigned long startUpdate = 0;
-unsigned long deltaUpdate = 0;
-unsigned long maxUpdateTime = 0;
-unsigned long maxUpdateWifi = 0;
-unsigned long maxUpdateOTA = 0;
-unsigned long maxUpdateNTP = 0;
-unsigned long maxUpdateTelnet = 0;
-unsigned long maxUpdateMQTT = 0;
-unsigned long maxUpdateWS = 0;
-unsigned long maxUpdateHTTP = 0;
-unsigned long maxUpdateHTTPUPDATER = 0;
-unsigned long maxUpdatemDNS = 0;
-unsigned long maxUpdateWeather = 0;
-unsigned long maxUpdateSCD30 = 0;
-unsigned long maxUpdateSGP30 = 0;
-unsigned long maxUpdateCCS811 = 0;
-unsigned long maxUpdateSPS30 = 0;
-unsigned long maxUpdateBME280 = 0; 
-unsigned long maxUpdateBME68x = 0; 
-unsigned long maxUpdateMLX = 0; 
-unsigned long maxUpdateMAX = 0;
-unsigned long maxUpdateMQTTMESSAGE = 0; 
-unsigned long maxUpdateWSMESSAGE = 0; 
-unsigned long maxUpdateLCD = 0;
-unsigned long maxUpdateINPUT = 0; 
-unsigned long maxUpdateRT = 0;
-unsigned long maxUpdateEEPROM = 0; 
-unsigned long maxUpdateJS = 0;
-unsigned long maxUpdateBASE = 0;
-unsigned long maxUpdateBLINK = 0;
-unsigned long maxUpdateREBOOT = 0;
-unsigned long maxUpdateALLGOOD = 0;
-unsigned long maxUpdateSYS = 0;
-
-unsigned long AllmaxUpdateTime = 0;
-unsigned long AllmaxUpdateWifi = 0;
-unsigned long AllmaxUpdateOTA = 0;
-unsigned long AllmaxUpdateNTP = 0;
-unsigned long AllmaxUpdateTelnet = 0;
-unsigned long AllmaxUpdateMQTT = 0;
-unsigned long AllmaxUpdateWS = 0;
-unsigned long AllmaxUpdateHTTP = 0;
-unsigned long AllmaxUpdateHTTPUPDATER = 0;
-unsigned long AllmaxUpdatemDNS = 0;
-unsigned long AllmaxUpdateWeather = 0;
-unsigned long AllmaxUpdateSCD30 = 0;
-unsigned long AllmaxUpdateSGP30 = 0;
-unsigned long AllmaxUpdateCCS811 = 0;
-unsigned long AllmaxUpdateSPS30 = 0;
-unsigned long AllmaxUpdateBME280 = 0; 
-unsigned long AllmaxUpdateBME68x = 0; 
-unsigned long AllmaxUpdateMLX = 0; 
-unsigned long AllmaxUpdateMAX = 0;
-unsigned long AllmaxUpdateMQTTMESSAGE = 0; 
-unsigned long AllmaxUpdateWSMESSAGE = 0; 
-unsigned long AllmaxUpdateLCD = 0;
-unsigned long AllmaxUpdateINPUT = 0; 
-unsigned long AllmaxUpdateRT = 0;
-unsigned long AllmaxUpdateEEPROM = 0; 
-unsigned long AllmaxUpdateJS = 0;
-unsigned long AllmaxUpdateBASE = 0;
-unsigned long AllmaxUpdateBLINK = 0;
-unsigned long AllmaxUpdateREBOOT = 0;
-unsigned long AllmaxUpdateALLGOOD = 0;
-unsigned long AllmaxUpdateSYS = 0;
-
 time_t        actualTime;                                  // https://www.cplusplus.com/reference/ctime/time_t/
 tm           *localTime;                                   // https://www.cplusplus.com/reference/ctime/tm/
 // Member    Type  Meaning                  Range
@@ -415,6 +405,8 @@ bool          timeNewData    = false;                      // do we have new dat
 bool          timeNewDataWS  = false;                      // do we have new data for websocket
 bool          dateNewData    = false;                      // do we have new data mqtt
 bool          dateNewDataWS  = false;                      // do we have new data websocket
+bool          systemNewDataWS = false;                     // system status for websocket
+uint32_t      sampleSequence = 0;                          // counts new readings, time and system updates, ETag of /api/all
 bool          ntpFirstTime   = true;
 bool          time_avail     = false;                      // do not display time until time is established
 bool          scheduleReboot = false;                      // is it time to reboot the ESP?
@@ -444,6 +436,9 @@ extern unsigned long      lastSaveSettings;                       // last time w
 extern unsigned long      lastSaveSettingsJSON;                   // last time we updated JSON, should occur every couple days
 extern Settings           mySettings;                             // the settings
 
+// I2C
+extern const unsigned int i2cTopologyAddress;                     // devices found on the i2c pins are stored at end of EEPROM
+
 // LCD
 extern bool          lcd_avail;
 extern uint8_t       lcd_i2c[2];                                  // the pins for the i2c port, set during initialization
@@ -452,7 +447,7 @@ extern TwoWire      *lcd_port;                                    // Pointer to
 extern bool          max30_avail;
 extern uint8_t       max30_i2c[2];                                 // the pins for the i2c port, set during initialization
 extern TwoWire      *max30_port;                                   // pointer to the i2c port, might be useful for other microcontrollers
-extern const long    intervalMAX30;
+extern const unsigned long intervalMAX30;
 extern unsigned long lastMAX30;            
 
 extern bool          ccs811_avail;
@@ -560,6 +555,16 @@ extern unsigned long lastWeather;
 extern unsigned long lastTelnet;         
 extern unsigned long lastWebSocket;      
 extern unsigned long lastTelnetInput;
+extern unsigned long logDropped;
+extern unsigned long queueMessageRate;
+extern unsigned long queueByteRate;
+extern unsigned long mqttMessageRate;
+extern unsigned long mqttByteRate;
+extern unsigned long mqttBurst;
+extern bool          systemNewData;
+extern uint8_t       mqttEncoding;
+extern uint8_t       wsEncoding;
+extern const TelemetryBand telemetryDefaultBands[HISTORY_CHANNELS] PROGMEM;
 
 extern bool          otaInProgress;
 extern bool          wifi_avail;
@@ -625,8 +630,17 @@ void setup() {
   /************************************************************************************************************************************/
   // Configuration setup and read
   /************************************************************************************************************************************/
-  EEPROM.begin(EEPROM_SIZE);
-  EEPROM.get(eepromAddress, mySettings);
+  // The file system holds the settings journal
+  fileSystemConfig.setAutoFormat(false);
+  LittleFS.setConfig(fileSystemConfig);
+  fsOK=LittleFS.begin(); 
+
+  EEPROM.begin(EEPROM_SIZE);                // also holds the I2C topology
+  defaultSettings();                        // settings missing in a journal of older firmware keep their default
+  if (loadSettings(mySettings) == false) {  // no valid journal, take settings of earlier firmware from EEPROM
+    loadSettingsEEPROM(mySettings);
+    compactSettings(mySettings);            // start journal
+  }
 
   /************************************************************************************************************************************/
   // Inject hard coded values into the settings.
@@ -698,11 +712,8 @@ void setup() {
   }
   
   /************************************************************************************************************************************/
-  // Start file system and list content
+  // List file system content
   /************************************************************************************************************************************/
-  fileSystemConfig.setAutoFormat(false);
-  LittleFS.setConfig(fileSystemConfig);
-  fsOK=LittleFS.begin(); 
   if (!fsOK){ R_printSerialLogln(F("LittleFS mount failed!")); }
   if (mySettings.debuglevel > 0 && fsOK) {
     R_printSerialLogln(F("LittleFS started. Contents:"));
@@ -724,126 +735,39 @@ void setup() {
   //myFile.read((uint8_t *)&mySettings, sizeof(mySettings));
   //myFile.close();
   
-  /************************************************************************************************************************************/
-  // When EEPROM is used for the first time, it has random content.
-  // A boolen seems to use one byte of memory in the EEPROM and when you read from EEPROM to a boolen variable 
-  // it can become uint_8. When the program sets these boolean values from true to false, it will convert 
-  // from true=255 to 254 and not to 0/false.
-  // At boot time we  need to ensure that any non zero value for boolean settings are forced to true.
-  // Once the varibales a set with code below and written back to EEPROM, this should not be necessary any longer.
-  if (mySettings.useLCD            > 0) { mySettings.useLCD            = true; } else { mySettings.useLCD              = false; }
-  if (mySettings.useWiFi           > 0) { mySettings.useWiFi           = true; } else { mySettings.useWiFi             = false; }
-  if (mySettings.useSCD30          > 0) { mySettings.useSCD30          = true; } else { mySettings.useSCD30            = false; }
-  if (mySettings.useSPS30          > 0) { mySettings.useSPS30          = true; } else { mySettings.useSPS30            = false; }
-  if (mySettings.useMAX30          > 0) { mySettings.useMAX30          = true; } else { mySettings.useMAX30            = false; }
-  if (mySettings.useMLX            > 0) { mySettings.useMLX            = true; } else { mySettings.useMLX              = false; }
-  if (mySettings.useBME68x         > 0) { mySettings.useBME68x         = true; } else { mySettings.useBME68x           = false; }
-  if (mySettings.useBME280         > 0) { mySettings.useBME280         = true; } else { mySettings.useBME280           = false; }
-  if (mySettings.useCCS811         > 0) { mySettings.useCCS811         = true; } else { mySettings.useCCS811           = false; }
-  if (mySettings.sendMQTTimmediate > 0) { mySettings.sendMQTTimmediate = true; } else { mySettings.sendMQTTimmediate   = false; }
-  if (mySettings.notused           > 0) { mySettings.notused           = true; } else { mySettings.notused             = false; }
-  if (mySettings.useBacklight      > 0) { mySettings.useBacklight      = true; } else { mySettings.useBacklight        = false; }
-  if (mySettings.useBacklightNight > 0) { mySettings.useBacklightNight = true; } else { mySettings.useBacklightNight   = false; }
-  if (mySettings.useBlinkNight     > 0) { mySettings.useBlinkNight     = true; } else { mySettings.useBlinkNight       = false; }
-  if (mySettings.useHTTP           > 0) { mySettings.useHTTP           = true; } else { mySettings.useHTTP             = false; }
-  if (mySettings.useHTTPUpdater    > 0) { mySettings.useHTTPUpdater    = true; } else { mySettings.useHTTPUpdater      = false; }
-  if (mySettings.useNTP            > 0) { mySettings.useNTP            = true; } else { mySettings.useNTP              = false; }
-  if (mySettings.useMQTT           > 0) { mySettings.useMQTT           = true; } else { mySettings.useMQTT             = false; }
-  if (mySettings.useOTA            > 0) { mySettings.useOTA            = true; } else { mySettings.useOTA              = false; }
-  if (mySettings.usemDNS           > 0) { mySettings.usemDNS           = true; } else { mySettings.usemDNS             = false; }
-  if (mySettings.useTelnet         > 0) { mySettings.useTelnet         = true; } else { mySettings.useTelnet           = false; }
-  if (mySettings.useSerial         > 0) { mySettings.useSerial         = true; } else { mySettings.useSerial           = false; }
-  if (mySettings.useLog            > 0) { mySettings.useLog            = true; } else { mySettings.useLog              = false; }
-  if (mySettings.useWeather        > 0) { mySettings.useWeather        = true; } else { mySettings.useWeather          = false; }
 
   /************************************************************************************************************************************/
   // Check which devices are attached to the I2C pins, this self configures our connections to the sensors
   /************************************************************************************************************************************/
-  // Wemos 
-  // uint8_t portArray[] = {16, 5, 4, 0, 2, 14, 12, 13};
-  // String portMap[] = {"D0", "D1", "D2", "D3", "D4", "D5", "D6", "D7"};
-
-  // dont search on ports used for data ready or interrupt signaling, otherwise use all the ones listed above
-  uint8_t portArray[] = {5, 4, 0, 2, 14, 12};
-  char portMap[6][3] = {"D1", "D2", "D3", "D4", "D5", "D6"};
-  uint8_t error, address;
-  
   // lets turn on CCS811 so we can find it ;-)
   pinMode(CCS811_WAKE, OUTPUT);                        // CCS811 not Wake Pin
   digitalWrite(CCS811_WAKE, LOW);                      // set CCS811 to wake up
 
+  // Only the devices found at previous boot are verified, full scan if one is missing
   R_printSerialLogln();
-  for (uint8_t i = 0; i < sizeof(portArray); i++) {
-    for (uint8_t j = 0; j < sizeof(portArray); j++) {
-      if (i != j) {
-        snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Scanning (SDA:SCL) - %s:%s"), portMap[i], portMap[j]); 
-        R_printSerialLogln(tmpStr);
-        myWire.begin(portArray[i], portArray[j]);
-        myWire.setClock(I2C_SLOW);
-        myWire.setClockStretchLimit(200000);
-        for (address = 1; address < 127; address++ )  {
-          myWire.beginTransmission(address);
-          error = myWire.endTransmission();
-          if (error == 0) {
-            // found a device
-            if      (address == 0x20) {
-              lcd_avail  = true;  // LCD display Adafruit
-              lcd_port   = &myWire;    lcd_i2c[0]  = portArray[i];    lcd_i2c[1] = portArray[j];
-            } else if (address == 0x27) {
-              lcd_avail  = true;  // LCD display PCF8574
-              lcd_port   = &myWire;    lcd_i2c[0]  = portArray[i];    lcd_i2c[1] = portArray[j];
-            } else if (address == 0x57) {
-              max30_avail  = true;  // MAX 30105 Pulseox & Particle
-              max30_port   = &myWire;  max30_i2c[0] = portArray[i];  max30_i2c[1] = portArray[j];
-            } else if (address == 0x58) {
-              sgp30_avail  = true;  // Senserion TVOC eCO2
-              sgp30_port   = &myWire;  sgp30_i2c[0] = portArray[i];  sgp30_i2c[1] = portArray[j];
-            } else if (address == 0x5A) {
-              therm_avail = true;  // MLX IR sensor
-              mlx_port    = &myWire;   mlx_i2c[0]  = portArray[i];   mlx_i2c[1]  = portArray[j];
-            } else if (address == 0x5B) {
-              ccs811_avail  = true;  // Airquality CO2 tVOC
-              ccs811_port   = &myWire; ccs811_i2c[0] = portArray[i]; ccs811_i2c[1] = portArray[j];
-            } else if (address == 0x61) {
-              scd30_avail  = true;  // Senserion CO2
-              scd30_port   = &myWire;  scd30_i2c[0] = portArray[i];  scd30_i2c[1] = portArray[j];
-            } else if (address == 0x69) {
-              sps30_avail  = true;  // Senserion Particle
-              sps30_port   = &myWire;  sps30_i2c[0] = portArray[i];  sps30_i2c[1] = portArray[j];
-            } else if (address == 0x76) {
-              bme280_avail  = true;  // Bosch Temp, Humidity, Pressure
-              bme280_port   = &myWire; bme280_i2c[0] = portArray[i]; bme280_i2c[1] = portArray[j];
-            } else if (address == 0x77) {
-              bme68x_avail  = true;  // Bosch Temp, Humidity, Pressure, VOC
-              bme68x_port   = &myWire; bme68x_i2c[0] = portArray[i]; bme68x_i2c[1] = portArray[j];
-            } else {
-              snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Found unknonw device - %d!"),address); 
-              R_printSerialLog(tmpStr);
-            }
-          }
-        }
-      }
-    }
+  if ( (loadI2CTopology() && verifyI2CTopology()) == false ) {
+    scanI2C(false);
+    saveI2CTopology();
   }
 
   // List the devices we found
-  if (lcd_avail)    { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("LCD                  available: %2d SDA %d SCL %2d"), uint32_t(lcd_port),    lcd_i2c[0],    lcd_i2c[1]);    } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("LCD                  not available")); }  
+  if (lcd_avail)    { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("LCD                  available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(lcd_port)),    lcd_i2c[0],    lcd_i2c[1]);    } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("LCD                  not available")); }  
   R_printSerialLogln(tmpStr);
-  if (max30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MAX3010x             available: %2d SDA %d SCL %2d"), uint32_t(max30_port),  max30_i2c[0],  max30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MAX3010x             not available")); }  
+  if (max30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MAX3010x             available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(max30_port)),  max30_i2c[0],  max30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MAX3010x             not available")); }  
   printSerialLogln(tmpStr);
-  if (ccs811_avail) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811 eCO2, tVOC    available: %2d SDA %d SCL %2d"), uint32_t(ccs811_port), ccs811_i2c[0], ccs811_i2c[1]); } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811 eCO2, tVOC    not available")); }  
+  if (ccs811_avail) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811 eCO2, tVOC    available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(ccs811_port)), ccs811_i2c[0], ccs811_i2c[1]); } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811 eCO2, tVOC    not available")); }  
   R_printSerialLogln(tmpStr);
-  if (sgp30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 eCO2, tVOC     available: %2d SDA %d SCL %2d"), uint32_t(sgp30_port),  sgp30_i2c[0],  sgp30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 eCO2, tVOC     not available")); }  
+  if (sgp30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 eCO2, tVOC     available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(sgp30_port)),  sgp30_i2c[0],  sgp30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 eCO2, tVOC     not available")); }  
   R_printSerialLogln(tmpStr);
-  if (therm_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MLX temp             available: %2d SDA %d SCL %2d"), uint32_t(mlx_port),    mlx_i2c[0],    mlx_i2c[1]);    } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MLX temp             not available")); }  
+  if (therm_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MLX temp             available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(mlx_port)),    mlx_i2c[0],    mlx_i2c[1]);    } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MLX temp             not available")); }  
   R_printSerialLogln(tmpStr);
-  if (scd30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 CO2, rH        available: %2d SDA %d SCL %2d"), uint32_t(scd30_port),  scd30_i2c[0],  scd30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 CO2, rH        not available")); }
+  if (scd30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 CO2, rH        available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(scd30_port)),  scd30_i2c[0],  scd30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 CO2, rH        not available")); }
   R_printSerialLogln(tmpStr);
-  if (sps30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30 PM             available: %2d SDA %d SCL %2d"), uint32_t(sps30_port),  sps30_i2c[0],  sps30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30 PM             not available")); }  
+  if (sps30_avail)  { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30 PM             available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(sps30_port)),  sps30_i2c[0],  sps30_i2c[1]);  } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30 PM             not available")); }  
   R_printSerialLogln(tmpStr);
-  if (bme280_avail) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BM[E/P]280 T, P[,rH] available: %2d SDA %d SCL %2d"), uint32_t(bme280_port), bme280_i2c[0], bme280_i2c[1]); } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BM[E/P]280 T, P[,rH] not available")); }  
+  if (bme280_avail) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BM[E/P]280 T, P[,rH] available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(bme280_port)), bme280_i2c[0], bme280_i2c[1]); } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BM[E/P]280 T, P[,rH] not available")); }  
   R_printSerialLogln(tmpStr);
-  if (bme68x_avail) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x T, rH, P tVOC available: %2d SDA %d SCL %2d"), uint32_t(bme68x_port), bme68x_i2c[0], bme68x_i2c[1]); } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x T, rH, P tVOC not available")); }  
+  if (bme68x_avail) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x T, rH, P tVOC available: %2d SDA %d SCL %2d"), uint32_t(uintptr_t(bme68x_port)), bme68x_i2c[0], bme68x_i2c[1]); } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x T, rH, P tVOC not available")); }  
   R_printSerialLogln(tmpStr);
 
   /************************************************************************************************************************************/
@@ -867,6 +791,13 @@ void setup() {
   }
   intervalMQTT     = (unsigned long)(mySettings.intervalMQTT*1000.);          // 
   intervalNewData = true;
+  mqttEncoding     = (mySettings.mqttEncoding == TELEMETRY_MSGPACK) ? TELEMETRY_MSGPACK : TELEMETRY_JSON;
+  wsEncoding       = (mySettings.wsEncoding   == TELEMETRY_MSGPACK) ? TELEMETRY_MSGPACK : TELEMETRY_JSON;
+  mqttMessageRate  = (mySettings.mqttMessageRate  > 0) ? mySettings.mqttMessageRate  : MQTT_MESSAGERATE; // a zero rate would stop the messages
+  mqttBurst        = (mySettings.mqttBurst        > 0) ? mySettings.mqttBurst        : MQTT_BURST;
+  mqttByteRate     = (mySettings.mqttByteRate     > 0) ? mySettings.mqttByteRate     : MQTT_BYTERATE;
+  queueMessageRate =  mySettings.queueMessageRate;                             // 0 holds the queue
+  queueByteRate    = (mySettings.queueByteRate    > 0) ? mySettings.queueByteRate    : QUEUE_BYTERATE;
 
   /************************************************************************************************************************************/
   // Initialize all devices
@@ -899,6 +830,7 @@ void setup() {
 
   myWire.setClock(I2C_REGULAR);             // in Hz
   myWire.setClockStretchLimit(150000);      // in micro seconds
+  resetI2C();                               // libraries might have called begin() on the port
 
   // how often do we reset the cpu usage time counters for the subroutines?
   intervalSYS                                     = intervalWiFi;
@@ -913,6 +845,11 @@ void setup() {
   if (intervalSGP30  > intervalSYS) { intervalSYS = intervalSGP30;  }
   if (intervalSPS30  > intervalSYS) { intervalSYS = intervalSPS30;  }
 
+  initializeHistory();                      // rings for the sensors found
+  initializeArchive();                      // segments on LittleFS
+  initializeQueue();                        // records not published before reset
+  initializeTelemetry();                    // publish policy of sensor messages
+
   /************************************************************************************************************************************/
   // Populate LCD screen, start with cleared LCD
   /************************************************************************************************************************************/
@@ -986,6 +923,43 @@ void setup() {
   lastLogFile           = currentTime;
   lastSerialInput       = currentTime;
   lastTelnetInput       = currentTime;
+
+  /************************************************************************************************************************************/
+  // Register Tasks
+  /************************************************************************************************************************************/
+  // Socket services need frequent attention, the network state machines step once per intervalWiFi,
+  // sensor tasks are woken by their own state machine, other events run at their own interval.
+  // Tasks are executed in the order below if they are due at the same time.
+  addTask(taskTimeDate,          1000,                PROFILE_TIME);
+  addTask(taskWiFi,              intervalWiFi,        PROFILE_WIFI);
+  addTask(taskOTA,               intervalNetService,  PROFILE_OTA);
+  addTask(taskNTP,               intervalWiFi,        PROFILE_NTP);
+  addTask(taskMQTT,              intervalNetService,  PROFILE_MQTT);
+  addTask(taskWebSocket,         intervalNetService,  PROFILE_WS);
+  addTask(taskHTTP,              intervalNetService,  PROFILE_HTTP);
+  addTask(taskHTTPUpdater,       intervalNetService,  PROFILE_HTTPUPDATER);
+  addTask(taskMDNS,              intervalNetService,  PROFILE_MDNS);
+  addTask(taskTelnet,            intervalNetService,  PROFILE_TELNET);
+  addTask(taskWeather,           intervalWiFi,        PROFILE_WEATHER);
+  addI2CTasks(intervalI2C);      // SCD30, SGP30, CCS811, SPS30, BME280, BME68x, MLX, MAX30 grouped by i2c pins
+  taskIDI2CQueue =
+  addTask(taskI2CQueue,          intervalI2C,         PROFILE_I2CQUEUE);
+  wakeTask(taskIDI2CQueue, 0);   // responses queued during setup, afterwards woken by queueI2C
+  addTask(taskMQTTMessage,       intervalMQTTFast,    PROFILE_MQTTMESSAGE);
+  addTask(taskWebSocketMessage,  intervalWebSocket,   PROFILE_WSMESSAGE);
+  addTask(taskLCD,               1000,                PROFILE_LCD);
+  addTask(taskSYS,               intervalSYS,         PROFILE_SYS);
+  addTask(taskInput,             intervalNetService,  PROFILE_INPUT);
+  addTask(taskRuntime,           intervalRuntime,     PROFILE_RUNTIME);
+  addTask(taskEEPROM,            intervalSettings,    PROFILE_EEPROM);
+  addTask(taskLogFile,           INTERVALLOGFILE,     PROFILE_LOGFILE);
+  addTask(taskBaseline,          intervalBaseline,    PROFILE_BASELINE);
+  addTask(taskWarning,           intervalWarning,     PROFILE_ALLGOOD);
+  taskIDBlink = 
+  addTask(taskBlink,             intervalBlink,       PROFILE_BLINK);
+  addTask(taskReboot,            1000,                PROFILE_REBOOT);
+  addTask(taskI2C,               intervalI2C,         PROFILE_I2C);
+  addTask(taskHistory,           intervalHistory,     PROFILE_HISTORY);
     
 } // end setup
 
@@ -996,597 +970,462 @@ void setup() {
 void loop() {
   currentTime = lastYield = millis();                   // keep track of loop time
   
-  if (otaInProgress) { updateOTA(); }                   // when OTA is in progress we do not do anything else
-  else {                                                // OTA is not in progress, we update the subsystems
+  if (otaInProgress) {                                  // when OTA is in progress we do not do anything else
+    ProfileTimer profileTimer(PROFILE_OTA);
+    updateOTA(); 
+  } else {                                              // OTA is not in progress, we update the subsystems
 
-    // Free up Processor 
-    // You can not free up processor time here or at the end of the main loop as system crashes when inserting delay()
-    // D_printSerialTelnet(F("D:U:LD.."));
-    // if (myLoop < intervalLoop) {
-    //   delayRuns = (intervalLoop - myLoop) / 25;      // how often do we want to repeat delay 
-    //   if (delayRuns > 4) { delayRuns = 4; }          // we do not want to stay here for too long (100ms)
-    //   for (int i=0; i<=delayRuns; i++) { delay(25); }
-    // }
-    
-    // update current time every second -----------------------------------------------------------------
-    if ( (currentTime - lastcurrentTime) >= 1000 ) {
-      lastcurrentTime = currentTime;
-      D_printSerialTelnet(F("D:U:D&T.."));      
-
-      startUpdate = millis(); // how long does this code segment take?
-      actualTime  = time(NULL);
-      localTime   = localtime(&actualTime);             // convert to localtime with daylight saving time
-      time_avail  = true;
-
-      // every minute, broadcast time
-      if (localTime->tm_min != lastMin) {
-        timeNewDataWS = true;                           // broadcast date on websocket
-        timeNewData   = true;                           // broadcast date on mqtt
-        lastMin       = localTime->tm_min;
-      }
-      
-      if (localTime->tm_yday != lastYearDay) {
-        dateNewDataWS = true;                           // broadcast date on websocket
-        dateNewData   = true;                           // broadcast date on mqtt
-        lastYearDay   = localTime->tm_yday;
-      }
+    unsigned long startLoop = currentTime;
 
-      deltaUpdate = millis() - startUpdate;                                   // this code segment took delta ms
-      if (maxUpdateTime    < deltaUpdate) { maxUpdateTime = deltaUpdate; }    // current max updatetime for this code segment
-      if (AllmaxUpdateTime < deltaUpdate) { AllmaxUpdateTime = deltaUpdate; } // longest global updatetime for this code segement
-
-      D_printSerialTelnet(F("D:S:NTP.."));
-      yieldTime += yieldOS(); 
-    }
-    
     /**********************************************************************************************************************************/
     // Update the State Machines for all Devices and System Processes
     /**********************************************************************************************************************************/
-    // Update Wireless Services 
-    if (wifi_avail               && mySettings.useWiFi) { 
-      startUpdate = millis();
-      updateWiFi(); //<<<<<<<<<<<<<<<<<<<<--------------- WiFi update, this will reconnect if disconnected
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateWifi    < deltaUpdate) { maxUpdateWifi = deltaUpdate; }
-      if (AllmaxUpdateWifi < deltaUpdate) { AllmaxUpdateWifi = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (wifi_avail               && mySettings.useWiFi && mySettings.useOTA)    { 
-      startUpdate = millis();
-      updateOTA(); //<<<<<<<<<<<<<<<<<<<<---------------- Update OTA --------------------------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateOTA    < deltaUpdate)  { maxUpdateOTA = deltaUpdate; }
-      if (AllmaxUpdateOTA < deltaUpdate)  { AllmaxUpdateOTA = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (wifi_avail && ntp_avail  && mySettings.useWiFi && mySettings.useNTP)    { 
-      startUpdate = millis();
-      updateNTP();  //<<<<<<<<<<<<<<<<<<<<--------------- Update Network Time -----------------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateNTP    < deltaUpdate)  { maxUpdateNTP = deltaUpdate; }
-      if (AllmaxUpdateNTP < deltaUpdate)  { AllmaxUpdateNTP = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (wifi_avail                && mySettings.useWiFi && mySettings.useMQTT)   { 
-      startUpdate = millis();
-      updateMQTT(); //<<<<<<<<<<<<<<<<<<<<--------------- MQTT update serve connection --------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateMQTT    < deltaUpdate) { maxUpdateMQTT = deltaUpdate; }
-      if (AllmaxUpdateMQTT < deltaUpdate) { AllmaxUpdateMQTT = deltaUpdate; }
-      yieldTime += yieldOS();
-    } 
-    if (wifi_avail                && mySettings.useWiFi && mySettings.useHTTP)   { 
-      startUpdate = millis();
-      updateWebSocket(); //<<<<<<<<<<<<<<<<<<<<---------- Websocket update server connection --------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateWS    < deltaUpdate)   { maxUpdateWS = deltaUpdate; }
-      if (AllmaxUpdateWS < deltaUpdate)   { AllmaxUpdateWS = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (wifi_avail                && mySettings.useWiFi && mySettings.useHTTP)   { 
-      startUpdate = millis();
-      updateHTTP(); //<<<<<<<<<<<<<<<<<<<<--------------- Update web server -------------------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateHTTP    < deltaUpdate) { maxUpdateHTTP = deltaUpdate; }
-      if (AllmaxUpdateHTTP < deltaUpdate) { AllmaxUpdateHTTP = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (wifi_avail                && mySettings.useWiFi && mySettings.useHTTPUpdater)   { 
-      startUpdate = millis();
-      updateHTTPUpdater();  //<<<<<<<<<<<<<<<<<<<<------- Update firmware web server ----------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateHTTPUPDATER    < deltaUpdate) { maxUpdateHTTPUPDATER = deltaUpdate; }
-      if (AllmaxUpdateHTTPUPDATER < deltaUpdate) { AllmaxUpdateHTTPUPDATER = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (wifi_avail && mdns_avail  && mySettings.useWiFi && mySettings.usemDNS)   { 
-      startUpdate = millis();
-      updateMDNS(); //<<<<<<<<<<<<<<<<<<<<--------------- Update mDNS -------------------------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdatemDNS    < deltaUpdate) { maxUpdatemDNS = deltaUpdate; }
-      if (AllmaxUpdatemDNS < deltaUpdate) { AllmaxUpdatemDNS = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (wifi_avail                && mySettings.useWiFi && mySettings.useTelnet)    { 
-      startUpdate = millis();
-      updateTelnet();  //<<<<<<<<<<<<<<<<<<<<------------ Update Telnet -----------------------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateTelnet    < deltaUpdate) { maxUpdateTelnet = deltaUpdate; }
-      if (AllmaxUpdateTelnet < deltaUpdate) { AllmaxUpdateTelnet = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    }
-    if (wifi_avail                && mySettings.useWiFi && mySettings.useWeather)    { 
-      startUpdate = millis();
-      updateWeather();  //<<<<<<<<<<<<<<<<<<<<------------ Update Telnet -----------------------------------
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateWeather    < deltaUpdate) { maxUpdateWeather = deltaUpdate; }
-      if (AllmaxUpdateWeather < deltaUpdate) { AllmaxUpdateWeather = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    }
-    
+    // Only the tasks whose deadline has passed are executed, see Scheduled Tasks below
+    runTasks();
+
     /**********************************************************************************************************************************/
-    // Update Sensor Readings
+    // Keep track of free processor time 
     /**********************************************************************************************************************************/
     
-    if (scd30_avail    && mySettings.useSCD30) { 
-      D_printSerialTelnet(F("D:U:SCD30.."));
-      startUpdate = millis();
-      if (updateSCD30()  == false) {scheduleReboot = true;}  //<<<<<<<<<<<<<<<<<< SCD30 Sensirion CO2 sensor
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateSCD30    < deltaUpdate)  { maxUpdateSCD30 = deltaUpdate; }
-      if (AllmaxUpdateSCD30 < deltaUpdate)  { AllmaxUpdateSCD30 = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (sgp30_avail    && mySettings.useSGP30) { 
-      D_printSerialTelnet(F("D:U:SGP30.."));
-      startUpdate = millis();
-      if (updateSGP30()  == false) {scheduleReboot = true;}  //<<<<<<<<<<<<<<<<< SGP30 Sensirion eCO2 sensor
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateSGP30 < deltaUpdate)     { maxUpdateSGP30 = deltaUpdate; }
-      if (AllmaxUpdateSGP30 < deltaUpdate)  { AllmaxUpdateSGP30 = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (ccs811_avail   && mySettings.useCCS811) { 
-      D_printSerialTelnet(F("D:U:CCS811.."));
-      startUpdate = millis();
-      if (updateCCS811() == false) {scheduleReboot = true;}  //<<<<<<<<<<<<<<<<<<<<------ CCS811 eCO2 sensor
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateCCS811    < deltaUpdate) { maxUpdateCCS811 = deltaUpdate; }
-      if (AllmaxUpdateCCS811 < deltaUpdate) { AllmaxUpdateCCS811 = deltaUpdate; }
-      yieldTime += yieldOS(); 
+    myLoop  = millis() - startLoop;
+    myLoopAvg = 0.9 * myLoopAvg + 0.1 * float(myLoop);
+    if ( myLoop > 0 ) { 
+      if ( myLoop < myLoopMin ) { myLoopMin = myLoop; }
+      if ( myLoop > myLoopMax ) { 
+        myLoopMax = myLoop; 
+        if ( myLoop > myLoopMaxAllTime)  { myLoopMaxAllTime = myLoop; }
+      }
     }
-    if (sps30_avail    && mySettings.useSPS30) { 
-      D_printSerialTelnet(F("D:U:SPS30.."));
-      startUpdate = millis();
-      if (updateSPS30()  == false) {scheduleReboot = true;}  //<<<<<<<<<<<<< SPS30 Sensirion Particle sensor
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateSPS30    < deltaUpdate)  { maxUpdateSPS30 = deltaUpdate; }
-      if (AllmaxUpdateSPS30 < deltaUpdate)  { AllmaxUpdateSPS30 = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (bme280_avail   && mySettings.useBME280) { 
-      D_printSerialTelnet(F("D:U:BME280.."));
-      startUpdate = millis();
-      if (updateBME280() == false) {scheduleReboot = true;}  //<<<<<<<<<<<<<<<<<<<< BME280, Hum, Press, Temp
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateBME280    < deltaUpdate) { maxUpdateBME280 = deltaUpdate; }
-      if (AllmaxUpdateBME280 < deltaUpdate) { AllmaxUpdateBME280 = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    if (bme68x_avail   && mySettings.useBME68x) { 
-      D_printSerialTelnet(F("D:U:BME68x.."));
-      startUpdate = millis();
-      if (updateBME68x() == false) {scheduleReboot = true;}  //<<<<< BME68x, Hum, Press, Temp, Gasresistance
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateBME68x    < deltaUpdate) { maxUpdateBME68x = deltaUpdate; }
-      if (AllmaxUpdateBME68x < deltaUpdate) { AllmaxUpdateBME68x = deltaUpdate; }      
-      yieldTime += yieldOS(); 
+    if (myLoopMax > 20) {
+      myLoopMaxAvg = 0.9 * myLoopMaxAvg + 0.1 * float(myLoopMax);
+    }  
+    if ( yieldTime > 0 ) { 
+      if ( yieldTime < yieldTimeMin ) { yieldTimeMin = yieldTime; }
+      if ( yieldTime > yieldTimeMax ) {
+        yieldTimeMax = yieldTime; 
+        if ( yieldTime > yieldTimeMaxAllTime)  { yieldTimeMaxAllTime = yieldTime; }
+      }
+      yieldTime = 0;
     }
-    if (therm_avail    && mySettings.useMLX) { 
-      D_printSerialTelnet(F("D:U:THERM.."));
-      startUpdate = millis();
-      if (updateMLX()    == false) {scheduleReboot = true;}  //<<<<<<<<<<<<<< MLX Contactless Thermal Sensor
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateMLX    < deltaUpdate)    { maxUpdateMLX = deltaUpdate; }      
-      if (AllmaxUpdateMLX < deltaUpdate)    { AllmaxUpdateMLX = deltaUpdate; }      
-      yieldTime += yieldOS(); 
-    } 
-    if (max30_avail      && mySettings.useMAX30) {
-      D_printSerialTelnet(F("D:U:MAX30.."));
-      startUpdate = millis();
-      // goes here // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< MAX Pulse Ox Sensor      
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateMAX    < deltaUpdate)    { maxUpdateMAX = deltaUpdate; } 
-      if (AllmaxUpdateMAX < deltaUpdate)    { AllmaxUpdateMAX = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    } 
-    
+
     /**********************************************************************************************************************************/
-    // Broadcast MQTT and WebSocket Messages
+    // Free up Processor 
     /**********************************************************************************************************************************/
-    
-    if (mqtt_connected) {
-      D_printSerialTelnet(F("D:U:MQTT.."));
-      startUpdate = millis();
-      updateMQTTMessage();  //<<<<<<<<<<<<<<<<<<<<----------------------------------- MQTT send sensor data
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateMQTTMESSAGE    < deltaUpdate) { maxUpdateMQTTMESSAGE = deltaUpdate; }
-      if (AllmaxUpdateMQTTMESSAGE < deltaUpdate) { AllmaxUpdateMQTTMESSAGE = deltaUpdate; }
-      // yieldTime += yieldOS(); // is inside updateMQTTMessage()
+    // Nothing is due until the next deadline
+    if ( (logBuffered() >= LOGFLUSHSIZE) && (timeToNextTask() >= LOGFLUSHIDLE) ) {
+      ProfileTimer profileTimer(PROFILE_LOGFILE);
+      flushLog();                                       // write log entries in batches while idle
     }
-    if (ws_connected) { 
-      D_printSerialTelnet(F("D:U:WS.."));
-      startUpdate = millis();      
-      updateWebSocketMessage();  //<<<<<<<<<<<<<<<<<<<<-------------------------- WebSocket send sensor data
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateWSMESSAGE    < deltaUpdate) { maxUpdateWSMESSAGE = deltaUpdate; }
-      if (AllmaxUpdateWSMESSAGE < deltaUpdate) { AllmaxUpdateWSMESSAGE = deltaUpdate; }
-      // yieldTime += yieldOS(); // is inside updateWebSocketMessage 
+    myDelay = timeToNextTask();
+    if (myDelay > MAXIDLE) { myDelay = MAXIDLE; }
+    myDelayAvg = 0.9 * myDelayAvg + 0.1 * float(myDelay);
+    if ( myDelay < myDelayMin ) { myDelayMin = myDelay; }
+    if ( myDelay > 0 ) { 
+      idleFunction(myDelay);                            // replaced with define statement at beginning of the this document
+      lastYield = millis();
     }
-
-    /**********************************************************************************************************************************/
-    // LCD: Display Sensor Data
-    /**********************************************************************************************************************************/
     
-    if (lcd_avail && mySettings.useLCD) {
-      if ( ((localTime->tm_sec % (intervalLCD/1000)) == 0) && ((currentTime - lastLCD) >= intervalLCD) ) {
-        lastLCD = currentTime;
-        D_printSerialTelnet(F("D:U:LCD.."));
-        startUpdate = millis();
-        int timeMinutes = localTime->tm_hour*60+localTime->tm_min;
-        
-        // Update the LCD screen
-        // ---
-        if      ( mySettings.LCDdisplayType == 1 ) { updateLCD(); }                //<<<<<<------
-        else if ( mySettings.LCDdisplayType == 2 ) { updateTwoPageLCD(); }
-        else if ( mySettings.LCDdisplayType == 3 ) { updateSinglePageLCD(); }
-        else if ( mySettings.LCDdisplayType == 4 ) { updateSinglePageLCDwTime(); }
-        else { if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("LCD display type not supported")); } } 
-          
-        // Do we want to blink the LCD background ?
-        // ---
-        if ( mySettings.useBacklight && (allGood == false) ) {
-          // Sensors indicate blinking 
-          // Is our time synced?
-          if ((currentTime-ntp_lastSync) < 10*NTP_INTERVAL*1000) {
-            // We have network synced time.
-            // Do we want to blink at night or is it day time?
-            if ( (mySettings.useBlinkNight == true) ||
-               ( (mySettings.useBlinkNight == false) && ( (timeMinutes < mySettings.nightBegin) && (timeMinutes > mySettings.nightEnd) ) ) 
-               ) { blinkLCD = true; }
-            else { blinkLCD = false;} 
-          } else { blinkLCD = true; } // no network time
-        } else { blinkLCD = false; } // sensors in accetable range
-
-        // Update LCD background 
-        // --=-
-        // If we want to blink, dont adjust the background
-        //   If background is on:
-        //     If we dont want background light turn it off
-        //     If background is on and we want it off during the night turn it off
-        //   If background is off:
-        //     If we want background
-        //       If we dont care about night, turn on
-        //       If we care about night, turn on if its day time
+  } // end OTA not in progress
+} // end loop
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scheduled Tasks
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// The tasks are registered in setup() and executed by runTasks() when their deadline has passed.
+// Execution time is measured by the scheduler.
+
+// update current time every second -----------------------------------------------------------------
+void taskTimeDate() {
+  lastcurrentTime = currentTime;
+  D_printSerialTelnet(F("D:U:D&T.."));      
+
+  actualTime  = time(NULL);
+  localTime   = localtime(&actualTime);                 // convert to localtime with daylight saving time
+  time_avail  = true;
+
+  // every minute, broadcast time
+  if (localTime->tm_min != lastMin) {
+    timeNewDataWS = true;                               // broadcast date on websocket
+    timeNewData   = true;                               // broadcast date on mqtt
+    sampleSequence++;
+    lastMin       = localTime->tm_min;
+  }
   
-        if (blinkLCD == false) {
-          if (lastLCDInten) {
-            // LCD background is ON
-            // ---
-            // dont want backlight at all or dont want backlight at night
-            if ( (mySettings.useBacklight == false) ||       
-                 ( (mySettings.useBacklightNight == false) && 
-                   ( (timeMinutes >= mySettings.nightBegin) || 
-                     (timeMinutes <= mySettings.nightEnd) 
-                   )
-                 )  
-            ) { 
-              // Turn LCD light off
-              switchI2C(lcd_port, lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit);
-              #if defined(ADALCD)
-              lcd.setBacklight(LOW);
-              #else
-              lcd.setBacklight(0);
-              #endif
-              lastLCDInten = false;
-            }
-          } else {
-            // LCD background is OFF
-            // ---
-            // want backlight on night and day or want backlight on during day
-            if ( ( (mySettings.useBacklight == true) && (mySettings.useBacklightNight == true) ) ||  
-                   ( (timeMinutes < mySettings.nightBegin) && 
-                     (timeMinutes > mySettings.nightEnd) 
-                   )
-            ) { 
-              // Turn LCD light on
-              switchI2C(lcd_port, lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit);
-              #if defined(ADALCD)
-               lcd.setBacklight(HIGH);
-              #else
-               lcd.setBacklight(255);
-              #endif
-              lastLCDInten = true;
-            }           
+  if (localTime->tm_yday != lastYearDay) {
+    dateNewDataWS = true;                               // broadcast date on websocket
+    dateNewData   = true;                               // broadcast date on mqtt
+    sampleSequence++;
+    lastYearDay   = localTime->tm_yday;
+  }
+  D_printSerialTelnet(F("D:S:NTP.."));
+}
+
+/**************************************************************************************************************************************/
+// Update Wireless Services 
+/**************************************************************************************************************************************/
+
+void taskWiFi()        { if (wifi_avail              && mySettings.useWiFi)                           { updateWiFi(); } }        // WiFi update, this will reconnect if disconnected
+void taskOTA()         { if (wifi_avail              && mySettings.useWiFi && mySettings.useOTA)        { updateOTA(); } }         // Update OTA
+void taskNTP()         { if (wifi_avail && ntp_avail && mySettings.useWiFi && mySettings.useNTP)        { updateNTP(); } }         // Update Network Time
+void taskMQTT()        { if (wifi_avail              && mySettings.useWiFi && mySettings.useMQTT)       { updateMQTT(); } }        // MQTT update serve connection
+void taskWebSocket()   { if (wifi_avail              && mySettings.useWiFi && mySettings.useHTTP)       { updateWebSocket(); } }   // Websocket update server connection
+void taskHTTP()        { if (wifi_avail              && mySettings.useWiFi && mySettings.useHTTP)       { updateHTTP(); } }        // Update web server
+void taskHTTPUpdater() { if (wifi_avail              && mySettings.useWiFi && mySettings.useHTTPUpdater){ updateHTTPUpdater(); } } // Update firmware web server
+void taskMDNS()        { if (wifi_avail && mdns_avail && mySettings.useWiFi && mySettings.usemDNS)      { updateMDNS(); } }        // Update mDNS
+void taskTelnet()      { if (wifi_avail              && mySettings.useWiFi && mySettings.useTelnet)     { updateTelnet(); } }      // Update Telnet
+void taskWeather()     { if (wifi_avail              && mySettings.useWiFi && mySettings.useWeather)    { updateWeather(); } }     // Update Weather
+
+/**************************************************************************************************************************************/
+// Update Sensor Readings
+/**************************************************************************************************************************************/
+// If a sensor fails and its driver can not recover, reboot is scheduled
+// After each update the task is woken when the next step of the state machine is due
+
+void taskSCD30() {
+  if (startI2CSensor(taskIDSCD30)) { return; } // plugged in while running
+  if (scd30_avail  && mySettings.useSCD30)  { D_printSerialTelnet(F("D:U:SCD30.."));  if (updateSCD30()  == false) {scheduleReboot = true;} wakeTask(taskIDSCD30, nextSCD30()); } // SCD30 Sensirion CO2 sensor
+}
+void taskSGP30() {
+  if (startI2CSensor(taskIDSGP30)) { return; } // plugged in while running
+  if (sgp30_avail  && mySettings.useSGP30)  { D_printSerialTelnet(F("D:U:SGP30.."));  if (updateSGP30()  == false) {scheduleReboot = true;} wakeTask(taskIDSGP30, nextSGP30()); } // SGP30 Sensirion eCO2 sensor
+}
+void taskCCS811() {
+  if (startI2CSensor(taskIDCCS811)) { return; } // plugged in while running
+  if (ccs811_avail && mySettings.useCCS811) { D_printSerialTelnet(F("D:U:CCS811..")); if (updateCCS811() == false) {scheduleReboot = true;} wakeTask(taskIDCCS811, nextCCS811()); } // CCS811 eCO2 sensor
+}
+void taskSPS30() {
+  if (startI2CSensor(taskIDSPS30)) { return; } // plugged in while running
+  if (sps30_avail  && mySettings.useSPS30)  { D_printSerialTelnet(F("D:U:SPS30.."));  if (updateSPS30()  == false) {scheduleReboot = true;} wakeTask(taskIDSPS30, nextSPS30()); } // SPS30 Sensirion Particle sensor
+}
+void taskBME280() {
+  if (startI2CSensor(taskIDBME280)) { return; } // plugged in while running
+  if (bme280_avail && mySettings.useBME280) { D_printSerialTelnet(F("D:U:BME280..")); if (updateBME280() == false) {scheduleReboot = true;} wakeTask(taskIDBME280, nextBME280()); } // BME280, Hum, Press, Temp
+}
+void taskBME68x() {
+  if (startI2CSensor(taskIDBME68x)) { return; } // plugged in while running
+  if (bme68x_avail && mySettings.useBME68x) { D_printSerialTelnet(F("D:U:BME68x..")); if (updateBME68x() == false) {scheduleReboot = true;} wakeTask(taskIDBME68x, nextBME68x()); } // BME68x, Hum, Press, Temp, Gasresistance
+}
+void taskMLX() {
+  if (startI2CSensor(taskIDMLX)) { return; } // plugged in while running
+  if (therm_avail  && mySettings.useMLX)    { D_printSerialTelnet(F("D:U:THERM.."));  if (updateMLX()    == false) {scheduleReboot = true;} wakeTask(taskIDMLX, nextMLX()); } // MLX Contactless Thermal Sensor
+}
+void taskMAX30() {
+  if (startI2CSensor(taskIDMAX30)) { return; } // plugged in while running
+  if (max30_avail  && mySettings.useMAX30)  { D_printSerialTelnet(F("D:U:MAX30.."));  } // MAX Pulse Ox Sensor goes here
+}
+
+/**************************************************************************************************************************************/
+// Broadcast MQTT and WebSocket Messages
+/**************************************************************************************************************************************/
+
+void taskMQTTMessage() {
+  if (mqtt_connected) { D_printSerialTelnet(F("D:U:MQTT.."));  drainQueue(); updateMQTTMessage(); } // MQTT send queued and current sensor data
+}
+void taskWebSocketMessage() {
+  if (ws_connected)   { D_printSerialTelnet(F("D:U:WS.."));    updateWebSocketMessage(); } // WebSocket send sensor data
+}
+
+/**************************************************************************************************************************************/
+// LCD: Display Sensor Data
+/**************************************************************************************************************************************/
+// LCD is updated on full multiples of intervalLCD seconds
+
+void taskLCD() {
+  if (lcd_avail && mySettings.useLCD) {
+    if ( ((localTime->tm_sec % (intervalLCD/1000)) == 0) && ((currentTime - lastLCD) >= intervalLCD) ) {
+      lastLCD = currentTime;
+      D_printSerialTelnet(F("D:U:LCD.."));
+      int timeMinutes = localTime->tm_hour*60+localTime->tm_min;
+      
+      // Update the LCD screen
+      // ---
+      if      ( mySettings.LCDdisplayType == 1 ) { updateLCD(); }                //<<<<<<------
+      else if ( mySettings.LCDdisplayType == 2 ) { updateTwoPageLCD(); }
+      else if ( mySettings.LCDdisplayType == 3 ) { updateSinglePageLCD(); }
+      else if ( mySettings.LCDdisplayType == 4 ) { updateSinglePageLCDwTime(); }
+      else { if (mySettings.debuglevel > 0) { R_printSerialTelnetLogln(F("LCD display type not supported")); } } 
+        
+      // Do we want to blink the LCD background ?
+      // ---
+      if ( mySettings.useBacklight && (allGood == false) ) {
+        // Sensors indicate blinking 
+        // Is our time synced?
+        if ((currentTime-ntp_lastSync) < 10*NTP_INTERVAL*1000) {
+          // We have network synced time.
+          // Do we want to blink at night or is it day time?
+          if ( (mySettings.useBlinkNight == true) ||
+             ( (mySettings.useBlinkNight == false) && ( (timeMinutes < mySettings.nightBegin) && (timeMinutes > mySettings.nightEnd) ) ) 
+             ) { blinkLCD = true; }
+          else { blinkLCD = false;} 
+        } else { blinkLCD = true; } // no network time
+      } else { blinkLCD = false; } // sensors in accetable range
+
+      // Update LCD background 
+      // --=-
+      // If we want to blink, dont adjust the background
+      //   If background is on:
+      //     If we dont want background light turn it off
+      //     If background is on and we want it off during the night turn it off
+      //   If background is off:
+      //     If we want background
+      //       If we dont care about night, turn on
+      //       If we care about night, turn on if its day time
+
+      if (blinkLCD == false) {
+        if (lastLCDInten) {
+          // LCD background is ON
+          // ---
+          // dont want backlight at all or dont want backlight at night
+          if ( (mySettings.useBacklight == false) ||       
+               ( (mySettings.useBacklightNight == false) && 
+                 ( (timeMinutes >= mySettings.nightBegin) || 
+                   (timeMinutes <= mySettings.nightEnd) 
+                 )
+               )  
+          ) { 
+            // Turn LCD light off
+            switchI2C(lcd_port, lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit);
+            #if defined(ADALCD)
+            lcd.setBacklight(LOW);
+            #else
+            lcd.setBacklight(0);
+            #endif
+            lastLCDInten = false;
           }
-          yieldTime += yieldOS(); 
+        } else {
+          // LCD background is OFF
+          // ---
+          // want backlight on night and day or want backlight on during day
+          if ( ( (mySettings.useBacklight == true) && (mySettings.useBacklightNight == true) ) ||  
+                 ( (timeMinutes < mySettings.nightBegin) && 
+                   (timeMinutes > mySettings.nightEnd) 
+                 )
+          ) { 
+            // Turn LCD light on
+            switchI2C(lcd_port, lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit);
+            #if defined(ADALCD)
+             lcd.setBacklight(HIGH);
+            #else
+             lcd.setBacklight(255);
+            #endif
+            lastLCDInten = true;
+          }           
         }
+        yieldTime += yieldOS(); 
+      }
+
+      if ( (mySettings.debuglevel > 1) && mySettings.useSerial ) { R_printSerialTelnetLogln(F("LCD updated")); }
+    } // end interval LCD
+  } // end LCD avail
+}
+
+/**************************************************************************************************************************************/
+// Terminal Status Display
+/**************************************************************************************************************************************/
+
+void taskSYS() {
+  lastSYS = currentTime;
+  systemNewData = true;                                    // system status on MQTT
+  systemNewDataWS = true;                                  // system status on websocket
   
-        if ( (mySettings.debuglevel > 1) && mySettings.useSerial ) { R_printSerialTelnetLogln(F("LCD updated")); }
-        deltaUpdate = millis() - startUpdate;
-        if (maxUpdateLCD    < deltaUpdate) { maxUpdateLCD = deltaUpdate; }
-        if (AllmaxUpdateLCD < deltaUpdate) { AllmaxUpdateLCD = deltaUpdate; }
-      } // end interval LCD
-    } // end LCD avail
+  if (mySettings.debuglevel == 99) {   // update continously
+    D_printSerialTelnet(F("D:U:SYS.."));
+    printProfile();
+    printState();        
+    printSensors();
+  } // dbg level 99
   
-    /**********************************************************************************************************************************/
-    // Terminal Status Display
-    /**********************************************************************************************************************************/
-    
-    if ((currentTime - lastSYS) >= intervalSYS) {
-      lastSYS = currentTime;
-      
-      if (mySettings.debuglevel == 99) {   // update continously
-        D_printSerialTelnet(F("D:U:SYS.."));
-        startUpdate = millis();
-        printProfile();
-        printState();        
-        printSensors();
-        deltaUpdate = millis() - startUpdate;
-        if (maxUpdateSYS < deltaUpdate) { maxUpdateSYS = deltaUpdate; }
-      } // dbg level 99
-      
-      // reset max values and measure them again until next display
-      // AllmaxUpdate... are the runtime maxima that are not reset between each display update
-      yieldTimeMin = yieldTimeMax = 0;
-      myDelayMin = intervalSYS; myLoopMin = intervalSYS; myLoopMax = 0;      
-      maxUpdateTime  = maxUpdateWifi = maxUpdateOTA =  maxUpdateNTP = maxUpdateMQTT = maxUpdateHTTP
-                     = maxUpdateHTTPUPDATER = maxUpdatemDNS = 0;
-      maxUpdateSCD30 = maxUpdateSGP30 =  maxUpdateCCS811 = maxUpdateSPS30 = maxUpdateBME280 = maxUpdateBME68x 
-                     = maxUpdateMLX = maxUpdateMAX = 0;
-      maxUpdateMQTTMESSAGE = maxUpdateWSMESSAGE = maxUpdateLCD = maxUpdateINPUT = maxUpdateRT = maxUpdateEEPROM 
-                     = maxUpdateBASE = maxUpdateBLINK = maxUpdateREBOOT = maxUpdateALLGOOD = 0;
-    }
-  
-    /**********************************************************************************************************************************/
-    // Serial or Telnet User Input
-    /**********************************************************************************************************************************/
-    
-    D_printSerialTelnet(F("D:U:SER.."));
-    startUpdate = millis();
-
-    // Serial input capture
-    // Telnet input is captured by telnet server (no coded here )
-    if (Serial.available()) {
-      int bytesread = Serial.readBytesUntil('\n', serialInputBuff, sizeof(serialInputBuff)-1);  // Read from serial until newline is read or timeout exceeded
-      // while (Serial.available() > 0) { Serial.read(); } // Clear remaining data in input buffer
-      serialInputBuff[bytesread] = '\0';
-      serialReceived = true;
-      yieldTime += yieldOS(); 
-    } else {
-      serialReceived = false;
-    }
-    
-    inputHandle(); // User input handling
+  // reset loop extremes and measure them again until next display
+  // the subsystem profiles are not reset, their maximum belongs to the same executions as their histogram
+  yieldTimeMin = yieldTimeMax = 0;
+  myDelayMin = intervalSYS; myLoopMin = intervalSYS; myLoopMax = 0;      
+}
 
-    deltaUpdate = millis() - startUpdate;
-    if (maxUpdateINPUT < deltaUpdate) { maxUpdateINPUT = deltaUpdate; }
-    if (AllmaxUpdateINPUT < deltaUpdate) { AllmaxUpdateINPUT = deltaUpdate; }
+/**************************************************************************************************************************************/
+// Serial or Telnet User Input
+/**************************************************************************************************************************************/
 
-    /**********************************************************************************************************************************/
-    // Other Time Managed Events such as runtime, saving baseline, rebooting, blinking LCD for warning
-    /**********************************************************************************************************************************/
+void taskInput() {
+  D_printSerialTelnet(F("D:U:SER.."));
+
+  // Serial input capture
+  // Telnet input is captured by telnet server (no coded here )
+  if (Serial.available()) {
+    int bytesread = Serial.readBytesUntil('\n', serialInputBuff, sizeof(serialInputBuff)-1);  // Read from serial until newline is read or timeout exceeded
+    // while (Serial.available() > 0) { Serial.read(); } // Clear remaining data in input buffer
+    serialInputBuff[bytesread] = '\0';
+    serialReceived = true;
+    yieldTime += yieldOS(); 
+  } else {
+    serialReceived = false;
+  }
   
-    // Update runtime every minute -------------------------------------
-    if ((currentTime - lastTime) >= intervalRuntime) {
-      D_printSerialTelnet(F("D:U:RUNTIME.."));
-      startUpdate = millis();
-      mySettings.runTime = mySettings.runTime + ((currentTime - lastTime) / 1000);
-      lastTime = currentTime;
-      if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("Runtime updated")); }
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateRT    < deltaUpdate) { maxUpdateRT = deltaUpdate; }
-      if (AllmaxUpdateRT < deltaUpdate) { AllmaxUpdateRT = deltaUpdate; }
-    }
+  inputHandle(); // User input handling
+}
 
-    // Save Configuration infrequently ---------------------------------------
-    if ((currentTime - lastSaveSettings) >= intervalSettings) {
-      lastSaveSettings = currentTime;
-      D_printSerialTelnet(F("D:U:EEPROM.."));
-      startUpdate = millis();
-      EEPROM.put(eepromAddress, mySettings);
-      if (EEPROM.commit()) {
-        lastSaveSettings = currentTime;
-        if (mySettings.debuglevel > 1) { R_printSerialTelnetLog(F("EEPROM updated")); }
-      }
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateEEPROM    < deltaUpdate) { maxUpdateEEPROM = deltaUpdate; }
-      if (AllmaxUpdateEEPROM < deltaUpdate) { AllmaxUpdateEEPROM = deltaUpdate; }
-      yieldTime += yieldOS(); 
-    }
-    
-    /** JSON savinge to LittelFS takes resources
-    if ((currentTime - lastSaveSettingsJSON) >= intervalSettingsJSON) {
-      D_printSerialTelnet(F("D:U:JSON.."));
-      startUpdate = millis();
-      saveConfiguration(mySettings);
-      lastSaveSettingsJSON = currentTime;
-      if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("Sensi.json updated")); }
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateJS    < deltaUpdate) { maxUpdateJS = deltaUpdate; }
-      if (AllmaxUpdateJS < deltaUpdate) { AllmaxUpdateJS = deltaUpdate; }
-      yieldTime += yieldOS(); 
+/**************************************************************************************************************************************/
+// Other Time Managed Events such as runtime, saving baseline, rebooting, blinking LCD for warning
+/**************************************************************************************************************************************/
+
+// Update runtime every minute -------------------------------------
+void taskRuntime() {
+  D_printSerialTelnet(F("D:U:RUNTIME.."));
+  mySettings.runTime = mySettings.runTime + ((currentTime - lastTime) / 1000);
+  lastTime = currentTime;
+  if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("Runtime updated")); }
+}
+
+// Save changed settings to journal --------------------------------------
+void taskEEPROM() {
+  D_printSerialTelnet(F("D:U:EEPROM.."));
+  if (saveSettings(mySettings)) {
+    lastSaveSettings = currentTime;
+  }
+}
+
+// Read responses of split phase i2c transactions ------------------------
+void taskI2CQueue() { runI2C(); }
+
+// Probe for sensors plugged in during operation ------------------------
+void taskI2C() {
+  D_printSerialTelnet(F("D:U:I2C.."));
+  if (probeI2C()) { saveI2CTopology(); }                      // its task initializes the new sensor
+}
+
+// Sample sensor readings into history ---------------------------------
+void taskHistory() {
+  D_printSerialTelnet(F("D:U:HISTORY.."));
+  if (updateHistory()) {                                  // minute means go to LittleFS
+    updateArchive();
+    if (mySettings.useWiFi && mySettings.useMQTT && !mqtt_connected) { updateQueue(); } // and are kept until the broker is back
+  }
+}
+
+/** JSON savinge to LittelFS takes resources
+void taskJSON() {
+  D_printSerialTelnet(F("D:U:JSON.."));
+  saveConfiguration(mySettings);
+  lastSaveSettingsJSON = currentTime;
+  if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("Sensi.json updated")); }
+}
+**/
+
+// regularly write buffered log entries
+// if logfile is larger than threshold, create a back up and start new one
+void taskLogFile() {
+  lastLogFile = currentTime;
+  D_printSerialTelnet(F("D:U:Log.."));
+  flushLog();
+}
+
+// Obtain baseline from sensors to create internal baseline -------------------
+void taskBaseline() {
+  D_printSerialTelnet(F("D:U:BASE.."));
+  lastBaseline = currentTime;
+  // Copy CCS811 basline to settings when warmup is finished
+  if (ccs811_avail && mySettings.useCCS811) {
+    if (currentTime >= warmupCCS811) {
+      switchI2C(ccs811_port, ccs811_i2c[0], ccs811_i2c[1], ccs811_i2cspeed, ccs811_i2cClockStretchLimit);
+      mySettings.baselineCCS811 = ccs811.getBaseline();
+      mySettings.baselineCCS811_valid = 0xF0;
+      if (mySettings.debuglevel > 1) { R_printSerialTelnetLog(F("CCS811 baseline placed into settings")); }
+      // warmupCCS811 = warmupCCS811 + stablebaseCCS811;          
     }
-    **/
-
-    // regularly check logfile
-    // if it is open, close it, we dont close the logfile after each write
-    // if its size is larger than threshold, create a back up and start new one
-    if ((currentTime - lastLogFile) >= INTERVALLOGFILE) {
-      lastLogFile = currentTime;
-      D_printSerialTelnet(F("D:U:Log.."));
-      // Check if logfile needs to be trimmed ----------------------------------
-      if (logFile) {
-        if (logFile.size() > LOGFILESIZE) {
-          logFile.close();
-          LittleFS.remove("/Sensi.bak");
-          LittleFS.rename("/Sensi.log", "/Sensi.bak");
-        } else {
-          logFile.close(); // just close logfile
-        }
-        yieldTime += yieldOS();       
-      }
+  }      
+  // Copy SGP30 basline to settings when warmup is finished
+  if (sgp30_avail && mySettings.useSGP30) {
+    if (currentTime >=  warmupSGP30) {
+      mySettings.baselinetVOC_SGP30 = sgp30.baselineTVOC; // internal variable
+      mySettings.baselineeCO2_SGP30 = sgp30.baselineCO2;  // internal varianle
+      mySettings.baselineSGP30_valid = 0xF0;
+      if (mySettings.debuglevel > 1) { R_printSerialTelnetLog(F("SGP30 baseline placed into settings")); }
+      // warmupSGP30 = warmupSGP30 + intervalSGP30Baseline;
     }
+  }
+}
 
-    // Obtain baseline from sensors to create internal baseline -------------------
-    if ((currentTime - lastBaseline) >= intervalBaseline) {
-      D_printSerialTelnet(F("D:U:BASE.."));
-      startUpdate = millis();
-      lastBaseline = currentTime;
-      // Copy CCS811 basline to settings when warmup is finished
-      if (ccs811_avail && mySettings.useCCS811) {
-        if (currentTime >= warmupCCS811) {
-          switchI2C(ccs811_port, ccs811_i2c[0], ccs811_i2c[1], ccs811_i2cspeed, ccs811_i2cClockStretchLimit);
-          mySettings.baselineCCS811 = ccs811.getBaseline();
-          mySettings.baselineCCS811_valid = 0xF0;
-          if (mySettings.debuglevel > 1) { R_printSerialTelnetLog(F("CCS811 baseline placed into settings")); }
-          // warmupCCS811 = warmupCCS811 + stablebaseCCS811;          
-        }
-      }      
-      // Copy SGP30 basline to settings when warmup is finished
-      if (sgp30_avail && mySettings.useSGP30) {
-        if (currentTime >=  warmupSGP30) {
-          mySettings.baselinetVOC_SGP30 = sgp30.baselineTVOC; // internal variable
-          mySettings.baselineeCO2_SGP30 = sgp30.baselineCO2;  // internal varianle
-          mySettings.baselineSGP30_valid = 0xF0;
-          if (mySettings.debuglevel > 1) { R_printSerialTelnetLog(F("SGP30 baseline placed into settings")); }
-          // warmupSGP30 = warmupSGP30 + intervalSGP30Baseline;
-        }
-      }
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateBASE    < deltaUpdate) { maxUpdateBASE = deltaUpdate; }
-      if (AllmaxUpdateBASE < deltaUpdate) { AllmaxUpdateBASE = deltaUpdate; }
-      yieldTime += yieldOS();
-    }
+// Update AirQuality Warning -------------------------------------------------
+void taskWarning() {
+  D_printSerialTelnet(F("D:U:AQ?.."));
+  lastWarning = currentTime;
+  allGood = sensorsWarning(); // <<<<<<<<<<<<<<<<<<
+  if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("AQ Warnings updated")); }
+}
 
-    // Update AirQuality Warning -------------------------------------------------
-    if ((currentTime - lastWarning) > intervalWarning) {                         // warning interval
-      D_printSerialTelnet(F("D:U:AQ?.."));
-      startUpdate = millis();
-      lastWarning = currentTime;
-      allGood = sensorsWarning(); // <<<<<<<<<<<<<<<<<<
-      deltaUpdate = millis() - startUpdate;
-      if (mySettings.debuglevel > 1) { R_printSerialTelnetLogln(F("AQ Warnings updated")); }
-      if (maxUpdateALLGOOD    < deltaUpdate) { maxUpdateALLGOOD = deltaUpdate; }
-      if (AllmaxUpdateALLGOOD < deltaUpdate) { AllmaxUpdateALLGOOD = deltaUpdate; }
-      yieldTime += yieldOS();
+// Do we want to blink LCD?  -------------------------------------------------   
+//  blinkLCD will only be ture if night and blink requirements are met
+//  on and off times differ, the task interval is adjusted after each toggle
+void taskBlink() {
+  D_printSerialTelnet(F("D:U:BLNK.."));
+
+  // blink LCD background ----------------------------------------------------
+  if (blinkLCD) {
+    // if (mySettings.debuglevel > 1) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Sensors out of normal range!")); }
+    switchI2C(lcd_port, lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit);
+    lastBlink = currentTime;
+    lastLCDInten = !lastLCDInten;
+    #if defined(ADALCD)
+    if (lastLCDInten) {
+      lcd.setBacklight(HIGH);
+      intervalBlink = intervalBlinkOn; 
+    } else {
+      lcd.setBacklight(LOW);
+      intervalBlink = intervalBlinkOff;
     }
-    
-    // Do we want to blink LCD?  -------------------------------------------------   
-    //  blinkLCD will only be ture if night and blink requirements are met
-    if ((currentTime - lastBlink) > intervalBlink) {                             // blink interval
-      D_printSerialTelnet(F("D:U:BLNK.."));
-      startUpdate = millis();
-
-      // blink LCD background ----------------------------------------------------
-      if (blinkLCD) {
-        // if (mySettings.debuglevel > 1) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Sensors out of normal range!")); }
-        switchI2C(lcd_port, lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit);
-        lastBlink = currentTime;
-        lastLCDInten = !lastLCDInten;
-        #if defined(ADALCD)
-        if (lastLCDInten) {
-          lcd.setBacklight(HIGH);
-          intervalBlink = intervalBlinkOn; 
-        } else {
-          lcd.setBacklight(LOW);
-          intervalBlink = intervalBlinkOff;
-        }
-        #else
-        if (lastLCDInten) {
-          lcd.setBacklight(255);
-          intervalBlink = intervalBlinkOn;
-        } else {
-          lcd.setBacklight(0);
-          intervalBlink = intervalBlinkOff;
-        }
-        #endif
-      } // end toggle the LCD background
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateBLINK    < deltaUpdate) { maxUpdateBLINK = deltaUpdate; }       
-      if (AllmaxUpdateBLINK < deltaUpdate) { AllmaxUpdateBLINK = deltaUpdate; }             
-      yieldTime += yieldOS(); 
-    } // end blinking interval
-
-    // Deal with request to reboot --------------------------------------
-    // This occurs if sensors reading results in error and driver fails to recover
-    // Reboot at preset time
-    if (scheduleReboot == true) {
-      D_printSerialTelnet(F("D:U:RBT.."));
-      startUpdate = millis();
-      if ( (mySettings.rebootMinute>=0) && (mySettings.rebootMinute<=1440) ) { // do not reboot if rebootMinute is -1 or bigger than 24hrs
-        if (timeSynced) {
-          if (localTime->tm_hour*60+localTime->tm_min == mySettings.rebootMinute) {
-            if (mySettings.debuglevel > 0) { R_printSerialTelnetLog(F("Rebooting...")); }
-            rebootNow = true;
-          }  
-        } else {
-          // we might not want to reboot whenever a sensor fails
-          if (mySettings.debuglevel > 1) {  R_printSerialTelnetLog(F("Rebooting when time is synced...")); }
-        }
-      }
-      deltaUpdate = millis() - startUpdate;
-      if (maxUpdateREBOOT    < deltaUpdate) { maxUpdateREBOOT = deltaUpdate; }
-      if (AllmaxUpdateREBOOT < deltaUpdate) { AllmaxUpdateREBOOT = deltaUpdate; }
+    #else
+    if (lastLCDInten) {
+      lcd.setBacklight(255);
+      intervalBlink = intervalBlinkOn;
+    } else {
+      lcd.setBacklight(0);
+      intervalBlink = intervalBlinkOff;
     }
+    #endif
+    setTaskInterval(taskIDBlink, intervalBlink);
+  } // end toggle the LCD background
+}
 
-    // Reboot has been requested by device ERROR or by user input
-    // Check if devices are in appropriate state, otherwise try again later
-    if (rebootNow) {
-      bool rebootok = true;
-      if (bme280_avail   && mySettings.useBME280){ if  ( (stateBME280 == DATA_AVAILABLE) || (stateBME280 == IS_BUSY)        ) {rebootok = false;} }
-      if (bme68x_avail   && mySettings.useBME68x){ if  ( (stateBME68x == DATA_AVAILABLE) || (stateBME68x == IS_BUSY)        ) {rebootok = false;} }
-      if (ccs811_avail   && mySettings.useCCS811){ if  ( (stateCCS811 == IS_WAKINGUP)    || (stateCCS811 == DATA_AVAILABLE) ) {rebootok = false;} }
-      // if (therm_avail && mySettings.useMLX)   { }
-      if (scd30_avail    && mySettings.useSCD30) { if  ( (stateSCD30  == DATA_AVAILABLE) || (stateSCD30  == IS_BUSY)        ) {rebootok = false;} }
-      // if (sgp30_avail && mySettings.useSGP30) { }
-      if (sps30_avail    && mySettings.useSPS30) { if  ( (stateSPS30  == IS_WAKINGUP)    || (stateSPS30  == IS_BUSY)        ) {rebootok = false;} }
-      if (max30_avail    && mySettings.useMAX30) { }
-      if (rebootok) {
-        R_printSerialTelnetLog(F("Bye ..."));
-        Serial.flush();
-        logFile.close();
-        ESP.reset();
-      }
-    }
-    
-    /**********************************************************************************************************************************/
-    // Keep track of free processor time 
-    /**********************************************************************************************************************************/
-    
-    myLoop  = millis() - currentTime;
-    myLoopAvg = 0.9 * myLoopAvg + 0.1 * float(myLoop);
-    if ( myLoop > 0 ) { 
-      if ( myLoop < myLoopMin ) { myLoopMin = myLoop; }
-      if ( myLoop > myLoopMax ) { 
-        myLoopMax = myLoop; 
-        if ( myLoop > myLoopMaxAllTime)  { myLoopMaxAllTime = myLoop; }
+// Deal with request to reboot --------------------------------------
+// This occurs if sensors reading results in error and driver fails to recover
+// Reboot at preset time
+void taskReboot() {
+  if (scheduleReboot == true) {
+    D_printSerialTelnet(F("D:U:RBT.."));
+    if ( (mySettings.rebootMinute>=0) && (mySettings.rebootMinute<=1440) ) { // do not reboot if rebootMinute is -1 or bigger than 24hrs
+      if (timeSynced) {
+        if (localTime->tm_hour*60+localTime->tm_min == mySettings.rebootMinute) {
+          if (mySettings.debuglevel > 0) { R_printSerialTelnetLog(F("Rebooting...")); }
+          rebootNow = true;
+        }  
+      } else {
+        // we might not want to reboot whenever a sensor fails
+        if (mySettings.debuglevel > 1) {  R_printSerialTelnetLog(F("Rebooting when time is synced...")); }
       }
     }
-    if (myLoopMax > 20) {
-      myLoopMaxAvg = 0.9 * myLoopMaxAvg + 0.1 * float(myLoopMax);
-    }  
-    if ( yieldTime > 0 ) { 
-      if ( yieldTime < yieldTimeMin ) { yieldTimeMin = yieldTime; }
-      if ( yieldTime > yieldTimeMax ) {
-        yieldTimeMax = yieldTime; 
-        if ( yieldTime > yieldTimeMaxAllTime)  { yieldTimeMaxAllTime = yieldTime; }
-      }
-      yieldTime = 0;
+  }
+
+  // Reboot has been requested by device ERROR or by user input
+  // Check if devices are in appropriate state, otherwise try again later
+  if (rebootNow) {
+    bool rebootok = true;
+    if (bme280_avail   && mySettings.useBME280){ if  ( (stateBME280 == DATA_AVAILABLE) || (stateBME280 == IS_BUSY)        ) {rebootok = false;} }
+    if (bme68x_avail   && mySettings.useBME68x){ if  ( (stateBME68x == DATA_AVAILABLE) || (stateBME68x == IS_BUSY)        ) {rebootok = false;} }
+    if (ccs811_avail   && mySettings.useCCS811){ if  ( (stateCCS811 == IS_WAKINGUP)    || (stateCCS811 == DATA_AVAILABLE) ) {rebootok = false;} }
+    // if (therm_avail && mySettings.useMLX)   { }
+    if (scd30_avail    && mySettings.useSCD30) { if  ( (stateSCD30  == DATA_AVAILABLE) || (stateSCD30  == IS_BUSY)        ) {rebootok = false;} }
+    // if (sgp30_avail && mySettings.useSGP30) { }
+    if (sps30_avail    && mySettings.useSPS30) { if  ( (stateSPS30  == IS_WAKINGUP)    || (stateSPS30  == IS_BUSY)        ) {rebootok = false;} }
+    if (max30_avail    && mySettings.useMAX30) { }
+    if (rebootok) {
+      R_printSerialTelnetLog(F("Bye ..."));
+      Serial.flush();
+      flushArchive();
+      flushQueue();
+      flushLog();
+      ESP.reset();
     }
-    
-  } // end OTA not in progress
-} // end loop
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Support functions
@@ -1611,20 +1450,40 @@ bool checkI2C(uint8_t address, TwoWire *myWire) {
 
 // Switches I2C port for ESP8266
 // # if defined(ESP8266)
+// Nothing is done if the port is already on these pins with this clock,
+// begin() is only called when the pins change as it also resets clock and stretch limit
 void switchI2C(TwoWire *myPort, int sdaPin, int sclPin, uint32_t i2cSpeed, uint32_t i2cStretch) {
-  myPort->begin(sdaPin, sclPin);
-  myPort->setClock(i2cSpeed);
-  myPort->setClockStretchLimit(i2cStretch);
+  bool pinsChanged = (myPort != i2cPort) || (sdaPin != i2cPortSDA) || (sclPin != i2cPortSCL);
+  if ( !pinsChanged && (i2cSpeed == i2cPortSpeed) && (i2cStretch == i2cPortStretch) ) {
+    i2cSwitchesSkipped++;
+    return;
+  }
+  if (pinsChanged) {
+    myPort->begin(sdaPin, sclPin);
+    i2cPort        = myPort;
+    i2cPortSDA     = sdaPin;
+    i2cPortSCL     = sclPin;
+    i2cPortSpeed   = 0;
+    i2cPortStretch = 0;
+    i2cSwitches++;
+  }
+  if (i2cSpeed   != i2cPortSpeed)   { myPort->setClock(i2cSpeed);               i2cPortSpeed   = i2cSpeed;   }
+  if (i2cStretch != i2cPortStretch) { myPort->setClockStretchLimit(i2cStretch); i2cPortStretch = i2cStretch; }
   yieldI2C(); // replaced with function defined at beginning of this document
 }
 
+// Forget the port configuration, next switchI2C reconfigures the port
+// Needed after a library called begin() on the port, e.g. when sensors are initialized
+void resetI2C() {
+  i2cPort = NULL;
+}
+
 // Boot helper
 // Prints message and waits until timeout or user send character on serial terminal
 void serialTrigger(const char* mess, int timeout) {
   unsigned long startTime = millis();
-  bool clearSerial = true;
   Serial.println(); Serial.println(mess);
-  while ( !Serial.available() && (millis() - startTime < timeout) ) {
+  while ( !Serial.available() && (millis() - startTime < (unsigned long)timeout) ) {
     delay(1000);
   }
   while (Serial.available()) { Serial.read(); }
@@ -1682,6 +1541,10 @@ void systemJSON(char *payLoad, size_t len){
   size_t l = strlen(str);
   strlcpy(payLoad, str, l+1);
   systemJSONMQTT(payLoad+l, len-l-1);
+  l = strlen(payLoad);
+  strlcpy(payLoad+l, ", \"queue\": ", len-l);
+  l = strlen(payLoad);
+  queueJSON(payLoad+l, len-l-1);
   strlcat(payLoad, "}", len);
 }
 
@@ -1794,10 +1657,26 @@ bool inputHandle() {
     }
 
     else if (command[0] == '.') {                                            // print a clear execution times of subroutines
-      tmpTime = millis();
+      ProfileTimer profileTimer(PROFILE_SYS);
       printProfile();
-      deltaUpdate = millis() - tmpTime;
-      if (maxUpdateSYS < deltaUpdate) { maxUpdateSYS = deltaUpdate; }
+    }
+
+    else if (command[0] == 'H') {                                            // recorded sensor history
+      printHistory();
+    }
+
+    else if (command[0] == 'A') {                                            // archive segments
+      printArchive();
+    }
+
+    else if (command[0] == 'I') {                                            // I2C devices
+      if (textlen > 0) {
+        if (text[0] == 's') {                                                // full scan
+          scanI2C(true);
+          saveI2CTopology();
+        }
+      }
+      printI2CTopology();
     }
 
     else if (command[0] =='?' || command[0] =='h') {                         // help requested
@@ -1923,6 +1802,12 @@ bool inputHandle() {
             R_printSerialTelnetLogln(tmpStr);
             yieldTime += yieldOS(); 
           }
+        } else if (text[0] == 'e') {                                      // websocket sensor message encoding
+          wsEncoding = (wsEncoding == TELEMETRY_JSON) ? TELEMETRY_MSGPACK : TELEMETRY_JSON;
+          mySettings.wsEncoding = wsEncoding;
+          snprintf_P(tmpStr, sizeof(tmpStr), PSTR("WebSocket sensor messages are: %s"), telemetryEncodingName(wsEncoding));
+          R_printSerialTelnetLogln(tmpStr);
+          yieldTime += yieldOS(); 
         } else { helpMenu(); }
       } else { printState(); }
     }
@@ -1969,6 +1854,78 @@ bool inputHandle() {
           mySettings.sendMQTTimmediate = !bool(mySettings.sendMQTTimmediate);
           snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT is sent immediatly: %s"), mySettings.sendMQTTimmediate?FPSTR(mOFF):FPSTR(mON)); 
 
+        } else if (text[0] == 'e') {                                      // mqtt sensor message encoding
+          mqttEncoding = (mqttEncoding == TELEMETRY_JSON) ? TELEMETRY_MSGPACK : TELEMETRY_JSON;
+          mySettings.mqttEncoding = mqttEncoding;
+          if ( (mqttEncoding == TELEMETRY_MSGPACK) && mqtt_connected ) { publishTelemetrySchema(); }
+          snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT sensor messages are: %s"), telemetryEncodingName(mqttEncoding));
+
+        } else if (text[0] == 'q') {                                      // mqtt queue metrics
+          queueJSON(tmpStr, sizeof(tmpStr));
+
+        } else if (text[0] == 'r') {                                      // mqtt queue drain rate
+          tmpuI = strtoul(value, NULL, 10);
+          if (tmpuI <= 100) {
+            queueMessageRate = tmpuI;
+            mySettings.queueMessageRate = queueMessageRate;
+            snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT queue drains %lu messages/s"), queueMessageRate);
+          } else { strcpy_P(tmpStr, PSTR("MQTT queue rate out of valid range")); }
+
+        } else if (text[0] == 'b') {                                      // mqtt queue drain byte rate
+          tmpuI = strtoul(value, NULL, 10);
+          if ((tmpuI >= 64) && (tmpuI <= 65536)) {
+            queueByteRate = tmpuI;
+            mySettings.queueByteRate = queueByteRate;
+            snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT queue drains %lu bytes/s"), queueByteRate);
+          } else { strcpy_P(tmpStr, PSTR("MQTT queue byte rate out of valid range")); }
+
+        } else if (text[0] == 'd') {                                      // deadband of a channel, absolute and relative [%]
+          char *sep = strchr(value, ',');
+          if (sep == NULL) {
+            printTelemetryPolicy();
+            strcpy_P(tmpStr, PSTR("Set with Mdscd30.CO2,10,0 and Mhscd30,0,600"));
+          } else {
+            char *end;
+            *sep = '\0';
+            float absolute = strtof(sep+1, &end);
+            float relative = (*end == ',') ? strtof(end+1, NULL) : 0.0;
+            if (setTelemetryBand(value, absolute, relative)) {
+              snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%s deadband is: %.2f or %.1f%%"), value, absolute, relative);
+            } else { strcpy_P(tmpStr, PSTR("Unknown channel or deadband out of valid range")); }
+          }
+
+        } else if (text[0] == 'h') {                                      // minimum interval and heartbeat of a sensor [s]
+          char *sep = strchr(value, ',');
+          if (sep != NULL) {
+            char *end;
+            *sep = '\0';
+            unsigned long minInterval = strtoul(sep+1, &end, 10);
+            unsigned long maxSilence  = (*end == ',') ? strtoul(end+1, NULL, 10) : TELEMETRY_HEARTBEAT;
+            if ( (minInterval <= 65535) && (maxSilence <= 65535) && setTelemetryTiming(value, minInterval, maxSilence) ) {
+              snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%s is sent at most every %lus and at least every %lus"), value, minInterval, maxSilence);
+            } else { strcpy_P(tmpStr, PSTR("Unknown sensor or interval out of valid range")); }
+          } else { strcpy_P(tmpStr, PSTR("No valid command provided")); }
+
+        } else if (text[0] == 't') {                                      // age at publish of immediate topics
+          if (value[0] == 'r') { resetTopicsMQTT(); }
+          printTopicsMQTT();
+          topicsJSONMQTT(tmpStr, sizeof(tmpStr));
+
+        } else if (text[0] == 'l') {                                      // limiter of immediate topics, rate, burst, byte rate
+          char *end;
+          unsigned long rate     = strtoul(value, &end, 10);
+          unsigned long burst    = (*end == ',') ? strtoul(end+1, &end, 10) : mqttBurst;
+          unsigned long byteRate = (*end == ',') ? strtoul(end+1, NULL, 10) : mqttByteRate;
+          if ( (rate >= 1) && (rate <= 100) && (burst >= 1) && (burst <= 100) && (byteRate >= 64) && (byteRate <= 65536) ) {
+            mqttMessageRate = rate;
+            mqttBurst       = burst;
+            mqttByteRate    = byteRate;
+            mySettings.mqttMessageRate = mqttMessageRate;
+            mySettings.mqttBurst       = mqttBurst;
+            mySettings.mqttByteRate    = mqttByteRate;
+            snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT sends %lu messages/s, burst %lu, %lu bytes/s"), mqttMessageRate, mqttBurst, mqttByteRate);
+          } else { strcpy_P(tmpStr, PSTR("MQTT limit out of valid range")); }
+
         } else { strcpy_P(tmpStr, PSTR("No valid command provided")); }
         R_printSerialTelnetLogln(tmpStr);
         yieldTime += yieldOS(); 
@@ -2004,7 +1961,7 @@ bool inputHandle() {
         } else if (text[0] == 'n') {                                      // night start
           if (strlen(value) > 0) { tmpuI = strtoul(value, NULL, 10); } 
           else { tmpuI = 22*60;  }
-          if ((tmpuI >= 0) && (tmpuI <= 1440) && (tmpuI >= mySettings.nightEnd)) {
+          if ((tmpuI <= 1440) && (tmpuI >= mySettings.nightEnd)) {
             mySettings.nightBegin = (uint16_t)tmpuI;
             snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Night begin set to: %u after midnight"), mySettings.nightBegin); 
           } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Night start out of valid range %u - 1440 minutes after midnight"), mySettings.nightEnd ); }
@@ -2012,7 +1969,7 @@ bool inputHandle() {
         } else if (text[0] == 'e') {                                      // night end
           if (strlen(value) > 0) { tmpuI = strtoul(value, NULL, 10); } 
           else { tmpuI = 6*60; }
-          if ((tmpuI >= 0) && (tmpuI <= 1440) && (tmpuI <= mySettings.nightBegin)) {
+          if ((tmpuI <= 1440) && (tmpuI <= mySettings.nightBegin)) {
             mySettings.nightEnd = (uint16_t)tmpuI;
             snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Night end set to: %u minutes after midnight"), mySettings.nightEnd); 
           } else { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Night end out of valid range 0 - %u minutes after midnight"), mySettings.nightBegin); }
@@ -2091,7 +2048,7 @@ bool inputHandle() {
         if        (text[0] == 'c') {                                      // force CO2
           if (strlen(value) > 0) {
             tmpuI = strtoul(value, NULL, 10);
-            if ((tmpuI >= 0) && (tmpuI <= 65535)) {
+            if ((tmpuI <= 65535)) {
               if (sgp30_avail && mySettings.useSGP30) {
                 switchI2C(sgp30_port, sgp30_i2c[0], sgp30_i2c[1], sgp30_i2cspeed, sgp30_i2cClockStretchLimit);
                 sgp30.getBaseline();                                                         // read both eCO2 and tVOC baselines
@@ -2107,7 +2064,7 @@ bool inputHandle() {
         } else if (text[0] == 'v') {                                      // force tVOC
           if (strlen(value) > 0) {
             tmpuI = strtoul(value, NULL, 10);
-            if ((tmpuI >= 0) && (tmpuI <= 65535)) {
+            if ((tmpuI <= 65535)) {
               if (sgp30_avail && mySettings.useSGP30) {
                 switchI2C(sgp30_port, sgp30_i2c[0], sgp30_i2c[1], sgp30_i2cspeed, sgp30_i2cClockStretchLimit);
                 sgp30.getBaseline();                                                         // read both eCO2 and tVOC baselines
@@ -2219,7 +2176,7 @@ bool inputHandle() {
         if      (text[0] == 'c') {                                    // force baseline
           if (strlen(value) > 0) {
             tmpuI = strtoul(value, NULL, 10);
-            if ((tmpuI >= 0) && (tmpuI <= 65535)) {
+            if ((tmpuI <= 65535)) {
               if (ccs811_avail && mySettings.useCCS811) {
                 switchI2C(ccs811_port, ccs811_i2c[0], ccs811_i2c[1], ccs811_i2cspeed, ccs811_i2cClockStretchLimit);
                 ccs811.setBaseline((uint16_t)tmpuI);
@@ -2430,7 +2387,7 @@ bool inputHandle() {
     else if (command[0] == 'l') {                                            // set debug level
       if (textlen > 0) {
         tmpuI = strtoul(text, NULL, 10);
-        if ((tmpuI >= 0) && (tmpuI <= 99)) {
+        if ((tmpuI <= 99)) {
           mySettings.debuglevel = (unsigned int)tmpuI;
           snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Debug level set to: %u"), mySettings.debuglevel);  
         } else { strcpy_P(tmpStr, PSTR("Debug level out of valid Range")); }
@@ -2463,11 +2420,10 @@ bool inputHandle() {
 
         if (text[0] == 's') {                                                // save
           tmpTime = millis();
-          if        (text[1] == 'E') {                                       // save EEPROM
+          if        (text[1] == 'E') {                                       // save journal
             D_printSerialTelnet(F("D:S:EPRM.."));
-            EEPROM.put(0, mySettings);
-            if (EEPROM.commit()) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings saved to EEPROM in: %dms"), millis() - tmpTime); } // takes 400ms
-            else {snprintf_P(tmpStr, sizeof(tmpStr), PSTR("EEPROM failed to commit"));} 
+            if (saveSettings(mySettings)) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings saved to journal in: %dms"), millis() - tmpTime); }
+            else {snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings journal could not be written"));} 
           } else if (text[1] == 'J') {                                       // save JSON
             D_printSerialTelnet(F("D:S:JSON.."));
             saveConfiguration(mySettings);
@@ -2478,11 +2434,10 @@ bool inputHandle() {
 
         } else if (text[0] == 'r') {                                         // read
           tmpTime = millis();
-          if        (text[1] == 'E') {                                       // read EEPROM
+          if        (text[1] == 'E') {                                       // read journal
             D_printSerialTelnet(F("D:R:EPRM.."));
-            EEPROM.begin(EEPROM_SIZE);
-            EEPROM.get(eepromAddress, mySettings);
-            snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings read from eeprom in: %dms"), millis() - tmpTime); 
+            if (loadSettings(mySettings)) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings read from journal in: %dms"), millis() - tmpTime); }
+            else {snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Settings journal not valid"));} 
           } else if (text[1] == 'J') {                                       // read JSON
             D_printSerialTelnet(F("D:R:JSON.."));
             tmpTime = millis();
@@ -2496,6 +2451,7 @@ bool inputHandle() {
         } else if (text[0] == 'f') {                                         // format file system
           if (text[1] == 'f') {
             if ( LittleFS.format() ) { R_printSerialTelnetLogln(F("LittleFS formated")); }
+            indexFiles();                                                    // no web assets left
           } else { R_printSerialTelnetLogln(F("LittleFS not formated, need to provide ff")); }
 
         } else if (text[0] == 'p') {                                         // print file
@@ -2525,6 +2481,7 @@ bool inputHandle() {
             if (fsOK) {
               if (LittleFS.exists(value)) {
                 LittleFS.remove(value);
+                indexFile(value);                                            // served from the other version or not at all
                 printSerialTelnetLog(value); 
                 printSerialTelnetLogln(F(" deleted")); 
               } else { 
@@ -2550,6 +2507,7 @@ bool inputHandle() {
                     file.write(c);
                   }
                   file.close();
+                  indexFile(value);
                   printSerialTelnetLogln(F("Finished writting"));
                 } else { printSerialTelnetLog(F("Failed to open file: ")); printSerialTelnetLogln(value); }
                 file.close();
@@ -2615,19 +2573,26 @@ void helpMenu() {
     printSerialTelnetLogln(FPSTR(singleSeparator));                                                                 yieldTime += yieldOS(); 
     //                       "================================================================================"
     printSerialTelnetLogln(F("| ?: help screen                        | n: set this device name, nSensi      |"));  yieldTime += yieldOS(); 
-    printSerialTelnetLogln(F("| z: print sensor data                  |                                      |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| z: print sensor data                  | H: recorded sensor history           |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| j: print sensor data in JSON          | .: execution times                   |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| I: I2C devices                        | Is: scan all I2C pins                |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| A: archive segments on LittleFS       |                                      |"));  yieldTime += yieldOS(); 
 
     printSerialTelnetLogln(F("==WiFi==================================|======================================="));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| W: WiFi states                        |                                      |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| Ws1: set SSID 1 Ws1UAWiFi             | Wp1: set password                    |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| Ws2: set SSID 2                       | Wp2: set password                    |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| Ws3: set SSID 3                       | Wp3: set password                    |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| We: WebSocket JSON/MessagePack        |                                      |"));  yieldTime += yieldOS(); 
 
     printSerialTelnetLogln(F("==MQTT==================================|======================================="));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| Mu: set username                      | Mi: set time interval Mi1.0 [s]      |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| Mp: set password                      | Ms: set server                       |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| Mm: individual/single msg             | Mf: set fallback server              |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| Mq: queue for broker outages          | Mr: set queue drain rate Mr2 [msg/s] |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| Me: MQTT JSON/MessagePack             | Mb: set queue drain Mb1024 [bytes/s] |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| Md: deadband Mdscd30.CO2,10,0 [%]     | Mh: intervals Mhscd30,0,600 [s]      |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| Mt: age at publish, Mtr resets        | Ml: limit Ml4,8,2048 [msg/s,n,B/s]   |"));  yieldTime += yieldOS(); 
 
     printSerialTelnetLogln(F("==NTP===================================|======================================="));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| Ns: set server                        | Nn: set night start min after midni  |"));  yieldTime += yieldOS(); 
@@ -2678,7 +2643,7 @@ void helpMenu() {
     printSerialTelnetLogln(F("| l: 99 continous                       |                                      |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("==Settigns==============================|==Filesystem==========================="));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| s:   print current settings           | Fff: format filesystem               |"));  yieldTime += yieldOS();
-    printSerialTelnetLogln(F("| FsE: save settings to EEPROM          | F:  list content of filesystem       |"));  yieldTime += yieldOS(); 
+    printSerialTelnetLogln(F("| FsE: save settings journal            | F:  list content of filesystem       |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| FsJ: save settings to Sensio.json     | Fp: print file Fp/Sensi.json         |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| FrE / FrS: read settings              | Fx: delete file Fx/Sensi.bak         |"));  yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("| dd: default settings                  | Fw: write into file Fw/index.html ^Z |"));  yieldTime += yieldOS(); 
@@ -2703,6 +2668,8 @@ void printSettings() {
   printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
   snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Log file:....... .............. %s"),  (mySettings.useLog) ? FPSTR(mON) : FPSTR(mOFF));  
   printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Log buffer: .................. %u bytes, %lu dropped"), (unsigned int)logBuffered(), logDropped);  
+  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
   printSerialTelnetLogln(FPSTR(doubleSeparator)); yieldTime += yieldOS();   
   printSerialTelnetLogln(F("-Network----------------------------")); yieldTime += yieldOS(); 
   snprintf_P(tmpStr, sizeof(tmpStr), PSTR("HTTP: ......................... %s"),  (mySettings.useHTTP) ? FPSTR(mON) : FPSTR(mOFF)); 
@@ -2758,6 +2725,10 @@ void printSettings() {
   printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
   snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT interval: . .............. %f"),   mySettings.intervalMQTT);  
   printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT queue: ................... %u records, drain %lu messages/s %lu bytes/s"), queueDepth(), queueMessageRate, queueByteRate);
+  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT limit: ................... %lu messages/s burst %lu %lu bytes/s"), mqttMessageRate, mqttBurst, mqttByteRate);
+  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
   printSerialTelnetLogln(FPSTR(doubleSeparator)); yieldTime += yieldOS(); 
   printSerialTelnetLogln(F("-Sensors----------------------------"));  yieldTime += yieldOS(); 
   snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30: ........................ %s"),  (mySettings.useSCD30)   ? FPSTR(mON) : FPSTR(mOFF)); 
@@ -2836,7 +2807,7 @@ void printSensors() {
   R_printSerialTelnetLogln(FPSTR(doubleSeparator)); yieldTime += yieldOS(); 
   
   if (lcd_avail && mySettings.useLCD) {
-    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("LCD interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalLCD, uint32_t(lcd_port), lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit); 
+    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("LCD interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalLCD, uint32_t(uintptr_t(lcd_port)), lcd_i2c[0], lcd_i2c[1], lcd_i2cspeed, lcd_i2cClockStretchLimit); 
     printSerialTelnetLogln(tmpStr);
   } else {
     printSerialTelnetLogln(F("LCD: not available"));
@@ -2852,7 +2823,7 @@ void printSensors() {
     checkCO2(float(scd30_ppm),qualityMessage,15);
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 CO2 is: %s"), qualityMessage); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();     
-    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalSCD30, uint32_t(scd30_port), scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed,scd30_i2cClockStretchLimit); 
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalSCD30, uint32_t(uintptr_t(scd30_port)), scd30_i2c[0], scd30_i2c[1], scd30_i2cspeed,scd30_i2cClockStretchLimit); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 last error: %dmin"), (currentTime - scd30_lastError)/60000); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
@@ -2877,7 +2848,7 @@ void printSensors() {
     checkGasResistance(bme68x.gas_resistance,qualityMessage,15);
     snprintf_P(tmpStr, sizeof(tmpStr),PSTR("Gas resistance is %s"),qualityMessage); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
-    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalBME68x, uint32_t(bme68x_port), bme68x_i2c[0], bme68x_i2c[1], bme68x_i2cspeed, bme68x_i2cClockStretchLimit); 
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalBME68x, uint32_t(uintptr_t(bme68x_port)), bme68x_i2c[0], bme68x_i2c[1], bme68x_i2cspeed, bme68x_i2cClockStretchLimit); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x last error: %dmin"), (currentTime - bme68x_lastError)/60000); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
@@ -2905,7 +2876,7 @@ void printSensors() {
       snprintf_P(tmpStr, sizeof(tmpStr),PSTR(" Humidity is %s"),qualityMessage); 
       printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     }
-    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME280 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalBME280, uint32_t(bme280_port), bme280_i2c[0], bme280_i2c[1], bme280_i2cspeed, bme280_i2cClockStretchLimit ); 
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME280 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalBME280, uint32_t(uintptr_t(bme280_port)), bme280_i2c[0], bme280_i2c[1], bme280_i2cspeed, bme280_i2cClockStretchLimit ); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME280 last error: %dmin"), (currentTime - bme280_lastError)/60000); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
@@ -2924,7 +2895,7 @@ void printSensors() {
     checkTVOC(sgp30.TVOC,qualityMessage,15);  
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("tVOC conentration is %s"),qualityMessage);  
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
-    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalSGP30, uint32_t(sgp30_port), sgp30_i2c[0], sgp30_i2c[1], sgp30_i2cspeed, sgp30_i2cClockStretchLimit);  
+    snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalSGP30, uint32_t(uintptr_t(sgp30_port)), sgp30_i2c[0], sgp30_i2c[1], sgp30_i2cspeed, sgp30_i2cClockStretchLimit);  
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 last error: %dmin"), (currentTime - sgp30_lastError)/60000); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
@@ -2947,7 +2918,7 @@ void printSensors() {
     checkTVOC(TVOCuI,qualityMessage,15);
     snprintf_P(tmpStr, sizeof(tmpStr),PSTR("tVOC concentration is %s"), qualityMessage); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();     
-    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("CCS811 mode: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), ccs811Mode, uint32_t(ccs811_port), ccs811_i2c[0], ccs811_i2c[1], ccs811_i2cspeed, ccs811_i2cClockStretchLimit); 
+    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("CCS811 mode: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), ccs811Mode, uint32_t(uintptr_t(ccs811_port)), ccs811_i2c[0], ccs811_i2c[1], ccs811_i2cspeed, ccs811_i2cClockStretchLimit); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     printSerialTelnetLogln(F("[4=0.25s, 3=60s, 2=10sec, 1=1sec]")); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811 last error: %dmin"), (currentTime - ccs811_lastError)/60000); 
@@ -2973,7 +2944,7 @@ void printSensors() {
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr),PSTR("Autoclean interval: %lu"),sps30AutoCleanInterval); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
-    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("SPS30 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalSPS30, uint32_t(sps30_port), sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit); 
+    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("SPS30 interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalSPS30, uint32_t(uintptr_t(sps30_port)), sps30_i2c[0], sps30_i2c[1], sps30_i2cspeed, sps30_i2cClockStretchLimit); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30 last error: %dmin"), (currentTime - sps30_lastError)/60000); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
@@ -2998,7 +2969,7 @@ void printSensors() {
     checkAmbientTemperature(tmpOF,qualityMessage,15);
     snprintf_P(tmpStr, sizeof(tmpStr),PSTR("Ambient temperature is %s"), qualityMessage); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
-    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("MLX interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalMLX, uint32_t(mlx_port), mlx_i2c[0], mlx_i2c[1], mlx_i2cspeed, mlx_i2cClockStretchLimit); 
+    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("MLX interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalMLX, uint32_t(uintptr_t(mlx_port)), mlx_i2c[0], mlx_i2c[1], mlx_i2cspeed, mlx_i2cClockStretchLimit); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
     snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MLX last error: %dmin"), (currentTime - mlx_lastError)/60000); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
@@ -3008,9 +2979,8 @@ void printSensors() {
   printSerialTelnetLogln(FPSTR(singleSeparator)); yieldTime += yieldOS(); 
 
   if (max30_avail && mySettings.useMAX30) {
-    char qualityMessage[16];
     //switchI2C(max30_port, max30_i2c[0], max30_i2c[1], I2C_FAST, I2C_LONGSTRETCH);
-    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("MAX interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalMAX, uint32_t(max30_port), max30_i2c[0], max30_i2c[1], max30_i2cspeed, max30_i2cClockStretchLimit); 
+    snprintf_P(tmpStr, sizeof(tmpStr),PSTR("MAX interval: %d Port: %d SDA %d SCL %d Speed %d CLKStretch %d"), intervalMAX, uint32_t(uintptr_t(max30_port)), max30_i2c[0], max30_i2c[1], max30_i2cspeed, max30_i2cClockStretchLimit); 
     printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
   } else {
     printSerialTelnetLogln(F("MAX: not available")); yieldTime += yieldOS(); 
@@ -3269,36 +3239,22 @@ void printProfile() {
   snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Free Heap Size: %d[B] Heap Fragmentation: %d%% Max Block Size: %d[B]"), ESP.getFreeHeap(), ESP.getHeapFragmentation(), ESP.getMaxFreeBlockSize()); printSerialTelnetLogln(tmpStr);
   printSerialTelnetLogln(FPSTR(doubleSeparator)); yieldTime += yieldOS(); 
 
-  // This displays the amount of time it took complete the update routines.
-  // The currentMax/alltimeMax is displayed. Alltime max is reset when network services are started up in their update routines.
-  printSerialTelnetLogln(F("All values in [ms]"));
-  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Time&Date:    %4u %4u mDNS:   %4u %4u HTTPupd: %4u %4u HTTP:    %4u %4u\r\nMQTT:         %4u %4u WS:     %4u %4u NTP:     %4u %4u OTA:     %4u %4u\r\nWifi:         %4u %4u Weather:%4u %4u"), 
-                    maxUpdateTime, AllmaxUpdateTime, maxUpdatemDNS, AllmaxUpdatemDNS, maxUpdateHTTPUPDATER, AllmaxUpdateHTTPUPDATER, maxUpdateHTTP, AllmaxUpdateHTTP, maxUpdateMQTT, AllmaxUpdateMQTT, 
-                    maxUpdateWS, AllmaxUpdateWS, maxUpdateNTP, AllmaxUpdateNTP, maxUpdateOTA, AllmaxUpdateOTA, maxUpdateWifi, AllmaxUpdateWifi,maxUpdateWeather, AllmaxUpdateWeather);         
-  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
+  // This displays the distribution of the time it took to complete the update routines.
+  // Maximum and histograms are reset together when network services are started up in their update routines.
+  printProfiles();
   snprintf_P(tmpStr, sizeof(tmpStr), PSTR("mDNS last error: %dmin"), (currentTime - mDNS_lastError)/60000); 
   printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
 
-  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30:        %4u %4u SGP30:  %4u %4u CCS811:  %4u %4u SPS30:   %4u %4u\r\nBME280:       %4u %4u BME68x: %4u %4u MLX:     %4u %4u MAX:     %4u %4u"), maxUpdateSCD30, AllmaxUpdateSCD30, 
-                    maxUpdateSGP30, AllmaxUpdateSGP30, maxUpdateCCS811, AllmaxUpdateCCS811, maxUpdateSPS30, AllmaxUpdateSPS30, maxUpdateBME280, AllmaxUpdateBME280, maxUpdateBME68x, AllmaxUpdateBME68x, maxUpdateMLX, AllmaxUpdateMLX, maxUpdateMAX, AllmaxUpdateMAX);
-  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
-
-  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTTmsg:      %4u %4u WSmsg:  %4u %4u LCD:     %4u %4u Input:   %4u %4u\r\nRunTime:      %4u %4u EEPROM: %4u %4u"), maxUpdateMQTTMESSAGE, AllmaxUpdateMQTTMESSAGE, maxUpdateWSMESSAGE, AllmaxUpdateWSMESSAGE, 
-                    maxUpdateLCD, AllmaxUpdateLCD, maxUpdateINPUT, AllmaxUpdateINPUT, maxUpdateRT, AllmaxUpdateRT, maxUpdateEEPROM, AllmaxUpdateEEPROM);
-                    //maxUpdateJS, AllmaxUpdateJS
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Yield Time:   %4u/%u/%u"), 
+                    yieldTimeMin, yieldTimeMax, yieldTimeMaxAllTime); 
   printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
 
-  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Baseline:     %4u %4u Blink:  %4u %4u Reboot:  %4u %4u AllGood: %4u %4u"), 
-                    maxUpdateBASE, AllmaxUpdateBASE, maxUpdateBLINK, AllmaxUpdateBLINK, maxUpdateREBOOT, AllmaxUpdateREBOOT, maxUpdateALLGOOD, AllmaxUpdateALLGOOD);
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Idle Time:    %4d/%d[ms] Avg: %d[us]"), 
+                    myDelayMin, MAXIDLE, int(myDelayAvg*1000)); 
   printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
-  
-  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("This display: %4u"), 
-                    maxUpdateSYS);
-  printSerialTelnetLogln(tmpStr);  yieldTime += yieldOS(); 
 
-  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Yield Time:   %4u/%u/%u"), 
-                    yieldTimeMin, yieldTimeMax, yieldTimeMaxAllTime); 
-  printSerialTelnetLogln(tmpStr); yieldTime += yieldOS(); 
+  printSerialTelnetLogln(FPSTR(singleSeparator)); yieldTime += yieldOS(); 
+  printTasks();
 
   printSerialTelnetLogln(FPSTR(doubleSeparator)); yieldTime += yieldOS(); 
 }
@@ -3367,4 +3323,16 @@ void defaultSettings() {
   mySettings.altitude                      = (float) 0.0;
   mySettings.emissivity                    = (float) 0.98;
   mySettings.LCDdisplayType                = 4;
+  mySettings.mqttEncoding                  = TELEMETRY_JSON;
+  mySettings.wsEncoding                    = TELEMETRY_JSON;
+  memcpy_P(mySettings.telemetryBands, telemetryDefaultBands, sizeof(mySettings.telemetryBands));
+  for (uint8_t i=0; i<TELEMETRY_SENSORS; i++) {
+    mySettings.telemetryTimings[i].minInterval = 0;
+    mySettings.telemetryTimings[i].maxSilence  = TELEMETRY_HEARTBEAT;
+  }
+  mySettings.mqttMessageRate               = MQTT_MESSAGERATE;
+  mySettings.mqttBurst                     = MQTT_BURST;
+  mySettings.mqttByteRate                  = MQTT_BYTERATE;
+  mySettings.queueMessageRate              = QUEUE_MESSAGERATE;
+  mySettings.queueByteRate                 = QUEUE_BYTERATE;
 }
@@ -0,0 +1,242 @@
+/******************************************************************************************************/
+// Binary Telemetry
+/******************************************************************************************************/
+#include "src/Telemetry.h"
+#include "src/History.h"
+#include "src/MQTT.h"
+#include "src/WebSocket.h"
+#include "src/Config.h"
+#include "src/Print.h"
+
+// External Variables
+extern Settings         mySettings;    // Config
+extern unsigned long    currentTime;   // Sensi
+extern unsigned long    yieldTime;
+extern char             tmpStr[256];
+extern PubSubClient     mqttClient;    // MQTT
+extern WebSocketsServer webSocket;     // WebSocket
+extern const char       historyNames[HISTORY_CHANNELS][HISTORY_NAMELENGTH] PROGMEM; // History
+extern HistorySource    historySources[HISTORY_CHANNELS];
+
+uint8_t mqttEncoding = TELEMETRY_JSON;                     // encoding of MQTT sensor messages
+uint8_t wsEncoding   = TELEMETRY_JSON;                     // encoding of websocket sensor messages
+
+const char telemetrySensorNames[TELEMETRY_SENSORS][TELEMETRY_SENSORNAMELENGTH] PROGMEM = {
+  "scd30", "sgp30", "ccs811", "sps30", "bme280", "bme68x", "mlx"};
+
+const uint32_t telemetryChannels[TELEMETRY_SENSORS] = {
+  TELEMETRY_SCD30, TELEMETRY_SGP30, TELEMETRY_CCS811, TELEMETRY_SPS30, TELEMETRY_BME280, TELEMETRY_BME68X, TELEMETRY_MLX};
+
+// about the accuracy of the sensors, changes below are noise
+const TelemetryBand telemetryDefaultBands[HISTORY_CHANNELS] PROGMEM = {
+  { 10.0, 0.0 }, { 1.0, 0.0 }, { 0.2, 0.0 },               // scd30 CO2 [ppm], rH [%], T [C]
+  { 10.0, 0.0 }, {  5.0, 0.0 },                            // sgp30 eCO2 [ppm], tVOC [ppb]
+  { 10.0, 0.0 }, {  5.0, 0.0 },                            // ccs811 eCO2 [ppm], tVOC [ppb]
+  {  1.0, 5.0 }, {  1.0, 5.0 }, { 1.0, 5.0 }, { 1.0, 5.0 },// sps30 PM [ug/m3]
+  {  0.2, 0.0 }, {  1.0, 0.0 }, { 0.2, 0.0 },              // bme280 p [hPa], rH [%], T [C]
+  {  0.2, 0.0 }, {  1.0, 0.0 }, { 0.2, 0.0 }, { 0.0, 5.0 },// bme68x p [hPa], rH [%], T [C], resistance [Ohm]
+  {  0.2, 0.0 }, {  0.2, 0.0 }                             // mlx To, Ta [C]
+};
+
+TelemetryBand   (&telemetryBands)[HISTORY_CHANNELS]    = mySettings.telemetryBands;   // deadband of each channel, kept in the settings
+TelemetryTiming (&telemetryTimings)[TELEMETRY_SENSORS] = mySettings.telemetryTimings; // intervals of each sensor
+TelemetryState  telemetryStates[TELEMETRY_TRANSPORTS];     // what was sent on MQTT and WebSocket
+
+/******************************************************************************************************/
+// MessagePack
+/******************************************************************************************************/
+
+size_t telemetryMsgPack(uint32_t channels, uint8_t *payload, size_t len) {
+  uint32_t available = 0;
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if ( (channels & (1UL << i)) && *historySources[i].avail ) { available |= 1UL << i; }
+  }
+  uint8_t n = __builtin_popcount(available);
+  size_t  l = 0;
+  if (len < 3) { return 0; }
+  if (n < 16) {                                            // fixmap
+    payload[l++] = 0x80 | n;
+  } else {                                                 // map 16
+    payload[l++] = 0xde;
+    payload[l++] = 0;
+    payload[l++] = n;
+  }
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if ( !(available & (1UL << i)) ) { continue; }
+    if (l + 6 > len) { return 0; }                         // key and float32 do not fit
+    payload[l++] = i;                                      // positive fixint
+    float value = historySources[i].read();
+    float raw   = roundf((value - historySources[i].offset) / historySources[i].scale);
+    if (isnan(value)) {
+      payload[l++] = 0xc0;                                 // nil
+    } else if ( (raw > INT16_MIN) && (raw <= INT16_MAX) ) {
+      int16_t v = (int16_t)raw;
+      payload[l++] = 0xd1;                                 // int 16
+      payload[l++] = (uint16_t)v >> 8;
+      payload[l++] = (uint16_t)v & 0xFF;
+    } else {
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      payload[l++] = 0xca;                                 // float 32
+      payload[l++] = bits >> 24;
+      payload[l++] = bits >> 16;
+      payload[l++] = bits >> 8;
+      payload[l++] = bits;
+    }
+  }
+  return l;
+}
+
+// {"encoding":"msgpack","value":"raw*scale+offset","channels":[{"id":0,"name":"scd30.CO2","scale":1,"offset":0}, ... ]}
+size_t telemetrySchemaJSON(uint8_t field, char *payload, size_t len) {
+  int l = 0;
+  if (field == 0) {
+    l = snprintf_P(payload, len, PSTR("{\"encoding\":\"msgpack\",\"value\":\"raw*scale+offset\",\"channels\":["));
+  } else if (field <= HISTORY_CHANNELS) {
+    uint8_t channel = field-1;
+    char    name[HISTORY_NAMELENGTH];
+    strncpy_P(name, historyNames[channel], sizeof(name));
+    l = snprintf_P(payload, len, PSTR("%s{\"id\":%u,\"name\":\"%s\",\"scale\":%g,\"offset\":%g}"),
+                   (channel > 0) ? "," : "", channel, name, historySources[channel].scale, historySources[channel].offset);
+  } else if (field == HISTORY_CHANNELS+1) {
+    l = snprintf_P(payload, len, PSTR("]}"));
+  }
+  if (l < 0) { return 0; }
+  return ((size_t)l < len) ? (size_t)l : len-1;
+}
+
+/******************************************************************************************************/
+// Transports
+/******************************************************************************************************/
+
+bool publishTelemetryMQTT(const char *topic, uint32_t channels) {
+  uint8_t payload[TELEMETRY_MAXSIZE];
+  size_t  l = telemetryMsgPack(channels, payload, sizeof(payload));
+  if (l == 0) { return false; }
+  MQTTFragment fragment = { payload, (unsigned int)l, false };
+  return mqttClient.publishv(topic, &fragment, 1, false);
+}
+
+// Streamed the same way as /data/all, the first pass adds up the length
+bool publishTelemetrySchema() {
+  char   payload[TELEMETRY_SCHEMALENGTH];
+  size_t length = 0;
+  for (uint8_t i=0; i<TELEMETRY_SCHEMAFIELDS; i++) { length += telemetrySchemaJSON(i, payload, sizeof(payload)); }
+  if (!mqttClient.beginPublish(mqttTopic(PSTR("schema")), length, true)) { return false; }
+  for (uint8_t i=0; i<TELEMETRY_SCHEMAFIELDS; i++) {
+    size_t l = telemetrySchemaJSON(i, payload, sizeof(payload));
+    mqttClient.write((const uint8_t *)payload, l);
+  }
+  return (mqttClient.endPublish() == 1);
+}
+
+size_t broadcastTelemetryWS(uint32_t channels) {
+  uint8_t payload[TELEMETRY_MAXSIZE];
+  size_t  l = telemetryMsgPack(channels, payload, sizeof(payload));
+  if ( (l == 0) || !webSocket.broadcastBIN(payload, l) ) { return 0; }
+  return l;
+}
+
+const char *telemetryEncodingName(uint8_t encoding) {
+  return (encoding == TELEMETRY_MSGPACK) ? "MessagePack" : "JSON";
+}
+
+/******************************************************************************************************/
+// Publish Policy
+/******************************************************************************************************/
+
+void initializeTelemetry() {
+  for (uint8_t t=0; t<TELEMETRY_TRANSPORTS; t++) {
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) { telemetryStates[t].last[i] = NAN; }
+    memset(telemetryStates[t].lastTime, 0, sizeof(telemetryStates[t].lastTime));
+    telemetryStates[t].sent    = 0;
+    telemetryStates[t].dropped = 0;
+  }
+}
+
+bool telemetryDue(uint8_t transport, uint8_t sensor) {
+  TelemetryState *state   = &telemetryStates[transport];
+  unsigned long   elapsed = currentTime - state->lastTime[sensor];
+  uint32_t        mask    = telemetryChannels[sensor];
+  bool            first   = true;                          // nothing sent yet
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if ( (mask & (1UL << i)) && !isnan(state->last[i]) ) { first = false; break; }
+  }
+  if (first) { return true; }
+  if ( elapsed < (unsigned long)telemetryTimings[sensor].minInterval * 1000UL ) { return false; }
+  if ( (telemetryTimings[sensor].maxSilence > 0) && (elapsed >= (unsigned long)telemetryTimings[sensor].maxSilence * 1000UL) ) { return true; }
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if ( !(mask & (1UL << i)) ) { continue; }
+    float value = historySources[i].read();
+    float last  = state->last[i];
+    if (isnan(value) != isnan(last)) { return true; }      // reading appeared or went away
+    if (isnan(value)) { continue; }
+    float band = fmaxf(telemetryBands[i].absolute, telemetryBands[i].relative * 0.01f * fabsf(last));
+    if (fabsf(value - last) >= fmaxf(band, historySources[i].scale)) { return true; }
+  }
+  return false;
+}
+
+void telemetrySent(uint8_t transport, uint8_t sensor) {
+  TelemetryState *state = &telemetryStates[transport];
+  uint32_t        mask  = telemetryChannels[sensor];
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if (mask & (1UL << i)) { state->last[i] = historySources[i].read(); }
+  }
+  state->lastTime[sensor] = currentTime;
+  state->sent++;
+}
+
+// Called before the messages are built, so a reading inside the deadband does not hold up the other sensors
+bool telemetryFilter(uint8_t transport, uint8_t sensor, bool *newData) {
+  if (*newData && !telemetryDue(transport, sensor)) {
+    *newData = false;
+    telemetryStates[transport].dropped++;
+  }
+  return *newData;
+}
+
+int8_t telemetrySensor(const char *name) {
+  for (uint8_t i=0; i<TELEMETRY_SENSORS; i++) {
+    if (strcmp_P(name, telemetrySensorNames[i]) == 0) { return i; }
+  }
+  return -1;
+}
+
+bool setTelemetryBand(const char *channel, float absolute, float relative) {
+  if ( (absolute < 0.0) || (relative < 0.0) ) { return false; }
+  for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+    if (strcmp_P(channel, historyNames[i]) == 0) {
+      telemetryBands[i].absolute = absolute;
+      telemetryBands[i].relative = relative;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool setTelemetryTiming(const char *sensor, uint16_t minInterval, uint16_t maxSilence) {
+  int8_t i = telemetrySensor(sensor);
+  if (i < 0) { return false; }
+  telemetryTimings[i].minInterval = minInterval;
+  telemetryTimings[i].maxSilence  = maxSilence;
+  return true;
+}
+
+void printTelemetryPolicy() {
+  char name[HISTORY_NAMELENGTH];
+  printSerialTelnetLogln(F("Channel            Deadband   [%]     Min [s]  Heartbeat [s]"));
+  for (uint8_t s=0; s<TELEMETRY_SENSORS; s++) {
+    for (uint8_t i=0; i<HISTORY_CHANNELS; i++) {
+      if ( !(telemetryChannels[s] & (1UL << i)) ) { continue; }
+      strncpy_P(name, historyNames[i], sizeof(name));
+      snprintf_P(tmpStr, sizeof(tmpStr), PSTR("%-18s %8.2f %5.1f     %7u  %13u"), name,
+                 telemetryBands[i].absolute, telemetryBands[i].relative, telemetryTimings[s].minInterval, telemetryTimings[s].maxSilence);
+      printSerialTelnetLogln(tmpStr); yieldTime += yieldOS();
+    }
+  }
+  snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MQTT: %lu sent %lu dropped, WebSocket: %lu sent %lu dropped"),
+             (unsigned long)telemetryStates[TELEMETRY_MQTT].sent, (unsigned long)telemetryStates[TELEMETRY_MQTT].dropped,
+             (unsigned long)telemetryStates[TELEMETRY_WS].sent,   (unsigned long)telemetryStates[TELEMETRY_WS].dropped);
+  printSerialTelnetLogln(tmpStr);
+}
@@ -17,7 +17,6 @@ unsigned long weather_lastError;
 bool weather_success = false;
 bool weather_avail = true;                                 // do we have this sensor?
 bool weatherNewData = false;                               // do we have new data
-bool weatherNewDataHandeled = false;                       // have we handeled the new data?
 bool weatherNewDataWS = false;                             // do we have new data for websocket
 
 volatile WiFiStates stateWeather = IS_WAITING;             // keeping track of MQTT state
@@ -26,6 +25,7 @@ clientData weatherData;
 // External Variables
 extern Settings      mySettings;   // Config
 extern bool          fastMode;     // Sensi
+extern uint32_t      sampleSequence; // Sensi
 extern unsigned long lastYield;    // Sensi
 extern unsigned long currentTime;  // Sensi
 extern char          tmpStr[256];  // Sensi
@@ -152,6 +152,7 @@ void updateWeather() {
         if ( getWeatherData() ) {
           weatherNewData   = true;
           weatherNewDataWS = true;
+          sampleSequence++;
           weather_success = true;
         } else {
           if ((mySettings.debuglevel > 0) && mySettings.useWeather) { R_printSerialTelnetLogln(F("Weather: could not obtain data")); }
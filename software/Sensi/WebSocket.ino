@@ -18,6 +18,9 @@
 #include "src/SPS30.h"
 #include "src/Weather.h"
 #include "src/Print.h"
+#include "src/Profile.h"
+#include "src/Telemetry.h"
+#include "src/HTTP.h"
 
 
 bool ws_connected = false;                                 // mqtt connection established?
@@ -25,14 +28,19 @@ unsigned long lastWebSocket;                               // last time we check
 volatile WiFiStates stateWebSocket  = IS_WAITING;          // keeping track of websocket
 
 WebSocketsServer webSocket = WebSocketsServer(81);         // The Websocket interface
+uint32_t wsSequence[HTTP_APIBLOCKS];                       // sample sequence when a block was last broadcast, 0: never
+uint32_t wsSnapshots = 0;                                  // clients that received a snapshot
+uint32_t wsResumes   = 0;                                  // clients that resumed with only the blocks they missed
 
 // External Variables
 extern unsigned long yieldTime;        // Sensi
 extern unsigned long lastYield;        // Sensi
-extern unsigned long AllmaxUpdateWS;   // Sensi
 extern Settings      mySettings;       // Config
 extern unsigned long currentTime;      // Sensi
 extern char          tmpStr[256];      // Sensi
+extern uint8_t       wsEncoding;       // Telemetry
+extern uint32_t      sampleSequence;   // Sensi
+extern const HTTPBlock httpBlocks[HTTP_APIBLOCKS]; // HTTP
 
 extern bool          bme280NewDataWS;
 extern bool          bme68xNewDataWS;
@@ -45,6 +53,7 @@ extern bool          weatherNewDataWS;
 extern bool          timeNewDataWS;
 extern bool          dateNewDataWS;
 extern bool          max30NewDataWS;
+extern bool          systemNewDataWS;
 
 /******************************************************************************************************/
 // Initialize Web Socket Server 
@@ -84,7 +93,7 @@ void updateWebSocket() {
         // webSocket.setAuthorization("user", "Password");        
         if (mySettings.debuglevel  > 0) { R_printSerialTelnetLogln(F("WebSocket: server started")); }
         stateWebSocket = CHECK_CONNECTION;
-        AllmaxUpdateWS = 0;
+        resetProfile(PROFILE_WS);
       }
       break;
     }
@@ -120,8 +129,9 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t lenght
         IPAddress ip = webSocket.remoteIP(num);
         if (mySettings.debuglevel  == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Websocket [%u] connection from %u.%u.%u.%u url: %s"), num, ip[0], ip[1], ip[2], ip[3], payload); R_printSerialTelnetLogln(tmpStr); }
         ws_connected = true;
-        //ForceSendValues = 1;
         webSocket.sendTXT(num, "Connected");
+        const char *seq = strstr((const char *)payload, "seq=");    // ws://host:81/?seq=123 resumes after a reconnect
+        sendSnapshotWS(num, (seq != NULL) ? strtoul(seq+4, NULL, 10) : 0, seq != NULL);
       }
       break;
       
@@ -180,62 +190,113 @@ void hexdump(const void *mem, uint32_t len, uint8_t cols) {
     printSerialTelnetLog("\r\n");
 }
 
+// The dashboard starts from a snapshot: every available block as its own message, then { "seq": 123 }.
+// A client that reconnects with the last seq it received only gets the blocks broadcast since then.
+// A seq from before a reboot is ahead of the device and gets the full snapshot.
+void sendSnapshotWS(uint8_t num, uint32_t seq, bool resume) {
+  char payLoad[HTTP_APIBLOCKLENGTH];
+  if (seq > sampleSequence) { resume = false; }
+  for (uint8_t i=0; i<HTTP_APIBLOCKS; i++) {
+    if (!apiBlockAvailable(i)) { continue; }
+    if (resume && (wsSequence[i] <= seq)) { continue; }
+    httpBlocks[i].json(payLoad, sizeof(payLoad));
+    webSocket.sendTXT(num, payLoad);
+    yieldTime += yieldOS();
+  }
+  snprintf_P(payLoad, sizeof(payLoad), PSTR("{ \"seq\": %lu}"), (unsigned long)sampleSequence);
+  webSocket.sendTXT(num, payLoad);
+  if (resume) { wsResumes++; } else { wsSnapshots++; }
+  if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Websocket [%u] %s at %lu"), num, resume ? "resumed" : "snapshot", (unsigned long)sampleSequence); R_printSerialTelnetLogln(tmpStr); }
+}
+
 void updateWebSocketMessage() {
     char payLoad[512];
+    size_t l;
+    bool   sent = false;
+
+    // readings inside their deadband are dropped
+    telemetryFilter(TELEMETRY_WS, TELEMETRY_SENSOR_BME280, &bme280NewDataWS);
+    telemetryFilter(TELEMETRY_WS, TELEMETRY_SENSOR_SCD30,  &scd30NewDataWS);
+    telemetryFilter(TELEMETRY_WS, TELEMETRY_SENSOR_SGP30,  &sgp30NewDataWS);
+    telemetryFilter(TELEMETRY_WS, TELEMETRY_SENSOR_SPS30,  &sps30NewDataWS);
+    telemetryFilter(TELEMETRY_WS, TELEMETRY_SENSOR_CCS811, &ccs811NewDataWS);
+    telemetryFilter(TELEMETRY_WS, TELEMETRY_SENSOR_BME68X, &bme68xNewDataWS);
+    telemetryFilter(TELEMETRY_WS, TELEMETRY_SENSOR_MLX,    &mlxNewDataWS);
         
     if (bme280NewDataWS) {
-      bme280JSON(payLoad, sizeof(payLoad));
-      webSocket.broadcastTXT(payLoad);      
+      if (wsEncoding == TELEMETRY_MSGPACK) { l = broadcastTelemetryWS(TELEMETRY_BME280); }
+      else { bme280JSON(payLoad, sizeof(payLoad)); webSocket.broadcastTXT(payLoad); l = strlen(payLoad); }      
       bme280NewDataWS = false;
-      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME280 WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
+      wsSequence[HTTP_BLOCK_BME280] = sampleSequence;
+      sent = true;
+      telemetrySent(TELEMETRY_WS, TELEMETRY_SENSOR_BME280);
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME280 WebSocket data boradcasted, len: %u"), l); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }
 
     if (scd30NewDataWS)  {
-      scd30JSON(payLoad, sizeof(payLoad));
-      webSocket.broadcastTXT(payLoad);      
+      if (wsEncoding == TELEMETRY_MSGPACK) { l = broadcastTelemetryWS(TELEMETRY_SCD30); }
+      else { scd30JSON(payLoad, sizeof(payLoad)); webSocket.broadcastTXT(payLoad); l = strlen(payLoad); }      
       scd30NewDataWS = false;
-      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }
+      wsSequence[HTTP_BLOCK_SCD30] = sampleSequence;
+      sent = true;
+      telemetrySent(TELEMETRY_WS, TELEMETRY_SENSOR_SCD30);
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SCD30 WebSocket data boradcasted, len: %u"), l); R_printSerialTelnetLogln(tmpStr); }
       yieldTime += yieldOS(); 
     }
     
     if (sgp30NewDataWS)  {
-      sgp30JSON(payLoad, sizeof(payLoad));
-      webSocket.broadcastTXT(payLoad);      
+      if (wsEncoding == TELEMETRY_MSGPACK) { l = broadcastTelemetryWS(TELEMETRY_SGP30); }
+      else { sgp30JSON(payLoad, sizeof(payLoad)); webSocket.broadcastTXT(payLoad); l = strlen(payLoad); }      
       sgp30NewDataWS = false;
-      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }
+      wsSequence[HTTP_BLOCK_SGP30] = sampleSequence;
+      sent = true;
+      telemetrySent(TELEMETRY_WS, TELEMETRY_SENSOR_SGP30);
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SGP30 WebSocket data boradcasted, len: %u"), l); R_printSerialTelnetLogln(tmpStr); }
       yieldTime += yieldOS(); 
     }
     
     if (sps30NewDataWS)  {
-      sps30JSON(payLoad, sizeof(payLoad));
-      webSocket.broadcastTXT(payLoad);      
+      if (wsEncoding == TELEMETRY_MSGPACK) { l = broadcastTelemetryWS(TELEMETRY_SPS30); }
+      else { sps30JSON(payLoad, sizeof(payLoad)); webSocket.broadcastTXT(payLoad); l = strlen(payLoad); }      
       sps30NewDataWS = false;
-      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30 WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
+      wsSequence[HTTP_BLOCK_SPS30] = sampleSequence;
+      sent = true;
+      telemetrySent(TELEMETRY_WS, TELEMETRY_SENSOR_SPS30);
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("SPS30 WebSocket data boradcasted, len: %u"), l); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }
     
     if (ccs811NewDataWS) {
-      ccs811JSON(payLoad, sizeof(payLoad));
-      webSocket.broadcastTXT(payLoad);      
+      if (wsEncoding == TELEMETRY_MSGPACK) { l = broadcastTelemetryWS(TELEMETRY_CCS811); }
+      else { ccs811JSON(payLoad, sizeof(payLoad)); webSocket.broadcastTXT(payLoad); l = strlen(payLoad); }      
       ccs811NewDataWS = false;
-      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811 WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
+      wsSequence[HTTP_BLOCK_CCS811] = sampleSequence;
+      sent = true;
+      telemetrySent(TELEMETRY_WS, TELEMETRY_SENSOR_CCS811);
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("CCS811 WebSocket data boradcasted, len: %u"), l); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }
 
     if (bme68xNewDataWS) {
-      bme68xJSON(payLoad, sizeof(payLoad));
-      webSocket.broadcastTXT(payLoad);      
+      if (wsEncoding == TELEMETRY_MSGPACK) { l = broadcastTelemetryWS(TELEMETRY_BME68X); }
+      else { bme68xJSON(payLoad, sizeof(payLoad)); webSocket.broadcastTXT(payLoad); l = strlen(payLoad); }      
       bme68xNewDataWS = false;
-      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
+      wsSequence[HTTP_BLOCK_BME68X] = sampleSequence;
+      sent = true;
+      telemetrySent(TELEMETRY_WS, TELEMETRY_SENSOR_BME68X);
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("BME68x WebSocket data boradcasted, len: %u"), l); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }
 
     if (mlxNewDataWS) {
-      mlxJSON(payLoad, sizeof(payLoad));
-      webSocket.broadcastTXT(payLoad);      
+      if (wsEncoding == TELEMETRY_MSGPACK) { l = broadcastTelemetryWS(TELEMETRY_MLX); }
+      else { mlxJSON(payLoad, sizeof(payLoad)); webSocket.broadcastTXT(payLoad); l = strlen(payLoad); }      
       mlxNewDataWS = false;
-      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MLX WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
+      wsSequence[HTTP_BLOCK_MLX] = sampleSequence;
+      sent = true;
+      telemetrySent(TELEMETRY_WS, TELEMETRY_SENSOR_MLX);
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("MLX WebSocket data boradcasted, len: %u"), l); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }  
 
@@ -243,6 +304,8 @@ void updateWebSocketMessage() {
       weatherJSON(payLoad, sizeof(payLoad));
       webSocket.broadcastTXT(payLoad);      
       weatherNewDataWS = false;
+      wsSequence[HTTP_BLOCK_WEATHER] = sampleSequence;
+      sent = true;
       if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Weather WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }  
@@ -251,6 +314,8 @@ void updateWebSocketMessage() {
       timeJSON(payLoad, sizeof(payLoad));
       webSocket.broadcastTXT(payLoad);      
       timeNewDataWS = false;
+      wsSequence[HTTP_BLOCK_TIME] = sampleSequence;
+      sent = true;
       if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Time WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }
@@ -259,7 +324,26 @@ void updateWebSocketMessage() {
       dateJSON(payLoad, sizeof(payLoad));
       webSocket.broadcastTXT(payLoad);      
       dateNewDataWS = false;
+      wsSequence[HTTP_BLOCK_DATE] = sampleSequence;
+      sent = true;
       if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("Date WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
       yieldTime += yieldOS(); 
     }
+
+    if (systemNewDataWS) {
+      sampleSequence++;                                    // heap and queue change without a reading, a client at the last seq still needs them
+      systemJSON(payLoad, sizeof(payLoad));
+      webSocket.broadcastTXT(payLoad);      
+      systemNewDataWS = false;
+      wsSequence[HTTP_BLOCK_SYSTEM] = sampleSequence;
+      sent = true;
+      if (mySettings.debuglevel == 3) { snprintf_P(tmpStr, sizeof(tmpStr), PSTR("System WebSocket data boradcasted, len: %u"), strlen(payLoad)); R_printSerialTelnetLogln(tmpStr); }      
+      yieldTime += yieldOS(); 
+    }
+
+    // clients remember the sequence to resume after a reconnect
+    if (sent) {
+      snprintf_P(payLoad, sizeof(payLoad), PSTR("{ \"seq\": %lu}"), (unsigned long)sampleSequence);
+      webSocket.broadcastTXT(payLoad);
+    }
 }
@@ -11,6 +11,7 @@
 #include "src/Sensi.h"
 #include "src/WebSocket.h"
 #include "src/Print.h"
+#include "src/Profile.h"
 
 char          hostName[16] = {0};
 bool          wifi_avail = true;                           // do we have wifi?
@@ -46,7 +47,6 @@ extern volatile WiFiStates stateTelnet;
 extern volatile WiFiStates stateWebSocket;
 
 extern unsigned long lastYield;        // Sensi
-extern unsigned long AllmaxUpdateWifi;
 extern Settings      mySettings;       // Config
 extern unsigned long currentTime;      // Sensi
 extern char          tmpStr[256];      // Sensi
@@ -154,7 +154,7 @@ void updateWiFi() {
           stateTelnet      = START_UP;
           stateWeather     = START_UP;
           randomSeed(micros()); // init random generator (time until connect is random)
-          AllmaxUpdateWifi = 0;
+          resetProfile(PROFILE_WIFI);
         } else {
           if (mySettings.debuglevel == 3) { R_printSerialTelnetLogln(F("WiFi: is searching for known APs")); }
           wifi_connected = false;
@@ -171,7 +171,7 @@ void updateWiFi() {
         if (wifiMulti.run(connectTimeOut) != WL_CONNECTED) { // if connected returns status, does not seem to need frequent calls
           if (mySettings.debuglevel  > 0) { R_printSerialTelnetLogln(F("WiFi: is searching for known AP")); }
           wifi_connected = false;
-          AllmaxUpdateWifi = 0;
+          resetProfile(PROFILE_WIFI);
         } else {
           if (mySettings.debuglevel  == 3) { 
             IPAddress ip = WiFi.localIP(); // uint8_t first_octet, uint8_t second_octet, uint8_t third_octet, uint8_t fourth_octet
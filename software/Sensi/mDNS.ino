@@ -1,9 +1,10 @@
 /******************************************************************************************************/
 // mDNS multicast Domain Name Service
 /******************************************************************************************************/
-#include "src/Wifi.h"
+#include "src/WiFi.h"
 #include "src/Sensi.h"
 #include "src/Config.h"
+#include "src/Profile.h"
 
 // External variables
 extern unsigned long yieldTime;        // Sensi
@@ -13,7 +14,6 @@ extern unsigned long currentTime;      // Sensi
 extern char          tmpStr[256];      // Sensi
 extern char          hostName[16];     // WiFi
 
-extern unsigned long AllmaxUpdatemDNS; // Sensi
 extern volatile WiFiStates    stateMDNS;        // WiFi
 extern unsigned long lastMDNS;         // WiFi
 extern unsigned long mDNS_lastError;   // WiFi
@@ -68,7 +68,7 @@ void updateMDNS() {
 
         D_printSerialTelnet(F("D:S:mDNS:R.."));
         if ( MDNS.isRunning() ) {
-          AllmaxUpdatemDNS = 0;
+          resetProfile(PROFILE_MDNS);
           stateMDNS = CHECK_CONNECTION;
           // mDNS announce service for website
           if ( mySettings.useHTTP == true) {
@@ -0,0 +1,73 @@
+/******************************************************************************************************/
+// Sensor Archive
+/******************************************************************************************************/
+#ifndef ARCHIVE_H_
+#define ARCHIVE_H_
+
+#include <LittleFS.h>
+#include "History.h"
+
+// The minute means of the history channels are appended to a binary archive on LittleFS.
+// There is one segment per UTC day, /archive/YYYYMMDD.dat, with an index /archive/YYYYMMDD.idx.
+//
+// Records are compressed into blocks of ARCHIVE_BLOCKSIZE bytes in RAM, a block is appended to the segment
+// when it is full, when the day changes, after ARCHIVE_FLUSHINTERVAL and before reboot.
+// Each block starts with a header and can be decoded on its own:
+//   timestamps: the first one is in the header, the following ones as delta of delta to the previous interval
+//     '0' same interval, '10' 7 bits, '110' 9 bits, '1110' 12 bits, '1111' 32 bits
+//   values: float per channel, the first record raw, the following ones XORed with the previous value of the channel
+//     '0' same value, '10' meaningful bits inside the window of the previous value,
+//     '11' 5 bits leading zeros, 5 bits length-1, meaningful bits
+// After the block is written, its time range, channels and file offset are appended to the index.
+// A block cut short by a reset has no index entry and is skipped when reading.
+// The oldest segments are removed when the archive exceeds ARCHIVE_BUDGET or the file system runs low.
+
+#define ARCHIVE_DIR              "/archive"                // segment directory
+#define ARCHIVE_BLOCKSIZE           512                    // [bytes] compressed records buffered in RAM
+#define ARCHIVE_BUDGET          1000000                    // [bytes] all segments
+#define ARCHIVE_RESERVE           65536                    // [bytes] keep free on the file system for logs and settings
+#define ARCHIVE_FLUSHINTERVAL      1800                    // [s] longest a record stays in RAM
+#define ARCHIVE_INTERVAL             60                    // [s] nominal time between records
+#define ARCHIVE_MAXDAYS              62                    // longest export
+#define ARCHIVE_MAGIC            0x5341                    // block header marker
+#define ARCHIVE_NODATA       0x7FC00000                    // quiet NaN, sensor had no reading
+
+enum ArchiveFormats{ARCHIVE_CSV = 0, ARCHIVE_NDJSON};
+
+struct ArchiveBlockHeader {
+  uint16_t      magic;                                     // ARCHIVE_MAGIC
+  uint16_t      length;                                    // bytes of compressed records following the header
+  uint32_t      channels;                                  // bit mask of history channels in each record
+  uint32_t      start;                                     // [s] epoch of first record
+  uint16_t      records;                                   // records in block
+  uint16_t      reserved;                                  //
+};
+
+struct ArchiveIndexEntry {
+  uint32_t      start;                                     // [s] epoch of first record
+  uint32_t      end;                                       // [s] epoch of last record
+  uint32_t      channels;                                  // bit mask of history channels
+  uint32_t      offset;                                    // of block header in segment
+};
+
+struct ArchiveCodec {
+  uint8_t      *data;                                      // compressed records
+  uint16_t      bit;                                       // next bit to write or read
+  uint16_t      records;                                   // records encoded or left to decode
+  uint32_t      start;                                     // [s] epoch of first record
+  uint32_t      channels;                                  // bit mask of history channels
+  uint32_t      time;                                      // [s] epoch of previous record
+  int32_t       delta;                                     // [s] previous time between records
+  uint32_t      value[HISTORY_CHANNELS];                   // previous value as float bits
+  uint8_t       leading[HISTORY_CHANNELS];                 // leading zeros of previous XOR
+  uint8_t       trailing[HISTORY_CHANNELS];                // trailing zeros of previous XOR
+};
+
+void     initializeArchive(void);                          // sum segment sizes
+void     updateArchive(void);                              // append minute means of history, call when a minute closed
+void     flushArchive(void);                               // write buffered records to LittleFS
+bool     archiveOpen(uint32_t from, uint32_t to, uint8_t format);  // start export of time range [s], false if nothing stored
+size_t   archiveExport(char *payload, size_t len);         // next field of export, 0 at end
+void     printArchive(void);                               // list segments on terminal
+
+#endif
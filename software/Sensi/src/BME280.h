@@ -47,6 +47,7 @@
 // 3.6microA H,P,T
 bool initializeBME280(void);
 bool updateBME280(void);
+unsigned long nextBME280(void);                            // [ms] until the state machine needs to run again
 void bme280JSON(char *payload, size_t len);				   // convert readings to serialized JSON
 void bme280JSONMQTT(char *payload, size_t len);			   // convert readings to serialized JSON
 
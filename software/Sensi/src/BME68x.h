@@ -45,6 +45,7 @@
 
 bool initializeBME68x(void);                               // get sensor ready
 bool updateBME68x(void);                                   // moving through statemachine
+unsigned long nextBME68x(void);                            // [ms] until the state machine needs to run again
 bool startMeasurementsBME68x();                            // request data
 bool readDataBME68x();                                     // obtain the requested data
 void bme68xJSON(char *payload, size_t len);                // convert readings to serialized JSON
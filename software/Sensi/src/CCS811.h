@@ -32,6 +32,7 @@
 
 bool initializeCCS811(void);                               // 
 bool updateCCS811(void);                                   //
+unsigned long nextCCS811(void);                            // [ms] until the state machine needs to run again
 void ICACHE_RAM_ATTR handleCCS811Interrupt(void);          // interrupt service routine to handle data ready signal
 void ccs811JSON(char *payload, size_t len);			       // convert readings to serialzied JSON
 void ccs811JSONMQTT(char *payload, size_t len);			   // convert readings to serialzied JSON
@@ -8,17 +8,18 @@
 #include <FS.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>                                   // Encoding Decoding JSON text
+#include "Telemetry.h"                                     // publish policy is part of the settings
 
 #define JSONSIZE                  2048                     // crashes program if too small, use online tool to check recommended size
 #define EEPROM_SIZE               2048                     // make sure this value is larger than the space required by the settings below and lowwer than the max Settings of the microcontroller
 #define intervalSettingsJSON 604800000                     // 7 days
-#define intervalSettings      43200000                     // 12 hrs 
+#define intervalSettings       3600000                     // 1 hr, only changed fields are written
 
 // ========================================================// The EEPROM section
 // This table has grown over time. So its not in order.
 // Appending new settings will keeps the already stored settings.
 // Boolean settings are stored as a byte.
-// This structure is approx 690 bytes in size.
+// This structure is 980 bytes in size.
 
 struct Settings {
   unsigned long runTime;                                   // keep track of total sensor run time
@@ -84,9 +85,89 @@ struct Settings {
   float         altitude;                                  // altitude of current lcoation in meters
   float         emissivity;                                // MLX emissivity 
   uint8_t       LCDdisplayType;                            // 
+  uint8_t       mqttEncoding;                              // TELEMETRY_JSON or TELEMETRY_MSGPACK sensor messages on MQTT
+  uint8_t       wsEncoding;                                // ... on websocket
+  TelemetryBand telemetryBands[HISTORY_CHANNELS];          // deadband of each channel
+  TelemetryTiming telemetryTimings[TELEMETRY_SENSORS];     // minimum interval and heartbeat of each sensor
+  unsigned long mqttMessageRate;                           // [1/s] sustained rate of immediate MQTT messages
+  unsigned long mqttBurst;                                 // [messages] saved up budget
+  unsigned long mqttByteRate;                              // [bytes/s]
+  unsigned long queueMessageRate;                          // [1/s] drain rate of MQTT queue
+  unsigned long queueByteRate;                             // [bytes/s]
 };
 
-void saveConfiguration(const Settings &config);
-void loadConfiguration(Settings &config);
+// ========================================================// The settings journal
+// Settings are stored in a journal file on LittleFS. The first record is a snapshot of the whole structure,
+// the following records hold the bytes of fields that changed since the previous save.
+// Each record carries the layout version and a CRC. At boot the snapshot is loaded and the records are replayed
+// until the end of the file or the first record that does not validate, e.g. one cut short by a reset.
+// When the journal would grow beyond one flash sector, it is compacted into a new snapshot,
+// written to a temporary file and renamed over the journal.
+// A journal of an older layout version is migrated field by field and compacted.
+// The EEPROM copy of earlier firmware is read once when there is no valid journal.
+// Without a file system the settings are read from and written to EEPROM.
+// This firmware writes a snapshot record header below the I2C topology at the end of the EEPROM. Without a valid header
+// the EEPROM holds the settings of firmware before the journal, only the fields up to LCDdisplayType are taken.
+
+#define SETTINGS_JOURNAL      "/Settings.jnl"              // journal file
+#define SETTINGS_COMPACT      "/Settings.tmp"              // snapshot being written
+#define SETTINGS_JOURNALSIZE      4096                     // [bytes] compact when journal would grow beyond
+#define SETTINGS_MAGIC            0x5E                     // marks a journal record
+#define SETTINGS_VERSION             2                     // layout of Settings, increment when fields change
+#define SETTINGS_EEPROMLENGTH     offsetof(Settings, mqttEncoding) // [bytes] of Settings in EEPROM of firmware before the journal
+#define SETTINGS_GAP                 8                     // changed bytes closer than this go into one record
+
+struct SettingsRecord {
+  uint8_t       magic;                                     // SETTINGS_MAGIC
+  uint8_t       version;                                   // SETTINGS_VERSION
+  uint16_t      offset;                                    // of changed bytes in Settings, 0 for snapshot
+  uint16_t      length;                                    // bytes following, sizeof(Settings) for snapshot
+  uint16_t      crc;                                       // CRC-16 of record with crc 0 and the bytes following
+};
+
+// ========================================================// Sensi.json
+// Sensi.json is written and read field by field with the table settingsFields, no JsonDocument is needed.
+// Each entry names the JSON key, type, offset and size of a member of Settings.
+// The parser reads a flat JSON object in chunks of any size. Keys not in the table and nested values are skipped,
+// settings missing in the file keep their value.
+
+#define SETTINGS_KEYLENGTH          32                     // longest JSON key including terminator
+#define SETTINGS_VALUELENGTH        72                     // longest JSON value including terminator
+#define SETTINGS_JSONCHUNK          64                     // [bytes] read from Sensi.json at a time
+
+enum SettingsTypes{SETTING_BOOL = 0, SETTING_UNSIGNED, SETTING_SIGNED, SETTING_FLOAT, SETTING_STRING};
+enum SettingsParserStates{PARSE_OBJECT = 0, PARSE_KEY, PARSE_KEYSTRING, PARSE_COLON, PARSE_VALUE, PARSE_STRING, PARSE_LITERAL, PARSE_SKIP, PARSE_DONE, PARSE_ERROR};
+
+struct SettingsField {
+  char          key[SETTINGS_KEYLENGTH];                   // JSON key
+  uint8_t       type;                                      // SettingsTypes
+  uint16_t      offset;                                    // of member in Settings
+  uint8_t       size;                                      // of member in Settings
+};
+
+struct SettingsParser {
+  uint8_t       state;                                     // SettingsParserStates
+  uint8_t       depth;                                     // nesting of skipped value
+  bool          inString;                                  // skipped value is inside string
+  bool          escape;                                    // previous character was a backslash
+  uint8_t       unicode;                                   // hex digits of \u escape still to come
+  uint16_t      code;                                      // of \u escape
+  char          key[SETTINGS_KEYLENGTH];                   //
+  uint8_t       keyLength;                                 //
+  char          value[SETTINGS_VALUELENGTH];               //
+  uint8_t       valueLength;                               //
+  uint8_t       fields;                                    // settings applied
+};
+
+void   saveConfiguration(const Settings &config);
+void   loadConfiguration(Settings &config);
+size_t settingsJSON(uint16_t index, const Settings &config, char *payload, size_t len);   // "{", one line per setting, "}", 0 after the end
+void   beginSettingsParser(SettingsParser *parser);        //
+bool   parseSettingsJSON(SettingsParser *parser, const char *data, size_t len, Settings &config); // feed next chunk, false on syntax error
+bool loadSettings(Settings &config);                      // replay journal, false if there is no valid journal, EEPROM without file system
+bool saveSettings(const Settings &config);                // append changed fields to journal, EEPROM without file system
+bool compactSettings(const Settings &config);             // replace journal with snapshot
+void sanitizeSettings(Settings &config);                  // force booleans to 0/1 in settings from EEPROM
+bool loadSettingsEEPROM(Settings &config);                // settings from EEPROM, false if they were written by firmware before the journal
 
 #endif
@@ -4,7 +4,55 @@
 #ifndef HTTP_H_
 #define HTTP_H_
 
-#include <ESP8266WebServer.h>
+#include <NonBlockingWebServer.h>
+
+// The server keeps up to NBWS_MAX_CLIENTS browsers with keep-alive and advances each by one step per updateHTTP().
+// Files, /profile, /history?ch and /archive are sent piece by piece as the browser takes them, a slow browser does not
+// hold up the sensors. Other handlers send() their response at once, it has to fit into the TCP send buffer and
+// NBWS_RESPONSE_MAX of the connection, a larger one is answered with 500.
+
+// /api/all returns the blocks of the single endpoints in one object, { "system": {...}, "time": {...}, "scd30": {...}, ...}
+//   ?fields=scd30,time selects blocks, sensors not available are left out
+//   ETag is W/"<sample sequence>-<blocks>", If-None-Match with the current ETag is answered with 304 Not Modified
+//   system (heap, loop time, queue) and time change between samples, a response holding them has no ETag and is always sent
+
+#define HTTP_APINAMELENGTH  10                             // block name including terminator
+#define HTTP_APIBLOCKLENGTH 320                            // longest block
+
+// Web assets on LittleFS (pages, styles, scripts and images) are indexed when the server starts, the one asset
+// written or removed by an upload or the terminal is indexed again:
+//   path, compressed version present, size, MIME type and FNV-1a hash of the bytes sent
+// They carry the hash as strong ETag, a matching If-None-Match is answered with 304 without opening a file.
+// Pages are revalidated on every visit, the other assets are cached for HTTP_ASSETAGE.
+// Other files (logs, settings, archive) change while running and are looked up on every request.
+
+#define HTTP_MAXFILES       20                             // indexed assets
+#define HTTP_PATHLENGTH     32                             // LittleFS path including terminator
+#define HTTP_MIMELENGTH     26                             // MIME type including terminator
+#define HTTP_ASSETAGE       86400                          // [s] max-age of assets other than pages
+
+// cached types first
+enum HTTPMimeTypes{HTTP_MIME_HTML = 0, HTTP_MIME_CSS, HTTP_MIME_JS, HTTP_MIME_PNG, HTTP_MIME_GIF, HTTP_MIME_JPEG, HTTP_MIME_ICON,
+                   HTTP_MIME_TEXT, HTTP_MIME_XML, HTTP_MIME_JSON, HTTP_MIME_PDF, HTTP_MIME_ZIP, HTTP_MIME_GZIP, HTTP_MIMETYPES};
+#define HTTP_MIME_CACHED    HTTP_MIME_ICON                 // last type that is indexed
+
+struct HTTPFile {
+  char          path[HTTP_PATHLENGTH];                     // as requested, without .gz
+  uint32_t      size;                                      // [bytes] sent
+  uint32_t      hash;                                      // FNV-1a of the bytes sent
+  uint8_t       mime;                                      // HTTPMimeTypes
+  bool          gz;                                        // path.gz is sent
+};
+
+enum HTTPBlocks{HTTP_BLOCK_SYSTEM = 0, HTTP_BLOCK_TIME, HTTP_BLOCK_DATE, HTTP_BLOCK_HOSTNAME, HTTP_BLOCK_IP,
+                HTTP_BLOCK_BME280, HTTP_BLOCK_BME68X, HTTP_BLOCK_CCS811, HTTP_BLOCK_SCD30, HTTP_BLOCK_SGP30, HTTP_BLOCK_SPS30,
+                HTTP_BLOCK_MLX, HTTP_BLOCK_MAX30, HTTP_BLOCK_WEATHER, HTTP_APIBLOCKS};
+#define HTTP_VOLATILEBLOCKS ((1U << HTTP_BLOCK_SYSTEM) | (1U << HTTP_BLOCK_TIME))  // not covered by the sample sequence
+
+struct HTTPBlock {
+  bool         *avail;                                     // sensor is available, NULL: always
+  void        (*json)(char *payload, size_t len);          // block as { "name": {...}}
+};
 
 void initializeHTTP();
 void initializeHTTPUpdater();
@@ -27,13 +75,26 @@ void handleTime(void);
 void handleAnimation(void);
 void handleNotFound(void);
 void handleSystem(void);
+void handleProfile(void);
+void handleHistory(void);
+void handleArchive(void);
 void handleEdit(void);
 void handleConfig(void);
+void handleSchema(void);
 void handleFileUpload(void);
 void handleWeather(void);
+void handleAPIAll(void);
+uint16_t apiFields(const char *fields);  // bitmask of blocks named in comma separated list, all if empty
+bool     apiBlockAvailable(uint8_t block);                 // sensor of block is available
 
 String getContentType(String filename);
 bool handleFileRead(String filePath); 
 bool streamFile(String path);           // send the right file to the client (if it exists)
+uint8_t  mimeType(const char *path);                       // HTTPMimeTypes from the extension, text if unknown
+void     indexFiles(void);                                 // index web assets on LittleFS
+void     indexFile(const char *name);                      // index or drop one asset after it was written or removed
+void     hashFile(HTTPFile *f, const char *path, bool gz, uint8_t mime, File &file);  // fill the entry from the open file
+int8_t   fileIndex(const char *path);                      // index of asset, -1 if not indexed
+bool     sendIndexedFile(uint8_t index);                   // 304 or the file with ETag and cache headers
 
 #endif
@@ -0,0 +1,71 @@
+/******************************************************************************************************/
+// Sensor History
+/******************************************************************************************************/
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+// Recent readings of each sensor channel are kept in RAM at three resolutions:
+//   tier 0: the reading once a second
+//   tier 1: min, mean and max of each minute
+//   tier 2: min, mean and max of each hour
+// Readings are stored as int16 fixed point, value = raw * scale + offset, HISTORY_NODATA when the sensor had no reading.
+// Each tier is a ring buffer. Channels of available sensors get rings.
+// All rings share a static block of HISTORY_BUDGET bytes, split evenly among the channels.
+// Within a channel the hours are sized first, then the minutes, the readings get the rest. When the nominal
+// depths do not fit, the coarser tiers keep as much of their span as the minimum of the finer tiers allows,
+// so the history reaches back as far as possible. Below the sum of the minimums all tiers shrink by the same factor.
+// A sensor found during operation gets rings without clearing the others, shortened rings keep their newest samples.
+
+#define HISTORY_BUDGET            10240                    // [bytes] ring memory of all channels
+#define HISTORY_TIERS                 3                    // resolutions
+#define HISTORY_NAMELENGTH           20                    // channel name including terminator
+#define HISTORY_NODATA        INT16_MIN                    // sensor had no reading
+#define intervalHistory            1000                    // [ms] sample all channels
+
+enum HistoryChannels{HISTORY_SCD30_CO2 = 0, HISTORY_SCD30_RH, HISTORY_SCD30_T,
+                     HISTORY_SGP30_ECO2, HISTORY_SGP30_TVOC, HISTORY_CCS811_ECO2, HISTORY_CCS811_TVOC,
+                     HISTORY_SPS30_PM1, HISTORY_SPS30_PM2, HISTORY_SPS30_PM4, HISTORY_SPS30_PM10,
+                     HISTORY_BME280_P, HISTORY_BME280_RH, HISTORY_BME280_T,
+                     HISTORY_BME68X_P, HISTORY_BME68X_RH, HISTORY_BME68X_T, HISTORY_BME68X_RESISTANCE,
+                     HISTORY_MLX_TO, HISTORY_MLX_TA, HISTORY_CHANNELS};
+
+struct HistoryTier {
+  uint16_t      interval;                                  // [s] between samples
+  uint16_t      depth;                                     // nominal number of samples
+  uint16_t      minimum;                                   // samples kept when coarser tiers are short of memory
+  uint8_t       values;                                    // 1: reading, 3: min, mean, max
+};
+
+struct HistorySource {
+  bool         *avail;                                     // sensor found and initialized
+  float       (*read)(void);                               // current reading in JSON units
+  float         scale;                                     // units per count
+  float         offset;                                    // value of raw 0
+  uint8_t       decimals;                                  // digits after the decimal point in JSON
+};
+
+struct HistoryRing {
+  int16_t      *data;                                      // depth * values samples
+  uint16_t      depth;                                     // 0 if channel is not recorded
+  uint16_t      head;                                      // next sample is written here
+  uint16_t      count;                                     // samples stored
+  int32_t       sum;                                       // accumulated since last sample
+  int16_t       min;                                       //
+  int16_t       max;                                       //
+  uint16_t      n;                                         // readings accumulated
+};
+
+void     initializeHistory(void);                          // assign ring memory to channels of available sensors
+void     allocateHistory(void);                            // rings for sensors found later, recorded samples are kept
+bool     updateHistory(void);                              // sample all channels, call every intervalHistory, true when a minute closed
+int8_t   historyChannel(const char *name);                 // channel index, -1 if unknown or not recorded
+uint8_t  historyTier(unsigned long resolution);            // finest tier with at least resolution [s]
+uint16_t historyCount(uint8_t channel, uint8_t tier);      // samples stored
+bool     historySample(uint8_t channel, uint8_t tier, uint16_t index, float *min, float *mean, float *max); // index 0 is the oldest, false if no reading
+void     historyHeaderJSON(uint8_t channel, uint8_t tier, char *payload, size_t len);                       // opens the history object
+size_t   historySampleJSON(uint8_t channel, uint8_t tier, uint16_t index, char *payload, size_t len);       // one element of the data array
+void     historyChannelJSON(uint8_t channel, char *payload, size_t len);                                    // resolutions and samples of channel
+void     printHistory(void);                                // list recorded channels and the time span they cover on terminal
+uint32_t historyCoverage(uint8_t tier);                    // [s] span of the shortest ring of tier
+
+#endif
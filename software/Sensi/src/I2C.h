@@ -0,0 +1,108 @@
+/******************************************************************************************************/
+// I2C Topology
+/******************************************************************************************************/
+#ifndef I2C_H_
+#define I2C_H_
+
+#include <Wire.h>
+#include <SensirionProtocol.h>
+
+// Scanning all pin pairs for all addresses at boot takes several seconds.
+// The devices found are stored with a checksum at the end of the EEPROM, the settings occupy its beginning.
+// At boot only the stored devices are verified, a full scan runs when the checksum does not match,
+// a stored device does not acknowledge or when requested by the user.
+// Supported sensors that are not yet attached are probed periodically on the pin pairs in use,
+// so that a sensor plugged in during operation is initialized without reboot.
+// The probe only marks the sensor found and wakes its task, the task initializes it before its first update.
+//
+// Sensor tasks are registered ordered by pin pair. Tasks with the same deadline run in registration order,
+// so the sensors on one pin pair are serviced back to back and switchI2C() does not need to reconfigure the port.
+// This grouping is best effort: a sensor task is woken by its state machine, the registration interval is only
+// the fallback, and deadlines of different sensors rarely fall on the same ms. The heap orders by deadline only,
+// port switches are counted in i2cSwitches and shown with the topology.
+//
+// Split phase transactions
+// Sensirion sensors need several ms between command and reading the response. Instead of waiting,
+// a driver queues a transaction: write command, wait, read response. The command is written right away,
+// the response is read by runI2C() once the wait expired and the sensor words are CRC checked.
+// The driver checks the state of its transaction on its next update and sets it back to I2C_IDLE.
+// Queueing wakes the queue task when the response is due, reading the response wakes the task that queued it.
+// readI2CMeasurement() runs the data ready / read measurement sequence common to the Sensirion sensors.
+// writeI2C() sends commands without response such as start and reset, the driver waits their execution time
+// in a state of its own instead of a delay().
+
+#define I2C_MAXDEVICES               16                    // devices stored in topology
+#define I2C_TOPOLOGY_VALID       0x12C0                    // marks an initialized topology
+#define I2C_SCANSPEED          I2C_SLOW                    // clock while probing addresses
+#define I2C_SCANSTRETCH I2C_LONGSTRETCH                    // clock stretch limit while probing addresses
+#define intervalI2C               60000                    // 1 minute, probe for sensors that were plugged in
+#define I2C_MAXWORDS                 20                    // SPS30 measurement as floats
+
+struct I2CEntry {
+  uint8_t       address;                                   // 7 bit address
+  uint8_t       sda;                                       // SDA pin
+  uint8_t       scl;                                       // SCL pin
+};
+
+struct I2CTopology {
+  uint16_t      valid;                                     // I2C_TOPOLOGY_VALID
+  uint8_t       numDevices;                                // entries used
+  I2CEntry      devices[I2C_MAXDEVICES];                   // devices found
+  uint16_t      checksum;                                  // Fletcher-16 of the preceeding bytes
+};
+
+struct I2CSensor {
+  uint8_t       address;                                   // 7 bit address
+  bool         *avail;                                     // sensor found and initialized
+  uint8_t      *i2c;                                       // SDA and SCL pins of the sensor
+  TwoWire     **port;                                      // i2c port of the sensor
+  bool         *use;                                       // enabled in settings
+  bool        (*initialize)(void);                         // get sensor ready
+  int          *task;                                      // scheduler task of the sensor, NULL if none
+};
+
+struct I2CTask {
+  void        (*run)(void);                                // sensor update
+  uint8_t       profile;                                   // execution time is recorded in this profile
+  uint8_t      *i2c;                                       // SDA and SCL pins of the sensor
+  int          *id;                                        // scheduler task id
+};
+
+enum I2CTransactionStates{I2C_IDLE = 0, I2C_WAITING, I2C_DONE, I2C_FAILED};
+enum I2CMeasurementResults{I2C_PENDING = 0, I2C_DATA, I2C_NODATA, I2C_NOACK};
+
+struct I2CTransaction {
+  TwoWire      *port;                                      // i2c port of the sensor
+  uint8_t      *i2c;                                       // SDA and SCL pins of the sensor
+  uint32_t      speed;                                     // clock
+  uint32_t      stretch;                                   // clock stretch limit
+  uint8_t       address;                                   // 7 bit address
+  uint16_t      command;                                   // command written
+  unsigned long wait;                                      // [us] from command to response
+  uint16_t      response[I2C_MAXWORDS];                    // words read, CRC checked
+  uint8_t       responseLength;                            // words to read
+  volatile uint8_t state;                                  // I2CTransactionStates
+  unsigned long readTime;                                  // [us] when response can be read
+  int           task;                                      // scheduler task woken when response was read
+  I2CTransaction *next;                                    // queue
+};
+
+bool loadI2CTopology(void);                                // read topology from EEPROM, false if not valid
+bool saveI2CTopology(void);                                // write topology to EEPROM
+bool verifyI2CTopology(void);                              // probe stored devices, false if one is missing
+void scanI2C(bool initialize);                             // probe all pin pairs and addresses, rebuilds topology
+bool probeI2C(void);                                       // probe supported sensors not yet found, true if one was added
+bool startI2CSensor(int task);                             // initialize the sensor of task if it was found while running
+void printI2CTopology(void);                               // list devices on terminal
+void addI2CTasks(unsigned long interval);                  // register sensor tasks grouped by pin pair, interval is the fallback
+
+bool     queueI2C(I2CTransaction *transaction, uint16_t command, unsigned long wait, uint8_t words); // Sensirion command and response words
+bool     writeI2C(I2CTransaction *transaction, uint16_t command, const uint16_t *args, uint8_t nArgs); // Sensirion command and arguments, no response
+void     runI2C(void);                                     // read responses that are due, never waits
+uint8_t  readI2CMeasurement(I2CTransaction *transaction, uint16_t readyCommand, uint16_t readCommand, unsigned long wait, uint8_t words); // call each update, I2CMeasurementResults
+uint16_t i2cCommand(const I2CTransaction *transaction);    // 16 bit command of transaction
+uint16_t i2cWord(const I2CTransaction *transaction, uint8_t index);       // response word
+uint32_t i2cLong(const I2CTransaction *transaction, uint8_t index);       // response words index and index+1
+float    i2cFloat(const I2CTransaction *transaction, uint8_t index);      // response words index and index+1 as IEEE754
+
+#endif
@@ -15,6 +15,7 @@
 
 bool initializeMLX(void);
 bool updateMLX(void);
+unsigned long nextMLX(void);                               // [ms] until the state machine needs to run again
 void mlxJSON(char *payload, size_t len);	               // convert readings to serialized JSON
 void mlxJSONMQTT(char *payload, size_t len);	           // convert readings to serialized JSON
 
@@ -12,11 +12,52 @@
 #define intervalMQTTSlow    60000                          //                                      every 60 secs
 #define intervalMQTTconnect 15000                          // time in between mqtt server connection attempts
 #define mqttClientID       "Sensi" 
+#define MQTT_ALLFIELDS         29                         // fields of /data/all including opening and closing brace
+#define MQTT_ALLFIELDLENGTH    48                         // longest field of /data/all including terminator
+#define MQTT_ALLCHUNK         192                         // [bytes] of /data/all written to the socket at a time
+#define MQTT_TOPICLENGTH       20                         // suffix of a pending topic including terminator
+#define MQTT_MESSAGERATE        4                         // [1/s] default sustained rate of sensor messages
+#define MQTT_BURST              8                         // [messages] default burst after a quiet period
+#define MQTT_BYTERATE        2048                         // [bytes/s] default sustained rate of sensor messages
+#define MQTT_PAYLOADSIZE      512                         // [bytes] message of a topic or of the queue
+
+// In immediate mode every module raises its new data flag and the topic becomes pending.
+// Each pass sends pending topics round robin, starting after the last one sent, as long as the token buckets allow:
+// mqttMessageRate messages and mqttByteRate bytes per second, with up to mqttBurst messages saved up.
+// A topic waits at most for the other pending topics to go first, (topics - 1) / mqttMessageRate once the burst is spent.
+// The time from flag to publish is kept per topic as age at publish.
+
+enum MQTTTopics{MQTT_TOPIC_SYSTEM = 0, MQTT_TOPIC_SCD30, MQTT_TOPIC_SGP30, MQTT_TOPIC_SPS30, MQTT_TOPIC_CCS811,
+                MQTT_TOPIC_BME68X, MQTT_TOPIC_BME280, MQTT_TOPIC_MLX, MQTT_TOPIC_WEATHER, MQTT_TOPIC_SENSORS,
+                MQTT_TOPIC_INTERVALS, MQTT_TOPIC_TIME, MQTT_TOPIC_DATE, MQTT_TOPICS};
+
+struct MQTTTopic {
+  bool         *pending;                                  // new data flag of the module
+  void        (*json)(char *payload, size_t len);         // builds the JSON payload
+  int8_t        sensor;                                   // telemetry sensor for MessagePack and the publish policy, -1 if none
+};
+
+struct MQTTTopicStats {
+  bool          waiting;                                  // flag was seen
+  unsigned long since;                                    // [ms] flag was seen
+  uint32_t      sent;                                     // messages
+  unsigned long lastAge;                                  // [ms] age at publish of the last message
+  unsigned long meanAge;                                  // [ms] running mean, 1/8 weight of the last message
+  unsigned long maxAge;                                   // [ms] since boot or last reset
+  size_t        length;                                   // [bytes] of the last payload built
+};
 
 void initializeMQTT(void);
 void updateMQTT(void);
 void updateMQTTMessage(void);
-void updateMQTTpayload(char *payload, size_t len);
+size_t allJSONMQTT(uint8_t field, char *payload, size_t len);  // one field of /data/all
+bool publishAllMQTT(const char *topic);                   // stream /data/all into the socket
+bool publishMQTT(const char *topic, const char *payload); // publish text payload of any length
+bool publishTopicsMQTT(void);                             // send pending topics as the token buckets allow, false if nothing was sent
+void topicsJSONMQTT(char *payload, size_t len);           // limiter settings and worst age at publish
+void printTopicsMQTT(void);                               // age at publish of each topic on terminal
+void resetTopicsMQTT(void);                               // clear age statistics
+const char *mqttTopic(const char *suffix);                // main topic and suffix from PROGMEM
 void mqttCallback(char* topic, uint8_t* payload, unsigned int len);
 
 #endif
@@ -4,6 +4,10 @@
 #ifndef PRINT_H_
 #define PRINT_H_
 
+#define LOGBUFFERSIZE              2048                    // [bytes] log entries buffered in RAM
+#define LOGFLUSHSIZE                512                    // [bytes] buffered entries are written when loop is idle
+#define LOGFLUSHIDLE                  5                    // [ms] idle time needed to write buffered entries
+
 /******************************************************************************************************/
 // DEBUG Print Configurations
 /******************************************************************************************************/
@@ -31,32 +35,35 @@
   #define R_printSerialTelnetLogln(X) printSerialTelnetLogln(X)                           // regular output with /r/n appended
 #endif
 
-void printSerial(char* str);
+void printSerial(const char* str);
 void printSerial(String str);
-void printSerialln(char* str);
+void printSerialln(const char* str);
 void printSerialln(String str);
 void printSerialln();
-void printTelnet(char* str);
+void printTelnet(const char* str);
 void printTelnet(String str);
-void printTelnetln(char* str);
+void printTelnetln(const char* str);
 void printTelnetln(String str);
 void printTelnetln();
-void printLog(char* str);
+void printLog(const char* str);
 void printLog(String str);
-void printLog(char* str);
+void printLog(const char* str);
 void printLogln(String str);
 void printLogln();
-void printSerialTelnet(char* str);                              // Serial.print to serial and telnet
-void printSerialTelnetln(char* str);                            // Serial.println to serial and telnet
+void appendLog(const char* str, size_t len, bool newLine);     // add entry to log buffer, time stamp is prepended
+void flushLog();                                                // write log buffer to logfile
+size_t logBuffered();                                           // bytes in log buffer
+void printSerialTelnet(const char* str);                        // Serial.print to serial and telnet
+void printSerialTelnetln(const char* str);                      // Serial.println to serial and telnet
 void printSerialTelnet(String str);                             // Serial.print to serial and telnet
 void printSerialTelnetln(String str);                           // Serial.println to serial and telnet
-void printSerialTelnetLog(char* str);                           // Serial.print to serial, telnet and logfile
-void printSerialTelnetLogln(char* str);                         // Serial.println to serial, telnet and logfile
+void printSerialTelnetLog(const char* str);                     // Serial.print to serial, telnet and logfile
+void printSerialTelnetLogln(const char* str);                   // Serial.println to serial, telnet and logfile
 void printSerialTelnetLog(String str);                          // Serial.print to serial, telnet and logfile
 void printSerialTelnetLogln(String str);                        // Serial.println to serial, telnet and logfile
 void printSerialTelnetLogln();                                  // Serial.println to serial, telnet and logfile
-void printSerialLog(char* str);                                 // Serial.print to serial and logfile
-void printSerialLogln(char* str);                               // Serial.println to serial and logfile
+void printSerialLog(const char* str);                           // Serial.print to serial and logfile
+void printSerialLogln(const char* str);                         // Serial.println to serial and logfile
 void printSerialLog(String str);                                // Serial.print to serial and logfile
 void printSerialLogln(String str);                              // Serial.println to serial and logfile
 void printSerialLogln();                                        // Serial.println to serial and logfile
@@ -0,0 +1,50 @@
+/******************************************************************************************************/
+// Execution Time Profiling
+/******************************************************************************************************/
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+// Each subsystem has a latency histogram with logarithmic buckets.
+// Bucket 0 holds executions shorter than PROFILEMINTIME, each following bucket doubles the range,
+// the last bucket collects everything longer than PROFILEMINTIME << (PROFILEBUCKETS-2).
+// With 64us and 16 buckets the histogram spans 64us .. 1s.
+// When a bucket is full all buckets are halved, older executions have less weight but the distribution is retained.
+// Percentiles are estimated from the upper edge of the bucket.
+// Histogram, count and maximum cover the same executions, they are cleared together by resetProfile().
+
+#define PROFILEBUCKETS               16                    // number of histogram buckets
+#define PROFILEMINTIME               64                    // [us] upper edge of first bucket
+
+enum ProfileIDs{PROFILE_TIME = 0, PROFILE_WIFI, PROFILE_OTA, PROFILE_NTP, PROFILE_MQTT, PROFILE_WS, PROFILE_HTTP, PROFILE_HTTPUPDATER,
+                PROFILE_MDNS, PROFILE_TELNET, PROFILE_WEATHER,
+                PROFILE_SCD30, PROFILE_SGP30, PROFILE_CCS811, PROFILE_SPS30, PROFILE_BME280, PROFILE_BME68X, PROFILE_MLX, PROFILE_MAX30,
+                PROFILE_MQTTMESSAGE, PROFILE_WSMESSAGE, PROFILE_LCD, PROFILE_INPUT, PROFILE_RUNTIME, PROFILE_EEPROM, PROFILE_LOGFILE,
+                PROFILE_BASELINE, PROFILE_ALLGOOD, PROFILE_BLINK, PROFILE_REBOOT, PROFILE_I2C, PROFILE_I2CQUEUE, PROFILE_HISTORY, PROFILE_SYS, NUMPROFILES};
+
+struct Profile {
+  uint32_t count;                                          // number of recorded executions
+  uint64_t sum;                                            // [us] total execution time
+  uint32_t max;                                            // [us] longest execution since start or resetProfile()
+  uint16_t bucket[PROFILEBUCKETS];                         // histogram
+};
+
+void          recordProfile(uint8_t id, unsigned long duration);    // add execution time [us]
+void          resetProfile(uint8_t id);                             // clear all statistics, e.g. when service restarts
+unsigned long profilePercentile(uint8_t id, uint8_t percent);       // [us]
+const char   *profileName(uint8_t id);                              // PROGMEM string
+void          printProfiles(void);                                  // tabulate statistics on terminal
+void          profileJSON(uint8_t id, char *payload, size_t len);   // statistics of one subsystem as JSON member
+
+// Measures the execution time of the enclosing scope
+// { ProfileTimer profileTimer(PROFILE_LCD); updateLCD(); }
+class ProfileTimer {
+  public:
+    ProfileTimer(uint8_t id) : _id(id), _start(micros()) {}
+    ~ProfileTimer() { recordProfile(_id, micros() - _start); }
+    unsigned long elapsed() { return micros() - _start; } // [us]
+  private:
+    uint8_t       _id;
+    unsigned long _start;
+};
+
+#endif
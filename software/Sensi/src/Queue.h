@@ -0,0 +1,46 @@
+/******************************************************************************************************/
+// MQTT Queue
+/******************************************************************************************************/
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include <LittleFS.h>
+#include "History.h"
+
+// While MQTT is enabled but not connected, the minute means of the history channels are queued with their time.
+// Records are appended to a RAM buffer of QUEUE_RAMSIZE bytes. When it is full, its records are appended to
+// QUEUE_FILE on LittleFS. The file is limited to QUEUE_FILESIZE, after that new records are dropped.
+// Once the broker is back, records are published oldest first to <main topic>/data/queued:
+//   {"time":1767225600,"scd30.CO2":650,"scd30.rH":40.1, ...}
+// Draining is limited to queueMessageRate messages and queueByteRate bytes per second,
+// so the current readings still go out while the backlog is sent.
+// Records are published with QoS 1 and leave the queue once the broker acknowledged them. Up to MQTT_MAX_INFLIGHT
+// records wait for PUBACK, the client sends them again after a reconnect.
+// RAM records are written to the file before reboot and OTA. After a reset the file is sent from its start again.
+
+#define QUEUE_FILE             "/mqtt.que"                 // records not published
+#define QUEUE_RAMSIZE          1024                        // [bytes] records buffered in RAM
+#define QUEUE_FILESIZE       131072                        // [bytes] about 3 days of 10 channels
+#define QUEUE_MESSAGERATE         2                        // [1/s] default drain rate
+#define QUEUE_BYTERATE         1024                        // [bytes/s] default drain rate
+#define QUEUE_FIELDLENGTH        32                        // longest field of queued message including terminator
+#define QUEUE_PAYLOADSIZE       448                        // [bytes] longest queued message, with its topic it has to fit MQTT_INFLIGHT_BUFFER, at most MQTT_PAYLOADSIZE
+
+struct QueueRecord {
+  uint32_t      time;                                      // [s] epoch of minute mean
+  uint32_t      channels;                                  // bit mask of history channels, one float each follows
+};
+
+struct QueueSent {
+  uint16_t      msgId;                                     // of QoS 1 publish
+  uint16_t      size;                                      // [bytes] of record in queue
+};
+
+void     initializeQueue(void);                            // size of queue file left from before reset
+void     updateQueue(void);                                // queue minute means of history, call when a minute closed and MQTT is down
+bool     drainQueue(void);                                 // remove acknowledged records, publish queued records as rate allows, false if nothing was sent
+void     flushQueue(void);                                 // move records in RAM to the queue file
+uint32_t queueDepth(void);                                 // records waiting
+void     queueJSON(char *payload, size_t len);             // queue metrics
+
+#endif
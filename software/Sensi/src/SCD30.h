@@ -21,9 +21,13 @@
 
 #define scd30_i2cspeed               I2C_REGULAR             
 #define scd30_i2cClockStretchLimit   I2C_LONGSTRETCH
+#define SCD30_COMMAND_DELAY          3000                  // [us] between command and reading the response
 
 bool      initializeSCD30(void);
 bool      updateSCD30(void);
+unsigned long nextSCD30(void);                             // [ms] until the state machine needs to run again
+uint8_t   readSCD30(void);                                 // split phase data ready and measurement, I2CMeasurementResults
+void      getSCD30Values(void);                            // copy measurement response to readings
 void      ICACHE_RAM_ATTR handleSCD30Interrupt(void);      // Interrupt service routine when data ready is signaled
 void      scd30JSON(char *payload, size_t len);                        // convert readings to serialized JSON
 void      scd30JSONMQTT(char *payload, size_t len);                    // convert readings to serialized JSON
@@ -27,6 +27,7 @@ enum SGP30SensorStates{SGP30_IS_IDLE = 0, SGP30_IS_MEASURING, SGP30_WAITING_FOR_
 
 bool initializeSGP30(void);
 bool updateSGP30(void);
+unsigned long nextSGP30(void);                             // [ms] until the state machine needs to run again
 void sgp30JSON(char *payload, size_t len);                  // convert readings to serialized JSON
 void sgp30JSONMQTT(char *payload, size_t len);              // convert readings to serialized JSON
 
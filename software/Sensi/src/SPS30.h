@@ -29,9 +29,21 @@
 #define sps30_i2cClockStretchLimit   I2C_LONGSTRETCH       // or I2C_DEFAULTSTRETCH
 #define SPS30_TIMEOUT_DELAY          100
 #define SPS30_ERROR_COUNT            24                    // 
+#define SPS30_ADDRESS              0x69                    // split phase reads bypass the library
+#define SPS30_DATAREADY          0x0202                    // read data ready flag, 1 word
+#define SPS30_MEASUREMENT        0x0300                    // read measured values, 10 floats
+#define SPS30_COMMAND_DELAY         500                    // [us] between command and reading the response
+#define SPS30_START              0x0010                    // start measurement, argument SPS30_FLOATFORMAT
+#define SPS30_FLOATFORMAT        0x0300                    // measured values as IEEE754 floats
+#define SPS30_RESET              0xD304                    // device reset
+#define SPS30_WAKE_DELAY             50                    // [ms] after wake up until start
+#define SPS30_RESET_DELAY           100                    // [ms] after reset until the sensor accepts commands
+#define SPS30_BUSRESET_DELAY       2000                    // [ms] after general call reset until it is probed again
 
 bool initializeSPS30(void);
 bool updateSPS30(void);
+unsigned long nextSPS30(void);                             // [ms] until the state machine needs to run again
+uint8_t readSPS30(void);                                   // split phase data ready and measurement, I2CMeasurementResults
 void sps30JSON(char *payload, size_t len);                 // convert readings to serialized JSON
 void sps30JSONMQTT(char *payload, size_t len);             // convert readings to serialized JSON
 
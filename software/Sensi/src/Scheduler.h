@@ -0,0 +1,39 @@
+/******************************************************************************************************/
+// Task Scheduler
+/******************************************************************************************************/
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+// The main loop no longer polls every subsystem on every pass.
+// Each subsystem registers an update function with its interval.
+// The tasks are kept in a min-heap ordered by their next deadline, the loop only runs what is due
+// and then idles until the next deadline.
+// A task is rescheduled one interval after it started, the same as setting lastX = currentTime in its own
+// interval checks, so a task registered at its real interval passes them.
+// Sensor state machines need short waits between their steps. Their task is woken with wakeTask() at the
+// time the next step is due, notifyTask() does the same from an interrupt service routine.
+
+#define MAXTASKS                     40                    // number of tasks that can be registered
+#define TASKBUDGET                   50                    // tasks taking longer than this [ms] are counted as overrun
+#define intervalNetService           10                    // 10ms, servicing of sockets (OTA, HTTP, WebSocket, Telnet, MQTT)
+#define intervalPoll                100                    // 0.1s, state machine waiting for a condition instead of a time
+
+struct Task {
+  void         (*run)(void);                               // update function
+  unsigned long  interval;                                 // [ms]
+  unsigned long  next;                                     // next deadline [ms]
+  unsigned long  overruns;                                 // how often did task exceed TASKBUDGET
+  uint8_t        profile;                                  // execution time is recorded in this profile
+};
+
+int  addTask(void (*run)(void), unsigned long interval, uint8_t profile); // returns task id or -1
+void setTaskInterval(int id, unsigned long interval);     // takes effect when task is rescheduled
+int  currentTask(void);                                    // id of the running task or -1
+void wakeTask(int id, unsigned long delay);                // run task within delay [ms] unless it is due earlier
+void notifyTask(int id);                                   // wakeTask(id, 0) from an interrupt service routine
+unsigned long dueIn(unsigned long since, unsigned long wait); // [ms] until (currentTime - since) > wait, intervalPoll if already passed
+void runTasks(void);                                       // executes all tasks that are due
+long timeToNextTask(void);                                 // ms until next deadline, 0 if a task is due
+void printTasks(void);                                     // lists tasks with interval and overruns
+
+#endif
@@ -70,7 +70,8 @@ enum SensorStates{IS_IDLE = 0, IS_MEASURING, IS_BUSY, DATA_AVAILABLE, GET_BASELI
 /******************************************************************************************************/
 unsigned long yieldOS(void);                                    // returns how long yield took
 bool checkI2C(uint8_t address, TwoWire *myWire);                // is device attached at this address?
-void switchI2C(TwoWire *myPort, int sdaPin, int sclPin, uint32_t i2cSpeed, uint32_t i2cStretch);
+void switchI2C(TwoWire *myPort, int sdaPin, int sclPin, uint32_t i2cSpeed, uint32_t i2cStretch); // reconfigures port if pins or clock changed
+void resetI2C(void);                                            // port configuration unknown, e.g. after begin() by a library
 void serialTrigger(const char* mess, int timeout);              // delays until user input
 bool inputHandle(void);                                         // hanldes user input
 void helpMenu(void);                                            // lists user functions
@@ -0,0 +1,79 @@
+/******************************************************************************************************/
+// Binary Telemetry
+/******************************************************************************************************/
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "History.h"
+
+// Sensor messages on MQTT and WebSocket are either JSON text or MessagePack, selected per transport.
+// A MessagePack message is a map from key to value:
+//   key:   history channel index, fixed by HistoryChannels
+//   value: int16 fixed point, reading = raw * scale + offset with scale and offset of the channel
+//          float32 when the reading does not fit into int16
+//          nil when the sensor has no reading
+// SCD30 as MessagePack: 83 00 d1 02 8a 01 d1 0f a0 02 d1 08 fc = {0:650, 1:4000, 2:2300} is 13 bytes instead of about 250.
+// The schema with names, scales and offsets is published retained to <main topic>/schema and served at /schema.
+// Time, date, weather and status messages stay JSON.
+//
+// Sensor messages of both encodings pass a publish policy, separately for MQTT and WebSocket:
+//   a reading is sent when a channel moved out of its deadband since the last message of the sensor,
+//   deadband = max(absolute, relative * last value, one count of the channel),
+//   not sooner than minInterval after the last message and at the latest after maxSilence (heartbeat).
+// Readings inside the deadband are dropped. The policy applies to single sensor messages, not to /data/all.
+
+#define TELEMETRY_MAXSIZE        128                       // [bytes] MessagePack message of all channels
+#define TELEMETRY_SCHEMAFIELDS   (HISTORY_CHANNELS+2)      // fields of the schema including opening and closing
+#define TELEMETRY_SCHEMALENGTH   96                        // longest field of the schema including terminator
+
+enum TelemetryEncodings{TELEMETRY_JSON = 0, TELEMETRY_MSGPACK};
+enum TelemetryTransports{TELEMETRY_MQTT = 0, TELEMETRY_WS, TELEMETRY_TRANSPORTS};
+enum TelemetrySensors{TELEMETRY_SENSOR_SCD30 = 0, TELEMETRY_SENSOR_SGP30, TELEMETRY_SENSOR_CCS811, TELEMETRY_SENSOR_SPS30,
+                      TELEMETRY_SENSOR_BME280, TELEMETRY_SENSOR_BME68X, TELEMETRY_SENSOR_MLX, TELEMETRY_SENSORS};
+
+// channels of each sensor message
+#define TELEMETRY_SCD30   ((1UL<<HISTORY_SCD30_CO2)  | (1UL<<HISTORY_SCD30_RH)   | (1UL<<HISTORY_SCD30_T))
+#define TELEMETRY_SGP30   ((1UL<<HISTORY_SGP30_ECO2) | (1UL<<HISTORY_SGP30_TVOC))
+#define TELEMETRY_CCS811  ((1UL<<HISTORY_CCS811_ECO2)| (1UL<<HISTORY_CCS811_TVOC))
+#define TELEMETRY_SPS30   ((1UL<<HISTORY_SPS30_PM1)  | (1UL<<HISTORY_SPS30_PM2)  | (1UL<<HISTORY_SPS30_PM4) | (1UL<<HISTORY_SPS30_PM10))
+#define TELEMETRY_BME280  ((1UL<<HISTORY_BME280_P)   | (1UL<<HISTORY_BME280_RH)  | (1UL<<HISTORY_BME280_T))
+#define TELEMETRY_BME68X  ((1UL<<HISTORY_BME68X_P)   | (1UL<<HISTORY_BME68X_RH)  | (1UL<<HISTORY_BME68X_T) | (1UL<<HISTORY_BME68X_RESISTANCE))
+#define TELEMETRY_MLX     ((1UL<<HISTORY_MLX_TO)     | (1UL<<HISTORY_MLX_TA))
+#define TELEMETRY_ALL     ((1UL<<HISTORY_CHANNELS)-1)
+
+#define TELEMETRY_SENSORNAMELENGTH  8                      // sensor name including terminator
+#define TELEMETRY_HEARTBEAT       600                      // [s] default maxSilence
+
+struct TelemetryBand {
+  float         absolute;                                  // [channel units] deadband
+  float         relative;                                  // [%] of the last value sent
+};
+
+struct TelemetryTiming {
+  uint16_t      minInterval;                               // [s] between messages, 0: as soon as the deadband is left
+  uint16_t      maxSilence;                                // [s] heartbeat, 0: only when the deadband is left
+};
+
+struct TelemetryState {
+  float         last[HISTORY_CHANNELS];                    // readings of the last message, NAN before the first
+  unsigned long lastTime[TELEMETRY_SENSORS];               // [ms] of the last message
+  uint32_t      sent;                                      // messages
+  uint32_t      dropped;                                   // readings inside the deadband
+};
+
+size_t   telemetryMsgPack(uint32_t channels, uint8_t *payload, size_t len);      // current readings of available channels, returns length
+size_t   telemetrySchemaJSON(uint8_t field, char *payload, size_t len);          // one field of the schema
+bool     publishTelemetryMQTT(const char *topic, uint32_t channels);             // publish readings as MessagePack
+bool     publishTelemetrySchema(void);                                           // publish schema retained
+size_t   broadcastTelemetryWS(uint32_t channels);                                // send readings as MessagePack to websocket clients, returns length
+const char *telemetryEncodingName(uint8_t encoding);                             // "JSON" or "MessagePack"
+void     initializeTelemetry(void);                                              // nothing sent yet, the policy is kept in the settings
+bool     telemetryDue(uint8_t transport, uint8_t sensor);                        // reading of sensor should be sent
+void     telemetrySent(uint8_t transport, uint8_t sensor);                       // remember reading as sent
+bool     telemetryFilter(uint8_t transport, uint8_t sensor, bool *newData);      // clears newData when the reading is not due, returns newData
+int8_t   telemetrySensor(const char *name);                                      // sensor index, -1 if unknown
+bool     setTelemetryBand(const char *channel, float absolute, float relative);  // deadband of channel, false if unknown
+bool     setTelemetryTiming(const char *sensor, uint16_t minInterval, uint16_t maxSilence); // intervals of sensor, false if unknown
+void     printTelemetryPolicy(void);                                             // policy and counters on terminal
+
+#endif
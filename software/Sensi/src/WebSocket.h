@@ -14,5 +14,6 @@ void updateWebSocket(void);
 void hexdump(const void *mem, uint32_t len, uint8_t cols);
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t lenght);
 void updateWebSocketMessage(void);
+void sendSnapshotWS(uint8_t num, uint32_t seq, bool resume); // available blocks to one client, only those broadcast after seq when resuming
 
 #endif
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Merge the Sensi sketch into a single C++ translation unit the way the Arduino builder does.
+
+The main sketch is placed first, the other .ino files follow in alphabetical order.
+Prototypes of all functions defined in the sketch are inserted ahead of the first function
+definition so that functions can be used before they are defined.
+"""
+import os
+import re
+import sys
+
+KEYWORDS = {'if', 'for', 'while', 'switch', 'else', 'return', 'do', 'case'}
+DEFINITION = re.compile(r'^([A-Za-z_][\w:<>\*&\s]*?[\s\*&])(\w+)\s*\(([^()]*)\)\s*\{')
+
+
+def sketch_files(sketch_dir, main):
+    files = sorted(f for f in os.listdir(sketch_dir) if f.endswith('.ino') and f != main)
+    return [main] + files
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: ino2cpp.py <sketch dir> <output.cpp>')
+    sketch_dir, output = sys.argv[1], sys.argv[2]
+    main_ino = os.path.basename(os.path.abspath(sketch_dir)) + '.ino'
+
+    body = []
+    prototypes = []
+    first_definition = None
+    for name in sketch_files(sketch_dir, main_ino):
+        path = os.path.abspath(os.path.join(sketch_dir, name))
+        body.append('#line 1 "%s"\n' % path)
+        with open(path) as f:
+            for number, line in enumerate(f, 1):
+                match = DEFINITION.match(line)
+                if match and match.group(2) not in KEYWORDS and not match.group(1).strip().startswith(('return', 'else')):
+                    prototypes.append('%s%s(%s);\n' % (match.group(1), match.group(2), match.group(3)))
+                    if first_definition is None:
+                        first_definition = len(body)
+                        first_line = '#line %d "%s"\n' % (number, path)
+                body.append(line)
+        body.append('\n')
+
+    merged = ['#include <Arduino.h>\n']
+    if first_definition is None:
+        merged += body
+    else:
+        merged += body[:first_definition]
+        merged += prototypes
+        merged.append(first_line)  # compiler messages refer to the sketch lines
+        merged += body[first_definition:]
+
+    with open(output, 'w') as f:
+        f.writelines(merged)
+
+
+if __name__ == '__main__':
+    main()
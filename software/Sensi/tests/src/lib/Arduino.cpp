@@ -0,0 +1,343 @@
+#include "Arduino.h"
+#include <new>
+
+/******************************************************************************************************/
+// Simulated time
+/******************************************************************************************************/
+
+static uint64_t simulatedMicros = 0;
+
+uint64_t host::now(void)            { return simulatedMicros; }
+void     host::advance(uint64_t us) { simulatedMicros += us; }
+
+unsigned long micros(void) { simulatedMicros += HOST_TICK; return (unsigned long)(uint32_t)simulatedMicros; }
+unsigned long millis(void) { simulatedMicros += HOST_TICK; return (unsigned long)(uint32_t)(simulatedMicros / 1000); }
+void delay(unsigned long ms)            { simulatedMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { simulatedMicros += us; }
+void yield(void)                        { simulatedMicros += HOST_TICK; }
+void esp_yield(void)                    { yield(); }
+
+/******************************************************************************************************/
+// Heap accounting
+/******************************************************************************************************/
+// Each allocation carries its size in front of the returned block
+
+static size_t heapUsedBytes = 0;
+static size_t heapPeakBytes = 0;
+bool          host::heapCounted = true;
+
+size_t host::heapUsed(void)      { return heapUsedBytes; }
+size_t host::heapPeak(void)      { return heapPeakBytes; }
+void   host::resetHeapPeak(void) { heapPeakBytes = heapUsedBytes; }
+
+static void *hostAllocate(size_t size) {
+  max_align_t *block = (max_align_t *)malloc(size + sizeof(max_align_t));
+  if (block == nullptr) { return nullptr; }
+  if (!host::heapCounted) { size = 0; }                          // freed without being counted either
+  *(size_t *)block = size;
+  heapUsedBytes += size;
+  if (heapUsedBytes > heapPeakBytes) { heapPeakBytes = heapUsedBytes; }
+  return block + 1;
+}
+
+static void hostFree(void *ptr) {
+  if (ptr == nullptr) { return; }
+  max_align_t *block = (max_align_t *)ptr - 1;
+  heapUsedBytes -= *(size_t *)block;
+  free(block);
+}
+
+void *operator new(size_t size)                                  { void *p = hostAllocate(size); if (!p) { throw std::bad_alloc(); } return p; }
+void *operator new[](size_t size)                                { void *p = hostAllocate(size); if (!p) { throw std::bad_alloc(); } return p; }
+void *operator new(size_t size, const std::nothrow_t &) noexcept   { return hostAllocate(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return hostAllocate(size); }
+void  operator delete(void *ptr) noexcept                        { hostFree(ptr); }
+void  operator delete[](void *ptr) noexcept                      { hostFree(ptr); }
+void  operator delete(void *ptr, size_t) noexcept                { hostFree(ptr); }
+void  operator delete[](void *ptr, size_t) noexcept              { hostFree(ptr); }
+
+/******************************************************************************************************/
+// ESP
+/******************************************************************************************************/
+
+EspClass ESP;
+bool     host::restartRequested = false;
+
+uint32_t EspClass::getFreeHeap(void) {
+  return (heapUsedBytes < HOST_HEAPSIZE) ? (uint32_t)(HOST_HEAPSIZE - heapUsedBytes) : 0;
+}
+
+void EspClass::getHeapStats(uint32_t *free, uint16_t *max, uint8_t *frag) {
+  if (free) { *free = getFreeHeap(); }
+  if (max)  { *max  = (uint16_t)std::min<uint32_t>(getFreeHeap(), 0xFFFF); }
+  if (frag) { *frag = 0; }
+}
+
+uint32_t EspClass::getCycleCount(void) { return (uint32_t)(host::now() * 80); }
+void     EspClass::reset(void)         { host::restartRequested = true; }
+void     EspClass::restart(void)       { host::restartRequested = true; }
+
+/******************************************************************************************************/
+// GPIO and helpers
+/******************************************************************************************************/
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int  digitalRead(uint8_t) { return LOW; }
+int  analogRead(uint8_t) { return 0; }
+static void (*isrs[32])(void) = {nullptr};
+void attachInterrupt(uint8_t pin, void (*isr)(void), int) { if (pin < 32) { isrs[pin] = isr; } }
+void detachInterrupt(uint8_t pin) { if (pin < 32) { isrs[pin] = nullptr; } }
+void host::interrupt(uint8_t pin) { if ((pin < 32) && isrs[pin]) { isrs[pin](); } }
+void interrupts(void) {}
+void noInterrupts(void) {}
+
+static uint32_t randomState = 1;
+static uint32_t nextRandom(void) { randomState = randomState * 1103515245 + 12345; return randomState >> 1; }
+long random(long howbig) { return (howbig <= 0) ? 0 : (long)(nextRandom() % howbig); }
+long random(long howsmall, long howbig) { return (howsmall >= howbig) ? howsmall : howsmall + random(howbig - howsmall); }
+void randomSeed(unsigned long seed) { if (seed) { randomState = seed; } }
+long map(long x, long in_min, long in_max, long out_min, long out_max) { return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min; }
+
+size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size) { size_t n = (len >= size) ? size - 1 : len; memcpy(dst, src, n); dst[n] = '\0'; }
+  return len;
+}
+
+size_t strlcat(char *dst, const char *src, size_t size) {
+  size_t dlen = strnlen(dst, size);
+  if (dlen == size) { return size + strlen(src); }
+  return dlen + strlcpy(dst + dlen, src, size - dlen);
+}
+
+static char *unsignedToString(unsigned long value, char *str, int base) {
+  char buf[8 * sizeof(long) + 1];
+  int  i = 0;
+  do { int d = value % base; buf[i++] = (char)(d < 10 ? '0' + d : 'a' + d - 10); value /= base; } while (value);
+  int j = 0;
+  while (i) { str[j++] = buf[--i]; }
+  str[j] = '\0';
+  return str;
+}
+
+char *ultoa(unsigned long value, char *str, int base) { return unsignedToString(value, str, base); }
+char *utoa(unsigned value, char *str, int base)       { return unsignedToString(value, str, base); }
+char *ltoa(long value, char *str, int base) {
+  if ((value < 0) && (base == 10)) { str[0] = '-'; unsignedToString((unsigned long)(-value), str + 1, base); return str; }
+  return unsignedToString((unsigned long)value, str, base);
+}
+char *itoa(int value, char *str, int base) { return ltoa(value, str, base); }
+char *dtostrf(double value, signed char width, unsigned char prec, char *s) { sprintf(s, "%*.*f", width, prec, value); return s; }
+
+/******************************************************************************************************/
+// String
+/******************************************************************************************************/
+
+static std::string numberToString(unsigned long value, unsigned char base, bool negative) {
+  char buf[8 * sizeof(long) + 2];
+  if (negative) { buf[0] = '-'; unsignedToString(value, buf + 1, base); }
+  else          { unsignedToString(value, buf, base); }
+  return std::string(buf);
+}
+
+static std::string floatToString(double value, unsigned char decimalPlaces) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  return std::string(buf);
+}
+
+String::String(unsigned char value, unsigned char base) : _s(numberToString(value, base, false)) {}
+String::String(int value, unsigned char base)           : _s((value < 0 && base == 10) ? numberToString((unsigned long)(-(long)value), base, true) : numberToString((unsigned int)value, base, false)) {}
+String::String(unsigned int value, unsigned char base)  : _s(numberToString(value, base, false)) {}
+String::String(long value, unsigned char base)          : _s((value < 0 && base == 10) ? numberToString((unsigned long)(-value), base, true) : numberToString((unsigned long)value, base, false)) {}
+String::String(unsigned long value, unsigned char base) : _s(numberToString(value, base, false)) {}
+String::String(float value, unsigned char decimalPlaces)  : _s(floatToString(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : _s(floatToString(value, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String &s) const {
+  if (_s.length() != s._s.length()) { return false; }
+  for (size_t i = 0; i < _s.length(); i++) { if (tolower(_s[i]) != tolower(s._s[i])) { return false; } }
+  return true;
+}
+
+bool String::endsWith(const String &suffix) const {
+  if (suffix._s.length() > _s.length()) { return false; }
+  return _s.compare(_s.length() - suffix._s.length(), suffix._s.length(), suffix._s) == 0;
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const {
+  if (!bufsize || !buf) { return; }
+  if (index >= _s.length()) { buf[0] = 0; return; }
+  unsigned int n = std::min<unsigned int>(bufsize - 1, _s.length() - index);
+  memcpy(buf, _s.c_str() + index, n);
+  buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const { size_t p = _s.find(ch, fromIndex); return p == std::string::npos ? -1 : (int)p; }
+int String::indexOf(const String &str, unsigned int fromIndex) const { size_t p = _s.find(str._s, fromIndex); return p == std::string::npos ? -1 : (int)p; }
+int String::lastIndexOf(char ch) const { size_t p = _s.rfind(ch); return p == std::string::npos ? -1 : (int)p; }
+int String::lastIndexOf(const String &str) const { size_t p = _s.rfind(str._s); return p == std::string::npos ? -1 : (int)p; }
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) { std::swap(beginIndex, endIndex); }
+  if (beginIndex >= _s.length()) { return String(); }
+  if (endIndex > _s.length()) { endIndex = _s.length(); }
+  return String(_s.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::replace(char find, char replace) { for (auto &c : _s) { if (c == find) { c = replace; } } }
+void String::replace(const String &find, const String &replace) {
+  if (find._s.empty()) { return; }
+  size_t pos = 0;
+  while ((pos = _s.find(find._s, pos)) != std::string::npos) { _s.replace(pos, find._s.length(), replace._s); pos += replace._s.length(); }
+}
+void String::toLowerCase(void) { for (auto &c : _s) { c = (char)tolower(c); } }
+void String::toUpperCase(void) { for (auto &c : _s) { c = (char)toupper(c); } }
+void String::trim(void) {
+  size_t b = _s.find_first_not_of(" \t\r\n");
+  if (b == std::string::npos) { _s.clear(); return; }
+  size_t e = _s.find_last_not_of(" \t\r\n");
+  _s = _s.substr(b, e - b + 1);
+}
+
+String operator + (const String &lhs, const String &rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, const char *rhs)   { String s(lhs); s.concat(rhs); return s; }
+String operator + (const char *lhs, const String &rhs)   { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, char rhs)          { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, int rhs)           { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, unsigned int rhs)  { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, long rhs)          { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, unsigned long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, float rhs)         { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, double rhs)        { String s(lhs); s.concat(rhs); return s; }
+String operator + (const String &lhs, const __FlashStringHelper *rhs) { String s(lhs); s.concat(rhs); return s; }
+
+/******************************************************************************************************/
+// Print
+/******************************************************************************************************/
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) { n += write(*buffer++); }
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char    buf[256];
+  va_list arg;
+  va_start(arg, format);
+  int len = vsnprintf(buf, sizeof(buf), format, arg);
+  va_end(arg);
+  if (len < 0) { return 0; }
+  if ((size_t)len >= sizeof(buf)) {
+    std::string big(len + 1, '\0');
+    va_start(arg, format);
+    vsnprintf(&big[0], big.size(), format, arg);
+    va_end(arg);
+    return write((const uint8_t *)big.c_str(), len);
+  }
+  return write((const uint8_t *)buf, len);
+}
+
+size_t Print::print(const __FlashStringHelper *str) { return write(reinterpret_cast<const char *>(str)); }
+size_t Print::print(long value, int base)           { return print(String(value, (unsigned char)base)); }
+size_t Print::print(unsigned long value, int base)  { return print(String(value, (unsigned char)base)); }
+size_t Print::print(double value, int digits)       { return print(String(value, (unsigned char)digits)); }
+
+/******************************************************************************************************/
+// Stream
+/******************************************************************************************************/
+// Reads do not wait, on the host all data is available immediately or never
+
+int Stream::timedRead() { return read(); }
+int Stream::timedPeek() { return peek(); }
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) { int c = timedRead(); if (c < 0) { break; } *buffer++ = (char)c; count++; }
+  return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
+  size_t index = 0;
+  while (index < length) { int c = timedRead(); if (c < 0 || c == terminator) { break; } *buffer++ = (char)c; index++; }
+  return index;
+}
+
+String Stream::readString() {
+  String ret;
+  int c;
+  while ((c = timedRead()) >= 0) { ret += (char)c; }
+  return ret;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String ret;
+  int c;
+  while ((c = timedRead()) >= 0 && c != terminator) { ret += (char)c; }
+  return ret;
+}
+
+bool Stream::find(const char *target) {
+  size_t len = strlen(target), matched = 0;
+  int c;
+  while ((c = timedRead()) >= 0) {
+    matched = (c == target[matched]) ? matched + 1 : ((c == target[0]) ? 1 : 0);
+    if (matched == len) { return true; }
+  }
+  return false;
+}
+
+long Stream::parseInt() {
+  int c;
+  while ((c = timedPeek()) >= 0 && !(isdigit(c) || c == '-')) { read(); }
+  String num;
+  while ((c = timedPeek()) >= 0 && (isdigit(c) || (c == '-' && num.length() == 0))) { num += (char)read(); }
+  return num.toInt();
+}
+
+float Stream::parseFloat() {
+  int c;
+  while ((c = timedPeek()) >= 0 && !(isdigit(c) || c == '-' || c == '.')) { read(); }
+  String num;
+  while ((c = timedPeek()) >= 0 && (isdigit(c) || c == '-' || c == '.')) { num += (char)read(); }
+  return num.toFloat();
+}
+
+/******************************************************************************************************/
+// Serial
+/******************************************************************************************************/
+
+HardwareSerial Serial;
+bool host::serialEcho = true;
+
+void host::serialInput(const char *text) { Serial.input += text; }
+
+int HardwareSerial::available() { return (int)input.size(); }
+int HardwareSerial::read() { if (input.empty()) { return -1; } int c = (uint8_t)input[0]; input.erase(0, 1); return c; }
+int HardwareSerial::peek() { return input.empty() ? -1 : (uint8_t)input[0]; }
+size_t HardwareSerial::write(uint8_t c) { if (host::serialEcho) { fputc(c, stdout); } return 1; }
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) { if (host::serialEcho) { fwrite(buffer, 1, size, stdout); } return size; }
+void HardwareSerial::flush() { if (host::serialEcho) { fflush(stdout); } }
+
+/******************************************************************************************************/
+// Wall clock
+/******************************************************************************************************/
+// The libc clock is replaced so that localtime() and NTP follow the simulated time
+
+#define HOST_EPOCH 1767225600                                      // 2026-01-01 00:00:00 UTC
+
+extern "C" time_t time(time_t *t) noexcept {
+  time_t now = HOST_EPOCH + (time_t)(simulatedMicros / 1000000);
+  if (t) { *t = now; }
+  return now;
+}
+
+// glibc declares tv nonnull
+extern "C" int gettimeofday(struct timeval *tv, void *tz) noexcept {
+  (void)tz;
+  tv->tv_sec  = HOST_EPOCH + (time_t)(simulatedMicros / 1000000);
+  tv->tv_usec = (suseconds_t)(simulatedMicros % 1000000);
+  return 0;
+}
@@ -0,0 +1,154 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// Host implementation of the parts of the ESP8266 Arduino core used by Sensi.
+// Time is simulated: it only advances through delay(), yield(), bus transactions and a small
+// tick on each millis()/micros() call, so runs are deterministic.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <functional>
+
+#ifndef ARDUINO
+#define ARDUINO 10819
+#endif
+#ifndef ESP8266
+#define ESP8266
+#endif
+#define ARDUINO_ARCH_ESP8266
+
+typedef uint8_t byte;
+typedef bool    boolean;
+typedef unsigned int word;
+
+#define HIGH          0x1
+#define LOW           0x0
+#define INPUT         0x00
+#define OUTPUT        0x01
+#define INPUT_PULLUP  0x02
+#define RISING        0x01
+#define FALLING       0x02
+#define CHANGE        0x03
+#define LSBFIRST      0
+#define MSBFIRST      1
+#define DEC           10
+#define HEX           16
+#define OCT           8
+#define BIN           2
+
+// NodeMCU pin names
+#define D0 16
+#define D1  5
+#define D2  4
+#define D3  0
+#define D4  2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+#define LED_BUILTIN 2
+#define SDA 4
+#define SCL 5
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+#define ICACHE_FLASH_ATTR
+
+// Program memory is ordinary memory on the host
+#define PROGMEM
+#define PGM_P                const char *
+#define PGM_VOID_P           const void *
+#define PSTR(s)              (s)
+class __FlashStringHelper;
+#define FPSTR(p)             (reinterpret_cast<const __FlashStringHelper *>(p))
+#define F(s)                 FPSTR(PSTR(s))
+#define pgm_read_byte(a)     (*(const uint8_t *)(a))
+#define pgm_read_byte_near(a) pgm_read_byte(a)
+#define pgm_read_word(a)     (*(const uint16_t *)(a))
+#define pgm_read_dword(a)    (*(const uint32_t *)(a))
+#define pgm_read_float(a)    (*(const float *)(a))
+#define pgm_read_ptr(a)      (*(void * const *)(a))
+#define snprintf_P           snprintf
+#define sprintf_P            sprintf
+#define vsnprintf_P          vsnprintf
+#define printf_P             printf
+#define strcpy_P             strcpy
+#define strncpy_P            strncpy
+#define strcat_P             strcat
+#define strncat_P            strncat
+#define strcmp_P             strcmp
+#define strncmp_P            strncmp
+#define strcasecmp_P         strcasecmp
+#define strlen_P             strlen
+#define strnlen_P            strnlen
+#define strstr_P             strstr
+#define memcpy_P             memcpy
+#define memcmp_P             memcmp
+
+size_t strlcpy(char *dst, const char *src, size_t size);
+size_t strlcat(char *dst, const char *src, size_t size);
+char  *itoa(int value, char *str, int base);
+char  *ltoa(long value, char *str, int base);
+char  *utoa(unsigned value, char *str, int base);
+char  *ultoa(unsigned long value, char *str, int base);
+char  *dtostrf(double value, signed char width, unsigned char prec, char *s);
+
+using std::min;
+using std::max;
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define sq(x)                   ((x)*(x))
+#define radians(deg)            ((deg)*DEG_TO_RAD)
+#define degrees(rad)            ((rad)*RAD_TO_DEG)
+#define DEG_TO_RAD              0.017453292519943295769236907684886
+#define RAD_TO_DEG              57.295779513082320876798154814105
+#define lowByte(w)              ((uint8_t) ((w) & 0xff))
+#define highByte(w)             ((uint8_t) ((w) >> 8))
+#define bitRead(value, bit)     (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit)      ((value) |= (1UL << (bit)))
+#define bitClear(value, bit)    ((value) &= ~(1UL << (bit)))
+#define bit(b)                  (1UL << (b))
+#define digitalPinToInterrupt(p) (p)
+
+// Time
+unsigned long millis(void);
+unsigned long micros(void);
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+void          yield(void);
+void          esp_yield(void);
+
+// GPIO, no hardware attached
+void          pinMode(uint8_t pin, uint8_t mode);
+void          digitalWrite(uint8_t pin, uint8_t val);
+int           digitalRead(uint8_t pin);
+int           analogRead(uint8_t pin);
+void          attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void          detachInterrupt(uint8_t pin);
+void          interrupts(void);
+void          noInterrupts(void);
+
+long          random(long howbig);
+long          random(long howsmall, long howbig);
+void          randomSeed(unsigned long seed);
+long          map(long x, long in_min, long in_max, long out_min, long out_max);
+
+void          setup(void);
+void          loop(void);
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "Esp.h"
+#include "Host.h"
+
+#endif // Arduino_h
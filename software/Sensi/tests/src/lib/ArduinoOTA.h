@@ -0,0 +1,33 @@
+#ifndef ArduinoOTA_h
+#define ArduinoOTA_h
+
+#include "ESP8266WiFi.h"
+
+#define U_FLASH   0
+#define U_FS      100
+
+typedef enum { OTA_AUTH_ERROR, OTA_BEGIN_ERROR, OTA_CONNECT_ERROR, OTA_RECEIVE_ERROR, OTA_END_ERROR } ota_error_t;
+
+// No update is ever offered on the host
+class ArduinoOTAClass {
+  public:
+    void setPort(uint16_t port) { (void)port; }
+    void setHostname(const char *hostname) { (void)hostname; }
+    void setPassword(const char *password) { (void)password; }
+    void onStart(std::function<void(void)> fn) { _start = fn; }
+    void onEnd(std::function<void(void)> fn) { _end = fn; }
+    void onProgress(std::function<void(unsigned int, unsigned int)> fn) { _progress = fn; }
+    void onError(std::function<void(ota_error_t)> fn) { _error = fn; }
+    void begin(bool useMDNS = true) { (void)useMDNS; }
+    void handle() {}
+    int  getCommand() { return U_FLASH; }
+
+  private:
+    std::function<void(void)> _start, _end;
+    std::function<void(unsigned int, unsigned int)> _progress;
+    std::function<void(ota_error_t)> _error;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef EEPROM_h
+#define EEPROM_h
+
+// Emulated EEPROM, commit() copies the RAM image to "flash" and counts the bytes written
+
+#include <vector>
+#include "Arduino.h"
+
+class EEPROMClass {
+  public:
+    void    begin(size_t size) { _data.resize(size, 0xFF); if (_flash.size() < size) { _flash.resize(size, 0xFF); } memcpy(_data.data(), _flash.data(), size); }
+    bool    commit() { if (_data.empty()) { return false; } _flash = _data; _commits++; _bytesWritten += _data.size(); host::advance(_data.size() * 10); return true; }
+    bool    end() { bool ok = commit(); _data.clear(); return ok; }
+    uint8_t read(int address) { return ((size_t)address < _data.size()) ? _data[address] : 0; }
+    void    write(int address, uint8_t value) { if ((size_t)address < _data.size()) { _data[address] = value; } }
+    uint8_t *getDataPtr() { return _data.data(); }
+    size_t  length() { return _data.size(); }
+    template <typename T> T &get(int address, T &t) { if (address + sizeof(T) <= _data.size()) { memcpy((void *)&t, _data.data() + address, sizeof(T)); } return t; }
+    template <typename T> const T &put(int address, const T &t) { if (address + sizeof(T) <= _data.size()) { memcpy(_data.data() + address, (const void *)&t, sizeof(T)); } return t; }
+
+    uint32_t commits() const { return _commits; }
+    uint64_t bytesWritten() const { return _bytesWritten; }
+
+  private:
+    std::vector<uint8_t> _data;
+    std::vector<uint8_t> _flash;
+    uint32_t _commits = 0;
+    uint64_t _bytesWritten = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
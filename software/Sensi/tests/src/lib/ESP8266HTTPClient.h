@@ -0,0 +1,32 @@
+#ifndef ESP8266HTTPClient_h
+#define ESP8266HTTPClient_h
+
+// HTTP client answered by host::httpGet, without it every request fails to connect
+
+#include "ESP8266WiFi.h"
+
+#define HTTPC_ERROR_CONNECTION_FAILED (-1)
+#define HTTP_CODE_OK 200
+
+class HTTPClient {
+  public:
+    bool    begin(WiFiClient &client, const String &url) { _client = &client; _url = url; return true; }
+    void    end() { if (_client) { _client->stop(); } _client = nullptr; }
+    void    useHTTP10(bool usehttp10 = true) { (void)usehttp10; }
+    void    setTimeout(uint16_t timeout) { (void)timeout; }
+    int     GET();
+    String  getString();
+    WiFiClient &getStream() { return *_client; }
+    int     getSize() { return _client ? _client->available() : -1; }
+
+  private:
+    WiFiClient *_client = nullptr;
+    String      _url;
+};
+
+namespace host {
+  // returns the HTTP status code and fills body
+  extern std::function<int(const String &url, std::string &body)> httpGet;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef ESP8266HTTPUpdateServer_h
+#define ESP8266HTTPUpdateServer_h
+
+#include "ESP8266WebServer.h"
+
+class ESP8266HTTPUpdateServer {
+  public:
+    void setup(ESP8266WebServer *server, const String &path, const String &username, const String &password) {
+      (void)username; (void)password;
+      server->on(path, HTTP_GET, [server]() { server->send(200, "text/html", "update"); });
+    }
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "ESP8266WebServer.h"
+
+void ESP8266WebServer::request(HTTPMethod method, const String &uri, const std::vector<std::pair<String, String>> &args,
+                               const std::vector<std::pair<String, String>> &headers) {
+  _queue.push_back({method, uri, args, headers});
+}
+
+void ESP8266WebServer::handleClient() {
+  if (!_running || _queue.empty()) { return; }
+  Request req = _queue.front();
+  _queue.pop_front();
+  _uri           = req.uri;
+  _method        = req.method;
+  _args          = req.args;
+  _headers       = req.headers;
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _response      = HTTPResponse();
+  _served++;
+  for (auto &route : _routes) {
+    if ((route.uri == _uri) && ((route.method == HTTP_ANY) || (route.method == _method))) {
+      route.fn();
+      return;
+    }
+  }
+  if (_notFound) { _notFound(); }
+  else           { send(404, "text/plain", String("Not found: ") + _uri); }
+}
+
+String ESP8266WebServer::arg(const String &name) {
+  for (auto &a : _args) { if (a.first == name) { return a.second; } }
+  return String();
+}
+
+// like the ESP8266 server only headers named in collectHeaders() are kept
+String ESP8266WebServer::header(const String &name) {
+  bool collected = false;
+  for (auto &c : _collect) { if (c.equalsIgnoreCase(name)) { collected = true; } }
+  if (!collected) { return String(); }
+  for (auto &h : _headers) { if (h.first.equalsIgnoreCase(name)) { return h.second; } }
+  return String();
+}
+
+bool ESP8266WebServer::hasArg(const String &name) {
+  for (auto &a : _args) { if (a.first == name) { return true; } }
+  return false;
+}
+
+void ESP8266WebServer::sendHeader(const String &name, const String &value, bool first) {
+  std::string line = std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+  if (first) { _response.headers.insert(0, line); }
+  else       { _response.headers += line; }
+}
+
+void ESP8266WebServer::send(int code, const char *contentType, const String &content) {
+  _response.code        = code;
+  _response.contentType = contentType ? contentType : "";
+  _response.chunked     = (_contentLength == CONTENT_LENGTH_UNKNOWN);
+  _response.body.assign(content.c_str(), content.length());
+  _bytesSent += 64 + _response.headers.size() + content.length();  // status line and fixed headers
+}
+
+// in chunked mode an empty chunk ends the response
+void ESP8266WebServer::sendContent(const char *content, size_t size) {
+  _response.body.append(content, size);
+  _bytesSent += size + (_response.chunked ? 8 : 0);
+}
+
+size_t ESP8266WebServer::streamFile(File &file, const String &contentType) {
+  _contentLength = file.size();
+  send(200, contentType.c_str(), String());
+  uint8_t buf[256];
+  size_t  total = 0;
+  int     n;
+  while ((n = file.read(buf, sizeof(buf))) > 0) { sendContent((const char *)buf, n); total += n; }
+  return total;
+}
@@ -0,0 +1,118 @@
+#ifndef ESP8266WebServer_h
+#define ESP8266WebServer_h
+
+// HTTP server without sockets
+//
+// Requests are queued with request() and served one per handleClient() call, so their cost shows
+// up in the task that polls the server. The last response is kept for inspection.
+
+#include <deque>
+#include <vector>
+#include "ESP8266WiFi.h"
+#include "FS.h"
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+#define HTTP_UPLOAD_BUFLEN 2048
+
+typedef struct {
+  HTTPUploadStatus status;
+  String  filename;
+  String  name;
+  String  type;
+  size_t  totalSize;
+  size_t  currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+} HTTPUpload;
+
+struct HTTPResponse {
+  int         code = 0;
+  String      contentType;
+  std::string headers;
+  std::string body;
+  bool        chunked = false;
+};
+
+class ESP8266WebServer {
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    ESP8266WebServer(int port = 80) : _port(port) {}
+    void    begin() { _running = true; }
+    void    begin(uint16_t port) { _port = port; begin(); }
+    void    stop() { _running = false; }
+    void    close() { stop(); }
+    void    handleClient();
+    void    on(const String &uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void    on(const String &uri, HTTPMethod method, THandlerFunction fn) { _routes.push_back({uri, method, fn, nullptr}); }
+    void    on(const String &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) { _routes.push_back({uri, method, fn, ufn}); }
+    void    onNotFound(THandlerFunction fn) { _notFound = fn; }
+
+    String  uri() { return _uri; }
+    HTTPMethod method() { return _method; }
+    int     args() { return (int)_args.size(); }
+    String  arg(int i) { return ((size_t)i < _args.size()) ? _args[i].second : String(); }
+    String  arg(const String &name);
+    String  argName(int i) { return ((size_t)i < _args.size()) ? _args[i].first : String(); }
+    bool    hasArg(const String &name);
+    String  header(const String &name);
+    void    collectHeaders(const char *headerKeys[], const size_t headerKeysCount) { _collect.assign(headerKeys, headerKeys + headerKeysCount); }
+    HTTPUpload &upload() { return _upload; }
+    WiFiClient &client() { return _client; }
+
+    void    setContentLength(size_t contentLength) { _contentLength = contentLength; }
+    void    sendHeader(const String &name, const String &value, bool first = false);
+    void    send(int code, const char *contentType = nullptr, const String &content = String());
+    void    send(int code, const String &contentType, const String &content) { send(code, contentType.c_str(), content); }
+    void    send(int code, const char *contentType, const char *content) { send(code, contentType, String(content)); }
+    void    send_P(int code, PGM_P contentType, PGM_P content) { send(code, contentType, String(content)); }
+    void    sendContent(const String &content) { sendContent(content.c_str(), content.length()); }
+    void    sendContent(const char *content) { sendContent(content, strlen(content)); }
+    void    sendContent(const char *content, size_t size);
+    void    sendContent_P(PGM_P content) { sendContent(content); }
+    size_t  streamFile(File &file, const String &contentType);
+
+    // host side
+    void    request(HTTPMethod method, const String &uri, const std::vector<std::pair<String, String>> &args = {},
+                    const std::vector<std::pair<String, String>> &headers = {});
+    size_t  pending() const { return _queue.size(); }
+    const HTTPResponse &response() const { return _response; }
+    uint32_t served() const { return _served; }
+    uint64_t bytesSent() const { return _bytesSent; }
+
+  private:
+    struct Route {
+      String           uri;
+      HTTPMethod       method;
+      THandlerFunction fn;
+      THandlerFunction ufn;
+    };
+    struct Request {
+      HTTPMethod       method;
+      String           uri;
+      std::vector<std::pair<String, String>> args;
+      std::vector<std::pair<String, String>> headers;
+    };
+
+    int        _port;
+    bool       _running = false;
+    std::vector<Route>   _routes;
+    THandlerFunction     _notFound;
+    std::deque<Request>  _queue;
+    String     _uri;
+    HTTPMethod _method = HTTP_GET;
+    std::vector<std::pair<String, String>> _args;
+    std::vector<std::pair<String, String>> _headers;
+    std::vector<String>  _collect;
+    HTTPUpload _upload;
+    WiFiClient _client;
+    size_t     _contentLength = CONTENT_LENGTH_NOT_SET;
+    HTTPResponse _response;
+    uint32_t   _served = 0;
+    uint64_t   _bytesSent = 0;
+};
+
+#endif
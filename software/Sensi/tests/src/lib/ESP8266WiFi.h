@@ -0,0 +1,49 @@
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+// Station interface, connected whenever host::wifiConnected is set
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+#include "WiFiUdp.h"
+
+typedef enum {
+  WL_NO_SHIELD = 255, WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_CONNECTION_LOST = 5, WL_WRONG_PASSWORD = 6, WL_DISCONNECTED = 7
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } WiFiMode_t;
+
+class ESP8266WiFiClass {
+  public:
+    wl_status_t status() { return (host::wifiConnected && (_mode & WIFI_STA)) ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool        mode(WiFiMode_t mode) { _mode = mode; return true; }
+    WiFiMode_t  getMode() { return _mode; }
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr) { (void)passphrase; _ssid = ssid; return status(); }
+    bool        disconnect(bool wifioff = false) { if (wifioff) { _mode = WIFI_OFF; } return true; }
+    bool        isConnected() { return status() == WL_CONNECTED; }
+    bool        hostname(const char *name) { _hostname = name; return true; }
+    const char *getHostname() { return _hostname.c_str(); }
+    bool        setAutoReconnect(bool) { return true; }
+    bool        persistent(bool) { return true; }
+    IPAddress   localIP() { return isConnected() ? IPAddress(192, 168, 1, 100) : IPAddress(); }
+    IPAddress   gatewayIP() { return IPAddress(192, 168, 1, 1); }
+    IPAddress   subnetMask() { return IPAddress(255, 255, 255, 0); }
+    uint8_t    *macAddress(uint8_t *mac) { static const uint8_t m[6] = {0x5c, 0xcf, 0x7f, 0x00, 0x00, 0x01}; memcpy(mac, m, 6); return mac; }
+    String      macAddress() { return String("5C:CF:7F:00:00:01"); }
+    String      SSID() { return String(_ssid.c_str()); }
+    int32_t     RSSI() { return isConnected() ? -60 : 31; }
+    int32_t     channel() { return 6; }
+    int         hostByName(const char *name, IPAddress &result) { (void)name; result = IPAddress(192, 168, 1, 2); return host::wifiConnected ? 1 : 0; }
+
+  private:
+    WiFiMode_t  _mode = WIFI_OFF;
+    std::string _ssid;
+    std::string _hostname;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef ESP8266WiFiMulti_h
+#define ESP8266WiFiMulti_h
+
+#include "ESP8266WiFi.h"
+
+class ESP8266WiFiMulti {
+  public:
+    bool        addAP(const char *ssid, const char *passphrase = nullptr) { (void)passphrase; if (_ssid.empty() && ssid && *ssid) { _ssid = ssid; } return true; }
+    wl_status_t run(uint32_t connectTimeoutMs = 0) { (void)connectTimeoutMs; if (host::wifiConnected) { WiFi.begin(_ssid.c_str()); } return WiFi.status(); }
+
+  private:
+    std::string _ssid;
+};
+
+#endif
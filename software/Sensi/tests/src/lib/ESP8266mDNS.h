@@ -0,0 +1,20 @@
+#ifndef ESP8266mDNS_h
+#define ESP8266mDNS_h
+
+#include "ESP8266WiFi.h"
+
+class MDNSResponder {
+  public:
+    bool begin(const char *hostName) { (void)hostName; _running = true; return true; }
+    bool isRunning() { return _running; }
+    bool addService(const char *service, const char *protocol, uint16_t port) { (void)service; (void)protocol; (void)port; return _running; }
+    bool update() { return true; }
+    void end() { _running = false; }
+
+  private:
+    bool _running = false;
+};
+
+extern MDNSResponder MDNS;
+
+#endif
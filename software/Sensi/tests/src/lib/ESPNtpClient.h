@@ -0,0 +1,38 @@
+#ifndef _EspNtpClient_h
+#define _EspNtpClient_h
+
+// NTP client without a network, begin() synchronizes immediately while WiFi is up.
+// The wall clock of the host build is the simulated time, see time() in Arduino.cpp.
+
+#include "NTPEventTypes.h"
+
+#define DEFAULT_NTP_SERVER "pool.ntp.org"
+
+typedef std::function<void (NTPEvent_t)> onSyncEvent_t;
+
+class NTPClient {
+  public:
+    bool  begin(const char *ntpServerName = DEFAULT_NTP_SERVER);
+    bool  stop() { return true; }
+    void  onNTPSyncEvent(onSyncEvent_t handler) { _onSyncEvent = handler; }
+    bool  setInterval(int interval) { return interval >= 10; }
+    bool  setInterval(int shortInterval, int longInterval) { return (shortInterval >= 10) && (longInterval >= 10); }
+    void  setMinSyncAccuracy(long accuracy) { (void)accuracy; }
+    void  settimeSyncThreshold(long threshold) { (void)threshold; }
+    void  setMaxNumSyncRetry(unsigned long maxRetry) { (void)maxRetry; }
+    bool  setNTPTimeout(uint16_t milliseconds) { return milliseconds > 0; }
+    void  setTimeZone(const char *TZ) { setenv("TZ", TZ, 1); tzset(); }
+    void  setnumAveRounds(int rounds) { (void)rounds; }
+    char *ntpEvent2str(NTPEvent_t e);
+    char *getTimeDateString(time_t moment = time(NULL));
+    time_t getLastNTPSync() { return _lastSync; }
+
+  private:
+    onSyncEvent_t _onSyncEvent;
+    time_t        _lastSync = 0;
+    char          _str[64];
+};
+
+extern NTPClient NTP;
+
+#endif
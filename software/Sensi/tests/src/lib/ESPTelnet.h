@@ -0,0 +1,46 @@
+#ifndef ESPTelnet_h
+#define ESPTelnet_h
+
+// Telnet server without sockets, nobody connects unless connect() is called
+
+#include "ESP8266WiFi.h"
+
+class ESPTelnet : public Print {
+  public:
+    typedef void (*CallbackFunction) (String str);
+
+    bool    begin(uint16_t port = 23, bool checkConnection = true) { (void)port; (void)checkConnection; _running = true; return true; }
+    void    stop() { _running = false; }
+    void    loop();
+    bool    isClientConnected(WiFiClient client) { (void)client; return _connected; }
+    void    disconnectClient() { if (_connected) { _connected = false; if (on_disconnect) { on_disconnect(getIP()); } } }
+    size_t  write(uint8_t c) override { _bytesSent++; (void)c; return 1; }
+    size_t  write(const uint8_t *buf, size_t size) override { (void)buf; _bytesSent += size; return size; }
+    using   Print::write;
+    String  getIP() const { return String("192.168.1.2"); }
+    String  getLastAttemptIP() const { return getIP(); }
+
+    void    onConnect(CallbackFunction f) { on_connect = f; }
+    void    onConnectionAttempt(CallbackFunction f) { on_connection_attempt = f; }
+    void    onReconnect(CallbackFunction f) { on_reconnect = f; }
+    void    onDisconnect(CallbackFunction f) { on_disconnect = f; }
+    void    onInputReceived(CallbackFunction f) { on_input = f; }
+
+    // host side
+    void    connect() { _connected = true; if (on_connect) { on_connect(getIP()); } }
+    void    input(const char *line) { _input += line; }
+    uint64_t bytesSent() const { return _bytesSent; }
+
+  private:
+    bool    _running = false;
+    bool    _connected = false;
+    String  _input;
+    uint64_t _bytesSent = 0;
+    CallbackFunction on_connect = nullptr;
+    CallbackFunction on_reconnect = nullptr;
+    CallbackFunction on_disconnect = nullptr;
+    CallbackFunction on_connection_attempt = nullptr;
+    CallbackFunction on_input = nullptr;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef Esp_h
+#define Esp_h
+
+#include <stdint.h>
+#include "WString.h"
+
+// Heap statistics are derived from the allocations made on the host
+class EspClass {
+  public:
+    uint32_t getFreeHeap(void);
+    uint8_t  getHeapFragmentation(void) { return 0; }
+    uint32_t getMaxFreeBlockSize(void) { return getFreeHeap(); }
+    void     getHeapStats(uint32_t *free, uint16_t *max, uint8_t *frag);
+    uint32_t getChipId(void) { return 0x00C0FFEE; }
+    uint32_t getFlashChipId(void) { return 0x001640EF; }
+    uint32_t getFlashChipSize(void) { return 4194304; }
+    uint32_t getFlashChipRealSize(void) { return 4194304; }
+    uint32_t getFlashChipSpeed(void) { return 40000000; }
+    uint8_t  getCpuFreqMHz(void) { return 80; }
+    uint32_t getCycleCount(void);
+    uint32_t getSketchSize(void) { return 520000; }
+    uint32_t getFreeSketchSpace(void) { return 1000000; }
+    String   getResetReason(void) { return String("External System"); }
+    String   getResetInfo(void) { return String("External System"); }
+    String   getCoreVersion(void) { return String("3.0.2"); }
+    String   getSdkVersion(void) { return String("host"); }
+    const char *getFullVersion(void) { return "host"; }
+    void     wdtFeed(void) {}
+    void     wdtEnable(uint32_t) {}
+    void     wdtDisable(void) {}
+    void     reset(void);
+    void     restart(void);
+    void     deepSleep(uint64_t us, int mode = 0) { (void)us; (void)mode; restart(); }
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,108 @@
+#include "FS.h"
+#include "LittleFS.h"
+
+fs::FS LittleFS;
+
+static uint64_t bytesWritten = 0;
+static uint32_t writes       = 0;
+static uint32_t opens        = 0;
+static uint32_t lookups      = 0;
+
+uint64_t host::fsBytesWritten(void) { return bytesWritten; }
+uint32_t host::fsWrites(void)       { return writes; }
+uint32_t host::fsOpens(void)        { return opens; }
+uint32_t host::fsLookups(void)      { return lookups; }
+
+namespace fs {
+
+File::File(const std::string &name, FileData data, bool readable, bool writable, bool append)
+  : _name(name), _data(data), _position(append ? data->size() : 0), _readable(readable), _writable(writable) {}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  if (!_data || !_writable) { return 0; }
+  if (_position > _data->size()) { _data->resize(_position); }
+  _data->replace(_position, std::min(size, _data->size() - _position), (const char *)buf, size);
+  _position += size;
+  bytesWritten += size;
+  writes++;
+  return size;
+}
+
+int File::read() {
+  if (!_data || !_readable || (_position >= _data->size())) { return -1; }
+  return (uint8_t)(*_data)[_position++];
+}
+
+int File::peek() {
+  if (!_data || !_readable || (_position >= _data->size())) { return -1; }
+  return (uint8_t)(*_data)[_position];
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_data) { return false; }
+  size_t base = (mode == SeekSet) ? 0 : ((mode == SeekCur) ? _position : _data->size());
+  _position = base + pos;
+  return _position <= _data->size();
+}
+
+bool Dir::next() {
+  if (_files == nullptr) { return false; }
+  auto it = _started ? _files->upper_bound(_current) : _files->lower_bound(_path);
+  _started = true;
+  if ((it == _files->end()) || (it->first.compare(0, _path.length(), _path) != 0)) { return false; }
+  _current = it->first;
+  return true;
+}
+
+File Dir::openFile(const char *mode) {
+  return LittleFS.open(_current.c_str(), mode);
+}
+
+bool FS::info(FSInfo &info) {
+  size_t used = 0;
+  for (auto &f : _files) { used += (f.second->size() + 4095) / 4096 * 4096; }
+  info.totalBytes    = 1024 * 1024;
+  info.usedBytes     = used;
+  info.blockSize     = 4096;
+  info.pageSize      = 256;
+  info.maxOpenFiles  = 5;
+  info.maxPathLength = 32;
+  return _mounted;
+}
+
+// "r" read, "w" truncate, "a" append, "+" adds the other direction
+File FS::open(const char *path, const char *mode) {
+  if (!_mounted) { return File(); }
+  bool plus = strchr(mode, '+') != nullptr;
+  auto it   = _files.find(path);
+  opens++;
+  if (mode[0] == 'r') {
+    if (it == _files.end()) { return File(); }
+    return File(path, it->second, true, plus, false);
+  }
+  if (it == _files.end()) { it = _files.emplace(path, std::make_shared<std::string>()).first; }
+  if (mode[0] == 'w') { it->second->clear(); }
+  return File(path, it->second, plus, true, mode[0] == 'a');
+}
+
+bool FS::exists(const char *path) {
+  lookups++;
+  return _mounted && _files.count(path);
+}
+
+Dir FS::openDir(const char *path) {
+  std::string prefix(path);
+  if (prefix.empty() || (prefix.back() != '/')) { prefix += '/'; }
+  return Dir(&_files, prefix);
+}
+
+bool FS::rename(const char *pathFrom, const char *pathTo) {
+  auto it = _files.find(pathFrom);
+  if (!_mounted || (it == _files.end())) { return false; }
+  FileData data = it->second;
+  _files.erase(it);
+  _files[pathTo] = data;
+  return true;
+}
+
+} // namespace fs
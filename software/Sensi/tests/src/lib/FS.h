@@ -0,0 +1,135 @@
+#ifndef FS_H
+#define FS_H
+
+// File system kept in memory
+//
+// Files survive LittleFS.end()/begin() but not the process. Bytes written and the number of
+// open and write calls are counted so that flash wear and file system overhead can be compared.
+
+#include <map>
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+typedef std::shared_ptr<std::string> FileData;
+
+class File : public Stream {
+  public:
+    File() {}
+    File(const std::string &name, FileData data, bool readable, bool writable, bool append);
+
+    size_t  write(uint8_t c) override { return write(&c, 1); }
+    size_t  write(const uint8_t *buf, size_t size) override;
+    using   Print::write;
+    int     available() override { return (_data && _readable) ? (int)(_data->size() - std::min(_position, _data->size())) : 0; }
+    int     read() override;
+    int     read(uint8_t *buf, size_t size) { return (int)readBytes((char *)buf, size); }
+    int     peek() override;
+    void    flush() override {}
+    bool    seek(uint32_t pos, SeekMode mode);
+    bool    seek(uint32_t pos) { return seek(pos, SeekSet); }
+    size_t  position() const { return _position; }
+    size_t  size() const { return _data ? _data->size() : 0; }
+    void    close() { _data.reset(); }
+    bool    truncate(uint32_t size) { if (!_data) { return false; } _data->resize(size); return true; }
+    operator bool() const { return (bool)_data; }
+    const char *name() const { return _name.c_str() + ((_name.rfind('/') == std::string::npos) ? 0 : _name.rfind('/') + 1); }
+    const char *fullName() const { return _name.c_str(); }
+    bool    isFile() const { return (bool)_data; }
+    bool    isDirectory() const { return false; }
+
+  private:
+    std::string _name;
+    FileData    _data;
+    size_t      _position = 0;
+    bool        _readable = false;
+    bool        _writable = false;
+};
+
+class Dir {
+  public:
+    Dir() {}
+    Dir(const std::map<std::string, FileData> *files, const std::string &path) : _files(files), _path(path) {}
+    bool   next();
+    String fileName() const { return String(_current.substr(_path.length()).c_str()); }
+    size_t fileSize() const { auto it = _files->find(_current); return (it == _files->end()) ? 0 : it->second->size(); }
+    bool   isFile() const { return true; }
+    bool   isDirectory() const { return false; }
+    File   openFile(const char *mode);
+    bool   rewind() { _current.clear(); _started = false; return true; }
+
+  private:
+    const std::map<std::string, FileData> *_files = nullptr;
+    std::string _path;
+    std::string _current;
+    bool        _started = false;
+};
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+class FSConfig {
+  public:
+    FSConfig(bool autoFormat = true) : _autoFormat(autoFormat) {}
+    FSConfig &setAutoFormat(bool val = true) { _autoFormat = val; return *this; }
+    bool _autoFormat;
+};
+
+class FS {
+  public:
+    bool   setConfig(const FSConfig &cfg) { (void)cfg; return true; }
+    bool   begin() { _mounted = true; return true; }
+    void   end() { _mounted = false; }
+    bool   format() { _files.clear(); return true; }
+    bool   info(FSInfo &info);
+    File   open(const char *path, const char *mode);
+    File   open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+    bool   exists(const char *path);
+    bool   exists(const String &path) { return exists(path.c_str()); }
+    Dir    openDir(const char *path);
+    Dir    openDir(const String &path) { return openDir(path.c_str()); }
+    bool   remove(const char *path) { return _mounted && _files.erase(path); }
+    bool   remove(const String &path) { return remove(path.c_str()); }
+    bool   rename(const char *pathFrom, const char *pathTo);
+    bool   rename(const String &pathFrom, const String &pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+    bool   mkdir(const char *path) { (void)path; return true; }
+    bool   rmdir(const char *path) { (void)path; return true; }
+
+    // host side
+    void   load(const char *path, const std::string &data) { _files[path] = std::make_shared<std::string>(data); } // not counted
+
+  private:
+    bool   _mounted = false;
+    std::map<std::string, FileData> _files;
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::Dir;
+using fs::FSInfo;
+using fs::FSConfig;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+namespace host {
+  uint64_t fsBytesWritten(void);
+  uint32_t fsWrites(void);                                         // write calls reaching a file
+  uint32_t fsOpens(void);
+  uint32_t fsLookups(void);                                        // exists() calls
+}
+
+#endif
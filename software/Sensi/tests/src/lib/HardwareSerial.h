@@ -0,0 +1,32 @@
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include <string>
+#include "Stream.h"
+
+#define SERIAL_8N1 0x1c
+
+// Output goes to stdout when host::serialEcho is set, input is queued with host::serialInput()
+class HardwareSerial : public Stream {
+  public:
+    void   begin(unsigned long baud) { (void)baud; }
+    void   begin(unsigned long baud, int config) { (void)baud; (void)config; }
+    void   end() {}
+    void   setDebugOutput(bool) {}
+    void   setRxBufferSize(size_t) {}
+    int    available() override;
+    int    read() override;
+    int    peek() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using  Print::write;
+    int    availableForWrite() override { return 128; }
+    void   flush() override;
+    operator bool() const { return true; }
+
+    std::string input;
+};
+
+extern HardwareSerial Serial;
+
+#endif
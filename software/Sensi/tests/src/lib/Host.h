@@ -0,0 +1,28 @@
+#ifndef Host_h
+#define Host_h
+
+// Controls of the simulated board, used by the benchmark to script a run
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HOST_HEAPSIZE     52000                            // free heap of an ESP8266 before the sketch allocates
+#define HOST_TICK             1                            // [us] time spent on each millis()/micros() call
+
+namespace host {
+  uint64_t now(void);                                      // [us] simulated time since boot
+  void     advance(uint64_t us);                           // let simulated time pass
+
+  size_t   heapUsed(void);                                 // bytes allocated with new/malloc by the sketch
+  size_t   heapPeak(void);
+  void     resetHeapPeak(void);
+  extern bool heapCounted;                                 // allocations are charged to the sketch, off while the benchmark fills the flash
+
+  extern bool serialEcho;                                  // print Serial output on stdout
+  void     serialInput(const char *text);                  // queue characters as if typed on the terminal
+
+  extern bool restartRequested;                            // ESP.reset() or ESP.restart() was called
+  void     interrupt(uint8_t pin);                         // run the service routine attached to the pin
+}
+
+#endif
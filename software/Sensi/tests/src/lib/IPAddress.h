@@ -0,0 +1,34 @@
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include "Arduino.h"
+
+class IPAddress {
+  public:
+    IPAddress() { memset(_address, 0, sizeof(_address)); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _address[0] = a; _address[1] = b; _address[2] = c; _address[3] = d; }
+    IPAddress(uint32_t address) { memcpy(_address, &address, sizeof(_address)); }
+    IPAddress(const uint8_t *address) { memcpy(_address, address, sizeof(_address)); }
+
+    operator uint32_t() const { uint32_t a; memcpy(&a, _address, sizeof(a)); return a; }
+    bool operator == (const IPAddress &addr) const { return memcmp(_address, addr._address, sizeof(_address)) == 0; }
+    uint8_t  operator [] (int index) const { return _address[index]; }
+    uint8_t &operator [] (int index) { return _address[index]; }
+    bool   isSet() const { return (uint32_t)(*this) != 0; }
+    String toString() const {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _address[0], _address[1], _address[2], _address[3]);
+      return String(buf);
+    }
+    bool   fromString(const char *address) {
+      unsigned a, b, c, d;
+      if (sscanf(address, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) { return false; }
+      _address[0] = a; _address[1] = b; _address[2] = c; _address[3] = d;
+      return true;
+    }
+
+  private:
+    uint8_t _address[4];
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef LittleFS_h
+#define LittleFS_h
+
+#include "FS.h"
+
+class LittleFSConfig : public fs::FSConfig {
+  public:
+    LittleFSConfig(bool autoFormat = true) : FSConfig(autoFormat) {}
+};
+
+extern fs::FS LittleFS;
+
+#endif
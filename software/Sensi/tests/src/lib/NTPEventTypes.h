@@ -0,0 +1,25 @@
+#ifndef _NtpEventTypes_h
+#define _NtpEventTypes_h
+
+#include <ESP8266WiFi.h>
+
+typedef enum {
+  timeSyncd = 0, noResponse = -1, invalidAddress = -2, invalidPort = -3, requestSent = 1, partlySync = 2,
+  syncNotNeeded = 3, errorSending = -4, responseError = -5, syncError = -6, accuracyError = -7
+} NTPSyncEventType_t;
+
+typedef struct {
+  double offset = 0.0;
+  double delay = 0.0;
+  float dispersion = 0.0;
+  IPAddress serverAddress;
+  unsigned int port = 0;
+  unsigned int retrials = 0;
+} NTPSyncEventInfo_t;
+
+typedef struct {
+  NTPSyncEventType_t event;
+  NTPSyncEventInfo_t info;
+} NTPEvent_t;
+
+#endif
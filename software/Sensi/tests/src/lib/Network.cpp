@@ -0,0 +1,271 @@
+#include "ESP8266WiFi.h"
+#include "ESP8266mDNS.h"
+#include "ESP8266HTTPClient.h"
+#include "ArduinoOTA.h"
+#include "WebSocketsServer.h"
+#include "ESPTelnet.h"
+#include "ESPNtpClient.h"
+
+ESP8266WiFiClass WiFi;
+MDNSResponder    MDNS;
+ArduinoOTAClass  ArduinoOTA;
+NTPClient        NTP;
+
+bool host::wifiConnected = true;
+std::function<void(WiFiClient &client, const uint8_t *buf, size_t size)> host::peer;
+std::function<int(const String &url, std::string &body)> host::httpGet;
+
+static uint64_t bytesSent = 0;
+static uint32_t connects  = 0;
+
+uint64_t host::networkBytesSent(void) { return bytesSent; }
+uint32_t host::networkConnects(void)  { return connects; }
+
+/******************************************************************************************************/
+// WiFiServer
+/******************************************************************************************************/
+
+#define HOST_SERVERS 8
+
+static WiFiServer *servers[HOST_SERVERS];                           // listening, not allocated to keep the heap count
+
+std::shared_ptr<host::Socket> host::connectTo(uint16_t port) {
+  if (!host::wifiConnected) { return nullptr; }
+  for (WiFiServer *server : servers) {
+    if (server && (server->port() == port)) {
+      auto socket = std::make_shared<host::Socket>();
+      server->connect(socket);
+      return socket;
+    }
+  }
+  return nullptr;
+}
+
+void WiFiServer::begin() {
+  for (WiFiServer *&server : servers) { if (server == this) { return; } }
+  for (WiFiServer *&server : servers) { if (server == nullptr) { server = this; return; } }
+}
+
+void WiFiServer::stop() {
+  for (WiFiServer *&server : servers) { if (server == this) { server = nullptr; } }
+  for (auto &socket : _pending) { socket->closed = true; }
+  _pending.clear();
+}
+
+WiFiClient WiFiServer::available() {
+  if (_pending.empty()) { return WiFiClient(); }
+  auto socket = _pending.front();
+  _pending.pop_front();
+  return WiFiClient(socket);
+}
+
+/******************************************************************************************************/
+// WiFiClient
+/******************************************************************************************************/
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip.toString().c_str(), port);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  connects++;
+  host::advance(2000);                                             // round trip of the TCP handshake
+  _connected = host::wifiConnected;
+  _host      = host ? host : "";
+  _port      = port;
+  _rx.clear();
+  _rxIndex   = 0;
+  return _connected ? 1 : 0;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size) {
+  if (!_connected) { return 0; }
+  bytesSent += size;
+  if (_socket) {
+    if (!_socket->open) { return 0; }
+    _socket->toClient.append((const char *)buf, size);
+    return size;
+  }
+  if (host::peer) { host::peer(*this, buf, size); }
+  return size;
+}
+
+int WiFiClient::availableForWrite() {
+  if (!_socket) { return _connected ? HOST_TCPWINDOW : 0; }
+  return (_socket->open && (_socket->pending() < _socket->window)) ? (int)(_socket->window - _socket->pending()) : 0;
+}
+
+int WiFiClient::available() {
+  if (_socket) { return (int)(_socket->toServer.size() - _socket->serverRead); }
+  return (int)(_rx.size() - _rxIndex);
+}
+
+int WiFiClient::peek() {
+  if (_socket) { return (available() > 0) ? (uint8_t)_socket->toServer[_socket->serverRead] : -1; }
+  return (_rxIndex < _rx.size()) ? (uint8_t)_rx[_rxIndex] : -1;
+}
+
+uint8_t WiFiClient::connected() {
+  if (_socket) { return (_connected && _socket->open && !_socket->shut) || (available() > 0); }
+  return _connected || (available() > 0);
+}
+
+uint8_t WiFiClient::status() {
+  if (!_connected) { return CLOSED; }
+  if (_socket) { return !_socket->open ? CLOSED : (_socket->shut ? CLOSE_WAIT : ESTABLISHED); }
+  return ESTABLISHED;
+}
+
+void WiFiClient::stop() {
+  _connected = false;
+  if (!_socket) { return; }
+  _socket->closed = true;
+  if (_socket->serverRead < _socket->toServer.size()) {            // RST, the browser loses what it did not take
+    _socket->reset = true;
+    _socket->toClient.resize(_socket->clientRead);
+  }
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size) {
+  if (_socket) {
+    size_t n = std::min(size, _socket->toServer.size() - _socket->serverRead);
+    memcpy(buf, _socket->toServer.data() + _socket->serverRead, n);
+    _socket->serverRead += n;
+    return (int)n;
+  }
+  size_t n = std::min(size, _rx.size() - _rxIndex);
+  memcpy(buf, _rx.data() + _rxIndex, n);
+  _rxIndex += n;
+  return (int)n;
+}
+
+void WiFiClient::respond(const uint8_t *buf, size_t size) {
+  if (_rxIndex == _rx.size()) { _rx.clear(); _rxIndex = 0; }
+  _rx.append((const char *)buf, size);
+}
+
+/******************************************************************************************************/
+// HTTPClient
+/******************************************************************************************************/
+
+int HTTPClient::GET() {
+  std::string body;
+  if (!_client || !host::wifiConnected || !host::httpGet) { return HTTPC_ERROR_CONNECTION_FAILED; }
+  if (!_client->connect("host", 80)) { return HTTPC_ERROR_CONNECTION_FAILED; }
+  int code = host::httpGet(_url, body);
+  _client->respond((const uint8_t *)body.data(), body.size());
+  return code;
+}
+
+String HTTPClient::getString() {
+  return _client ? _client->readString() : String();
+}
+
+/******************************************************************************************************/
+// WebSocketsServer
+/******************************************************************************************************/
+
+bool WebSocketsServer::sendTXT(uint8_t num, const char *payload, size_t length) {
+  if ((num >= WEBSOCKETS_SERVER_CLIENT_MAX) || !_clients[num]) { return false; }
+  if (length == 0) { length = strlen(payload); }
+  _messages++;
+  _bytesSent += length + 4;                                        // frame header
+  _last.assign(payload, length);
+  return true;
+}
+
+bool WebSocketsServer::broadcastTXT(const char *payload, size_t length) {
+  bool ok = true;
+  for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+    if (_clients[i]) { ok = sendTXT(i, payload, length) && ok; }
+  }
+  return ok;
+}
+
+bool WebSocketsServer::sendBIN(uint8_t num, const uint8_t *payload, size_t length) {
+  if ((num >= WEBSOCKETS_SERVER_CLIENT_MAX) || !_clients[num]) { return false; }
+  _messages++;
+  _bytesSent += length + 4;                                        // frame header
+  _last.assign((const char *)payload, length);
+  return true;
+}
+
+bool WebSocketsServer::broadcastBIN(const uint8_t *payload, size_t length) {
+  bool ok = true;
+  for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+    if (_clients[i]) { ok = sendBIN(i, payload, length) && ok; }
+  }
+  return ok;
+}
+
+void WebSocketsServer::disconnect(void) {
+  for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) { disconnect(i); }
+}
+
+void WebSocketsServer::disconnect(uint8_t num) {
+  if ((num >= WEBSOCKETS_SERVER_CLIENT_MAX) || !_clients[num]) { return; }
+  _clients[num] = false;
+  if (_cbEvent) { _cbEvent(num, WStype_DISCONNECTED, nullptr, 0); }
+}
+
+int WebSocketsServer::connect(const char *url) {
+  if (!_running) { return -1; }
+  for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+    if (!_clients[i]) {
+      _clients[i] = true;
+      if (_cbEvent) { _cbEvent(i, WStype_CONNECTED, (uint8_t *)url, strlen(url)); }
+      return i;
+    }
+  }
+  return -1;
+}
+
+void WebSocketsServer::receive(uint8_t num, const char *text) {
+  if ((num < WEBSOCKETS_SERVER_CLIENT_MAX) && _clients[num] && _cbEvent) {
+    _cbEvent(num, WStype_TEXT, (uint8_t *)text, strlen(text));
+  }
+}
+
+/******************************************************************************************************/
+// Telnet
+/******************************************************************************************************/
+
+void ESPTelnet::loop() {
+  if (!_running || !_connected || (_input.length() == 0)) { return; }
+  int eol = _input.indexOf('\n');
+  if (eol < 0) { return; }
+  String line = _input.substring(0, eol);
+  _input.remove(0, eol + 1);
+  line.trim();
+  if (on_input) { on_input(line); }
+}
+
+/******************************************************************************************************/
+// NTP
+/******************************************************************************************************/
+
+bool NTPClient::begin(const char *ntpServerName) {
+  if ((ntpServerName == nullptr) || (*ntpServerName == '\0')) { return false; }
+  NTPEvent_t event;
+  event.event = host::wifiConnected ? timeSyncd : noResponse;
+  event.info.port = 123;
+  if (host::wifiConnected) { _lastSync = time(NULL); }
+  if (_onSyncEvent) { _onSyncEvent(event); }
+  return true;
+}
+
+char *NTPClient::ntpEvent2str(NTPEvent_t e) {
+  switch (e.event) {
+    case timeSyncd:     snprintf(_str, sizeof(_str), "Got NTP time"); break;
+    case noResponse:    snprintf(_str, sizeof(_str), "No response from server"); break;
+    case partlySync:    snprintf(_str, sizeof(_str), "Partial sync"); break;
+    case syncNotNeeded: snprintf(_str, sizeof(_str), "Sync not needed"); break;
+    default:            snprintf(_str, sizeof(_str), "NTP event %d", (int)e.event); break;
+  }
+  return _str;
+}
+
+char *NTPClient::getTimeDateString(time_t moment) {
+  strftime(_str, sizeof(_str), "%H:%M:%S %d/%m/%Y", localtime(&moment));
+  return _str;
+}
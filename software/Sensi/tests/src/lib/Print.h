@@ -0,0 +1,49 @@
+#ifndef Print_h
+#define Print_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "WString.h"
+
+class __FlashStringHelper;
+class Print;
+
+class Printable {
+  public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    virtual int  availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t printf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const String &str) { return write(str.c_str(), str.length()); }
+    size_t print(const char str[]) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = 10) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(long long value, int base = 10) { return print((long)value, base); }
+    size_t print(unsigned long long value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(double value, int digits = 2);
+    size_t print(const Printable &x) { return x.printTo(*this); }
+
+    size_t println(void) { return write("\r\n"); }
+    template <typename T> size_t println(const T &value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SPI_h
+#define SPI_h
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+class SPISettings {
+  public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) { (void)clock; (void)bitOrder; (void)dataMode; }
+};
+
+class SPIClass {
+  public:
+    void    begin() {}
+    void    end() {}
+    void    beginTransaction(SPISettings settings) { (void)settings; }
+    void    endTransaction() {}
+    uint8_t transfer(uint8_t data) { (void)data; return 0xFF; }
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,87 @@
+#include "SPS30_Arduino_Library.h"
+#include <SensirionProtocol.h>
+
+bool SPS30::command(uint16_t cmd, const uint16_t *args, size_t nArgs) {
+  if (_wire == nullptr) { return false; }
+  _wire->beginTransmission(SPS30_I2C_ADDRESS);
+  _wire->write((uint8_t)(cmd >> 8));
+  _wire->write((uint8_t)(cmd & 0xFF));
+  for (size_t i = 0; i < nArgs; i++) { sensirionWriteWord(*_wire, args[i]); }
+  return _wire->endTransmission() == 0;
+}
+
+bool SPS30::readWords(uint16_t cmd, uint16_t *words, size_t nWords) {
+  if (!command(cmd)) { return false; }
+  delayMicroseconds(500);                                          // command execution time
+  if (_wire->requestFrom((uint8_t)SPS30_I2C_ADDRESS, (size_t)(nWords * 3), true) != nWords * 3) { return false; }
+  return sensirionReadWords(*_wire, words, (uint8_t)nWords);
+}
+
+static void wordsToString(const uint16_t *words, size_t nWords, char *str, size_t len) {
+  size_t n = 0;
+  for (size_t i = 0; (i < nWords) && (n + 2 < len); i++) { str[n++] = (char)(words[i] >> 8); str[n++] = (char)(words[i] & 0xFF); }
+  str[n] = '\0';
+}
+
+bool SPS30::probe() {
+  uint16_t words[16];
+  if (!wake_up()) { return false; }
+  if (!readWords(SPS30_CMD_SERIAL, words, 16)) { return false; }
+  wordsToString(words, 16, _serial, sizeof(_serial));
+  if (!readWords(SPS30_CMD_PRODUCT_TYPE, words, 4)) { return false; }
+  wordsToString(words, 4, _product, sizeof(_product));
+  if (!readWords(SPS30_CMD_FW_VERSION, words, 1)) { return false; }
+  _fwMajor = words[0] >> 8;
+  _fwMinor = words[0] & 0xFF;
+  return true;
+}
+
+bool SPS30::i2c_general_call_reset() {
+  if (_wire == nullptr) { return false; }
+  _wire->beginTransmission(0x00);
+  _wire->write(0x06);
+  _wire->endTransmission();
+  return true;
+}
+
+// IEEE754 float output
+bool SPS30::start_measurement() {
+  const uint16_t arg = 0x0300;
+  return command(SPS30_CMD_START_MEASUREMENT, &arg, 1);
+}
+
+bool SPS30::read_data_ready(uint16_t *data_ready) {
+  return readWords(SPS30_CMD_READ_DATA_READY, data_ready, 1);
+}
+
+bool SPS30::read_measurement(sps30_measurement *measurement) {
+  float values[10];
+  if (!command(SPS30_CMD_READ_MEASUREMENT)) { return false; }
+  delayMicroseconds(500);                                          // command execution time
+  if (_wire->requestFrom((uint8_t)SPS30_I2C_ADDRESS, (size_t)60, true) != 60) { return false; }
+  if (!sensirionReadFloats(*_wire, values, 10)) { return false; }
+  memcpy(measurement, values, sizeof(values));
+  return true;
+}
+
+// first access after sleep wakes up the interface and is not acknowledged
+bool SPS30::wake_up() {
+  if (_wire == nullptr) { return false; }
+  _wire->beginTransmission(SPS30_I2C_ADDRESS);
+  _wire->endTransmission();
+  return command(SPS30_CMD_WAKE_UP);
+}
+
+bool SPS30::get_fan_auto_cleaning_interval(uint32_t *interval_seconds) {
+  uint16_t words[2];
+  if (!readWords(SPS30_CMD_AUTOCLEAN, words, 2)) { return false; }
+  *interval_seconds = ((uint32_t)words[0] << 16) | words[1];
+  return true;
+}
+
+bool SPS30::read_device_status_register(uint32_t *device_status_flags) {
+  uint16_t words[2];
+  if (!readWords(SPS30_CMD_STATUS_REGISTER, words, 2)) { return false; }
+  *device_status_flags = ((uint32_t)words[0] << 16) | words[1];
+  return true;
+}
@@ -0,0 +1,74 @@
+#ifndef SPS30_ARDUINO_LIBRARY_H
+#define SPS30_ARDUINO_LIBRARY_H
+
+// SPS30 driver using the Sensirion I2C protocol on the simulated Wire bus:
+// 16 bit commands, 16 bit words each followed by CRC-8 (polynomial 0x31, init 0xFF).
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define SPS30_I2C_ADDRESS          0x69
+#define SPS30_CMD_START_MEASUREMENT 0x0010
+#define SPS30_CMD_STOP_MEASUREMENT  0x0104
+#define SPS30_CMD_READ_DATA_READY   0x0202
+#define SPS30_CMD_READ_MEASUREMENT  0x0300
+#define SPS30_CMD_SLEEP             0x1001
+#define SPS30_CMD_WAKE_UP           0x1103
+#define SPS30_CMD_AUTOCLEAN         0x8004
+#define SPS30_CMD_PRODUCT_TYPE      0xD002
+#define SPS30_CMD_SERIAL            0xD033
+#define SPS30_CMD_FW_VERSION        0xD100
+#define SPS30_CMD_STATUS_REGISTER   0xD206
+#define SPS30_CMD_RESET             0xD304
+
+#define SPS30_STATUS_OK             0
+#define SPS30_STATUS_SPEED_ERROR    (1 << 21)
+#define SPS30_STATUS_LASER_ERROR    (1 << 5)
+#define SPS30_STATUS_FAN_ERROR      (1 << 4)
+
+struct sps30_measurement {
+  float mc_1p0;
+  float mc_2p5;
+  float mc_4p0;
+  float mc_10p0;
+  float nc_0p5;
+  float nc_1p0;
+  float nc_2p5;
+  float nc_4p0;
+  float nc_10p0;
+  float typical_particle_size;
+};
+
+
+class SPS30 {
+  public:
+    bool        begin(TwoWire *port) { _wire = port; return true; }
+    bool        probe();
+    bool        reset() { return command(SPS30_CMD_RESET); }
+    bool        i2c_general_call_reset();
+    bool        start_measurement();
+    bool        stop_measurement() { return command(SPS30_CMD_STOP_MEASUREMENT); }
+    bool        read_data_ready(uint16_t *data_ready);
+    bool        read_measurement(sps30_measurement *measurement);
+    bool        sleep() { return command(SPS30_CMD_SLEEP); }
+    bool        wake_up();
+    bool        get_fan_auto_cleaning_interval(uint32_t *interval_seconds);
+    bool        read_device_status_register(uint32_t *device_status_flags);
+    const char *serial_number() { return _serial; }
+    const char *product_type() { return _product; }
+    const char *driver_version() { return "host"; }
+    uint8_t     fw_major() { return _fwMajor; }
+    uint8_t     fw_minor() { return _fwMinor; }
+
+  private:
+    bool        command(uint16_t cmd, const uint16_t *args = nullptr, size_t nArgs = 0);
+    bool        readWords(uint16_t cmd, uint16_t *words, size_t nWords);
+
+    TwoWire    *_wire = nullptr;
+    char        _serial[33] = "";
+    char        _product[9] = "";
+    uint8_t     _fwMajor = 0;
+    uint8_t     _fwMinor = 0;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef WString_h
+#define WString_h
+
+// Arduino String on top of std::string
+
+#include <string>
+#include <stdint.h>
+
+class __FlashStringHelper;
+
+class String {
+  public:
+    String() {}
+    String(const char *cstr) : _s(cstr ? cstr : "") {}
+    String(const char *cstr, size_t len) : _s(cstr, len) {}
+    String(const __FlashStringHelper *str) : _s(reinterpret_cast<const char *>(str)) {}
+    String(const std::string &s) : _s(s) {}
+    String(const String &) = default;
+    String(String &&) = default;
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+
+    String &operator = (const String &) = default;
+    String &operator = (String &&) = default;
+    String &operator = (const char *cstr) { _s = cstr ? cstr : ""; return *this; }
+    String &operator = (const __FlashStringHelper *str) { _s = reinterpret_cast<const char *>(str); return *this; }
+
+    bool   reserve(unsigned int size) { _s.reserve(size); return true; }
+    unsigned int length(void) const { return _s.length(); }
+    bool   isEmpty(void) const { return _s.empty(); }
+    const char *c_str() const { return _s.c_str(); }
+    char  *begin() { return &_s[0]; }
+    char  *end() { return &_s[0] + _s.length(); }
+
+    bool   concat(const String &str) { _s += str._s; return true; }
+    bool   concat(const char *cstr) { if (cstr) { _s += cstr; } return true; }
+    bool   concat(const char *cstr, unsigned int length) { _s.append(cstr, length); return true; }
+    bool   concat(const __FlashStringHelper *str) { return concat(reinterpret_cast<const char *>(str)); }
+    bool   concat(char c) { _s += c; return true; }
+    bool   concat(unsigned char num) { return concat(String(num)); }
+    bool   concat(int num) { return concat(String(num)); }
+    bool   concat(unsigned int num) { return concat(String(num)); }
+    bool   concat(long num) { return concat(String(num)); }
+    bool   concat(unsigned long num) { return concat(String(num)); }
+    bool   concat(float num) { return concat(String(num)); }
+    bool   concat(double num) { return concat(String(num)); }
+
+    template <typename T> String &operator += (const T &rhs) { concat(rhs); return *this; }
+
+    int    compareTo(const String &s) const { return _s.compare(s._s); }
+    bool   equals(const String &s) const { return _s == s._s; }
+    bool   equals(const char *cstr) const { return _s == (cstr ? cstr : ""); }
+    bool   equalsIgnoreCase(const String &s) const;
+    bool   operator == (const String &rhs) const { return equals(rhs); }
+    bool   operator == (const char *cstr) const { return equals(cstr); }
+    bool   operator != (const String &rhs) const { return !equals(rhs); }
+    bool   operator != (const char *cstr) const { return !equals(cstr); }
+    bool   operator <  (const String &rhs) const { return _s < rhs._s; }
+    bool   startsWith(const String &prefix) const { return _s.compare(0, prefix._s.length(), prefix._s) == 0; }
+    bool   startsWith(const String &prefix, unsigned int offset) const { return _s.compare(offset, prefix._s.length(), prefix._s) == 0; }
+    bool   endsWith(const String &suffix) const;
+
+    char   charAt(unsigned int index) const { return index < _s.length() ? _s[index] : 0; }
+    void   setCharAt(unsigned int index, char c) { if (index < _s.length()) { _s[index] = c; } }
+    char   operator [] (unsigned int index) const { return charAt(index); }
+    char  &operator [] (unsigned int index) { return _s[index]; }
+    void   getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+    void   toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const { getBytes((unsigned char *)buf, bufsize, index); }
+
+    int    indexOf(char ch, unsigned int fromIndex = 0) const;
+    int    indexOf(const String &str, unsigned int fromIndex = 0) const;
+    int    lastIndexOf(char ch) const;
+    int    lastIndexOf(const String &str) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, _s.length()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void   replace(char find, char replace);
+    void   replace(const String &find, const String &replace);
+    void   remove(unsigned int index) { if (index < _s.length()) { _s.erase(index); } }
+    void   remove(unsigned int index, unsigned int count) { if (index < _s.length()) { _s.erase(index, count); } }
+    void   toLowerCase(void);
+    void   toUpperCase(void);
+    void   trim(void);
+
+    long   toInt(void) const { return atol(_s.c_str()); }
+    float  toFloat(void) const { return (float)atof(_s.c_str()); }
+    double toDouble(void) const { return atof(_s.c_str()); }
+
+  private:
+    std::string _s;
+};
+
+// Only named by libraries that specialize on the result of concatenations
+class StringSumHelper : public String {
+  public:
+    using String::String;
+};
+
+String operator + (const String &lhs, const String &rhs);
+String operator + (const String &lhs, const char *rhs);
+String operator + (const char *lhs, const String &rhs);
+String operator + (const String &lhs, char rhs);
+String operator + (const String &lhs, int rhs);
+String operator + (const String &lhs, unsigned int rhs);
+String operator + (const String &lhs, long rhs);
+String operator + (const String &lhs, unsigned long rhs);
+String operator + (const String &lhs, float rhs);
+String operator + (const String &lhs, double rhs);
+String operator + (const String &lhs, const __FlashStringHelper *rhs);
+
+#endif
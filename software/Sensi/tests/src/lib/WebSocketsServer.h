@@ -0,0 +1,62 @@
+#ifndef WebSocketsServer_h
+#define WebSocketsServer_h
+
+// WebSocket server without sockets
+//
+// Clients are connected with connect() and receive everything broadcast or sent to them. Messages
+// are counted and the last one is kept. Text from a client is delivered with receive().
+
+#include <vector>
+#include "ESP8266WiFi.h"
+
+#define WEBSOCKETS_SERVER_CLIENT_MAX 5
+
+typedef enum {
+  WStype_ERROR, WStype_DISCONNECTED, WStype_CONNECTED, WStype_TEXT, WStype_BIN,
+  WStype_FRAGMENT_TEXT_START, WStype_FRAGMENT_BIN_START, WStype_FRAGMENT, WStype_FRAGMENT_FIN,
+  WStype_PING, WStype_PONG
+} WStype_t;
+
+class WebSocketsServer {
+  public:
+    typedef std::function<void(uint8_t num, WStype_t type, uint8_t *payload, size_t length)> WebSocketServerEvent;
+
+    WebSocketsServer(uint16_t port) : _port(port) {}
+    void    begin() { _running = true; }
+    void    close() { _running = false; }
+    void    loop() {}
+    void    onEvent(WebSocketServerEvent cbEvent) { _cbEvent = cbEvent; }
+    void    setAuthorization(const char *user, const char *password) { (void)user; (void)password; }
+    void    setReconnectInterval(unsigned long time) { (void)time; }
+    void    enableHeartbeat(uint32_t, uint32_t, uint8_t) {}
+    bool    sendTXT(uint8_t num, const char *payload, size_t length = 0);
+    bool    sendTXT(uint8_t num, String &payload) { return sendTXT(num, payload.c_str(), payload.length()); }
+    bool    sendTXT(uint8_t num, const String &payload) { return sendTXT(num, payload.c_str(), payload.length()); }
+    bool    broadcastTXT(const char *payload, size_t length = 0);
+    bool    broadcastTXT(String &payload) { return broadcastTXT(payload.c_str(), payload.length()); }
+    bool    broadcastTXT(const String &payload) { return broadcastTXT(payload.c_str(), payload.length()); }
+    bool    sendBIN(uint8_t num, const uint8_t *payload, size_t length);
+    bool    broadcastBIN(const uint8_t *payload, size_t length);
+    void    disconnect(void);
+    void    disconnect(uint8_t num);
+    int     connectedClients(bool ping = false) { (void)ping; int n = 0; for (bool c : _clients) { n += c; } return n; }
+    IPAddress remoteIP(uint8_t num) { (void)num; return IPAddress(192, 168, 1, 2 + num); }
+
+    // host side
+    int     connect(const char *url = "/");                          // returns client number or -1
+    void    receive(uint8_t num, const char *text);
+    uint32_t messages() const { return _messages; }
+    uint64_t bytesSent() const { return _bytesSent; }
+    const std::string &lastMessage() const { return _last; }
+
+  private:
+    uint16_t _port;
+    bool     _running = false;
+    bool     _clients[WEBSOCKETS_SERVER_CLIENT_MAX] = {false};
+    WebSocketServerEvent _cbEvent;
+    uint32_t _messages = 0;
+    uint64_t _bytesSent = 0;
+    std::string _last;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef WiFiClient_h
+#define WiFiClient_h
+
+// TCP client without a network
+//
+// A connection succeeds while host::wifiConnected is set. What the sketch writes is handed to
+// host::peer, which plays the remote end and can queue a response with respond(). Without a peer
+// the data is discarded and only counted.
+//
+// A client accepted by a WiFiServer is bound to a host::Socket instead. The benchmark plays the
+// browser on the other end of the socket: it writes requests to toServer and takes the response
+// from toClient. The sketch can write ahead of the browser by window bytes, as into the TCP send
+// buffer; write() takes any amount, as the ESP8266 client waits until the data is sent.
+// A browser that shuts its side is no longer connected() but still reads. When the sketch closes with
+// request data it did not read, TCP resets the connection and what the browser did not take is lost.
+
+#include <memory>
+#include <string>
+#include "Client.h"
+
+#define HOST_TCPWINDOW 2920                                        // [bytes] TCP send buffer, two segments
+
+enum tcp_state { CLOSED = 0, LISTEN, SYN_SENT, SYN_RCVD, ESTABLISHED, FIN_WAIT_1, FIN_WAIT_2, CLOSE_WAIT, CLOSING, LAST_ACK, TIME_WAIT };  // lwIP
+
+namespace host {
+  struct Socket {
+    std::string toServer;                                          // written by the browser
+    size_t      serverRead = 0;
+    std::string toClient;                                          // written by the sketch
+    size_t      clientRead = 0;
+    size_t      window     = HOST_TCPWINDOW;
+    bool        open       = true;                                 // browser keeps the connection
+    bool        closed     = false;                                // sketch closed the connection
+    bool        shut       = false;                                // browser sent all it will, still reads
+    bool        reset      = false;                                // sketch closed with unread data
+    size_t      pending() const { return toClient.size() - clientRead; }
+  };
+}
+
+class WiFiClient : public Client {
+  public:
+    WiFiClient() {}
+    WiFiClient(std::shared_ptr<host::Socket> socket) : _connected(true), _socket(socket) {}
+    virtual ~WiFiClient() {}
+    int     connect(IPAddress ip, uint16_t port) override;
+    int     connect(const char *host, uint16_t port) override;
+    int     connect(const String &host, uint16_t port) { return connect(host.c_str(), port); }
+    size_t  write(uint8_t c) override { return write(&c, 1); }
+    size_t  write(const uint8_t *buf, size_t size) override;
+    using   Print::write;
+    int     availableForWrite() override;
+    int     available() override;
+    int     read() override { uint8_t c; return (read(&c, 1) == 1) ? c : -1; }
+    int     read(uint8_t *buf, size_t size) override;
+    int     peek() override;
+    void    flush() override {}
+    void    stop() override;
+    uint8_t connected() override;
+    uint8_t status();                                              // tcp_state
+    operator bool() override { return _connected; }
+    void    setNoDelay(bool) {}
+    void    setTimeout(unsigned long timeout) { Stream::setTimeout(timeout); }
+    IPAddress remoteIP() { return IPAddress(192, 168, 1, 2); }
+    uint16_t  remotePort() { return _port; }
+
+    void    respond(const uint8_t *buf, size_t size);              // queue data from the remote end
+    const std::string &host() const { return _host; }
+    uint16_t port() const { return _port; }
+
+  private:
+    bool        _connected = false;
+    std::string _host;
+    uint16_t    _port = 0;
+    std::string _rx;
+    size_t      _rxIndex = 0;
+    std::shared_ptr<host::Socket> _socket;                         // accepted by a WiFiServer
+};
+
+namespace host {
+  extern bool wifiConnected;                                       // access point reachable
+  extern std::function<void(WiFiClient &client, const uint8_t *buf, size_t size)> peer;
+  uint64_t networkBytesSent(void);
+  uint32_t networkConnects(void);
+  std::shared_ptr<Socket> connectTo(uint16_t port);                // browser connects to a WiFiServer, NULL if none listens
+}
+
+#endif
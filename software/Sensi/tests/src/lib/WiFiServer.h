@@ -0,0 +1,29 @@
+#ifndef WiFiServer_h
+#define WiFiServer_h
+
+#include <deque>
+#include "WiFiClient.h"
+
+// Connections made with host::connectTo() wait until the sketch accepts them
+class WiFiServer {
+  public:
+    WiFiServer(uint16_t port) : _port(port) {}
+    ~WiFiServer() { stop(); }
+    void       begin();
+    void       begin(uint16_t port) { _port = port; begin(); }
+    void       stop();
+    void       close() { stop(); }
+    void       setNoDelay(bool) {}
+    bool       hasClient() { return !_pending.empty(); }
+    WiFiClient available();
+    WiFiClient accept() { return available(); }
+    uint16_t   port() const { return _port; }
+
+    void       connect(std::shared_ptr<host::Socket> socket) { _pending.push_back(socket); }
+
+  private:
+    uint16_t   _port;
+    std::deque<std::shared_ptr<host::Socket>> _pending;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include "IPAddress.h"
+
+class WiFiUDP : public Stream {
+  public:
+    uint8_t begin(uint16_t port) { (void)port; return 1; }
+    void    stop() {}
+    int     beginPacket(IPAddress ip, uint16_t port) { (void)ip; (void)port; return 1; }
+    int     beginPacket(const char *host, uint16_t port) { (void)host; (void)port; return 1; }
+    int     endPacket() { return 1; }
+    size_t  write(uint8_t) override { return 1; }
+    size_t  write(const uint8_t *buf, size_t size) override { (void)buf; return size; }
+    using   Print::write;
+    int     parsePacket() { return 0; }
+    int     available() override { return 0; }
+    int     read() override { return -1; }
+    int     read(uint8_t *buf, size_t len) { (void)buf; (void)len; return 0; }
+    int     peek() override { return -1; }
+    void    flush() override {}
+};
+
+#endif
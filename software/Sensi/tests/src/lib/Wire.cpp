@@ -0,0 +1,135 @@
+#include "Wire.h"
+#include <map>
+#include <tuple>
+
+TwoWire Wire;
+
+typedef std::tuple<int, int, uint8_t> I2CSlot;                     // SDA, SCL, address
+
+static std::map<I2CSlot, I2CDevice *> devices;
+static uint64_t busTimeTotal     = 0;
+static uint32_t transactions     = 0;
+static uint32_t stretchTimeouts  = 0;
+static uint32_t begins           = 0;
+
+void host::attachI2C(int sda, int scl, uint8_t address, I2CDevice *device) { devices[I2CSlot(sda, scl, address)] = device; }
+void host::detachI2C(int sda, int scl, uint8_t address) { devices.erase(I2CSlot(sda, scl, address)); }
+void host::detachAllI2C(void) { devices.clear(); }
+uint64_t host::i2cBusTime(void) { return busTimeTotal; }
+uint32_t host::i2cTransactions(void) { return transactions; }
+uint32_t host::i2cStretchTimeouts(void) { return stretchTimeouts; }
+uint32_t host::i2cBegins(void) { return begins; }
+
+/******************************************************************************************************/
+// Device models
+/******************************************************************************************************/
+
+void RegisterDevice::receive(const uint8_t *data, size_t len) {
+  if (len == 0) { return; }
+  pointer = data[0];
+  for (size_t i = 1; i < len; i++) {
+    if (!readOnly[pointer]) { regs[pointer] = data[i]; }
+    if (onWrite) { onWrite(pointer, data[i]); }
+    pointer++;
+  }
+}
+
+size_t RegisterDevice::respond(uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; i++) { data[i] = regs[pointer++]; }
+  return len;
+}
+
+void RegisterDevice::set(uint8_t reg, const std::vector<uint8_t> &values) {
+  for (uint8_t value : values) { regs[reg++] = value; }
+}
+
+void CommandDevice::receive(const uint8_t *data, size_t len) {
+  _command.assign(data, data + len);
+  _response = _handler(_command);
+  _position = 0;
+}
+
+size_t CommandDevice::respond(uint8_t *data, size_t len) {
+  size_t n = 0;
+  while ((n < len) && (_position < _response.size())) { data[n++] = _response[_position++]; }
+  while (n < len) { data[n++] = 0xFF; }                            // released bus reads high
+  return len;
+}
+
+/******************************************************************************************************/
+// Bus
+/******************************************************************************************************/
+
+// twi_init sets pin modes, clock and stretch limit and flushes the buffers
+void TwoWire::begin(int sda, int scl) {
+  begins++;
+  host::advance(I2C_BEGIN_TIME);
+  _sda = sda;
+  _scl = scl;
+  _rxIndex = _rxLength = 0;
+  _txLength = 0;
+}
+
+I2CDevice *TwoWire::device(uint8_t address) {
+  auto it = devices.find(I2CSlot(_sda, _scl, address));
+  if ((it == devices.end()) || !it->second->present) { return nullptr; }
+  return it->second;
+}
+
+// start, address, data bytes and stop, 9 clocks per byte
+void TwoWire::busTime(size_t bytes) {
+  uint64_t us = ((uint64_t)(bytes + 1) * 9 * 1000000 + _clock - 1) / _clock;
+  busTimeTotal += us;
+  host::advance(us);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  _txAddress = address;
+  _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (_txLength >= BUFFER_LENGTH) { return 0; }
+  _txBuffer[_txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  size_t n = 0;
+  while ((n < quantity) && write(data[n])) { n++; }
+  return n;
+}
+
+// 0 success, 2 address not acknowledged, 4 other error
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+  (void)sendStop;
+  transactions++;
+  I2CDevice *dev = device(_txAddress);
+  if (dev == nullptr) { busTime(0); _txLength = 0; return 2; }
+  busTime(_txLength);
+  host::advance(dev->latency);
+  dev->writes++;
+  dev->receive(_txBuffer, _txLength);
+  _txLength = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, size_t quantity, bool sendStop) {
+  (void)sendStop;
+  transactions++;
+  _rxIndex = _rxLength = 0;
+  if (quantity > BUFFER_LENGTH) { quantity = BUFFER_LENGTH; }
+  I2CDevice *dev = device(address);
+  if (dev == nullptr) { busTime(0); return 0; }
+  host::advance(dev->latency);
+  if (dev->stretch > _stretchLimit) {
+    host::advance(_stretchLimit);
+    stretchTimeouts++;
+    return 0;
+  }
+  host::advance(dev->stretch);
+  busTime(quantity);
+  dev->reads++;
+  _rxLength = dev->respond(_rxBuffer, quantity);
+  return (uint8_t)_rxLength;
+}
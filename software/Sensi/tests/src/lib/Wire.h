@@ -0,0 +1,118 @@
+#ifndef TwoWire_h
+#define TwoWire_h
+
+// Simulated I2C bus
+//
+// The ESP8266 has one Wire instance whose pins are switched before each transaction. Devices are
+// therefore attached to a pin pair (SDA, SCL) and an address. A transaction advances simulated time
+// by the bytes on the wire at the current clock, plus the latency and clock stretching the device
+// was scripted with. Stretching beyond the clock stretch limit fails the transaction.
+
+#include <vector>
+#include <functional>
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 128
+#define I2C_BEGIN_TIME 20                                          // [us] to reassign the pins
+
+class I2CDevice {
+  public:
+    virtual ~I2CDevice() {}
+    virtual void   receive(const uint8_t *data, size_t len) = 0;  // master wrote len bytes
+    virtual size_t respond(uint8_t *data, size_t len) = 0;        // master reads up to len bytes
+
+    bool     present   = true;                                      // acknowledges its address
+    uint32_t latency   = 0;                                         // [us] added to every transaction
+    uint32_t stretch   = 0;                                         // [us] SCL held low before a read
+    uint32_t writes    = 0;                                         // transactions seen
+    uint32_t reads     = 0;
+};
+
+// Device with 8 bit register pointer that auto increments, e.g. Bosch and most ams sensors
+class RegisterDevice : public I2CDevice {
+  public:
+    void   receive(const uint8_t *data, size_t len) override;
+    size_t respond(uint8_t *data, size_t len) override;
+    void   set(uint8_t reg, const std::vector<uint8_t> &values);
+
+    uint8_t regs[256]     = {0};
+    bool    readOnly[256] = {false};                               // writes are ignored
+    uint8_t pointer       = 0;
+    std::function<void(uint8_t reg, uint8_t value)> onWrite;       // called for each register written
+};
+
+// Device answering the last command written, e.g. Sensirion sensors with 16 bit commands
+class CommandDevice : public I2CDevice {
+  public:
+    typedef std::function<std::vector<uint8_t>(const std::vector<uint8_t> &command)> Handler;
+    CommandDevice(Handler handler) : _handler(handler) {}
+    void   receive(const uint8_t *data, size_t len) override;
+    size_t respond(uint8_t *data, size_t len) override;
+
+  private:
+    Handler              _handler;
+    std::vector<uint8_t> _command;
+    std::vector<uint8_t> _response;
+    size_t               _position = 0;
+};
+
+class TwoWire : public Stream {
+  public:
+    void    begin(int sda, int scl);
+    void    begin(void) { begin(_sda, _scl); }
+    void    begin(uint8_t address) { (void)address; begin(); }
+    void    end(void) {}
+    void    setClock(uint32_t frequency) { if (frequency) { _clock = frequency; } }
+    void    setClockStretchLimit(uint32_t limit) { _stretchLimit = limit; }
+    void    beginTransmission(uint8_t address);
+    void    beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop);
+    uint8_t endTransmission(void) { return endTransmission(true); }
+    uint8_t requestFrom(uint8_t address, size_t quantity, bool sendStop);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity) { return requestFrom(address, (size_t)quantity, true); }
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) { return requestFrom(address, (size_t)quantity, (bool)sendStop); }
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (size_t)quantity, true); }
+    uint8_t requestFrom(int address, int quantity, int sendStop) { return requestFrom((uint8_t)address, (size_t)quantity, (bool)sendStop); }
+    uint8_t status(void) { return 0; }
+
+    size_t  write(uint8_t data) override;
+    size_t  write(const uint8_t *data, size_t quantity) override;
+    using   Print::write;
+    int     available(void) override { return (int)(_rxLength - _rxIndex); }
+    int     read(void) override { return (_rxIndex < _rxLength) ? _rxBuffer[_rxIndex++] : -1; }
+    int     peek(void) override { return (_rxIndex < _rxLength) ? _rxBuffer[_rxIndex] : -1; }
+    void    flush(void) override { _rxIndex = _rxLength = 0; _txLength = 0; }
+
+    int      sda(void) const { return _sda; }
+    int      scl(void) const { return _scl; }
+    uint32_t clock(void) const { return _clock; }
+
+  private:
+    void     busTime(size_t bytes);
+    I2CDevice *device(uint8_t address);
+
+    int      _sda = SDA;
+    int      _scl = SCL;
+    uint32_t _clock = 100000;
+    uint32_t _stretchLimit = 230;
+    uint8_t  _txAddress = 0;
+    uint8_t  _txBuffer[BUFFER_LENGTH];
+    size_t   _txLength = 0;
+    uint8_t  _rxBuffer[BUFFER_LENGTH];
+    size_t   _rxLength = 0;
+    size_t   _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+namespace host {
+  void     attachI2C(int sda, int scl, uint8_t address, I2CDevice *device);
+  void     detachI2C(int sda, int scl, uint8_t address);
+  void     detachAllI2C(void);
+  uint64_t i2cBusTime(void);                                       // [us] spent on the bus since boot
+  uint32_t i2cTransactions(void);
+  uint32_t i2cStretchTimeouts(void);                               // transactions failed due to clock stretch limit
+  uint32_t i2cBegins(void);                                        // pin reassignments
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "bme68xLibrary.h"
+
+bool Bme68x::readRegs(uint8_t reg, uint8_t *data, size_t len) {
+  _wire->beginTransmission(_address);
+  _wire->write(reg);
+  if (_wire->endTransmission() != 0) { return false; }
+  if (_wire->requestFrom(_address, (uint8_t)len) != len) { return false; }
+  for (size_t i = 0; i < len; i++) { data[i] = (uint8_t)_wire->read(); }
+  return true;
+}
+
+bool Bme68x::writeReg(uint8_t reg, uint8_t value) {
+  _wire->beginTransmission(_address);
+  _wire->write(reg);
+  _wire->write(value);
+  return _wire->endTransmission() == 0;
+}
+
+void Bme68x::begin(uint8_t i2cAddr, TwoWire &i2c) {
+  uint8_t id = 0;
+  _wire    = &i2c;
+  _address = i2cAddr;
+  _status  = (readRegs(BME68X_REG_CHIP_ID, &id, 1) && (id == BME68X_CHIP_ID)) ? BME68X_OK : BME68X_ERROR;
+}
+
+String Bme68x::statusString(void) {
+  if (_status == BME68X_OK)    { return String(""); }
+  if (_status == BME68X_ERROR) { return String("Communication failure"); }
+  return String("Warning");
+}
+
+void Bme68x::setTPH(uint8_t osTemp, uint8_t osPres, uint8_t osHum) {
+  _osTemp = osTemp; _osPres = osPres; _osHum = osHum;
+}
+
+void Bme68x::setOpMode(uint8_t opMode) {
+  _opMode = opMode;
+  if (!writeReg(BME68X_REG_CTRL_MEAS, (uint8_t)((_osTemp << 5) | (_osPres << 2) | opMode))) { _status = BME68X_ERROR; }
+}
+
+// Measurement duration from the data sheet, in microseconds, without heater duration
+uint32_t Bme68x::getMeasDur(uint8_t opMode) {
+  static const uint8_t osToMeasCycles[6] = {0, 1, 2, 4, 8, 16};
+  uint32_t measCycles = osToMeasCycles[_osTemp] + osToMeasCycles[_osPres] + osToMeasCycles[_osHum];
+  uint32_t measDur    = measCycles * 1963 + 477 * 4 + 477 * 5;
+  if (opMode != BME68X_PARALLEL_MODE) { measDur += 1000; }
+  return measDur;
+}
+
+uint8_t Bme68x::fetchData(void) {
+  uint8_t buf[15];
+  _nFields = 0;
+  if (!readRegs(BME68X_REG_FIELD0, buf, sizeof(buf))) { _status = BME68X_ERROR; return 0; }
+  _status = BME68X_OK;
+  if (!(buf[0] & BME68X_NEW_DATA_MSK)) { return 0; }
+  uint32_t pres = ((uint32_t)buf[2] << 12) | ((uint32_t)buf[3] << 4) | (buf[4] >> 4);
+  uint32_t temp = ((uint32_t)buf[5] << 12) | ((uint32_t)buf[6] << 4) | (buf[7] >> 4);
+  uint16_t hum  = ((uint16_t)buf[8] << 8) | buf[9];
+  uint16_t gas  = ((uint16_t)buf[13] << 8) | buf[14];
+  if (temp & 0x80000) { temp |= 0xFFF00000; }                      // 20 bit two's complement
+  _data.status         = buf[0];
+  _data.meas_index     = buf[1];
+  _data.pressure       = (float)pres;
+  _data.temperature    = (int32_t)temp / 100.0f;
+  _data.humidity       = hum / 1000.0f;
+  _data.gas_resistance = gas * 10.0f;
+  _opMode  = BME68X_SLEEP_MODE;                                     // forced mode returns to sleep
+  _nFields = 1;
+  return _nFields;
+}
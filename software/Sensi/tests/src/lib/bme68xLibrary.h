@@ -0,0 +1,86 @@
+#ifndef BME68X_CLASS_H
+#define BME68X_CLASS_H
+
+// BME68x driver talking to a simulated sensor over Wire
+//
+// The register map follows the BME688 but values are not compensated: the simulated sensor reports
+// pressure [Pa] and temperature [0.01 C] as 20 bit values, humidity [0.001 %] as 16 bit value and gas
+// resistance [Ohm/10] as 16 bit value in the ADC registers of field 0.
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define BME68X_CHIP_ID          UINT8_C(0x61)
+#define BME68X_REG_CHIP_ID      UINT8_C(0xD0)
+#define BME68X_REG_CTRL_MEAS    UINT8_C(0x74)
+#define BME68X_REG_FIELD0       UINT8_C(0x1D)
+#define BME68X_NEW_DATA_MSK     UINT8_C(0x80)
+
+#define BME68X_OK               INT8_C(0)
+#define BME68X_ERROR            INT8_C(-1)
+#define BME68X_WARNING          INT8_C(1)
+
+#define BME68X_SLEEP_MODE       UINT8_C(0)
+#define BME68X_FORCED_MODE      UINT8_C(1)
+#define BME68X_PARALLEL_MODE    UINT8_C(2)
+#define BME68X_SEQUENTIAL_MODE  UINT8_C(3)
+
+#define BME68X_OS_NONE          UINT8_C(0)
+#define BME68X_OS_1X            UINT8_C(1)
+#define BME68X_OS_2X            UINT8_C(2)
+#define BME68X_OS_4X            UINT8_C(3)
+#define BME68X_OS_8X            UINT8_C(4)
+#define BME68X_OS_16X           UINT8_C(5)
+
+#define BME68X_FILTER_OFF       UINT8_C(0)
+#define BME68X_FILTER_SIZE_1    UINT8_C(1)
+#define BME68X_FILTER_SIZE_3    UINT8_C(2)
+#define BME68X_FILTER_SIZE_7    UINT8_C(3)
+#define BME68X_FILTER_SIZE_15   UINT8_C(4)
+#define BME68X_FILTER_SIZE_31   UINT8_C(5)
+#define BME68X_FILTER_SIZE_63   UINT8_C(6)
+#define BME68X_FILTER_SIZE_127  UINT8_C(7)
+
+struct bme68xData {
+  uint8_t  status;
+  uint8_t  gas_index;
+  uint8_t  meas_index;
+  uint8_t  res_heat;
+  uint8_t  idac;
+  uint8_t  gas_wait;
+  float    temperature;
+  float    pressure;
+  float    humidity;
+  float    gas_resistance;
+};
+
+class Bme68x {
+  public:
+    void     begin(uint8_t i2cAddr, TwoWire &i2c);
+    int8_t   checkStatus(void) { return _status; }
+    String   statusString(void);
+    void     setTPH(uint8_t osTemp = BME68X_OS_2X, uint8_t osPres = BME68X_OS_16X, uint8_t osHum = BME68X_OS_1X);
+    void     setFilter(uint8_t filter = BME68X_FILTER_OFF) { _filter = filter; }
+    void     setHeaterProf(uint16_t temp, uint16_t dur) { _heatrTemp = temp; _heatrDur = dur; }
+    void     setOpMode(uint8_t opMode);
+    uint8_t  getOpMode(void) { return _opMode; }
+    uint32_t getMeasDur(uint8_t opMode = BME68X_SLEEP_MODE);
+    uint8_t  fetchData(void);
+    uint8_t  getData(bme68xData &data) { data = _data; return _nFields; }
+
+  private:
+    bool     readRegs(uint8_t reg, uint8_t *data, size_t len);
+    bool     writeReg(uint8_t reg, uint8_t value);
+
+    TwoWire *_wire = nullptr;
+    uint8_t  _address = 0x77;
+    int8_t   _status = BME68X_ERROR;
+    uint8_t  _osTemp = BME68X_OS_2X, _osPres = BME68X_OS_16X, _osHum = BME68X_OS_1X;
+    uint8_t  _filter = BME68X_FILTER_OFF;
+    uint8_t  _opMode = BME68X_SLEEP_MODE;
+    uint16_t _heatrTemp = 0, _heatrDur = 0;
+    uint8_t  _nFields = 0;
+    bme68xData _data = {};
+};
+
+#endif
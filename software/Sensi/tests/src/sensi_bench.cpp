@@ -0,0 +1,862 @@
+// Runs the Sensi firmware on the host with simulated sensors and network and reports
+// loop throughput, heap use and the cost of generating the JSON payloads.
+// Figures that are not what the firmware promises are reported with FAIL, the exit code is the number of them.
+//
+// usage: sensi_bench [-s simulated seconds] [-v] [-c] [-d debug level] [-o outage seconds] [-m] [-p plug in seconds]
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <Arduino.h>
+#include <Wire.h>
+#include <WiFiClient.h>
+#include <ESP8266HTTPClient.h>
+#include <NonBlockingWebServer.h>
+#include <SPS30_Arduino_Library.h>
+#include "src/Config.h"
+#include "src/Profile.h"
+#include "src/Scheduler.h"
+#include "src/I2C.h"
+#include "src/Queue.h"
+#include "src/Telemetry.h"
+#include "src/MQTT.h"
+#include "src/HTTP.h"
+#include <WebSocketsServer.h>
+
+extern Settings mySettings;
+extern Profile  profiles[NUMPROFILES];
+extern NonBlockingWebServer httpServer;
+extern WebSocketsServer webSocket;
+extern uint8_t mqttEncoding;
+extern uint8_t wsEncoding;
+extern uint32_t sampleSequence;
+extern TelemetryState telemetryStates[TELEMETRY_TRANSPORTS];
+extern const unsigned int i2cTopologyAddress;
+extern size_t settingsJournalSize;
+extern unsigned long queueDropped;
+extern HTTPFile httpFiles[HTTP_MAXFILES];
+uint16_t i2cChecksum(const I2CTopology &topology);
+uint16_t settingsRecordCRC(SettingsRecord record, const uint8_t *data);
+void defaultSettings(void);
+void printProfiles(void);
+void printHistory(void);
+void bme280JSON(char *payload, size_t len);
+void bme68xJSON(char *payload, size_t len);
+void ccs811JSON(char *payload, size_t len);
+void mlxJSON(char *payload, size_t len);
+void scd30JSON(char *payload, size_t len);
+void sgp30JSON(char *payload, size_t len);
+void sps30JSON(char *payload, size_t len);
+void timeJSON(char *payload, size_t len);
+void dateJSON(char *payload, size_t len);
+void systemJSON(char *payload, size_t len);
+
+// Pins of the two simulated buses, fast sensors on D1/D2, slow sensors and display on D3/D4
+#define BUS1_SDA D1
+#define BUS1_SCL D2
+#define BUS2_SDA D3
+#define BUS2_SCL D4
+#define SCD30_RDY D8                                               // data ready pin of the SCD30
+#define SCD30_READY 4000000                                        // [us] SCD30 measurement interval in fast mode
+#define BROKER_OUTAGE_START 120000000                              // [us] after boot, when -o is given
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) { printf("  FAIL %s\n", what); failures++; }
+}
+
+/******************************************************************************************************/
+// Sensor models
+/******************************************************************************************************/
+
+// bitwise CRC-8 as in the data sheet, independent of the lookup table used by the drivers
+static uint8_t modelCRC(const uint8_t *data, size_t len) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) { crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1); }
+  }
+  return crc;
+}
+
+static std::vector<uint8_t> sensirionWords(std::initializer_list<uint16_t> words) {
+  std::vector<uint8_t> out;
+  for (uint16_t w : words) {
+    uint8_t b[2] = {(uint8_t)(w >> 8), (uint8_t)(w & 0xFF)};
+    out.push_back(b[0]); out.push_back(b[1]); out.push_back(modelCRC(b, 2));
+  }
+  return out;
+}
+
+static std::vector<uint8_t> sensirionFloats(std::initializer_list<float> values) {
+  std::vector<uint8_t> out;
+  for (float v : values) {
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    std::vector<uint8_t> w = sensirionWords({(uint16_t)(u >> 16), (uint16_t)(u & 0xFFFF)});
+    out.insert(out.end(), w.begin(), w.end());
+  }
+  return out;
+}
+
+static uint16_t command16(const std::vector<uint8_t> &c) { return (c.size() >= 2) ? (uint16_t)((c[0] << 8) | c[1]) : 0; }
+
+// Calibration and ADC values are the compensation example of the BME280 data sheet
+static RegisterDevice bme280;
+static void setupBME280(void) {
+  bme280.set(0x88, {0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+                    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17});
+  bme280.set(0xA1, {75});
+  bme280.set(0xD0, {0x60});
+  bme280.set(0xE1, {0x72, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1E});
+  bme280.set(0xF7, {0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00, 0x75, 0x30});
+  for (int r = 0x88; r <= 0xD0; r++) { bme280.readOnly[r] = true; }
+  for (int r = 0xE1; r <= 0xE7; r++) { bme280.readOnly[r] = true; }
+  for (int r = 0xF7; r <= 0xFE; r++) { bme280.readOnly[r] = true; }
+}
+
+static RegisterDevice bme68x;
+static void setupBME68x(void) {
+  bme68x.set(0xD0, {0x61});
+  // new data, 101325 Pa, 23.50 C, 45.000 %, 120 kOhm
+  bme68x.set(0x1D, {0x80, 0x00, 0x18, 0xBC, 0xD0, 0x00, 0x92, 0xE0, 0xAF, 0xC8, 0x00, 0x00, 0x00, 0x2E, 0xE0});
+  for (int r = 0x1D; r <= 0x2B; r++) { bme68x.readOnly[r] = true; }
+  bme68x.readOnly[0xD0] = true;
+}
+
+// Status reports firmware mode, valid application and data ready, 450 ppm eCO2 and 10 ppb tVOC
+static RegisterDevice ccs811;
+static void setupCCS811(void) {
+  ccs811.set(0x00, {0x98});
+  ccs811.set(0x02, {0x01, 0xC2, 0x00, 0x0A, 0x98, 0x00, 0x00, 0x00});
+  ccs811.set(0x20, {0x81, 0x12});
+  ccs811.set(0x24, {0x20, 0x00});
+  for (int r = 0x00; r <= 0x0A; r++) { ccs811.readOnly[r] = true; }
+  for (int r = 0x20; r <= 0x25; r++) { ccs811.readOnly[r] = true; }
+  ccs811.readOnly[0xE0] = true;
+  ccs811.stretch = 50;
+}
+
+// SMBus word reads with packet error code, 25 C ambient and 34 C object temperature
+static CommandDevice mlx([](const std::vector<uint8_t> &c) -> std::vector<uint8_t> {
+  if (c.empty()) { return {}; }
+  uint16_t value = 0;
+  switch (c[0]) {
+    case 0x06: value = (uint16_t)(298.15 * 50); break;
+    case 0x07: value = (uint16_t)(307.15 * 50); break;
+    case 0x24: value = 0xFAE1; break;
+    case 0x2E: value = 0xBE5A; break;
+    default:   value = 0; break;
+  }
+  auto crc8 = [](uint8_t crc, uint8_t data) { crc ^= data; for (int i = 0; i < 8; i++) { crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1); } return crc; };
+  uint8_t lsb = value & 0xFF, msb = value >> 8;
+  uint8_t pec = crc8(crc8(crc8(crc8(crc8(0, 0x5A << 1), c[0]), (0x5A << 1) + 1), lsb), msb);
+  return {lsb, msb, pec};
+});
+
+// Continuous measurement every 2 s, 650 ppm, 24.0 C, 40 %; the SCD30 stretches the clock
+static CommandDevice scd30([](const std::vector<uint8_t> &c) -> std::vector<uint8_t> {
+  switch (command16(c)) {
+    case 0x0202: return sensirionWords({1});
+    case 0x0300: return sensirionFloats({650.0f, 24.0f, 40.0f});
+    case 0x4600: return sensirionWords({2});
+    case 0x5306: return sensirionWords({1});
+    case 0xD100: return sensirionWords({0x0342});
+    default:     return sensirionWords({0});
+  }
+});
+
+static CommandDevice sgp30([](const std::vector<uint8_t> &c) -> std::vector<uint8_t> {
+  switch (command16(c)) {
+    case 0x2008: return sensirionWords({420, 12});
+    case 0x2015: return sensirionWords({0x8F2E, 0x9130});
+    case 0x202F: return sensirionWords({0x0022});
+    case 0x2032: return sensirionWords({0xD400});
+    case 0x2050: return sensirionWords({13600, 18200});
+    case 0x3682: return sensirionWords({0x0000, 0x0123, 0x4567});
+    default:     return {};
+  }
+});
+
+static CommandDevice sps30([](const std::vector<uint8_t> &c) -> std::vector<uint8_t> {
+  switch (command16(c)) {
+    case SPS30_CMD_READ_DATA_READY:  return sensirionWords({1});
+    case SPS30_CMD_READ_MEASUREMENT: return sensirionFloats({3.1f, 4.2f, 4.8f, 5.0f, 20.5f, 24.3f, 24.6f, 24.7f, 24.7f, 0.45f});
+    case SPS30_CMD_AUTOCLEAN:        return sensirionWords({0x0009, 0x3A80});
+    case SPS30_CMD_PRODUCT_TYPE:     return sensirionWords({0x3030, 0x3038, 0x3030, 0x3030});
+    case SPS30_CMD_SERIAL:           return sensirionWords({0x3130, 0x3233, 0x3435, 0x3637, 0x3839, 0x4142, 0x4344, 0x4546, 0, 0, 0, 0, 0, 0, 0, 0});
+    case SPS30_CMD_FW_VERSION:       return sensirionWords({0x0202});
+    case SPS30_CMD_STATUS_REGISTER:  return sensirionWords({0, 0});
+    default:                         return {};
+  }
+});
+
+static RegisterDevice lcd;                                         // PCF8574 port expander only receives
+
+/******************************************************************************************************/
+// Network peers
+/******************************************************************************************************/
+
+static uint32_t mqttPublished = 0;
+static bool     mqttBrokerDown = false;
+
+// Minimal broker: acknowledges connect, subscribe and QoS 1 publishes, answers ping, counts publishes
+// While it is down, it accepts the connection but does not answer, as a broker that is restarting
+static void mqttBroker(WiFiClient &client, const uint8_t *buf, size_t size) {
+  if ((size == 0) || mqttBrokerDown) { return; }
+  switch (buf[0] & 0xF0) {
+    case 0x10: { const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00}; client.respond(connack, sizeof(connack)); break; }
+    case 0x30: {
+      mqttPublished++;
+      if ((buf[0] & 0x06) != 0x02) { break; }
+      size_t pos = 1;
+      while ((pos < size) && (buf[pos] & 0x80)) { pos++; }           // remaining length
+      pos++;
+      if (pos + 2 > size) { break; }
+      pos += 2 + ((buf[pos] << 8) | buf[pos+1]);                        // topic
+      if (pos + 2 > size) { break; }
+      const uint8_t puback[] = {0x40, 0x02, buf[pos], buf[pos+1]};
+      client.respond(puback, sizeof(puback));
+      break;
+    }
+    case 0x80: { if (size >= 4) { const uint8_t suback[] = {0x90, 0x03, buf[2], buf[3], 0x00}; client.respond(suback, sizeof(suback)); } break; }
+    case 0xC0: { const uint8_t pingresp[] = {0xD0, 0x00}; client.respond(pingresp, sizeof(pingresp)); break; }
+    default: break;
+  }
+}
+
+static int weatherService(const String &url, std::string &body) {
+  (void)url;
+  body = "{\"coord\":{\"lon\":-110.9265,\"lat\":32.2217},\"weather\":[{\"id\":800,\"main\":\"Clear\",\"description\":\"clear sky\",\"icon\":\"01d\"}],"
+         "\"base\":\"stations\",\"main\":{\"temp\":25.73,\"feels_like\":26.21,\"temp_min\":24.03,\"temp_max\":27.46,\"pressure\":1014,\"humidity\":71},"
+         "\"visibility\":10000,\"wind\":{\"speed\":1.54,\"deg\":160},\"clouds\":{\"all\":0},\"dt\":1662824394,"
+         "\"sys\":{\"type\":2,\"id\":2007774,\"country\":\"US\",\"sunrise\":1662815078,\"sunset\":1662860221},"
+         "\"timezone\":-25200,\"id\":5318313,\"name\":\"Tucson\",\"cod\":200}";
+  return 200;
+}
+
+// Browser on a connection to the HTTP server. It takes at most rate bytes of the response per pass of the
+// server, a slow browser on weak WiFi also has a small window.
+struct HTTPReply {
+  int         code = 0;
+  std::string headers;
+  std::string body;                                                // without chunk framing
+  size_t      bytes = 0;                                           // received, headers and framing included
+};
+
+struct Browser {
+  std::shared_ptr<host::Socket> socket;
+  std::string received;                                            // not parsed yet
+  size_t      rate = SIZE_MAX;                                     // [bytes] taken per pass
+  size_t      window = HOST_TCPWINDOW;
+  bool open(size_t windowSize = HOST_TCPWINDOW, size_t rateLimit = SIZE_MAX) {
+    socket = host::connectTo(80);
+    received.clear();
+    rate   = rateLimit;
+    window = windowSize;
+    if (socket) { socket->window = window; }
+    return (bool)socket;
+  }
+  void close() { if (socket) { socket->open = false; } socket.reset(); }
+  void request(const char *method, const String &uri, const std::vector<std::pair<String, String>> &args = {},
+               const std::vector<std::pair<String, String>> &headers = {}, const std::string &body = std::string()) {
+    if (socket->closed) { close(); open(window, rate); }            // server ended keep-alive
+    std::string r = std::string(method) + " " + uri.c_str();
+    for (size_t i = 0; i < args.size(); i++) { r += std::string((i == 0) ? "?" : "&") + args[i].first.c_str() + "=" + args[i].second.c_str(); }
+    r += " HTTP/1.1\r\nHost: sensi.local\r\n";
+    for (auto &h : headers) { r += std::string(h.first.c_str()) + ": " + h.second.c_str() + "\r\n"; }
+    if (!body.empty()) { r += "Content-Length: " + std::to_string(body.size()) + "\r\n"; }
+    r += "\r\n" + body;
+    socket->toServer += r;
+  }
+  bool take() {
+    size_t n = std::min(rate, socket->pending());
+    received.append(socket->toClient, socket->clientRead, n);
+    socket->clientRead += n;
+    return n > 0;
+  }
+  // a complete response is removed from received
+  bool parse(HTTPReply &reply, bool head) {
+    size_t end = received.find("\r\n\r\n");
+    if (end == std::string::npos) { return false; }
+    reply = HTTPReply();
+    reply.code    = atoi(received.c_str() + 9);
+    reply.headers = received.substr(0, end + 2);
+    size_t pos = end + 4;
+    if (head || (reply.code == 304) || (reply.code == 204)) {
+    } else if (reply.headers.find("Transfer-Encoding: chunked") != std::string::npos) {
+      while (true) {
+        size_t eol = received.find("\r\n", pos);
+        if (eol == std::string::npos) { return false; }
+        size_t size = strtoul(received.c_str() + pos, nullptr, 16);
+        if (received.size() < eol + 2 + size + 2) { return false; }
+        reply.body.append(received, eol + 2, size);
+        pos = eol + 2 + size + 2;
+        if (size == 0) { break; }
+      }
+    } else if (reply.headers.find("Content-Length: ") != std::string::npos) {
+      size_t size = strtoul(received.c_str() + reply.headers.find("Content-Length: ") + 16, nullptr, 10);
+      if (received.size() < pos + size) { return false; }
+      reply.body = received.substr(pos, size);
+      pos += size;
+    } else {                                                       // ends when the server closes
+      if (!socket->closed) { return false; }
+      reply.body = received.substr(pos);
+      pos = received.size();
+    }
+    reply.bytes = pos;
+    received.erase(0, pos);
+    return true;
+  }
+};
+
+static HTTPReply httpReply;                                        // last response to a benchmark request
+static uint32_t  httpPasses;                                       // handleClient() calls for the last response
+static double    httpMaxPass;                                      // [us] longest handleClient() call
+
+// serves until the browser has the complete response, false if it does not come
+static bool receive(Browser &browser, HTTPReply &reply = httpReply, bool head = false) {
+  httpPasses  = 0;
+  httpMaxPass = 0;
+  while (httpPasses < 100000) {
+    auto start = std::chrono::steady_clock::now();
+    httpServer.handleClient();
+    httpMaxPass = std::max(httpMaxPass, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    httpPasses++;
+    browser.take();
+    if (browser.parse(reply, head)) { return true; }
+    if (browser.socket->closed && (browser.socket->pending() == 0) && (httpPasses > 1)) { return false; }
+  }
+  return false;
+}
+
+/******************************************************************************************************/
+// Benchmark
+/******************************************************************************************************/
+
+static void attachDevices(bool withSCD30) {
+  setupBME280();
+  setupBME68x();
+  setupCCS811();
+  scd30.stretch = 150;
+  host::attachI2C(BUS1_SDA, BUS1_SCL, 0x76, &bme280);
+  host::attachI2C(BUS1_SDA, BUS1_SCL, 0x77, &bme68x);
+  host::attachI2C(BUS1_SDA, BUS1_SCL, 0x58, &sgp30);
+  host::attachI2C(BUS1_SDA, BUS1_SCL, 0x5A, &mlx);
+  host::attachI2C(BUS1_SDA, BUS1_SCL, 0x69, &sps30);
+  host::attachI2C(BUS2_SDA, BUS2_SCL, 0x5B, &ccs811);
+  if (withSCD30) { host::attachI2C(BUS2_SDA, BUS2_SCL, 0x61, &scd30); }
+  host::attachI2C(BUS2_SDA, BUS2_SCL, 0x27, &lcd);
+}
+
+// Settings as a device in the field would have them stored
+static void storeSettings(uint8_t debuglevel) {
+  defaultSettings();
+  mySettings.debuglevel = debuglevel;
+  mySettings.useMQTT    = true;
+  mySettings.useHTTP    = true;
+  mySettings.useNTP     = true;
+  mySettings.usemDNS    = true;
+  mySettings.useLog     = true;
+  mySettings.useWeather = true;
+  strcpy(mySettings.weatherApiKey, "0123456789abcdef0123456789abcdef");
+  EEPROM.begin(EEPROM_SIZE);
+  EEPROM.put(0, mySettings);
+  EEPROM.commit();
+}
+
+// I2C topology as a previous boot would have stored it
+static void storeTopology(bool withSCD30) {
+  const I2CEntry devices[] = {{0x76, BUS1_SDA, BUS1_SCL}, {0x77, BUS1_SDA, BUS1_SCL}, {0x58, BUS1_SDA, BUS1_SCL}, {0x5A, BUS1_SDA, BUS1_SCL},
+                              {0x69, BUS1_SDA, BUS1_SCL}, {0x5B, BUS2_SDA, BUS2_SCL}, {0x27, BUS2_SDA, BUS2_SCL}, {0x61, BUS2_SDA, BUS2_SCL}};
+  I2CTopology topology;
+  memset(&topology, 0, sizeof(topology));
+  topology.valid      = I2C_TOPOLOGY_VALID;
+  topology.numDevices = sizeof(devices) / sizeof(I2CEntry) - (withSCD30 ? 0 : 1);
+  memcpy(topology.devices, devices, topology.numDevices * sizeof(I2CEntry));
+  topology.checksum   = i2cChecksum(topology);
+  EEPROM.put(i2cTopologyAddress, topology);
+  EEPROM.commit();
+}
+
+typedef void (*JSONFunction)(char *payload, size_t len);
+
+static void benchJSON(const char *name, JSONFunction fn) {
+  const int iterations = 2000;
+  char payload[1024];
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) { fn(payload, sizeof(payload)); }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+  printf("  %-8s %8.2f us %6zu bytes\n", name, us, strlen(payload));
+}
+
+static void benchMsgPack(const char *name, uint32_t channels) {
+  const int iterations = 2000;
+  uint8_t payload[TELEMETRY_MAXSIZE];
+  size_t  l = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) { l = telemetryMsgPack(channels, payload, sizeof(payload)); }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+  printf("  %-8s %8.2f us %6zu bytes\n", name, us, l);
+}
+
+static String responseHeader(const char *name) {
+  const std::string &headers = httpReply.headers;
+  std::string key = std::string(name) + ": ";
+  size_t start = headers.find(key);
+  if (start == std::string::npos) { return String(); }
+  start += key.size();
+  return String(headers.substr(start, headers.find("\r\n", start) - start).c_str());
+}
+
+// one refresh of the dashboard, the single endpoints it polled before /api/all against one /api/all
+static void benchDashboard() {
+  const char *uris[] = {"/time", "/date", "/hostname", "/ip", "/system", "/bme280", "/bme68x", "/ccs811",
+                        "/mlx", "/scd30", "/sgp30", "/sps30"};
+  Browser browser;
+  browser.open();
+  size_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const char *uri : uris) { browser.request("GET", uri); receive(browser); bytes += httpReply.bytes; }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  printf("  %-22s %8.1f us %6zu bytes %zu requests\n", "dashboard single", us, bytes, sizeof(uris) / sizeof(uris[0]));
+  start = std::chrono::steady_clock::now();
+  browser.request("GET", "/api/all");
+  receive(browser);
+  us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  printf("  %-22s %8.1f us %6zu bytes 1 request\n", "dashboard api/all", us, httpReply.bytes);
+  browser.close();
+}
+
+// a second browser connects to the running server and leaves again
+static uint32_t benchWebSocket(const char *name, const char *url) {
+  uint32_t messages = webSocket.messages();
+  uint64_t bytes    = webSocket.bytesSent();
+  int num = webSocket.connect(url);
+  messages = webSocket.messages() - messages;
+  printf("  %-22s %8u messages %6llu bytes\n", name, messages, (unsigned long long)(webSocket.bytesSent() - bytes));
+  webSocket.disconnect(num);
+  return messages;
+}
+
+// the web pages of the sketch as uploaded to LittleFS, from the data folder next to tests, flash is not heap
+static void loadDataFiles(const char *folder) {
+  std::error_code ec;
+  host::heapCounted = false;
+  for (auto &entry : std::filesystem::directory_iterator(folder, ec)) {
+    if (!entry.is_regular_file()) { continue; }
+    std::ifstream in(entry.path(), std::ios::binary);
+    std::stringstream data;
+    data << in.rdbuf();
+    LittleFS.load(("/" + entry.path().filename().string()).c_str(), data.str());
+  }
+  host::heapCounted = true;
+}
+
+// like benchHTTP with the file system calls per request
+static int benchFile(const char *name, const String &uri, const std::vector<std::pair<String, String>> &headers = {}) {
+  const int iterations = 200;
+  Browser browser;
+  browser.open();
+  uint32_t opens   = host::fsOpens();
+  uint32_t lookups = host::fsLookups();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) { browser.request("GET", uri, {}, headers); receive(browser); }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+  printf("  %-22s %8.1f us %6zu bytes %d %4.1f opens %4.1f lookups\n", name, us, httpReply.body.size(), httpReply.code,
+         (double)(host::fsOpens() - opens) / iterations, (double)(host::fsLookups() - lookups) / iterations);
+  browser.close();
+  return httpReply.code;
+}
+
+// served directly, not through the scheduler, over one keep-alive connection
+static int benchHTTP(const char *name, const String &uri, const std::vector<std::pair<String, String>> &args,
+                      const std::vector<std::pair<String, String>> &headers = {}) {
+  const int iterations = 200;
+  Browser browser;
+  browser.open();
+  uint32_t passes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) { browser.request("GET", uri, args, headers); receive(browser); passes += httpPasses; }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+  printf("  %-22s %8.1f us %6zu bytes %d %5.1f passes\n", name, us, httpReply.body.size(), httpReply.code, (double)passes / iterations);
+  browser.close();
+  return httpReply.code;
+}
+
+// index.htm to a browser that takes rate bytes per pass of the server through a window of the given size
+static int benchSlowBrowser(const char *name, size_t window, size_t rate) {
+  Browser browser;
+  browser.open(window, rate);
+  browser.request("GET", "/index.htm");
+  bool ok = receive(browser);
+  printf("  %-22s %8u passes %8.1f us longest pass %6zu bytes %d\n", name, httpPasses, httpMaxPass,
+         httpReply.body.size(), ok ? httpReply.code : 0);
+  browser.close();
+  return ok ? httpReply.code : 0;
+}
+
+// a handler that sends size bytes at once to a slow browser, in pieces of piece bytes when piece is not 0
+static int benchLargeResponse(const char *name, size_t size, size_t piece, bool chunked = false) {
+  httpServer.on("/bench/large", HTTP_GET, []() {
+    size_t size  = httpServer.arg("size").toInt();
+    size_t piece = httpServer.arg("piece").toInt();
+    String text;
+    if (piece == 0) {
+      for (size_t i = 0; i < size; i++) { text += (char)('a' + i % 26); }
+      httpServer.send(200, "text/plain", text);
+      return;
+    }
+    for (size_t i = 0; i < piece; i++) { text += (char)('a' + i % 26); }
+    httpServer.setContentLength(httpServer.hasArg("chunked") ? CONTENT_LENGTH_UNKNOWN : size);
+    httpServer.send(200, "text/plain", String());
+    for (size_t sent = 0; sent < size; sent += piece) { httpServer.sendContent(text); }
+  });
+  Browser browser;
+  browser.open(1460, 256);
+  uint32_t grown     = httpServer.grown();
+  uint32_t overflows = httpServer.overflows();
+  std::vector<std::pair<String, String>> args = {{"size", String((unsigned)size)}, {"piece", String((unsigned)piece)}};
+  if (chunked) { args.push_back({"chunked", "1"}); }
+  browser.request("GET", "/bench/large", args);
+  bool ok = receive(browser);
+  printf("  %-22s %8u passes %8.1f us longest pass %6zu bytes %d %u grown %u overflows\n", name, httpPasses, httpMaxPass,
+         ok ? httpReply.body.size() : 0, ok ? httpReply.code : 0, httpServer.grown() - grown, httpServer.overflows() - overflows);
+  browser.close();
+  return ok ? httpReply.code : 0;
+}
+
+// a form body too large for the server is answered with 413 while the browser is still sending it,
+// and a browser that shut its side after the request gets the whole file
+static void benchClosing() {
+  Browser browser;
+  browser.open(1460, 16);
+  browser.socket->toServer += "POST /config HTTP/1.1\r\nHost: sensi.local\r\nContent-Type: text/plain\r\nContent-Length: 4000\r\n\r\n";
+  browser.socket->toServer += std::string(1000, 'x');
+  bool ok = receive(browser);
+  bool lingering = !browser.socket->closed;
+  browser.socket->toServer += std::string(3000, 'x');              // rest of the body after the response
+  httpServer.handleClient();
+  host::advance((NBWS_LINGER + 100) * 1000ULL);
+  httpServer.handleClient();
+  printf("  %-22s %8u passes %8d status %u lingering %u reset\n", "413 body in flight", httpPasses, ok ? httpReply.code : 0,
+         (unsigned)lingering, (unsigned)browser.socket->reset);
+  check(ok && (httpReply.code == 413) && lingering && browser.socket->closed && !browser.socket->reset,
+        "413 body in flight: body read, then closed");
+  browser.close();
+  httpServer.handleClient();
+
+  File index = LittleFS.open("/index.htm", "r");
+  size_t indexSize = index ? index.size() : 0;
+  index.close();
+  browser.open(1460, 256);
+  browser.request("GET", "/index.htm");
+  browser.socket->shut = true;
+  ok = receive(browser);
+  printf("  %-22s %8u passes %6zu bytes %d\n", "index.htm half closed", httpPasses, ok ? httpReply.body.size() : 0, ok ? httpReply.code : 0);
+  check(ok && (httpReply.body.size() == indexSize), "index.htm half closed: whole file");
+  browser.close();
+  httpServer.handleClient();
+}
+
+// several browsers at once: keep-alive, a request answered while a slow download runs, limits and timeouts
+static void benchConnections() {
+  Browser slow, fast;
+  HTTPReply reply;
+  uint32_t accepted = httpServer.accepted();
+  uint32_t served   = httpServer.served();
+  Browser browsers[NBWS_MAX_CLIENTS];
+  for (auto &b : browsers) { b.open(); }
+  for (int i = 0; i < 3; i++) { for (auto &b : browsers) { b.request("GET", "/api/all"); receive(b); } }
+  printf("  %-22s %8u connections %4u requests\n", "keep-alive", httpServer.accepted() - accepted, httpServer.served() - served);
+  check(httpServer.accepted() - accepted == NBWS_MAX_CLIENTS, "keep-alive: one connection per browser");
+
+  Browser extra;                                                   // all busy but idle, the longest idle one is closed
+  extra.open();
+  extra.request("GET", "/time");
+  bool ok = receive(extra);
+  printf("  %-22s %8d status %5u open, %u closed by the server\n", "fifth, others idle", ok ? httpReply.code : 0,
+         httpServer.connections(), (unsigned)browsers[0].socket->closed);
+  check(ok && (httpReply.code == 200), "fifth, others idle: served");
+  extra.close();
+  for (auto &b : browsers) { b.close(); }
+  httpServer.handleClient();
+
+  for (auto &b : browsers) { b.open(1460, 0); b.request("GET", "/index.htm"); }
+  httpServer.handleClient();                                       // all stuck in the download
+  uint32_t rejected = httpServer.rejected();
+  extra.open();
+  extra.request("GET", "/time");
+  ok = receive(extra);
+  printf("  %-22s %8d status %5u rejected\n", "fifth, others busy", ok ? httpReply.code : 0, httpServer.rejected() - rejected);
+  check(ok && (httpReply.code == 503), "fifth, others busy: 503");
+  extra.close();
+  for (auto &b : browsers) { b.close(); }
+  httpServer.handleClient();
+
+  slow.open(1460, 64);
+  fast.open();
+  slow.request("GET", "/index.htm");
+  httpServer.handleClient();
+  fast.request("GET", "/api/all");
+  ok = receive(fast, reply);
+  printf("  %-22s %8u passes %8.1f us longest pass %6zu bytes %d, %zu of index.htm sent\n", "api/all during slow", httpPasses,
+         httpMaxPass, reply.body.size(), ok ? reply.code : 0, slow.received.size() + slow.socket->pending());
+  check(ok && (reply.code == 200), "api/all during slow: served");
+  receive(slow);
+
+  slow.request("GET", "/archive");                                 // one export cursor
+  httpServer.handleClient();
+  fast.request("GET", "/archive");
+  ok = receive(fast, reply);
+  printf("  %-22s %8d status while a slow browser exports\n", "archive twice", ok ? reply.code : 0);
+  check(ok && (reply.code != 200), "archive twice: one export at a time");
+  receive(slow);
+  slow.close();
+  fast.close();
+
+  uint32_t timeouts = httpServer.timeouts();                       // request never completed
+  slow.open();
+  slow.socket->toServer += "GET /time HTTP/1.1\r\nHost: sens";
+  httpServer.handleClient();
+  host::advance((NBWS_TIMEOUT + 1000) * 1000ULL);
+  httpServer.handleClient();
+  printf("  %-22s %8u timeouts %5u open\n", "stalled request", httpServer.timeouts() - timeouts, httpServer.connections());
+  check((httpServer.timeouts() - timeouts == 1) && (httpServer.connections() == 0), "stalled request: closed");
+  slow.close();
+  httpServer.handleClient();
+}
+
+// multipart upload of a file in one request, the server passes it on in pieces
+static void benchUpload(const char *name, const char *path, size_t size) {
+  std::string file(size, 'x');
+  for (size_t i = 0; i < size; i++) { file[i] = (char)('a' + (i * 7) % 26); }
+  std::string boundary = "----sensiboundary";
+  std::string body = "--" + boundary + "\r\nContent-Disposition: form-data; name=\"data\"; filename=\"" + path + "\"\r\n"
+                     "Content-Type: text/plain\r\n\r\n" + file + "\r\n--" + boundary + "--\r\n";
+  Browser browser;
+  browser.open();
+  uint32_t writes = host::fsWrites();
+  browser.request("POST", "/upload", {}, {{"Content-Type", String(("multipart/form-data; boundary=" + boundary).c_str())}}, body);
+  bool ok = receive(browser);
+  File f = LittleFS.open(path, "r");
+  printf("  %-22s %8u passes %8.1f us longest pass %6zu bytes stored %d %u writes\n", name, httpPasses, httpMaxPass,
+         f ? f.size() : 0, ok ? httpReply.code : 0, host::fsWrites() - writes);
+  check(ok && f && (f.size() == size), "upload: file stored");
+  browser.close();
+  LittleFS.remove(path);
+}
+
+// an asset replaced behind the index by its compressed version is still served, and indexed again
+static void benchStaleFile(const char *name) {
+  File file = LittleFS.open("/bench.css", "w");
+  file.write((const uint8_t *)"body {}", 7);
+  file.close();
+  indexFile("/bench.css");
+  bool indexed = (fileIndex("/bench.css") >= 0);
+  file = LittleFS.open("/bench.css.gz", "w");
+  file.write((const uint8_t *)"compressed", 10);
+  file.close();
+  LittleFS.remove("/bench.css");
+  int code = benchFile(name, "/bench.css");
+  int8_t i = fileIndex("/bench.css");
+  check(indexed && (code == 200) && (httpReply.body.size() == 10) && (i >= 0) && httpFiles[i].gz, "stale asset: served and indexed again");
+  LittleFS.remove("/bench.css.gz");
+  indexFile("/bench.css");
+  check(fileIndex("/bench.css") < 0, "removed asset: dropped from the index");
+}
+
+// a journal cut short in its snapshot is rejected and the next save starts a new one
+static void benchJournal(const char *name) {
+  Settings settings = mySettings;
+  File file = LittleFS.open(SETTINGS_JOURNAL, "w");
+  file.write((const uint8_t *)&mySettings, 16);
+  file.close();
+  bool rejected = !loadSettings(settings) && (settingsJournalSize == 0);
+  uint32_t writes = host::fsWrites();
+  bool saved    = saveSettings(mySettings);
+  bool loaded   = loadSettings(settings) && (memcmp(&settings, &mySettings, sizeof(Settings)) == 0);
+  printf("  %-22s %8zu bytes journal %u writes\n", name, settingsJournalSize, host::fsWrites() - writes);
+  check(rejected, "settings journal: damaged snapshot rejected");
+  check(saved && loaded && (settingsJournalSize == sizeof(SettingsRecord) + sizeof(Settings)), "settings journal: rewritten");
+}
+
+// a snapshot of version 1, which ended with LCDdisplayType, keeps the fields added since at their value
+static void benchJournalMigration(const char *name) {
+  Settings older = mySettings;
+  older.debuglevel = mySettings.debuglevel + 1;
+  SettingsRecord record = { SETTINGS_MAGIC, 1, 0, (uint16_t)SETTINGS_EEPROMLENGTH, 0 };
+  record.crc = settingsRecordCRC(record, (const uint8_t *)&older);
+  File file = LittleFS.open(SETTINGS_JOURNAL, "w");
+  file.write((const uint8_t *)&record, sizeof(record));
+  file.write((const uint8_t *)&older, record.length);
+  file.close();
+  Settings settings = mySettings;
+  settings.mqttBurst = mySettings.mqttBurst + 1;
+  bool loaded = loadSettings(settings);
+  printf("  %-22s %8zu bytes journal\n", name, settingsJournalSize);
+  check(loaded && (settings.debuglevel == older.debuglevel) && (settings.mqttBurst == mySettings.mqttBurst + 1) &&
+        (settingsJournalSize == sizeof(SettingsRecord) + sizeof(Settings)), "settings journal: version 1 migrated");
+  compactSettings(mySettings);
+}
+
+int main(int argc, char **argv) {
+  unsigned long seconds = 600;
+  bool verbose = false;
+  bool cached  = false;
+  uint8_t debuglevel = 1;
+  unsigned long outage = 0;
+  bool msgpack = false;
+  unsigned long plug = 0;
+  for (int i = 1; i < argc; i++) {
+    if      ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) { seconds = strtoul(argv[++i], nullptr, 10); }
+    else if (strcmp(argv[i], "-v") == 0)                     { verbose = true; }
+    else if (strcmp(argv[i], "-c") == 0)                     { cached = true; }
+    else if ((strcmp(argv[i], "-d") == 0) && (i + 1 < argc)) { debuglevel = (uint8_t)atoi(argv[++i]); }
+    else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) { outage = strtoul(argv[++i], nullptr, 10); }
+    else if (strcmp(argv[i], "-m") == 0)                     { msgpack = true; }
+    else if ((strcmp(argv[i], "-p") == 0) && (i + 1 < argc)) { plug = strtoul(argv[++i], nullptr, 10); }
+  }
+  host::serialEcho = verbose;
+  host::peer       = mqttBroker;
+  host::httpGet    = weatherService;
+  attachDevices(plug == 0);
+  loadDataFiles("../data");
+  storeSettings(debuglevel);
+  if (cached) { storeTopology(plug == 0); }
+
+  auto     hostStart = std::chrono::steady_clock::now();
+  setup();
+  if (msgpack) { mqttEncoding = mySettings.mqttEncoding = TELEMETRY_MSGPACK; wsEncoding = mySettings.wsEncoding = TELEMETRY_MSGPACK; }
+  uint64_t bootTime  = host::now();
+  double   setupMs   = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - hostStart).count();
+
+  host::resetHeapPeak();
+  uint32_t minFreeHeap = ESP.getFreeHeap();
+  uint64_t loops = 0;
+  uint64_t end = bootTime + (uint64_t)seconds * 1000000;
+  hostStart = std::chrono::steady_clock::now();
+  uint64_t scd30Ready = bootTime + SCD30_READY;
+  uint64_t outageStart = bootTime + BROKER_OUTAGE_START;
+  uint64_t outageEnd   = outageStart + (uint64_t)outage * 1000000;
+  uint64_t resumeTime  = (seconds > 60) ? end - 60000000 : bootTime;
+  uint32_t resumeSeq   = 0;
+  uint64_t plugTime    = bootTime + (uint64_t)plug * 1000000;
+  while ((host::now() < end) && !host::restartRequested) {
+    if (host::now() >= scd30Ready) { host::interrupt(SCD30_RDY); scd30Ready += SCD30_READY; }
+    mqttBrokerDown = (host::now() >= outageStart) && (host::now() < outageEnd);
+    if (webSocket.connectedClients() == 0) { webSocket.connect(); } // one browser once the server runs
+    if ((resumeSeq == 0) && (host::now() >= resumeTime)) { resumeSeq = sampleSequence; }
+    if ((plug > 0) && (host::now() >= plugTime)) { host::attachI2C(BUS2_SDA, BUS2_SCL, 0x61, &scd30); plug = 0; }
+    loop();
+    loops++;
+    minFreeHeap = std::min(minFreeHeap, ESP.getFreeHeap());
+  }
+  double hostMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - hostStart).count();
+  double simulatedS = (host::now() - bootTime) / 1e6;
+
+  host::serialEcho = true;
+  printf("\nSensi host benchmark\n");
+  printf("  boot:        %10.1f s simulated %10.1f ms host\n", bootTime / 1e6, setupMs);
+  printf("  run:         %10.1f s simulated %10.1f ms host\n", simulatedS, hostMs);
+  printf("  loops:       %10llu %10.1f per s simulated %8.3f us host per loop\n", (unsigned long long)loops, loops / simulatedS, hostMs * 1000.0 / loops);
+  printf("  heap:        %10zu bytes in use %6zu peak %6u min free\n", host::heapUsed(), host::heapPeak(), minFreeHeap);
+  printf("  i2c:         %10u transactions %8.1f ms bus time %u stretch timeouts %u pin switches\n", host::i2cTransactions(), host::i2cBusTime() / 1e3, host::i2cStretchTimeouts(), host::i2cBegins());
+  printf("  network:     %10llu bytes sent %u connects %u MQTT publishes\n", (unsigned long long)host::networkBytesSent(), host::networkConnects(), mqttPublished);
+  printf("  websocket:   %10llu bytes sent %u messages\n", (unsigned long long)webSocket.bytesSent(), webSocket.messages());
+  printf("  file system: %10llu bytes written %u writes %u opens\n", (unsigned long long)host::fsBytesWritten(), host::fsWrites(), host::fsOpens());
+  printf("  eeprom:      %10llu bytes written %u commits\n", (unsigned long long)EEPROM.bytesWritten(), EEPROM.commits());
+  char queue[128];
+  queueJSON(queue, sizeof(queue));
+  printf("  mqtt queue:  %s\n", queue);
+  printf("  telemetry:   MQTT %u sent %u dropped, WebSocket %u sent %u dropped\n",
+         telemetryStates[TELEMETRY_MQTT].sent, telemetryStates[TELEMETRY_MQTT].dropped,
+         telemetryStates[TELEMETRY_WS].sent, telemetryStates[TELEMETRY_WS].dropped);
+  check(host::networkBytesSent() > 0, "network: bytes sent");
+  check(mqttPublished > 0, "network: MQTT publishes");
+  check(webSocket.bytesSent() > 0, "websocket: bytes sent");
+  check(host::i2cStretchTimeouts() == 0, "i2c: no stretch timeouts");
+  check(queueDropped == 0, "mqtt queue: no records dropped");
+  for (uint8_t i = PROFILE_SCD30; i <= PROFILE_MLX; i++) {
+    check(profiles[i].max <= TASKBUDGET * 1000UL, "sensor update: max within the task budget");
+  }
+  check(profiles[PROFILE_LCD].max <= TASKBUDGET * 1000UL, "LCD update: max within the task budget");
+  check(profiles[PROFILE_I2CQUEUE].max <= TASKBUDGET * 1000UL, "I2C queue: max within the task budget");
+  printf("\nSensor history, samples stored\n");
+  printHistory();
+  printf("\nMQTT topics, age at publish\n");
+  printTopicsMQTT();
+  printf("\nJSON generation, host time per call\n");
+  benchJSON("bme280", bme280JSON);
+  benchJSON("bme68x", bme68xJSON);
+  benchJSON("ccs811", ccs811JSON);
+  benchJSON("mlx",    mlxJSON);
+  benchJSON("scd30",  scd30JSON);
+  benchJSON("sgp30",  sgp30JSON);
+  benchJSON("sps30",  sps30JSON);
+  benchJSON("time",   timeJSON);
+  benchJSON("date",   dateJSON);
+  benchJSON("system", systemJSON);
+  printf("\nMessagePack generation, host time per call\n");
+  benchMsgPack("bme280", TELEMETRY_BME280);
+  benchMsgPack("bme68x", TELEMETRY_BME68X);
+  benchMsgPack("ccs811", TELEMETRY_CCS811);
+  benchMsgPack("mlx",    TELEMETRY_MLX);
+  benchMsgPack("scd30",  TELEMETRY_SCD30);
+  benchMsgPack("sgp30",  TELEMETRY_SGP30);
+  benchMsgPack("sps30",  TELEMETRY_SPS30);
+  benchMsgPack("all",    TELEMETRY_ALL);
+  printf("\nHTTP requests, host time per request\n");
+  check(benchHTTP("config",           "/config", {}) == 200, "config: served");
+  check(benchHTTP("schema",           "/schema", {}) == 200, "schema: served");
+  check(benchHTTP("profile",          "/profile", {}) == 200, "profile: served");
+  check(benchHTTP("history",          "/history", {}) == 200, "history: served");
+  benchHTTP("history scd30.CO2 1s",   "/history", {{"ch", "scd30.CO2"}, {"res", "1"}});
+  benchHTTP("history scd30.CO2 1min", "/history", {{"ch", "scd30.CO2"}, {"res", "60"}});
+  benchHTTP("history bme280.p 1h",    "/history", {{"ch", "bme280.p"}, {"res", "3600"}});
+  benchHTTP("archive csv",            "/archive", {});
+  benchHTTP("archive ndjson",         "/archive", {{"format", "ndjson"}});
+  check(benchHTTP("api all",          "/api/all", {}) == 200, "api all: served");
+  check(responseHeader("ETag").length() == 0, "api all: no ETag with system and time");
+  check(benchHTTP("api all scd30,date", "/api/all", {{"fields", "scd30,date"}}) == 200, "api all scd30,date: served");
+  String etag = responseHeader("ETag");
+  check(benchHTTP("api all not modified", "/api/all", {{"fields", "scd30,date"}}, {{"If-None-Match", etag}}) == 304,
+        "api all scd30,date: 304 for its ETag");
+  benchHTTP("api all scd30,time",     "/api/all", {{"fields", "scd30,time"}});
+  benchDashboard();
+  check(benchFile("file index.htm",   "/") == 200, "file index.htm: served");
+  etag = responseHeader("ETag");
+  check(benchFile("file index.htm 304", "/", {{"If-None-Match", etag}}) == 304, "file index.htm: 304 for its ETag");
+  benchFile("file main.css",          "/main.css");
+  benchFile("file png",               "/airquality-48x48.png");
+  benchStaleFile("file stale css");
+  printf("\nHTTP connections, %u at most\n", NBWS_MAX_CLIENTS);
+  File index = LittleFS.open("/index.htm", "r");
+  size_t indexSize = index ? index.size() : 0;
+  index.close();
+  check((benchSlowBrowser("index.htm fast", HOST_TCPWINDOW, SIZE_MAX) == 200) && (httpReply.body.size() == indexSize), "index.htm fast: whole file");
+  check((benchSlowBrowser("index.htm slow", 1460, 256) == 200) && (httpReply.body.size() == indexSize), "index.htm slow: whole file");
+  benchConnections();
+  benchUpload("upload 5 kB",              "/bench.txt", 5000);
+  check((benchLargeResponse("send 3 kB slow", 3000, 0) == 200) && (httpReply.body.size() == 3000), "send 3 kB slow: whole response");
+  check(benchLargeResponse("send 6 kB slow", 6000, 0) == 500, "send 6 kB slow: 500 when it does not fit");
+  check(benchLargeResponse("sendContent 6 kB slow", 6000, 1000) == 500, "sendContent 6 kB slow: 500 for its length");
+  check((benchLargeResponse("chunked 6 kB slow", 6000, 1000, true) == 200) && (httpReply.body.size() > 0) &&
+        (httpReply.body.size() < 6000), "chunked 6 kB slow: cut off and ended");
+  benchClosing();
+  printf("  %-22s %8u accepted %u served %u rejected %u timeouts %u grown %u overflows\n", "all benchmarks",
+         httpServer.accepted(), httpServer.served(), httpServer.rejected(), httpServer.timeouts(), httpServer.grown(), httpServer.overflows());
+  printf("\nWebSocket dashboard, messages and bytes to one client on connect\n");
+  check(benchWebSocket("snapshot",    "/") > 0, "websocket snapshot: sent");
+  benchWebSocket("resume 60 s behind", (String("/?seq=") + String(resumeSeq)).c_str());
+  benchWebSocket("resume current",    (String("/?seq=") + String(sampleSequence)).c_str());
+  printf("\nSettings journal\n");
+  benchJournal("damaged snapshot");
+  benchJournalMigration("version 1 snapshot");
+  printf("\n");
+  printProfiles();
+  if (failures > 0) { printf("\n%d checks failed\n", failures); }
+  return failures;
+}
@@ -0,0 +1,824 @@
+/******************************************************************************************************/
+// Non blocking HTTP/1.1 server
+/******************************************************************************************************/
+#include "NonBlockingWebServer.h"
+
+static const char *statusText(int code) {
+  switch (code) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default:  return "";
+  }
+}
+
+// header name of length len is key, case insensitive
+static bool headerIs(const char *name, size_t len, const char *key) {
+  return (strlen(key) == len) && (strncasecmp(name, key, len) == 0);
+}
+
+// first occurrence of needle in binary data, NULL if not found
+static const uint8_t *findBytes(const uint8_t *data, size_t len, const char *needle, size_t needleLength) {
+  if (needleLength > len) { return NULL; }
+  for (size_t i = 0; i <= len - needleLength; i++) {
+    if ((data[i] == (uint8_t)needle[0]) && (memcmp(data + i, needle, needleLength) == 0)) { return data + i; }
+  }
+  return NULL;
+}
+
+static uint8_t hexValue(char c) {
+  if ((c >= '0') && (c <= '9')) { return c - '0'; }
+  if ((c >= 'a') && (c <= 'f')) { return c - 'a' + 10; }
+  if ((c >= 'A') && (c <= 'F')) { return c - 'A' + 10; }
+  return 0;
+}
+
+static String urlDecode(const char *text, size_t len) {
+  String decoded;
+  decoded.reserve(len);
+  for (size_t i = 0; i < len; i++) {
+    if (text[i] == '+') {
+      decoded += ' ';
+    } else if ((text[i] == '%') && (i + 2 < len) && isxdigit(text[i+1]) && isxdigit(text[i+2])) {
+      decoded += (char)((hexValue(text[i+1]) << 4) | hexValue(text[i+2]));
+      i += 2;
+    } else {
+      decoded += text[i];
+    }
+  }
+  return decoded;
+}
+
+// value of name="value" in a Content-Disposition header
+static String dispositionValue(const char *header, size_t len, const char *name) {
+  String key = String(name) + "=\"";
+  const uint8_t *start = findBytes((const uint8_t *)header, len, key.c_str(), key.length());
+  if (start == NULL) { return String(); }
+  start += key.length();
+  const uint8_t *end = (const uint8_t *)memchr(start, '"', len - (start - (const uint8_t *)header));
+  return (end == NULL) ? String() : String((const char *)start, end - start);
+}
+
+/******************************************************************************************************/
+// Server
+/******************************************************************************************************/
+
+NonBlockingWebServer::NonBlockingWebServer(uint16_t port)
+  : _server(port), _current(NULL), _routeCount(0), _method(HTTP_GET), _argCount(0), _headerCount(0),
+    _contentLength(CONTENT_LENGTH_NOT_SET), _http10(false), _urlencoded(false), _expectContinue(false),
+    _part(NBWS_PART_BOUNDARY), _partFile(false), _upload(NULL), _requestId(0),
+    _served(0), _accepted(0), _rejected(0), _timeouts(0), _grown(0), _overflows(0) {
+  for (uint8_t i = 0; i < NBWS_MAX_CLIENTS; i++) {
+    _connections[i].state    = NBWS_FREE;
+    _connections[i].request  = NULL;
+    _connections[i].response = NULL;
+  }
+}
+
+NonBlockingWebServer::~NonBlockingWebServer() {
+  stop();
+}
+
+void NonBlockingWebServer::begin(void) {
+  _server.begin();
+}
+
+void NonBlockingWebServer::stop(void) {
+  for (uint8_t i = 0; i < NBWS_MAX_CLIENTS; i++) {
+    if (_connections[i].state != NBWS_FREE) { closeConnection(_connections[i]); }
+  }
+  _server.stop();
+}
+
+void NonBlockingWebServer::on(const String &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+  if (_routeCount >= NBWS_MAX_ROUTES) { return; }
+  _routes[_routeCount].uri    = uri;
+  _routes[_routeCount].method = method;
+  _routes[_routeCount].fn     = fn;
+  _routes[_routeCount].ufn    = ufn;
+  _routeCount++;
+}
+
+void NonBlockingWebServer::collectHeaders(const char *headerKeys[], const size_t headerKeysCount) {
+  _headerCount = (headerKeysCount < NBWS_MAX_HEADERS) ? headerKeysCount : NBWS_MAX_HEADERS;
+  for (uint8_t i = 0; i < _headerCount; i++) {
+    _headerKeys[i]   = headerKeys[i];
+    _headerValues[i] = String();
+  }
+}
+
+String NonBlockingWebServer::arg(const String &name) {
+  for (int i = 0; i < _argCount; i++) { if (_argNames[i] == name) { return _argValues[i]; } }
+  return String();
+}
+
+bool NonBlockingWebServer::hasArg(const String &name) {
+  for (int i = 0; i < _argCount; i++) { if (_argNames[i] == name) { return true; } }
+  return false;
+}
+
+String NonBlockingWebServer::header(const String &name) {
+  for (uint8_t i = 0; i < _headerCount; i++) { if (_headerKeys[i].equalsIgnoreCase(name)) { return _headerValues[i]; } }
+  return String();
+}
+
+bool NonBlockingWebServer::active(uint32_t id) {
+  for (uint8_t i = 0; i < NBWS_MAX_CLIENTS; i++) {
+    if ((_connections[i].state == NBWS_SEND) && (_connections[i].id == id)) { return true; }
+  }
+  return false;
+}
+
+uint8_t NonBlockingWebServer::connections(void) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < NBWS_MAX_CLIENTS; i++) { if (_connections[i].state != NBWS_FREE) { n++; } }
+  return n;
+}
+
+/******************************************************************************************************/
+// Connections
+/******************************************************************************************************/
+
+void NonBlockingWebServer::handleClient(void) {
+  accept();
+  for (uint8_t i = 0; i < NBWS_MAX_CLIENTS; i++) {
+    Connection &c = _connections[i];
+    if (c.state == NBWS_FREE) { continue; }
+    if (!c.client.connected() && ((c.state != NBWS_SEND) || (c.client.status() == CLOSED))) {  // a half closed client still reads
+      closeConnection(c);
+      continue;
+    }
+    switch (c.state) {
+      case NBWS_IDLE:
+      case NBWS_HEADERS: readHeaders(c);  break;
+      case NBWS_BODY:    readBody(c);     break;
+      case NBWS_UPLOAD:  readUpload(c);   break;
+      case NBWS_SEND:    sendResponse(c); break;
+      case NBWS_DISCARD: linger(c);       break;
+    }
+    unsigned long idle = millis() - c.lastActivity;
+    if ((c.state == NBWS_IDLE) && (idle > NBWS_KEEPALIVE)) {
+      closeConnection(c);
+    } else if ((c.state != NBWS_FREE) && (c.state != NBWS_IDLE) && (c.state != NBWS_DISCARD) && (idle > NBWS_TIMEOUT)) {
+      _timeouts++;
+      closeConnection(c);
+    }
+  }
+}
+
+// a new connection takes a free slot or the slot of the longest idle keep-alive connection
+void NonBlockingWebServer::accept(void) {
+  while (_server.hasClient()) {
+    WiFiClient client = _server.available();
+    if (!client) { break; }
+    Connection *slot = NULL;
+    Connection *idle = NULL;
+    for (uint8_t i = 0; i < NBWS_MAX_CLIENTS; i++) {
+      Connection &c = _connections[i];
+      if ((c.state != NBWS_FREE) && !c.client.connected()) { closeConnection(c); }
+      if (c.state == NBWS_FREE) { slot = &c; break; }
+      if ((c.state == NBWS_IDLE) && (c.requests > 0) && (c.requestLength == 0) && ((idle == NULL) || (c.lastActivity < idle->lastActivity))) { idle = &c; }
+    }
+    if ((slot == NULL) && (idle != NULL)) { closeConnection(*idle); slot = idle; }
+    char    *request  = (slot != NULL) ? (char *)malloc(NBWS_REQUEST_LENGTH) : NULL;
+    uint8_t *response = (request != NULL) ? (uint8_t *)malloc(NBWS_RESPONSE_LENGTH) : NULL;
+    if (response == NULL) {
+      uint8_t discard[64];
+      free(request);
+      client.print(F("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\nRetry-After: 1\r\n\r\n"));
+      while (client.read(discard, sizeof(discard)) > 0) {}     // unread data would reset the connection
+      client.stop();
+      _rejected++;
+      continue;
+    }
+    client.setNoDelay(true);
+    slot->client         = client;
+    slot->state          = NBWS_IDLE;
+    slot->request        = request;
+    slot->requestLength  = 0;
+    slot->headerLength   = 0;
+    slot->response       = response;
+    slot->responseSize   = NBWS_RESPONSE_LENGTH;
+    slot->responseStart  = 0;
+    slot->responseLength = 0;
+    slot->bodyRemaining  = 0;
+    slot->keepAlive      = true;
+    slot->chunked        = false;
+    slot->head           = false;
+    slot->headersSent    = false;
+    slot->ended          = false;
+    slot->cut            = false;
+    slot->rejected       = false;
+    slot->requests       = 0;
+    slot->id             = 0;
+    slot->lastActivity   = millis();
+    _accepted++;
+  }
+}
+
+void NonBlockingWebServer::closeConnection(Connection &c) {
+  if ((c.state == NBWS_UPLOAD) && (_upload != NULL)) {
+    if (_partFile) { uploadEvent(c, UPLOAD_FILE_ABORTED); }
+    delete _upload;
+    _upload = NULL;
+  }
+  if (_current == &c) { _current = NULL; }
+  if (c.request != NULL) {                                       // unread data would reset the connection
+    while (c.client.read((uint8_t *)c.request, NBWS_REQUEST_LENGTH) > 0) {}
+  }
+  c.client.stop();
+  c.file.close();
+  c.file     = File();
+  c.producer = nullptr;
+  free(c.request);
+  free(c.response);
+  c.request  = NULL;
+  c.response = NULL;
+  c.state    = NBWS_FREE;
+}
+
+/******************************************************************************************************/
+// Request
+/******************************************************************************************************/
+
+void NonBlockingWebServer::readHeaders(Connection &c) {
+  int available = c.client.available();
+  if ((available > 0) && (c.requestLength < NBWS_REQUEST_LENGTH - 1)) {
+    size_t room = NBWS_REQUEST_LENGTH - 1 - c.requestLength;
+    int n = c.client.read((uint8_t *)c.request + c.requestLength, ((size_t)available < room) ? available : room);
+    if (n > 0) { c.requestLength += n; c.lastActivity = millis(); }
+  }
+  if (c.requestLength == 0) { return; }
+  c.state = NBWS_HEADERS;
+  c.request[c.requestLength] = '\0';
+  char *end = strstr(c.request, "\r\n\r\n");
+  if (end == NULL) {
+    if (c.requestLength >= NBWS_REQUEST_LENGTH - 1) { reject(c, 431); }
+    return;
+  }
+  c.headerLength = end + 4 - c.request;
+  if (!parseRequest(c)) { return; }
+  if (_expectContinue && (c.bodyRemaining > 0)) { c.client.print(F("HTTP/1.1 100 Continue\r\n\r\n")); }
+
+  if (_boundary.length() > 0) {                                  // multipart upload, body is passed on in pieces
+    int8_t route = findRoute();
+    if ((route < 0) || !_routes[route].ufn) { reject(c, 404); return; }
+    if (_upload != NULL)                    { reject(c, 503); return; }
+    _upload = new HTTPUpload();
+    if (_upload == NULL)                    { reject(c, 503); return; }
+    _uploadUri = _uri;
+    _part      = NBWS_PART_BOUNDARY;
+    _partFile  = false;
+    c.route    = route;
+    c.requestLength -= c.headerLength;
+    memmove(c.request, c.request + c.headerLength, c.requestLength);
+    if (c.requestLength > c.bodyRemaining) { c.requestLength = c.bodyRemaining; }
+    c.bodyRemaining -= c.requestLength;
+    startRequest(c);
+    c.state = NBWS_UPLOAD;
+    readUpload(c);
+  } else if (c.bodyRemaining > 0) {                              // form or plain body, kept in the request buffer
+    if ((c.bodyRemaining > NBWS_BODY_LENGTH) || (c.headerLength + c.bodyRemaining >= NBWS_REQUEST_LENGTH)) { reject(c, 413); return; }
+    c.state = NBWS_BODY;
+    readBody(c);
+  } else {
+    dispatch(c);
+  }
+}
+
+void NonBlockingWebServer::readBody(Connection &c) {
+  size_t length = c.headerLength + c.bodyRemaining;
+  int available = c.client.available();
+  if ((available > 0) && (c.requestLength < length)) {
+    size_t room = length - c.requestLength;
+    int n = c.client.read((uint8_t *)c.request + c.requestLength, ((size_t)available < room) ? available : room);
+    if (n > 0) { c.requestLength += n; c.lastActivity = millis(); }
+  }
+  if (c.requestLength < length) { return; }
+  c.request[c.requestLength] = '\0';
+  parseRequest(c);                                               // other connections were served meanwhile
+  const char *body = c.request + c.headerLength;
+  size_t      size = length - c.headerLength;
+  if (_urlencoded) {
+    parseArguments(body, size);
+  } else if (_argCount < NBWS_MAX_ARGS) {
+    _argNames[_argCount]  = "plain";
+    _argValues[_argCount] = String(body, size);
+    _argCount++;
+  }
+  dispatch(c);
+}
+
+// request line and headers into uri, method, arguments and collected headers, false if rejected
+bool NonBlockingWebServer::parseRequest(Connection &c) {
+  _argCount       = 0;
+  _urlencoded     = false;
+  _expectContinue = false;
+  _boundary       = String();
+  for (uint8_t i = 0; i < _headerCount; i++) { _headerValues[i] = String(); }
+
+  char *line = c.request;
+  char *eol  = strstr(line, "\r\n");
+  char *uri  = (char *)memchr(line, ' ', eol - line);
+  char *version = (uri != NULL) ? (char *)memchr(uri + 1, ' ', eol - uri - 1) : NULL;
+  if (version == NULL) { reject(c, 400); return false; }
+  size_t methodLength = uri - line;
+  uri++;
+  if      (headerIs(line, methodLength, "GET"))     { _method = HTTP_GET; }
+  else if (headerIs(line, methodLength, "HEAD"))    { _method = HTTP_HEAD; }
+  else if (headerIs(line, methodLength, "POST"))    { _method = HTTP_POST; }
+  else if (headerIs(line, methodLength, "PUT"))     { _method = HTTP_PUT; }
+  else if (headerIs(line, methodLength, "PATCH"))   { _method = HTTP_PATCH; }
+  else if (headerIs(line, methodLength, "DELETE"))  { _method = HTTP_DELETE; }
+  else if (headerIs(line, methodLength, "OPTIONS")) { _method = HTTP_OPTIONS; }
+  else { reject(c, 501); return false; }
+  _http10     = (strncmp(version + 1, "HTTP/1.0", 8) == 0);
+  c.keepAlive = !_http10;
+  c.head      = (_method == HTTP_HEAD);
+  char *query = (char *)memchr(uri, '?', version - uri);
+  _uri = urlDecode(uri, ((query != NULL) ? query : version) - uri);
+  if (query != NULL) { parseArguments(query + 1, version - query - 1); }
+
+  c.bodyRemaining = 0;
+  for (line = eol + 2; line < c.request + c.headerLength - 2; line = eol + 2) {
+    eol = strstr(line, "\r\n");
+    char *colon = (char *)memchr(line, ':', eol - line);
+    if (colon == NULL) { continue; }
+    size_t nameLength = colon - line;
+    char  *value = colon + 1;
+    while ((value < eol) && (*value == ' ')) { value++; }
+    size_t valueLength = eol - value;
+    if (headerIs(line, nameLength, "Content-Length")) {
+      c.bodyRemaining = strtoul(value, NULL, 10);
+    } else if (headerIs(line, nameLength, "Connection")) {
+      if      (strncasecmp(value, "close", 5) == 0)      { c.keepAlive = false; }
+      else if (strncasecmp(value, "keep-alive", 10) == 0) { c.keepAlive = true; }
+    } else if (headerIs(line, nameLength, "Expect")) {
+      _expectContinue = (strncasecmp(value, "100-continue", 12) == 0);
+    } else if (headerIs(line, nameLength, "Content-Type")) {
+      if (strncasecmp(value, "multipart/form-data", 19) == 0) {
+        const uint8_t *boundary = findBytes((const uint8_t *)value, valueLength, "boundary=", 9);
+        if (boundary != NULL) {
+          boundary += 9;
+          size_t boundaryLength = (const uint8_t *)eol - boundary;
+          if ((boundaryLength > 1) && (boundary[0] == '"')) { boundary++; boundaryLength -= 2; }
+          _boundary = String((const char *)boundary, boundaryLength);
+        }
+      } else if (strncasecmp(value, "application/x-www-form-urlencoded", 33) == 0) {
+        _urlencoded = true;
+      }
+    }
+    for (uint8_t i = 0; i < _headerCount; i++) {
+      if (headerIs(line, nameLength, _headerKeys[i].c_str())) { _headerValues[i] = String(value, valueLength); }
+    }
+  }
+  return true;
+}
+
+// name=value&name=value
+void NonBlockingWebServer::parseArguments(const char *query, size_t len) {
+  const char *end = query + len;
+  while ((query < end) && (_argCount < NBWS_MAX_ARGS)) {
+    const char *next  = (const char *)memchr(query, '&', end - query);
+    if (next == NULL) { next = end; }
+    const char *equal = (const char *)memchr(query, '=', next - query);
+    if (next > query) {
+      _argNames[_argCount]  = urlDecode(query, ((equal != NULL) ? equal : next) - query);
+      _argValues[_argCount] = (equal != NULL) ? urlDecode(equal + 1, next - equal - 1) : String();
+      _argCount++;
+    }
+    query = next + 1;
+  }
+}
+
+int8_t NonBlockingWebServer::findRoute(void) {
+  for (uint8_t i = 0; i < _routeCount; i++) {
+    Route &r = _routes[i];
+    if ((r.uri == _uri) && ((r.method == HTTP_ANY) || (r.method == _method) || ((r.method == HTTP_GET) && (_method == HTTP_HEAD)))) { return i; }
+  }
+  return -1;
+}
+
+// handler runs on the connection, the response is queued
+void NonBlockingWebServer::select(Connection &c) {
+  _current         = &c;
+  _responseHeaders = String();
+  _contentLength   = CONTENT_LENGTH_NOT_SET;
+}
+
+void NonBlockingWebServer::startRequest(Connection &c) {
+  c.id          = ++_requestId;
+  c.headersSent = false;
+  c.chunked     = false;
+  c.ended       = false;
+  c.cut         = false;
+  c.rejected    = false;
+  c.requests++;
+  if (c.requests >= NBWS_MAX_REQUESTS) { c.keepAlive = false; }
+  _served++;
+}
+
+// a handler that sent nothing gets 500, a chunked response without last chunk is ended
+void NonBlockingWebServer::finishHandler(Connection &c) {
+  if (_current != &c) { return; }                                // closed by the handler
+  if (!c.headersSent) {
+    send(500, "text/plain", "500: no response");
+  } else if (c.chunked && !c.ended && !c.producer && !c.head && !c.cut) {
+    queue(c, (const uint8_t *)"0\r\n\r\n", 5);
+    c.ended = true;
+  }
+  _current = NULL;
+  c.state  = NBWS_SEND;
+}
+
+void NonBlockingWebServer::dispatch(Connection &c) {
+  size_t consumed = c.headerLength + c.bodyRemaining;
+  c.requestLength -= consumed;                                   // pipelined requests stay in the buffer
+  memmove(c.request, c.request + consumed, c.requestLength);
+  c.bodyRemaining  = 0;
+  startRequest(c);
+  c.state = NBWS_SEND;
+  select(c);
+  int8_t route = findRoute();
+  if (route >= 0)              { _routes[route].fn(); }
+  else if (_notFound)          { _notFound(); }
+  else                         { send(404, "text/plain", String("Not found: ") + _uri); }
+  finishHandler(c);
+}
+
+// error response without handler, the connection is closed afterwards
+void NonBlockingWebServer::reject(Connection &c, int code) {
+  c.requestLength = 0;
+  c.bodyRemaining = 0;
+  c.keepAlive     = false;
+  c.head          = false;
+  startRequest(c);
+  c.rejected = true;
+  c.state = NBWS_SEND;
+  select(c);
+  send(code, "text/plain", String(code) + ": " + statusText(code));
+  _current = NULL;
+}
+
+// the rest of the request is read and dropped until the client closes or NBWS_LINGER has passed
+void NonBlockingWebServer::linger(Connection &c) {
+  c.client.read((uint8_t *)c.request, NBWS_REQUEST_LENGTH);
+  if (millis() - c.lastActivity > NBWS_LINGER) { closeConnection(c); }
+}
+
+/******************************************************************************************************/
+// Upload
+/******************************************************************************************************/
+
+void NonBlockingWebServer::readUpload(Connection &c) {
+  int available = c.client.available();
+  if ((available > 0) && (c.bodyRemaining > 0) && (c.requestLength < NBWS_REQUEST_LENGTH)) {
+    size_t room = NBWS_REQUEST_LENGTH - c.requestLength;
+    if (room > c.bodyRemaining)     { room = c.bodyRemaining; }
+    if (room > (size_t)available)   { room = available; }
+    int n = c.client.read((uint8_t *)c.request + c.requestLength, room);
+    if (n > 0) { c.requestLength += n; c.bodyRemaining -= n; c.lastActivity = millis(); }
+  }
+  while (parseMultipart(c)) {}
+  if (_part == NBWS_PART_END) {
+    c.requestLength = 0;                                           // epilogue
+    if (c.bodyRemaining > 0) { return; }
+    delete _upload;
+    _upload = NULL;
+    select(c);
+    _uri = _uploadUri; _method = HTTP_POST; _argCount = 0;
+    _routes[c.route].fn();
+    finishHandler(c);
+  } else if ((c.bodyRemaining == 0) || (c.requestLength == NBWS_REQUEST_LENGTH)) {
+    if ((c.bodyRemaining == 0) || (_part == NBWS_PART_HEADERS)) { // body ended early or part headers too long
+      if (_partFile) { uploadEvent(c, UPLOAD_FILE_ABORTED); }
+      delete _upload;
+      _upload = NULL;
+      reject(c, 400);
+    }
+  }
+}
+
+// one step of the multipart parser on the request buffer, false when more data is needed
+bool NonBlockingWebServer::parseMultipart(Connection &c) {
+  const uint8_t *data = (const uint8_t *)c.request;
+  size_t consumed = 0;
+  String delimiter = "--" + _boundary;
+  switch (_part) {
+    case NBWS_PART_BOUNDARY: {                                   // --boundary followed by CRLF or --
+      const uint8_t *found = findBytes(data, c.requestLength, delimiter.c_str(), delimiter.length());
+      if (found == NULL) {                                       // preamble
+        if (c.requestLength > delimiter.length()) { consumed = c.requestLength - delimiter.length(); }
+        break;
+      }
+      size_t end = found - data + delimiter.length();
+      if (end + 2 > c.requestLength) { consumed = found - data; break; }
+      _part = (memcmp(data + end, "--", 2) == 0) ? NBWS_PART_END : NBWS_PART_HEADERS;
+      consumed = end + 2;
+      break;
+    }
+    case NBWS_PART_HEADERS: {
+      const uint8_t *end = findBytes(data, c.requestLength, "\r\n\r\n", 4);
+      if (end == NULL) { break; }
+      String filename = dispositionValue((const char *)data, end - data, "filename");
+      _partFile = (filename.length() > 0);
+      if (_partFile) {
+        const uint8_t *type = findBytes(data, end - data, "Content-Type:", 13);
+        const uint8_t *eol  = (type != NULL) ? findBytes(type, end + 2 - type, "\r\n", 2) : NULL;
+        _upload->filename    = filename;
+        _upload->name        = dispositionValue((const char *)data, end - data, "name");
+        _upload->type        = (eol != NULL) ? String((const char *)type + 13, eol - type - 13) : String("application/octet-stream");
+        _upload->type.trim();
+        _upload->totalSize   = 0;
+        _upload->currentSize = 0;
+        uploadEvent(c, UPLOAD_FILE_START);
+      }
+      _part    = NBWS_PART_DATA;
+      consumed = end + 4 - data;
+      break;
+    }
+    case NBWS_PART_DATA: {                                       // data up to CRLF--boundary
+      String separator = "\r\n" + delimiter;
+      const uint8_t *found = findBytes(data, c.requestLength, separator.c_str(), separator.length());
+      if (found != NULL) {
+        consumed = found - data;
+        uploadData(c, data, consumed);
+        if (_partFile) {
+          uploadEvent(c, UPLOAD_FILE_WRITE);
+          uploadEvent(c, UPLOAD_FILE_END);
+          _partFile = false;
+        }
+        consumed += 2;
+        _part = NBWS_PART_BOUNDARY;
+      } else if (c.requestLength >= separator.length()) {        // keep what could be the start of the separator
+        consumed = c.requestLength - separator.length() + 1;
+        uploadData(c, data, consumed);
+      }
+      break;
+    }
+    default: break;
+  }
+  if (consumed == 0) { return false; }
+  c.requestLength -= consumed;
+  memmove(c.request, c.request + consumed, c.requestLength);
+  return (_part != NBWS_PART_END);
+}
+
+// file data is collected in the upload buffer and passed on when it is full
+void NonBlockingWebServer::uploadData(Connection &c, const uint8_t *data, size_t len) {
+  if (!_partFile) { return; }
+  while (len > 0) {
+    size_t n = HTTP_UPLOAD_BUFLEN - _upload->currentSize;
+    if (n > len) { n = len; }
+    memcpy(_upload->buf + _upload->currentSize, data, n);
+    _upload->currentSize += n;
+    data += n;
+    len  -= n;
+    if (_upload->currentSize == HTTP_UPLOAD_BUFLEN) { uploadEvent(c, UPLOAD_FILE_WRITE); }
+  }
+}
+
+void NonBlockingWebServer::uploadEvent(Connection &c, HTTPUploadStatus status) {
+  if ((status == UPLOAD_FILE_WRITE) && (_upload->currentSize == 0)) { return; }
+  _upload->status = status;
+  if (status == UPLOAD_FILE_WRITE) { _upload->totalSize += _upload->currentSize; }
+  Connection *current = _current;
+  if (status == UPLOAD_FILE_ABORTED) { _current = NULL; }        // connection is closing, nothing is sent
+  else                               { select(c); _uri = _uploadUri; _method = HTTP_POST; _argCount = 0; }
+  _routes[c.route].ufn();
+  if (status == UPLOAD_FILE_WRITE) { _upload->currentSize = 0; }
+  _current = current;
+}
+
+/******************************************************************************************************/
+// Response
+/******************************************************************************************************/
+
+void NonBlockingWebServer::sendHeader(const String &name, const String &value, bool first) {
+  String line = name + ": " + value + "\r\n";
+  if (first) { _responseHeaders = line + _responseHeaders; }
+  else       { _responseHeaders += line; }
+}
+
+// a second response to the same request is dropped
+void NonBlockingWebServer::send(int code, const char *contentType, const String &content) {
+  if ((_current == NULL) || _current->headersSent) { return; }
+  Connection &c = *_current;
+  char line[96];
+  String header;
+  header.reserve(128 + _responseHeaders.length());
+  snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", code, statusText(code));
+  header += line;
+  if ((contentType != NULL) && (*contentType != '\0')) { header += "Content-Type: "; header += contentType; header += "\r\n"; }
+  size_t length = (_contentLength == CONTENT_LENGTH_NOT_SET) ? content.length() : _contentLength;
+  if (length == CONTENT_LENGTH_UNKNOWN) {
+    if (_http10) { c.keepAlive = false; }                        // HTTP/1.0 ends the body by closing
+    else         { c.chunked = true; header += "Transfer-Encoding: chunked\r\n"; }
+  } else if ((code != 204) && (code != 304)) {
+    snprintf(line, sizeof(line), "Content-Length: %u\r\n", (unsigned int)length);
+    header += line;
+  }
+  header += _responseHeaders;
+  if (c.keepAlive) {
+    snprintf(line, sizeof(line), "Connection: keep-alive\r\nKeep-Alive: timeout=%u, max=%u\r\n",
+             (unsigned int)(NBWS_KEEPALIVE / 1000), (unsigned int)(NBWS_MAX_REQUESTS - c.requests));
+    header += line;
+  } else {
+    header += "Connection: close\r\n";
+  }
+  header += "\r\n";
+  size_t room = (c.responseLength == 0) ? c.client.availableForWrite() : 0;
+  size_t body = c.head ? 0 : content.length();
+  if (!c.head && !c.file && (length != CONTENT_LENGTH_UNKNOWN) && (length > body)) { body = length; }  // rest follows with sendContent()
+  if ((code != 500) && (header.length() + body > room + NBWS_RESPONSE_MAX - c.responseLength)) {
+    _overflows++;                                                // too large to keep, handler should use sendChunked()
+    _responseHeaders = String();
+    _contentLength   = CONTENT_LENGTH_NOT_SET;
+    c.keepAlive      = false;
+    c.file.close();
+    c.file           = File();
+    send(500, "text/plain", "500: response too large");
+    c.cut            = true;                                     // what the handler sends next is dropped
+    return;
+  }
+  c.headersSent = true;
+  queue(c, (const uint8_t *)header.c_str(), header.length());
+  if (content.length() > 0) { sendContent(content); }
+}
+
+void NonBlockingWebServer::send_P(int code, PGM_P contentType, PGM_P content) {
+  String type = FPSTR(contentType);
+  send(code, type.c_str(), String(FPSTR(content)));
+}
+
+// in chunked mode an empty content ends the response
+void NonBlockingWebServer::sendContent(const char *content, size_t size) {
+  if ((_current == NULL) || _current->head) { return; }
+  Connection &c = *_current;
+  if (!c.chunked) {
+    queue(c, (const uint8_t *)content, size);
+  } else if (!c.ended) {
+    if (size == 0) { queue(c, (const uint8_t *)"0\r\n\r\n", 5); c.ended = true; }
+    else           { queueChunk(c, content, size); }
+  }
+}
+
+void NonBlockingWebServer::sendContent_P(PGM_P content) {
+  sendContent(String(FPSTR(content)));
+}
+
+// headers now, the file as the client takes it, the server closes the file when done
+size_t NonBlockingWebServer::streamFile(File &file, const String &contentType) {
+  if ((_current == NULL) || _current->headersSent) { return 0; }
+  if (String(file.name()).endsWith(".gz") && (contentType != "application/x-gzip") && (contentType != "application/octet-stream")) {
+    sendHeader("Content-Encoding", "gzip");
+  }
+  _contentLength = file.size();
+  if (!_current->head) { _current->file = file; }               // before send(), the file does not take the response buffer
+  send(200, contentType.c_str(), String());
+  return file.size();
+}
+
+// headers now, the body is produced as the client takes it
+void NonBlockingWebServer::sendChunked(int code, const char *contentType, TProducerFunction producer) {
+  if (_current == NULL) { return; }
+  _contentLength = CONTENT_LENGTH_UNKNOWN;
+  send(code, contentType, String());
+  if (!_current->head) { _current->producer = producer; }
+}
+
+// a chunk is queued whole or not at all
+void NonBlockingWebServer::queueChunk(Connection &c, const char *data, size_t len) {
+  char size[12];
+  int  l = snprintf(size, sizeof(size), "%X\r\n", (unsigned int)len);
+  if (!fits(c, l + len + 2)) { return; }
+  queue(c, (const uint8_t *)size, l);
+  queue(c, (const uint8_t *)data, len);
+  queue(c, (const uint8_t *)"\r\n", 2);
+}
+
+// what the TCP send buffer takes is written, the rest waits in the response buffer
+// a response that does not fit into NBWS_RESPONSE_MAX is cut off, what is queued is sent and the connection closed after it
+void NonBlockingWebServer::queue(Connection &c, const uint8_t *data, size_t len) {
+  if ((c.state == NBWS_FREE) || !fits(c, len)) { return; }
+  if (c.responseLength == 0) {
+    size_t n = c.client.availableForWrite();
+    if (n > len) { n = len; }
+    if (n > 0) {
+      n = c.client.write(data, n);
+      data += n;
+      len  -= n;
+      c.lastActivity = millis();
+    }
+  }
+  if (len == 0) { return; }
+  if (c.responseStart + c.responseLength + len > c.responseSize) {
+    memmove(c.response, c.response + c.responseStart, c.responseLength);
+    c.responseStart = 0;
+  }
+  memcpy(c.response + c.responseStart + c.responseLength, data, len);
+  c.responseLength += len;
+}
+
+// false when len bytes do not fit into the response buffer, the response is cut off then
+bool NonBlockingWebServer::fits(Connection &c, size_t len) {
+  if (c.cut) { return false; }
+  size_t writable = (c.responseLength == 0) ? c.client.availableForWrite() : 0;
+  if ((len <= writable + c.responseSize - c.responseLength) || growResponse(c, c.responseLength + len - writable)) { return true; }
+  _overflows++;
+  c.cut       = true;
+  c.keepAlive = false;
+  return false;
+}
+
+// in steps of NBWS_RESPONSE_LENGTH, false if larger than NBWS_RESPONSE_MAX or out of memory
+bool NonBlockingWebServer::growResponse(Connection &c, size_t size) {
+  size = (size + NBWS_RESPONSE_LENGTH - 1) / NBWS_RESPONSE_LENGTH * NBWS_RESPONSE_LENGTH;
+  if (size > NBWS_RESPONSE_MAX) { return false; }
+  uint8_t *response = (uint8_t *)realloc(c.response, size);
+  if (response == NULL) { return false; }
+  if (c.responseSize == NBWS_RESPONSE_LENGTH) { _grown++; }
+  c.response     = response;
+  c.responseSize = size;
+  return true;
+}
+
+size_t NonBlockingWebServer::drain(Connection &c) {
+  if (c.responseLength == 0) { return 0; }
+  size_t n = c.client.availableForWrite();
+  if (n > c.responseLength) { n = c.responseLength; }
+  if (n == 0) { return 0; }
+  n = c.client.write(c.response + c.responseStart, n);
+  c.responseStart  += n;
+  c.responseLength -= n;
+  if (c.responseLength == 0) { c.responseStart = 0; }
+  if (n > 0) { c.lastActivity = millis(); }
+  return n;
+}
+
+// one buffer of the file or the producer per call
+void NonBlockingWebServer::sendResponse(Connection &c) {
+  drain(c);
+  if (c.responseLength > 0) { return; }                          // client has not taken the last piece
+  if (c.file) {
+    int n = c.file.read(c.response, NBWS_RESPONSE_LENGTH);
+    if (n > 0) { c.responseLength = n; drain(c); return; }
+    c.file.close();
+    c.file = File();
+  }
+  if (c.producer) {
+    if (c.chunked) {                                             // chunk size line before, CRLF after the data
+      size_t n = c.producer((char *)c.response + 8, NBWS_RESPONSE_LENGTH - 10);
+      if (n > 0) {
+        char size[8];
+        int  l = snprintf(size, sizeof(size), "%X\r\n", (unsigned int)n);
+        memcpy(c.response + 8 - l, size, l);
+        memcpy(c.response + 8 + n, "\r\n", 2);
+        c.responseStart  = 8 - l;
+        c.responseLength = l + n + 2;
+      } else {
+        memcpy(c.response, "0\r\n\r\n", 5);
+        c.responseLength = 5;
+        c.ended    = true;
+        c.producer = nullptr;
+      }
+    } else {
+      c.responseLength = c.producer((char *)c.response, NBWS_RESPONSE_LENGTH);
+      if (c.responseLength == 0) { c.producer = nullptr; }
+    }
+    drain(c);
+    return;
+  }
+  if (c.cut && c.chunked && !c.ended) {                          // the client gets a complete chunked response
+    memcpy(c.response, "0\r\n\r\n", 5);
+    c.responseLength = 5;
+    c.ended = true;
+    drain(c);
+    return;
+  }
+  finishRequest(c);
+}
+
+void NonBlockingWebServer::finishRequest(Connection &c) {
+  if (c.rejected) { c.state = NBWS_DISCARD; c.lastActivity = millis(); return; }
+  if (!c.keepAlive) { closeConnection(c); return; }
+  if (c.responseSize > NBWS_RESPONSE_LENGTH) {                   // grown for the last response
+    uint8_t *response = (uint8_t *)realloc(c.response, NBWS_RESPONSE_LENGTH);
+    if (response != NULL) { c.response = response; c.responseSize = NBWS_RESPONSE_LENGTH; }
+  }
+  c.state        = NBWS_IDLE;
+  c.headerLength = 0;
+  c.lastActivity = millis();
+}
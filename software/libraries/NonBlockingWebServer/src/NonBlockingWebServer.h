@@ -0,0 +1,197 @@
+/******************************************************************************************************/
+// Non blocking HTTP/1.1 server
+/******************************************************************************************************/
+// ESP8266WebServer serves one request per handleClient() and writes the whole response before it returns,
+// a large file to a slow client holds up the main loop until the transfer is done.
+// This server keeps up to NBWS_MAX_CLIENTS connections and advances each of them by one step per handleClient():
+//   read what arrived, run the handler once the request is complete, send what fits into the TCP send buffer.
+// Files given to streamFile() and chunked responses given to sendChunked() are read or produced piece by piece
+// as the client takes them. Connections are kept alive between requests.
+// Buffers are allocated when a connection is accepted and freed when it closes:
+//   NBWS_REQUEST_LENGTH for the request line and headers, NBWS_RESPONSE_LENGTH for what the client did not take yet.
+// A request that does not fit is answered with 431, a client that neither sends nor reads is dropped after NBWS_TIMEOUT.
+// After an error response the rest of the request is read and dropped for up to NBWS_LINGER before the connection
+// is closed, closing with unread data resets it and the client can lose the response.
+// A client that closed its side after the request still gets the response.
+// What a handler sends beyond the TCP send buffer waits in the response buffer, which grows up to NBWS_RESPONSE_MAX
+// for that response and shrinks again when it is sent. A larger response is answered with 500 when send() knows its
+// length. Otherwise what fits is sent, a chunked response is ended there, and the connection is closed after it.
+// Large responses belong into sendChunked().
+//
+// Routes, arguments, collected headers, send(), sendHeader(), sendContent(), setContentLength(), streamFile()
+// and upload() follow ESP8266WebServer. multipart/form-data uploads are passed to the upload handler in pieces.
+#ifndef NON_BLOCKING_WEB_SERVER_H_
+#define NON_BLOCKING_WEB_SERVER_H_
+
+#include <Arduino.h>
+#include <functional>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>                              // HTTPMethod, HTTPUpload, CONTENT_LENGTH_UNKNOWN
+#include <FS.h>
+
+#define NBWS_MAX_CLIENTS          4                        // concurrent connections
+#define NBWS_REQUEST_LENGTH     512                        // [bytes] request line and headers, multipart window
+#define NBWS_RESPONSE_LENGTH   1024                        // [bytes] response the client did not take yet
+#define NBWS_RESPONSE_MAX      4096                        // [bytes] response buffer of a handler that sends more
+#define NBWS_MAX_ROUTES          32                        // handlers registered with on()
+#define NBWS_MAX_ARGS            12                        // query and form arguments
+#define NBWS_MAX_HEADERS          4                        // headers kept with collectHeaders()
+#define NBWS_BODY_LENGTH        256                        // [bytes] largest url encoded form body
+#define NBWS_KEEPALIVE         5000                        // [ms] idle connection is closed
+#define NBWS_TIMEOUT          10000                        // [ms] connection without progress is dropped
+#define NBWS_LINGER            1000                        // [ms] rest of a rejected request is read before closing
+#define NBWS_MAX_REQUESTS       100                        // requests on one connection
+
+enum NBWSStates{NBWS_FREE = 0, NBWS_IDLE, NBWS_HEADERS, NBWS_BODY, NBWS_UPLOAD, NBWS_SEND, NBWS_DISCARD};
+enum NBWSParts{NBWS_PART_BOUNDARY = 0, NBWS_PART_HEADERS, NBWS_PART_DATA, NBWS_PART_END};
+
+class NonBlockingWebServer {
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+    typedef std::function<size_t(char *buffer, size_t len)> TProducerFunction;   // next piece of a chunked response, 0 ends it
+
+    NonBlockingWebServer(uint16_t port = 80);
+    ~NonBlockingWebServer();
+
+    void    begin(void);
+    void    stop(void);
+    void    close(void) { stop(); }
+    void    handleClient(void);                            // one step on each connection, never waits for a client
+
+    void    on(const String &uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void    on(const String &uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, nullptr); }
+    void    on(const String &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void    onNotFound(THandlerFunction fn) { _notFound = fn; }
+    void    collectHeaders(const char *headerKeys[], const size_t headerKeysCount);
+
+    // request being handled
+    String     uri(void) { return _uri; }
+    HTTPMethod method(void) { return _method; }
+    int        args(void) { return _argCount; }
+    String     arg(int i) { return (i < _argCount) ? _argValues[i] : String(); }
+    String     arg(const String &name);
+    String     argName(int i) { return (i < _argCount) ? _argNames[i] : String(); }
+    bool       hasArg(const String &name);
+    String     header(const String &name);
+    HTTPUpload &upload(void) { return *_upload; }
+    uint32_t   requestId(void) { return _requestId; }     // identifies the request being handled
+    bool       active(uint32_t id);                        // response of request id is still being sent
+
+    // response to the request being handled
+    void    setContentLength(size_t contentLength) { _contentLength = contentLength; }
+    void    sendHeader(const String &name, const String &value, bool first = false);
+    void    send(int code, const char *contentType = nullptr, const String &content = String());
+    void    send(int code, const String &contentType, const String &content) { send(code, contentType.c_str(), content); }
+    void    send(int code, const char *contentType, const char *content) { send(code, contentType, String(content)); }
+    void    send_P(int code, PGM_P contentType, PGM_P content);
+    void    sendContent(const String &content) { sendContent(content.c_str(), content.length()); }
+    void    sendContent(const char *content) { sendContent(content, strlen(content)); }
+    void    sendContent(const char *content, size_t size);
+    void    sendContent_P(PGM_P content);
+    size_t  streamFile(File &file, const String &contentType);                       // file is sent as the client takes it
+    void    sendChunked(int code, const char *contentType, TProducerFunction producer); // producer is called as the client takes the response
+
+    // statistics
+    uint8_t  connections(void);                            // open connections
+    uint32_t served(void)   { return _served; }            // requests handled
+    uint32_t accepted(void) { return _accepted; }          // connections accepted
+    uint32_t rejected(void) { return _rejected; }          // connections refused with 503, all slots busy
+    uint32_t timeouts(void) { return _timeouts; }          // connections dropped without progress
+    uint32_t grown(void)    { return _grown; }             // responses that needed a larger response buffer
+    uint32_t overflows(void) { return _overflows; }        // responses larger than NBWS_RESPONSE_MAX, 500 or cut off
+
+  private:
+    struct Route {
+      String           uri;
+      HTTPMethod       method;
+      THandlerFunction fn;
+      THandlerFunction ufn;
+    };
+
+    struct Connection {
+      WiFiClient        client;
+      uint8_t           state;                             // NBWSStates
+      char             *request;                           // NBWS_REQUEST_LENGTH, request headers and multipart window
+      uint16_t          requestLength;
+      uint16_t          headerLength;                      // of the request being read, including the blank line
+      uint8_t          *response;                          // NBWS_RESPONSE_LENGTH, waits for the client
+      uint16_t          responseSize;                      // allocated, up to NBWS_RESPONSE_MAX
+      uint16_t          responseStart;
+      uint16_t          responseLength;
+      File              file;                              // streamed after the response buffer
+      TProducerFunction producer;                          // produces chunks after the response buffer
+      size_t            bodyRemaining;                     // [bytes] of the request body not read yet
+      uint8_t           route;                             // of an upload
+      bool              keepAlive;
+      bool              chunked;                           // response uses chunked transfer encoding
+      bool              head;                              // HEAD request, body is not sent
+      bool              headersSent;                       // status line and headers are queued
+      bool              ended;                             // last chunk is queued
+      bool              cut;                               // response overflowed, the rest of it is dropped
+      bool              rejected;                          // error response, the connection lingers and closes
+      uint8_t           requests;                          // served on this connection
+      uint32_t          id;                                // of the request
+      unsigned long     lastActivity;                      // [ms] of the last byte read or written
+    };
+
+    void    accept(void);
+    void    closeConnection(Connection &c);
+    void    readHeaders(Connection &c);
+    void    readBody(Connection &c);
+    void    readUpload(Connection &c);
+    bool    parseMultipart(Connection &c);
+    void    uploadData(Connection &c, const uint8_t *data, size_t len);
+    void    uploadEvent(Connection &c, HTTPUploadStatus status);
+    void    sendResponse(Connection &c);
+    void    finishRequest(Connection &c);
+    bool    parseRequest(Connection &c);
+    void    parseArguments(const char *query, size_t len);
+    void    select(Connection &c);
+    void    startRequest(Connection &c);
+    void    finishHandler(Connection &c);
+    void    dispatch(Connection &c);
+    void    reject(Connection &c, int code);
+    void    linger(Connection &c);
+    void    queue(Connection &c, const uint8_t *data, size_t len);
+    bool    fits(Connection &c, size_t len);
+    bool    growResponse(Connection &c, size_t size);
+    void    queueChunk(Connection &c, const char *data, size_t len);
+    size_t  drain(Connection &c);
+    int8_t  findRoute(void);
+
+    WiFiServer        _server;
+    Connection        _connections[NBWS_MAX_CLIENTS];
+    Connection       *_current;                            // connection of the handler being run
+    Route             _routes[NBWS_MAX_ROUTES];
+    uint8_t           _routeCount;
+    THandlerFunction  _notFound;
+
+    String            _uri;
+    HTTPMethod        _method;
+    String            _argNames[NBWS_MAX_ARGS];
+    String            _argValues[NBWS_MAX_ARGS];
+    int               _argCount;
+    String            _headerKeys[NBWS_MAX_HEADERS];
+    String            _headerValues[NBWS_MAX_HEADERS];
+    uint8_t           _headerCount;
+    String            _responseHeaders;
+    size_t            _contentLength;
+    bool              _http10;
+    bool              _urlencoded;                         // body holds form arguments
+    bool              _expectContinue;                     // client waits for 100 Continue before the body
+    String            _boundary;                           // of the multipart body
+    String            _uploadUri;                          // of the upload in progress
+    uint8_t           _part;                               // NBWSParts
+    bool              _partFile;                           // part is a file
+    HTTPUpload       *_upload;                             // allocated for the one upload in progress
+    uint32_t          _requestId;
+
+    uint32_t          _served;
+    uint32_t          _accepted;
+    uint32_t          _rejected;
+    uint32_t          _timeouts;
+    uint32_t          _grown;
+    uint32_t          _overflows;
+};
+
+#endif
@@ -1668,24 +1668,12 @@ bool SPS30::I2C_Check_data_ready()
  * @brief : calculate CRC for I2c comms
  * @param data : 2 databytes to calculate the CRC from
  *
- * Source : datasheet SPS30
+ * Source : datasheet SPS30, shared Sensirion lookup table
  *
  * return CRC
  */
 uint8_t SPS30::I2C_calc_CRC(uint8_t data[2])
 {
-    uint8_t crc = 0xFF;
-    for(int i = 0; i < 2; i++) {
-        crc ^= data[i];
-        for(uint8_t bit = 8; bit > 0; --bit) {
-            if(crc & 0x80) {
-                crc = (crc << 1) ^ 0x31u;
-            } else {
-                crc = (crc << 1);
-            }
-        }
-    }
-
-    return crc;
+    return sensirionCRC8(data, 2);
 }
 #endif // INCLUDE_I2C
@@ -224,6 +224,7 @@ enum debug_serial {
     #else
         #include "Wire.h"           // for I2c
     #endif
+    #include <SensirionProtocol.h>  // shared CRC table
 
     /** Version 1.3.0
      *
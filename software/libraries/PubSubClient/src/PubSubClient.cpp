@@ -17,6 +17,10 @@ PubSubClient::PubSubClient() {
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 
 PubSubClient::PubSubClient(Client& client) {
@@ -27,6 +31,10 @@ PubSubClient::PubSubClient(Client& client) {
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client) {
@@ -38,6 +46,10 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client) {
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
@@ -48,6 +60,10 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client, Stream
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client) {
     this->_state = MQTT_DISCONNECTED;
@@ -59,6 +75,10 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATUR
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
@@ -70,6 +90,10 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATUR
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client) {
@@ -81,6 +105,10 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client) {
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
@@ -91,6 +119,10 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client, Stream& s
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client) {
     this->_state = MQTT_DISCONNECTED;
@@ -102,6 +134,10 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE,
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
@@ -113,6 +149,10 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE,
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 
 PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client) {
@@ -124,6 +164,10 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client) {
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
@@ -134,6 +178,10 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client, St
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client) {
     this->_state = MQTT_DISCONNECTED;
@@ -145,6 +193,10 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
@@ -156,6 +208,10 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
     setBufferSize(MQTT_MAX_PACKET_SIZE);
     setKeepAlive(MQTT_KEEPALIVE);
     setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    setInflightWindow(MQTT_MAX_INFLIGHT);
+    setRetryTimeout(MQTT_RETRY_TIMEOUT);
+    setConnectTimeout(MQTT_CONNECT_TIMEOUT, MQTT_SOCKET_TIMEOUT);
+    clearInflight();
 }
 
 PubSubClient::~PubSubClient() {
@@ -180,108 +236,140 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
 
 boolean PubSubClient::connect(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
     if (!connected()) {
-        int result = 0;
+        if (!sendConnect(id,user,pass,willTopic,willQos,willRetain,willMessage,cleanSession)) {
+            return false;
+        }
+
+        while (!_client->available()) {
+            unsigned long t = millis();
+            if (t-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
+                _state = MQTT_CONNECTION_TIMEOUT;
+                _client->stop();
+                return false;
+            }
+        }
+        return readConnack();
+    }
+    return true;
+}
+
+boolean PubSubClient::connectAsync(const char *id) {
+    return connectAsync(id,NULL,NULL,0,0,0,0,1);
+}
+
+boolean PubSubClient::connectAsync(const char *id, const char *user, const char *pass) {
+    return connectAsync(id,user,pass,0,0,0,0,1);
+}
+
+boolean PubSubClient::connectAsync(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
+    if (connected() || (_state == MQTT_CONNECTING)) {
+        return true;
+    }
+    _client->setTimeout(this->connectTimeout*1000UL);
+    if (!sendConnect(id,user,pass,willTopic,willQos,willRetain,willMessage,cleanSession)) {
+        return false;
+    }
+    _state = MQTT_CONNECTING;
+    return true;
+}
+
+boolean PubSubClient::sendConnect(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
+    int result = 0;
 
 
-        if(_client->connected()) {
-            result = 1;
+    if(_client->connected()) {
+        result = 1;
+    } else {
+        if (domain != NULL) {
+            result = _client->connect(this->domain, this->port);
         } else {
-            if (domain != NULL) {
-                result = _client->connect(this->domain, this->port);
-            } else {
-                result = _client->connect(this->ip, this->port);
-            }
+            result = _client->connect(this->ip, this->port);
         }
+    }
 
-        if (result == 1) {
-            nextMsgId = 1;
-            // Leave room in the buffer for header and variable length field
-            uint16_t length = MQTT_MAX_HEADER_SIZE;
-            unsigned int j;
+    if (result == 1) {
+        nextMsgId = 1;
+        // Leave room in the buffer for header and variable length field
+        uint16_t length = MQTT_MAX_HEADER_SIZE;
+        unsigned int j;
 
 #if MQTT_VERSION == MQTT_VERSION_3_1
-            uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
+        uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
 #define MQTT_HEADER_VERSION_LENGTH 9
 #elif MQTT_VERSION == MQTT_VERSION_3_1_1
-            uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
+        uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
 #define MQTT_HEADER_VERSION_LENGTH 7
 #endif
-            for (j = 0;j<MQTT_HEADER_VERSION_LENGTH;j++) {
-                this->buffer[length++] = d[j];
-            }
+        for (j = 0;j<MQTT_HEADER_VERSION_LENGTH;j++) {
+            this->buffer[length++] = d[j];
+        }
 
-            uint8_t v;
-            if (willTopic) {
-                v = 0x04|(willQos<<3)|(willRetain<<5);
-            } else {
-                v = 0x00;
-            }
-            if (cleanSession) {
-                v = v|0x02;
-            }
+        uint8_t v;
+        if (willTopic) {
+            v = 0x04|(willQos<<3)|(willRetain<<5);
+        } else {
+            v = 0x00;
+        }
+        if (cleanSession) {
+            v = v|0x02;
+        }
 
-            if(user != NULL) {
-                v = v|0x80;
+        if(user != NULL) {
+            v = v|0x80;
 
-                if(pass != NULL) {
-                    v = v|(0x80>>1);
-                }
-            }
-            this->buffer[length++] = v;
-
-            this->buffer[length++] = ((this->keepAlive) >> 8);
-            this->buffer[length++] = ((this->keepAlive) & 0xFF);
-
-            CHECK_STRING_LENGTH(length,id)
-            length = writeString(id,this->buffer,length);
-            if (willTopic) {
-                CHECK_STRING_LENGTH(length,willTopic)
-                length = writeString(willTopic,this->buffer,length);
-                CHECK_STRING_LENGTH(length,willMessage)
-                length = writeString(willMessage,this->buffer,length);
+            if(pass != NULL) {
+                v = v|(0x80>>1);
             }
+        }
+        this->buffer[length++] = v;
+
+        this->buffer[length++] = ((this->keepAlive) >> 8);
+        this->buffer[length++] = ((this->keepAlive) & 0xFF);
+
+        CHECK_STRING_LENGTH(length,id)
+        length = writeString(id,this->buffer,length);
+        if (willTopic) {
+            CHECK_STRING_LENGTH(length,willTopic)
+            length = writeString(willTopic,this->buffer,length);
+            CHECK_STRING_LENGTH(length,willMessage)
+            length = writeString(willMessage,this->buffer,length);
+        }
 
-            if(user != NULL) {
-                CHECK_STRING_LENGTH(length,user)
-                length = writeString(user,this->buffer,length);
-                if(pass != NULL) {
-                    CHECK_STRING_LENGTH(length,pass)
-                    length = writeString(pass,this->buffer,length);
-                }
+        if(user != NULL) {
+            CHECK_STRING_LENGTH(length,user)
+            length = writeString(user,this->buffer,length);
+            if(pass != NULL) {
+                CHECK_STRING_LENGTH(length,pass)
+                length = writeString(pass,this->buffer,length);
             }
+        }
 
-            write(MQTTCONNECT,this->buffer,length-MQTT_MAX_HEADER_SIZE);
-
-            lastInActivity = lastOutActivity = millis();
+        write(MQTTCONNECT,this->buffer,length-MQTT_MAX_HEADER_SIZE);
 
-            while (!_client->available()) {
-                unsigned long t = millis();
-                if (t-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
-                    _state = MQTT_CONNECTION_TIMEOUT;
-                    _client->stop();
-                    return false;
-                }
-            }
-            uint8_t llen;
-            uint32_t len = readPacket(&llen);
+        lastInActivity = lastOutActivity = millis();
+        return true;
+    }
+    _state = MQTT_CONNECT_FAILED;
+    return false;
+}
 
-            if (len == 4) {
-                if (buffer[3] == 0) {
-                    lastInActivity = millis();
-                    pingOutstanding = false;
-                    _state = MQTT_CONNECTED;
-                    return true;
-                } else {
-                    _state = buffer[3];
-                }
-            }
-            _client->stop();
+boolean PubSubClient::readConnack() {
+    uint8_t llen;
+    uint32_t len = readPacket(&llen);
+
+    if (len == 4) {
+        if (buffer[3] == 0) {
+            lastInActivity = millis();
+            pingOutstanding = false;
+            _state = MQTT_CONNECTED;
+            resendInflight(true);
+            return true;
         } else {
-            _state = MQTT_CONNECT_FAILED;
+            _state = buffer[3];
         }
-        return false;
     }
-    return true;
+    _client->stop();
+    return false;
 }
 
 // reads a byte into result
@@ -345,20 +433,49 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
         }
     }
     uint32_t idx = len;
-
-    for (uint32_t i = start;i<length;i++) {
-        if(!readByte(&digit)) return 0;
-        if (this->stream) {
-            if (isPublish && idx-*lengthLength-2>skip) {
-                this->stream->write(digit);
+    // Payload of a publish starts after fixed header, topic length, topic and message id
+    uint32_t payloadStart = *lengthLength+3+skip;
+    uint32_t end = idx+length-start;
+    // Bytes beyond the buffer are read here and dropped or passed to the stream
+    uint8_t discard[MQTT_READ_CHUNK_SIZE];
+    uint32_t previousMillis = millis();
+
+    while (idx < end) {
+        int available = _client->available();
+        uint8_t* chunk = discard;
+        int rc = 0;
+        if (available > 0) {
+            uint32_t n = end-idx;
+            if ((uint32_t)available < n) {
+                n = available;
+            }
+            if (len < this->bufferSize) {
+                chunk = this->buffer+len;
+                if (n > (uint32_t)(this->bufferSize-len)) {
+                    n = this->bufferSize-len;
+                }
+            } else if (n > MQTT_READ_CHUNK_SIZE) {
+                n = MQTT_READ_CHUNK_SIZE;
             }
+            rc = _client->read(chunk,n);
         }
-
-        if (len < this->bufferSize) {
-            this->buffer[len] = digit;
-            len++;
+        if (rc <= 0) {
+            // Nothing arrived or the read failed, give up after the socket timeout
+            yield();
+            if (millis() - previousMillis >= ((int32_t) this->socketTimeout * 1000)) {
+                return 0;
+            }
+            continue;
         }
-        idx++;
+        if (this->stream && isPublish && idx+rc > payloadStart) {
+            uint32_t from = (idx < payloadStart) ? payloadStart-idx : 0;
+            this->stream->write(chunk+from,rc-from);
+        }
+        if (chunk != discard) {
+            len += rc;
+        }
+        idx += rc;
+        previousMillis = millis();
     }
 
     if (!this->stream && idx > this->bufferSize) {
@@ -368,6 +485,21 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
 }
 
 boolean PubSubClient::loop() {
+    if (this->_state == MQTT_CONNECTING) {
+        // connectAsync() has sent CONNECT, take the CONNACK when it is there
+        if (_client->available()) {
+            if (!readConnack() && (this->_state == MQTT_CONNECTING)) {
+                this->_state = MQTT_CONNECT_FAILED;
+            }
+        } else if (!_client->connected()) {
+            this->_state = MQTT_CONNECT_FAILED;
+            _client->stop();
+        } else if (millis() - lastOutActivity >= this->connackTimeout*1000UL) {
+            this->_state = MQTT_CONNECTION_TIMEOUT;
+            _client->stop();
+        }
+        return this->_state == MQTT_CONNECTED;
+    }
     if (connected()) {
         unsigned long t = millis();
         if ((t - lastInActivity > this->keepAlive*1000UL) || (t - lastOutActivity > this->keepAlive*1000UL)) {
@@ -384,6 +516,7 @@ boolean PubSubClient::loop() {
                 pingOutstanding = true;
             }
         }
+        resendInflight(false);
         if (_client->available()) {
             uint8_t llen;
             uint16_t len = readPacket(&llen);
@@ -422,6 +555,10 @@ boolean PubSubClient::loop() {
                     _client->write(this->buffer,2);
                 } else if (type == MQTTPINGRESP) {
                     pingOutstanding = false;
+                } else if (type == MQTTPUBACK) {
+                    if (len == 4) {
+                        acknowledge((this->buffer[2]<<8)+this->buffer[3]);
+                    }
                 }
             } else if (!connected()) {
                 // readPacket has closed the connection
@@ -471,55 +608,131 @@ boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigne
     return false;
 }
 
-boolean PubSubClient::publish_P(const char* topic, const char* payload, boolean retained) {
-    return publish_P(topic, (const uint8_t*)payload, payload ? strnlen(payload, this->bufferSize) : 0, retained);
+boolean PubSubClient::publish(const char* topic, const char* payload, boolean retained, uint8_t qos) {
+    return publish(topic,(const uint8_t*)payload, payload ? strnlen(payload, this->bufferSize) : 0,retained,qos);
 }
 
-boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained) {
-    uint8_t llen = 0;
-    uint8_t digit;
-    unsigned int rc = 0;
-    uint16_t tlen;
-    unsigned int pos = 0;
-    unsigned int i;
-    uint8_t header;
-    unsigned int len;
-    int expectedLength;
-
-    if (!connected()) {
+boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained, uint8_t qos) {
+    if (qos == 0) {
+        return publish(topic,payload,plength,retained);
+    }
+    if (qos > 1 || !connected()) {
         return false;
     }
-
-    tlen = strnlen(topic, this->bufferSize);
-
-    header = MQTTPUBLISH;
-    if (retained) {
-        header |= 1;
+    if (this->inflightCount >= this->inflightWindow || this->inflightSlots >= MQTT_MAX_INFLIGHT) {
+        // Window is full
+        return false;
+    }
+    size_t tlen = strnlen(topic, this->bufferSize);
+    if (tlen == this->bufferSize) {
+        return false;
     }
-    this->buffer[pos++] = header;
-    len = plength + 2 + tlen;
+    uint32_t len = 2 + tlen + 2 + plength;
+    uint32_t size = 2 + len;
+    for (uint32_t l = len; l > 127; l >>= 7) {
+        size++;
+    }
+    if (size > MQTT_INFLIGHT_BUFFER) {
+        // Too long
+        return false;
+    }
+    int32_t offset = inflightAlloc(size);
+    if (offset < 0) {
+        return false;
+    }
+
+    uint8_t* packet = this->inflightBuffer+offset;
+    uint16_t pos = 0;
+    uint8_t digit;
+    packet[pos++] = MQTTPUBLISH|MQTTQOS1|(retained ? 1 : 0);
     do {
         digit = len  & 127; //digit = len %128
         len >>= 7; //len = len / 128
         if (len > 0) {
             digit |= 0x80;
         }
-        this->buffer[pos++] = digit;
-        llen++;
+        packet[pos++] = digit;
     } while(len>0);
+    pos = writeString(topic,packet,pos);
+    uint16_t msgId = nextId();
+    packet[pos++] = (msgId >> 8);
+    packet[pos++] = (msgId & 0xFF);
+    memcpy(packet+pos,payload,plength);
+    pos += plength;
+
+    MQTTInflight* m = &this->inflightTable[(this->inflightHead+this->inflightSlots)%MQTT_MAX_INFLIGHT];
+    m->msgId = msgId;
+    m->offset = offset;
+    m->length = pos;
+    m->sent = millis();
+    this->inflightSlots++;
+    this->inflightCount++;
+
+    // A failed write is repeated after the reconnect
+    _client->write(packet,pos);
+    lastOutActivity = m->sent;
+    return true;
+}
 
-    pos = writeString(topic,this->buffer,pos);
+boolean PubSubClient::publish_P(const char* topic, const char* payload, boolean retained) {
+    return publish_P(topic, (const uint8_t*)payload, payload ? strnlen(payload, this->bufferSize) : 0, retained);
+}
 
-    rc += _client->write(this->buffer,pos);
+boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained) {
+    MQTTFragment fragment = { payload, plength, true };
+    return publishv(topic, &fragment, 1, retained);
+}
 
-    for (i=0;i<plength;i++) {
-        rc += _client->write((char)pgm_read_byte_near(payload + i));
+boolean PubSubClient::publishv(const char* topic, const MQTTFragment* fragments, uint8_t count, boolean retained) {
+    if (!connected()) {
+        return false;
+    }
+    if (this->bufferSize < MQTT_MAX_HEADER_SIZE + 2+strnlen(topic, this->bufferSize)) {
+        // Topic too long
+        return false;
+    }
+    uint32_t plength = 0;
+    for (uint8_t i=0;i<count;i++) {
+        plength += fragments[i].length;
     }
 
+    // Leave room in the buffer for header and variable length field
+    uint16_t length = MQTT_MAX_HEADER_SIZE;
+    length = writeString(topic,this->buffer,length);
+    uint8_t header = MQTTPUBLISH;
+    if (retained) {
+        header |= 1;
+    }
+    size_t hlen = buildHeader(header, this->buffer, plength+length-MQTT_MAX_HEADER_SIZE);
+    uint32_t expectedLength = hlen+length-MQTT_MAX_HEADER_SIZE+plength;
+    uint16_t pos = MQTT_MAX_HEADER_SIZE-hlen;
+    uint32_t rc = 0;
+
+    for (uint8_t i=0;i<count;i++) {
+        const uint8_t* data = fragments[i].data;
+        unsigned int left = fragments[i].length;
+        while (left > 0) {
+            if (length == this->bufferSize) {
+                rc += _client->write(this->buffer+pos,length-pos);
+                pos = 0;
+                length = 0;
+            }
+            uint16_t n = this->bufferSize-length;
+            if (left < n) {
+                n = left;
+            }
+            if (fragments[i].inFlash) {
+                memcpy_P(this->buffer+length,data,n);
+            } else {
+                memcpy(this->buffer+length,data,n);
+            }
+            length += n;
+            data += n;
+            left -= n;
+        }
+    }
+    rc += _client->write(this->buffer+pos,length-pos);
     lastOutActivity = millis();
-
-    expectedLength = 1 + llen + 2 + tlen + plength;
-
     return (rc == expectedLength);
 }
 
@@ -621,10 +834,7 @@ boolean PubSubClient::subscribe(const char* topic, uint8_t qos) {
     if (connected()) {
         // Leave room in the buffer for header and variable length field
         uint16_t length = MQTT_MAX_HEADER_SIZE;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
-        }
+        nextId();
         this->buffer[length++] = (nextMsgId >> 8);
         this->buffer[length++] = (nextMsgId & 0xFF);
         length = writeString((char*)topic, this->buffer,length);
@@ -645,10 +855,7 @@ boolean PubSubClient::unsubscribe(const char* topic) {
     }
     if (connected()) {
         uint16_t length = MQTT_MAX_HEADER_SIZE;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
-        }
+        nextId();
         this->buffer[length++] = (nextMsgId >> 8);
         this->buffer[length++] = (nextMsgId & 0xFF);
         length = writeString(topic, this->buffer,length);
@@ -657,6 +864,97 @@ boolean PubSubClient::unsubscribe(const char* topic) {
     return false;
 }
 
+uint16_t PubSubClient::nextId() {
+    boolean used;
+    do {
+        nextMsgId++;
+        if (nextMsgId == 0) {
+            nextMsgId = 1;
+        }
+        used = false;
+        for (uint8_t i=0;i<this->inflightSlots;i++) {
+            if (this->inflightTable[(this->inflightHead+i)%MQTT_MAX_INFLIGHT].msgId == nextMsgId) {
+                used = true;
+            }
+        }
+    } while (used);
+    return nextMsgId;
+}
+
+int32_t PubSubClient::inflightAlloc(uint16_t size) {
+    if (this->inflightSlots == 0) {
+        return 0;
+    }
+    MQTTInflight* first = &this->inflightTable[this->inflightHead];
+    MQTTInflight* last = &this->inflightTable[(this->inflightHead+this->inflightSlots-1)%MQTT_MAX_INFLIGHT];
+    uint16_t end = last->offset+last->length;
+    if (end > first->offset) {
+        // Used part does not wrap, take the end of the buffer or its start
+        if (MQTT_INFLIGHT_BUFFER-end >= size) {
+            return end;
+        }
+        if (first->offset >= size) {
+            return 0;
+        }
+    } else if (first->offset-end >= size) {
+        return end;
+    }
+    return -1;
+}
+
+void PubSubClient::acknowledge(uint16_t msgId) {
+    for (uint8_t i=0;i<this->inflightSlots;i++) {
+        MQTTInflight* m = &this->inflightTable[(this->inflightHead+i)%MQTT_MAX_INFLIGHT];
+        if (m->msgId == msgId) {
+            m->msgId = 0;
+            this->inflightCount--;
+            break;
+        }
+    }
+    // Free the entries up to the oldest message still waiting
+    while (this->inflightSlots > 0 && this->inflightTable[this->inflightHead].msgId == 0) {
+        this->inflightHead = (this->inflightHead+1)%MQTT_MAX_INFLIGHT;
+        this->inflightSlots--;
+    }
+}
+
+void PubSubClient::resendInflight(boolean all) {
+    unsigned long t = millis();
+    for (uint8_t i=0;i<this->inflightSlots;i++) {
+        MQTTInflight* m = &this->inflightTable[(this->inflightHead+i)%MQTT_MAX_INFLIGHT];
+        if (m->msgId != 0 && (all || t - m->sent >= this->retryTimeout*1000UL)) {
+            uint8_t* packet = this->inflightBuffer+m->offset;
+            packet[0] |= MQTTDUP;
+            _client->write(packet,m->length);
+            m->sent = t;
+            lastOutActivity = t;
+        }
+    }
+}
+
+uint8_t PubSubClient::getInflight() {
+    return this->inflightCount;
+}
+
+uint16_t PubSubClient::getLastMsgId() {
+    return this->nextMsgId;
+}
+
+boolean PubSubClient::isInflight(uint16_t msgId) {
+    for (uint8_t i=0;i<this->inflightSlots;i++) {
+        if (this->inflightTable[(this->inflightHead+i)%MQTT_MAX_INFLIGHT].msgId == msgId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PubSubClient::clearInflight() {
+    this->inflightHead = 0;
+    this->inflightSlots = 0;
+    this->inflightCount = 0;
+}
+
 void PubSubClient::disconnect() {
     this->buffer[0] = MQTTDISCONNECT;
     this->buffer[1] = 0;
@@ -767,3 +1065,17 @@ PubSubClient& PubSubClient::setSocketTimeout(uint16_t timeout) {
     this->socketTimeout = timeout;
     return *this;
 }
+PubSubClient& PubSubClient::setInflightWindow(uint8_t window) {
+    this->inflightWindow = (window > MQTT_MAX_INFLIGHT) ? MQTT_MAX_INFLIGHT : window;
+    return *this;
+}
+PubSubClient& PubSubClient::setRetryTimeout(uint16_t timeout) {
+    this->retryTimeout = timeout;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setConnectTimeout(uint16_t tcpTimeout, uint16_t connackTimeout) {
+    this->connectTimeout = tcpTimeout;
+    this->connackTimeout = connackTimeout;
+    return *this;
+}
@@ -36,12 +36,41 @@
 #define MQTT_SOCKET_TIMEOUT 15
 #endif
 
+// MQTT_CONNECT_TIMEOUT: seconds the network client may block in its TCP connect when started with
+//  connectAsync(). Passed to the client with setTimeout(). Override with setConnectTimeout()
+#ifndef MQTT_CONNECT_TIMEOUT
+#define MQTT_CONNECT_TIMEOUT 2
+#endif
+
+// MQTT_READ_CHUNK_SIZE : bytes read from the network client at a time for the part of a packet that
+//  does not fit into the buffer.
+#ifndef MQTT_READ_CHUNK_SIZE
+#define MQTT_READ_CHUNK_SIZE 32
+#endif
+
+// MQTT_MAX_INFLIGHT : QoS 1 messages that may wait for PUBACK. Override with setInflightWindow() up to this.
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 4
+#endif
+
+// MQTT_INFLIGHT_BUFFER : bytes kept for the packets of QoS 1 messages waiting for PUBACK.
+//  A QoS 1 message is refused when its packet does not fit.
+#ifndef MQTT_INFLIGHT_BUFFER
+#define MQTT_INFLIGHT_BUFFER 512
+#endif
+
+// MQTT_RETRY_TIMEOUT : seconds before a QoS 1 message without PUBACK is sent again. Override with setRetryTimeout()
+#ifndef MQTT_RETRY_TIMEOUT
+#define MQTT_RETRY_TIMEOUT 10
+#endif
+
 // MQTT_MAX_TRANSFER_SIZE : limit how much data is passed to the network client
 //  in each write call. Needed for the Arduino Wifi Shield. Leave undefined to
 //  pass the entire MQTT packet in each write call.
 //#define MQTT_MAX_TRANSFER_SIZE 80
 
 // Possible values for client.state()
+#define MQTT_CONNECTING             -5
 #define MQTT_CONNECTION_TIMEOUT     -4
 #define MQTT_CONNECTION_LOST        -3
 #define MQTT_CONNECT_FAILED         -2
@@ -72,6 +101,7 @@
 #define MQTTQOS0        (0 << 1)
 #define MQTTQOS1        (1 << 1)
 #define MQTTQOS2        (2 << 1)
+#define MQTTDUP         (1 << 3)
 
 // Maximum size of fixed header and variable length size header
 #define MQTT_MAX_HEADER_SIZE 5
@@ -85,6 +115,21 @@
 
 #define CHECK_STRING_LENGTH(l,s) if (l+2+strnlen(s, this->bufferSize) > this->bufferSize) {_client->stop();return false;}
 
+// A part of a payload for publishv(), in RAM or in flash (PROGMEM)
+struct MQTTFragment {
+   const uint8_t* data;
+   unsigned int length;
+   boolean inFlash;
+};
+
+// A QoS 1 message waiting for PUBACK, its packet is kept in the inflight buffer
+struct MQTTInflight {
+   uint16_t msgId;       // 0 once acknowledged
+   uint16_t offset;      // of packet in inflight buffer
+   uint16_t length;      // of packet
+   unsigned long sent;   // millis() of last transmission
+};
+
 class PubSubClient : public Print {
 private:
    Client* _client;
@@ -92,12 +137,27 @@ private:
    uint16_t bufferSize;
    uint16_t keepAlive;
    uint16_t socketTimeout;
+   uint16_t connectTimeout;
+   uint16_t connackTimeout;
    uint16_t nextMsgId;
    unsigned long lastOutActivity;
    unsigned long lastInActivity;
    bool pingOutstanding;
+   // QoS 1 messages in the order they were published. Acknowledged messages stay in the
+   // table until all older ones are acknowledged, so the packets in the buffer form a ring.
+   MQTTInflight inflightTable[MQTT_MAX_INFLIGHT];
+   uint8_t inflightBuffer[MQTT_INFLIGHT_BUFFER];
+   uint8_t inflightHead;    // oldest entry
+   uint8_t inflightSlots;   // entries in table
+   uint8_t inflightCount;   // entries not acknowledged
+   uint8_t inflightWindow;
+   uint16_t retryTimeout;
    MQTT_CALLBACK_SIGNATURE;
    uint32_t readPacket(uint8_t*);
+   // Open the network connection unless it is open and send CONNECT
+   boolean sendConnect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   // Read the CONNACK and finish the connect
+   boolean readConnack();
    boolean readByte(uint8_t * result);
    boolean readByte(uint8_t * result, uint16_t * index);
    boolean write(uint8_t header, uint8_t* buf, uint16_t length);
@@ -107,6 +167,13 @@ private:
    // Note: the header is built at the end of the first MQTT_MAX_HEADER_SIZE bytes, so will start
    //       (MQTT_MAX_HEADER_SIZE - <returned size>) bytes into the buffer
    size_t buildHeader(uint8_t header, uint8_t* buf, uint16_t length);
+   // Next message id not used by a message waiting for PUBACK
+   uint16_t nextId();
+   // Offset in the inflight buffer where size bytes are free, -1 if there is no room
+   int32_t inflightAlloc(uint16_t size);
+   void acknowledge(uint16_t msgId);
+   // Send the messages waiting for PUBACK again, all of them or those older than the retry timeout
+   void resendInflight(boolean all);
    IPAddress ip;
    const char* domain;
    uint16_t port;
@@ -138,6 +205,11 @@ public:
    PubSubClient& setStream(Stream& stream);
    PubSubClient& setKeepAlive(uint16_t keepAlive);
    PubSubClient& setSocketTimeout(uint16_t timeout);
+   // Number of QoS 1 messages that may wait for PUBACK, at most MQTT_MAX_INFLIGHT
+   PubSubClient& setInflightWindow(uint8_t window);
+   PubSubClient& setRetryTimeout(uint16_t timeout);
+   // Timeouts of connectAsync() in seconds: the TCP connect of the network client and the wait for CONNACK
+   PubSubClient& setConnectTimeout(uint16_t tcpTimeout, uint16_t connackTimeout);
 
    boolean setBufferSize(uint16_t size);
    uint16_t getBufferSize();
@@ -147,13 +219,32 @@ public:
    boolean connect(const char* id, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   // Start to connect without waiting for the broker.
+   // The TCP connect of the network client is bounded by the connect timeout, then CONNECT is sent
+   // and loop() looks for the CONNACK. state() is MQTT_CONNECTING until it arrives, then MQTT_CONNECTED,
+   // or the error once the connection failed or the CONNACK timeout passed.
+   // Returns 1 if CONNECT was sent or the client is connected or connecting, 0 otherwise
+   boolean connectAsync(const char* id);
+   boolean connectAsync(const char* id, const char* user, const char* pass);
+   boolean connectAsync(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
    void disconnect();
    boolean publish(const char* topic, const char* payload);
    boolean publish(const char* topic, const char* payload, boolean retained);
    boolean publish(const char* topic, const uint8_t * payload, unsigned int plength);
    boolean publish(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained);
+   // Publish with QoS 0 or 1. A QoS 1 message is kept until its PUBACK arrives, it is sent again
+   // with the DUP flag after the retry timeout and after a reconnect.
+   // Returns 1 if the message was sent or kept for sending, 0 if not connected, the inflight window
+   // is full or the packet does not fit into the inflight buffer
+   boolean publish(const char* topic, const char* payload, boolean retained, uint8_t qos);
+   boolean publish(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained, uint8_t qos);
    boolean publish_P(const char* topic, const char* payload, boolean retained);
    boolean publish_P(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained);
+   // Publish a payload made of count fragments without assembling it first.
+   // Header, topic and fragments are copied into the buffer and sent whenever it is full,
+   // so a packet that fits into the buffer leaves in a single write.
+   // Returns 1 if the packet was sent, 0 if not connected, the topic does not fit into the buffer or a write failed
+   boolean publishv(const char* topic, const MQTTFragment* fragments, uint8_t count, boolean retained);
    // Start to publish a message.
    // This API:
    //   beginPublish(...)
@@ -174,9 +265,19 @@ public:
    boolean subscribe(const char* topic);
    boolean subscribe(const char* topic, uint8_t qos);
    boolean unsubscribe(const char* topic);
+   // Keep the connection alive and handle incoming packets, finishes connectAsync().
+   // Returns 1 while connected
    boolean loop();
    boolean connected();
    int state();
+   // QoS 1 messages waiting for PUBACK
+   uint8_t getInflight();
+   // Message id of the last QoS 1 publish or subscribe
+   uint16_t getLastMsgId();
+   // True while the QoS 1 message with this id waits for PUBACK
+   boolean isInflight(uint16_t msgId);
+   // Forget the QoS 1 messages waiting for PUBACK
+   void clearInflight();
 
 };
 
@@ -3,6 +3,7 @@
 #include "Buffer.h"
 #include "BDDTest.h"
 #include "trace.h"
+#include <unistd.h>
 
 
 byte server[] = { 172, 16, 0, 2 };
@@ -312,6 +313,109 @@ int test_connect_custom_keepalive() {
 }
 
 
+int test_connect_async() {
+    IT("connects without waiting for the connack");
+    ShimClient shimClient;
+
+    shimClient.setAllowConnect(true);
+    byte connect[] = {0x10,0x18,0x0,0x4,0x4d,0x51,0x54,0x54,0x4,0x2,0x0,0xf,0x0,0xc,0x63,0x6c,0x69,0x65,0x6e,0x74,0x5f,0x74,0x65,0x73,0x74,0x31};
+    shimClient.expect(connect,26);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connectAsync((char*)"client_test1");
+    IS_TRUE(rc);
+    IS_TRUE(shimClient.getTimeout() == MQTT_CONNECT_TIMEOUT*1000UL);
+    IS_TRUE(client.state() == MQTT_CONNECTING);
+    IS_FALSE(client.connected());
+
+    // nothing to read yet
+    rc = client.loop();
+    IS_FALSE(rc);
+    IS_TRUE(client.state() == MQTT_CONNECTING);
+    rc = client.publish((char*)"topic",(char*)"payload");
+    IS_FALSE(rc);
+
+    // a second call while connecting does not send connect again
+    rc = client.connectAsync((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_TRUE(client.state() == MQTT_CONNECTED);
+    IS_TRUE(client.connected());
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_connect_async_fails_no_network() {
+    IT("connect async fails if underlying client doesn't connect");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(false);
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connectAsync((char*)"client_test1");
+    IS_FALSE(rc);
+    IS_TRUE(client.state() == MQTT_CONNECT_FAILED);
+    END_IT
+}
+
+int test_connect_async_fails_on_bad_rc() {
+    IT("connect async fails with the return code of the connack");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+    byte connack[] = { 0x20, 0x02, 0x00, 0x05 };
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connectAsync((char*)"client_test1");
+    IS_TRUE(rc);
+    shimClient.respond(connack,4);
+    rc = client.loop();
+    IS_FALSE(rc);
+    IS_TRUE(client.state() == MQTT_CONNECT_UNAUTHORIZED);
+    IS_FALSE(shimClient.connected());
+    END_IT
+}
+
+int test_connect_async_fails_on_disconnect() {
+    IT("connect async fails if the connection closes before the connack");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connectAsync((char*)"client_test1");
+    IS_TRUE(rc);
+    shimClient.setConnected(false);
+    rc = client.loop();
+    IS_FALSE(rc);
+    IS_TRUE(client.state() == MQTT_CONNECT_FAILED);
+    END_IT
+}
+
+int test_connect_async_fails_on_no_response() {
+    IT("connect async times out without connack (takes 3 seconds)");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    client.setConnectTimeout(1,2);
+    int rc = client.connectAsync((char*)"client_test1");
+    IS_TRUE(rc);
+    IS_TRUE(shimClient.getTimeout() == 1000UL);
+    rc = client.loop();
+    IS_FALSE(rc);
+    IS_TRUE(client.state() == MQTT_CONNECTING);
+
+    sleep(3);
+    rc = client.loop();
+    IS_FALSE(rc);
+    IS_TRUE(client.state() == MQTT_CONNECTION_TIMEOUT);
+    IS_FALSE(shimClient.connected());
+    END_IT
+}
+
+
 int main()
 {
     SUITE("Connect");
@@ -332,5 +436,11 @@ int main()
     test_connect_disconnect_connect();
 
     test_connect_custom_keepalive();
+
+    test_connect_async();
+    test_connect_async_fails_no_network();
+    test_connect_async_fails_on_bad_rc();
+    test_connect_async_fails_on_disconnect();
+    test_connect_async_fails_on_no_response();
     FINISH
 }
@@ -20,6 +20,7 @@ extern "C"{
 
 #define PROGMEM
 #define pgm_read_byte_near(x) *(x)
+#define memcpy_P memcpy
 
 #define yield(x) {}
 
@@ -11,8 +11,8 @@ Buffer::Buffer(uint8_t* buf, size_t size) {
     this->length = 0;
     this->add(buf,size);
 }
-bool Buffer::available() {
-    return this->pos < this->length;
+int Buffer::available() {
+    return this->length - this->pos;
 }
 
 uint8_t Buffer::next() {
@@ -27,6 +27,11 @@ void Buffer::reset() {
 }
 
 void Buffer::add(uint8_t* buf, size_t size) {
+    if (this->pos == this->length) {
+        // Everything was read, start from the beginning
+        this->pos = 0;
+        this->length = 0;
+    }
     uint16_t i = 0;
     for (;i<size;i++) {
         this->buffer[this->length++] = buf[i];
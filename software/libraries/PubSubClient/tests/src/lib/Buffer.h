@@ -13,7 +13,7 @@ public:
     Buffer();
     Buffer(uint8_t* buf, size_t size);
 
-    virtual bool available();
+    virtual int available();
     virtual uint8_t next();
     virtual void reset();
 
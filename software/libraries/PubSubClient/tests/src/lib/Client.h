@@ -16,6 +16,11 @@ public:
   virtual void stop() = 0;
   virtual uint8_t connected() = 0;
   virtual operator bool() = 0;
+  // from Arduino's Stream, the connect timeout of network clients
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout() { return _timeout; }
+protected:
+  unsigned long _timeout = 1000;
 };
 
 #endif
@@ -25,6 +25,12 @@ size_t Stream::write(uint8_t b)  {
     return 1;
 }
 
+size_t Stream::write(const uint8_t *buffer, size_t size) {
+    for (size_t i=0;i<size;i++) {
+        this->write(buffer[i]);
+    }
+    return size;
+}
 
 bool Stream::error() {
     return this->_error;
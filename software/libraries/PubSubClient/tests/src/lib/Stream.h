@@ -13,6 +13,7 @@ private:
 public:
     Stream();
     virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *buffer, size_t size);
     
     virtual bool error();
     virtual void expect(uint8_t *buf, size_t size);
@@ -0,0 +1,293 @@
+#include "PubSubClient.h"
+#include "ShimClient.h"
+#include "Buffer.h"
+#include "BDDTest.h"
+#include "trace.h"
+#include <unistd.h>
+
+
+byte server[] = { 172, 16, 0, 2 };
+
+void callback(char* topic, byte* payload, unsigned int length) {
+  // handle message arrived
+}
+
+int test_publish_qos1() {
+    IT("publishes qos 1 with a message id");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish[] = {0x32,0x10,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x2,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.expect(publish,18);
+
+    rc = client.publish((char*)"topic",(char*)"payload",false,1);
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),1);
+
+    byte puback[] = { 0x40,0x02,0x0,0x2 };
+    shimClient.respond(puback,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),0);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publish_qos1_window() {
+    IT("pipelines qos 1 messages up to the window");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    client.setInflightWindow(2);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish1[] = {0x32,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x2,'A'};
+    byte publish2[] = {0x32,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x3,'B'};
+    shimClient.expect(publish1,12);
+    shimClient.expect(publish2,12);
+
+    rc = client.publish((char*)"topic",(char*)"A",false,1);
+    IS_TRUE(rc);
+    rc = client.publish((char*)"topic",(char*)"B",false,1);
+    IS_TRUE(rc);
+    rc = client.publish((char*)"topic",(char*)"C",false,1);
+    IS_FALSE(rc);
+    IS_EQUAL(client.getInflight(),2);
+
+    byte puback[] = { 0x40,0x02,0x0,0x2 };
+    shimClient.respond(puback,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),1);
+
+    byte publish3[] = {0x32,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x4,'C'};
+    shimClient.expect(publish3,12);
+    rc = client.publish((char*)"topic",(char*)"C",false,1);
+    IS_TRUE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publish_qos1_reordered() {
+    IT("accepts pubacks out of order");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    for (int i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+        rc = client.publish((char*)"topic",(char*)"payload",false,1);
+        IS_TRUE(rc);
+    }
+    IS_EQUAL(client.getInflight(),MQTT_MAX_INFLIGHT);
+    IS_EQUAL(client.getLastMsgId(),5);
+
+    // the newest message is acknowledged first
+    byte puback5[] = { 0x40,0x02,0x0,0x5 };
+    byte puback3[] = { 0x40,0x02,0x0,0x3 };
+    shimClient.respond(puback5,4);
+    shimClient.respond(puback3,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),MQTT_MAX_INFLIGHT-2);
+    IS_FALSE(client.isInflight(5));
+    IS_FALSE(client.isInflight(3));
+    IS_TRUE(client.isInflight(2));
+    IS_TRUE(client.isInflight(4));
+
+    // an unknown message id is ignored
+    byte puback9[] = { 0x40,0x02,0x0,0x9 };
+    shimClient.respond(puback9,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),MQTT_MAX_INFLIGHT-2);
+
+    byte puback2[] = { 0x40,0x02,0x0,0x2 };
+    byte puback4[] = { 0x40,0x02,0x0,0x4 };
+    shimClient.respond(puback2,4);
+    shimClient.respond(puback4,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),0);
+
+    // ids of acknowledged messages are used again after the freed slots
+    byte publish[] = {0x32,0x10,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x6,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.expect(publish,18);
+    rc = client.publish((char*)"topic",(char*)"payload",false,1);
+    IS_TRUE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publish_qos1_retry() {
+    IT("sends a qos 1 message again when the puback is lost (takes 3 seconds)");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    client.setRetryTimeout(2);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish[] = {0x32,0x10,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x2,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.expect(publish,18);
+    rc = client.publish((char*)"topic",(char*)"payload",false,1);
+    IS_TRUE(rc);
+
+    // nothing is sent before the retry timeout
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_FALSE(shimClient.error());
+
+    sleep(3);
+    byte dup[] = {0x3a,0x10,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x2,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.expect(dup,18);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),1);
+
+    byte puback[] = { 0x40,0x02,0x0,0x2 };
+    shimClient.respond(puback,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),0);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publish_qos1_reconnect() {
+    IT("sends qos 1 messages again after a reconnect");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish1[] = {0x32,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x2,'A'};
+    byte publish2[] = {0x32,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x3,'B'};
+    shimClient.expect(publish1,12);
+    shimClient.expect(publish2,12);
+    rc = client.publish((char*)"topic",(char*)"A",false,1);
+    IS_TRUE(rc);
+    rc = client.publish((char*)"topic",(char*)"B",false,1);
+    IS_TRUE(rc);
+
+    shimClient.setConnected(false);
+    rc = client.loop();
+    IS_FALSE(rc);
+    rc = client.publish((char*)"topic",(char*)"C",false,1);
+    IS_FALSE(rc);
+
+    byte connect[] = {0x10,0x18,0x0,0x4,0x4d,0x51,0x54,0x54,0x4,0x2,0x0,0xf,0x0,0xc,0x63,0x6c,0x69,0x65,0x6e,0x74,0x5f,0x74,0x65,0x73,0x74,0x31};
+    byte dup1[] = {0x3a,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x2,'A'};
+    byte dup2[] = {0x3a,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x3,'B'};
+    shimClient.expect(connect,26);
+    shimClient.expect(dup1,12);
+    shimClient.expect(dup2,12);
+    shimClient.respond(connack,4);
+    rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+    IS_EQUAL(client.getInflight(),2);
+
+    // a new message does not reuse the id of a waiting one
+    byte publish3[] = {0x32,0xa,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x4,'C'};
+    shimClient.expect(publish3,12);
+    rc = client.publish((char*)"topic",(char*)"C",false,1);
+    IS_TRUE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publish_qos1_too_long() {
+    IT("qos 1 publish fails when the packet does not fit the inflight buffer");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte payload[MQTT_INFLIGHT_BUFFER];
+    memset(payload,'x',sizeof(payload));
+    rc = client.publish((char*)"topic",payload,sizeof(payload),false,1);
+    IS_FALSE(rc);
+
+    // three thirds do not fit while the first is waiting
+    rc = client.publish((char*)"topic",payload,MQTT_INFLIGHT_BUFFER/3,false,1);
+    IS_TRUE(rc);
+    rc = client.publish((char*)"topic",payload,MQTT_INFLIGHT_BUFFER/3,false,1);
+    IS_TRUE(rc);
+    rc = client.publish((char*)"topic",payload,MQTT_INFLIGHT_BUFFER/3,false,1);
+    IS_FALSE(rc);
+    IS_EQUAL(client.getInflight(),2);
+
+    // the start of the buffer is used again once the first is acknowledged
+    byte puback[] = { 0x40,0x02,0x0,0x2 };
+    shimClient.respond(puback,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    rc = client.publish((char*)"topic",payload,MQTT_INFLIGHT_BUFFER/3,false,1);
+    IS_TRUE(rc);
+
+    rc = client.publish((char*)"topic",(char*)"payload",false,2);
+    IS_FALSE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+
+int main()
+{
+    SUITE("Publish QoS 1");
+    test_publish_qos1();
+    test_publish_qos1_window();
+    test_publish_qos1_reordered();
+    test_publish_qos1_retry();
+    test_publish_qos1_reconnect();
+    test_publish_qos1_too_long();
+
+    FINISH
+}
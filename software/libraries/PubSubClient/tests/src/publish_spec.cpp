@@ -173,7 +173,81 @@ int test_publish_P() {
     END_IT
 }
 
+int test_publishv() {
+    IT("publishes fragments from RAM and PROGMEM");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish[] = {0x30,0xe,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.expect(publish,16);
+
+    static const char flash[] PROGMEM = "pay";
+    MQTTFragment fragments[] = {
+        { (const uint8_t*)flash, 3, true },
+        { (const uint8_t*)"", 0, false },
+        { (const uint8_t*)"load", 4, false }
+    };
+    rc = client.publishv((char*)"topic",fragments,3,false);
+    IS_TRUE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publishv_larger_than_buffer() {
+    IT("publishes fragments larger than the buffer");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    client.setBufferSize(32);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
 
+    byte publish[9+60] = {0x31,0x43,0x0,0x5,0x74,0x6f,0x70,0x69,0x63};
+    for (int i = 0; i < 60; i++) {
+        publish[9+i] = 'a'+i/20;
+    }
+    shimClient.expect(publish,sizeof(publish));
+
+    uint8_t a[20], b[20], c[20];
+    memset(a,'a',20);
+    memset(b,'b',20);
+    memset(c,'c',20);
+    MQTTFragment fragments[] = { { a, 20, false }, { b, 20, true }, { c, 20, false } };
+    rc = client.publishv((char*)"topic",fragments,3,true);
+    IS_TRUE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publishv_not_connected() {
+    IT("publishv fails when not connected");
+    ShimClient shimClient;
+
+    PubSubClient client(server, 1883, callback, shimClient);
+
+    MQTTFragment fragment = { (const uint8_t*)"payload", 7, false };
+    int rc = client.publishv((char*)"topic",&fragment,1,false);
+    IS_FALSE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
 
 
 int main()
@@ -186,6 +260,9 @@ int main()
     test_publish_not_connected();
     test_publish_too_long();
     test_publish_P();
+    test_publishv();
+    test_publishv_larger_than_buffer();
+    test_publishv_not_connected();
 
     FINISH
 }
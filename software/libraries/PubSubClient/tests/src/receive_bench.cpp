@@ -0,0 +1,96 @@
+#include "PubSubClient.h"
+#include "ShimClient.h"
+#include "Buffer.h"
+#include "Stream.h"
+#include "trace.h"
+#include <chrono>
+#include <stdio.h>
+
+// Receive throughput: publish packets are fed through ShimClient and read by PubSubClient::loop()
+//   bin/receive_bench [messages] [payload bytes]
+
+byte server[] = { 172, 16, 0, 2 };
+
+// Counts the calls PubSubClient makes into the network client
+class CountingClient : public ShimClient {
+public:
+    unsigned long availableCalls = 0;
+    unsigned long readCalls = 0;
+    bool bulk = false;
+    virtual int available() { availableCalls++; return ShimClient::available(); }
+    virtual int read() { if (!bulk) readCalls++; return ShimClient::read(); }
+    virtual int read(uint8_t *buf, size_t size) {
+        // ShimClient reads a chunk byte by byte, count it once
+        readCalls++;
+        bulk = true;
+        int rc = ShimClient::read(buf,size);
+        bulk = false;
+        return rc;
+    }
+};
+
+unsigned long received = 0;
+
+void callback(char* topic, byte* payload, unsigned int length) {
+    received += length;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long messages = (argc > 1) ? strtoul(argv[1],NULL,10) : 100000;
+    unsigned int plength = (argc > 2) ? strtoul(argv[2],NULL,10) : 1024;
+    if (plength > 1800) {
+        plength = 1800; // ShimClient buffers 2048 bytes
+    }
+
+    CountingClient shimClient;
+    shimClient.setAllowConnect(true);
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    client.setBufferSize(plength+64);
+    if (!client.connect((char*)"client_test1")) {
+        LOG("connect failed\n");
+        return 1;
+    }
+
+    // PUBLISH qos 0, topic "topic"
+    uint8_t packet[2048];
+    uint32_t len = 2+5+plength;
+    uint16_t pos = 0;
+    packet[pos++] = 0x30;
+    do {
+        uint8_t digit = len & 127;
+        len >>= 7;
+        if (len > 0) {
+            digit |= 0x80;
+        }
+        packet[pos++] = digit;
+    } while (len > 0);
+    packet[pos++] = 0;
+    packet[pos++] = 5;
+    memcpy(packet+pos,"topic",5);
+    pos += 5;
+    memset(packet+pos,'x',plength);
+    pos += plength;
+
+    shimClient.availableCalls = 0;
+    shimClient.readCalls = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < messages; i++) {
+        shimClient.respond(packet,pos);
+        client.loop();
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    if (received != (unsigned long long)messages*plength) {
+        LOG("received " << received << " bytes, expected " << messages*plength << "\n");
+        return 1;
+    }
+    printf("%lu messages of %u bytes in %.3f s\n", messages, plength, s);
+    printf("  %.1f MB/s, %.2f us/message\n", (double)messages*pos/s/1e6, s*1e6/messages);
+    printf("  %.1f available() and %.1f read() calls/message\n",
+           (double)shimClient.availableCalls/messages, (double)shimClient.readCalls/messages);
+    return 0;
+}
@@ -324,6 +324,41 @@ int test_receive_qos1() {
     END_IT
 }
 
+// Reports data but fails to read it, as a network client after an error
+class FailingReadClient : public ShimClient {
+public:
+  bool failing = false;
+  virtual int read(uint8_t *buf, size_t size) { return failing ? -1 : ShimClient::read(buf,size); }
+};
+
+int test_receive_read_failure() {
+    IT("gives up a packet when reading its body fails (takes 1 second)");
+    reset_callback();
+
+    FailingReadClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    client.setSocketTimeout(1);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish[] = {0x30,0xe,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.respond(publish,16);
+    shimClient.failing = true;
+
+    unsigned long start = millis();
+    rc = client.loop();
+    IS_TRUE(millis() - start >= 1000);
+    IS_TRUE(millis() - start < 2000);
+    IS_FALSE(callback_called);
+
+    END_IT
+}
+
 int main()
 {
     SUITE("Receive");
@@ -335,6 +370,7 @@ int main()
     test_resize_buffer();
     test_receive_oversized_stream_message();
     test_receive_qos1();
+    test_receive_read_failure();
 
     FINISH
 }
@@ -0,0 +1,76 @@
+/******************************************************************************************************/
+// Sensirion I2C word protocol
+/******************************************************************************************************/
+// Sensirion sensors exchange 16 bit big endian words, each followed by a CRC-8 
+// (polynomial 0x31, init 0xFF, no reflection). 32 bit values and floats span two words.
+// Words are decoded while they are read from the Wire receive buffer, the CRC of each word is checked in the same pass.
+// The CRC table is kept once in flash for all drivers.
+#ifndef SENSIRION_PROTOCOL_H_
+#define SENSIRION_PROTOCOL_H_
+
+#include <Arduino.h>
+#include <string.h>
+
+#define SENSIRION_CRC8_INIT        0xFF
+#define SENSIRION_WORD_SIZE           3                    // MSB, LSB, CRC
+
+extern const uint8_t sensirionCRC8Table[256] PROGMEM;
+
+inline uint8_t sensirionCRC8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = SENSIRION_CRC8_INIT;
+  for (uint8_t i = 0; i < len; i++) { crc = pgm_read_byte(&sensirionCRC8Table[crc ^ data[i]]); }
+  return crc;
+}
+
+inline uint8_t sensirionCRC8(uint16_t word) {
+  uint8_t crc = pgm_read_byte(&sensirionCRC8Table[SENSIRION_CRC8_INIT ^ (uint8_t)(word >> 8)]);
+  return pgm_read_byte(&sensirionCRC8Table[crc ^ (uint8_t)(word & 0xFF)]);
+}
+
+// Port is TwoWire or a compatible i2c class
+// Write word and its CRC, used for command arguments
+template <class Port>
+inline void sensirionWriteWord(Port &port, uint16_t word) {
+  port.write((uint8_t)(word >> 8));
+  port.write((uint8_t)(word & 0xFF));
+  port.write(sensirionCRC8(word));
+}
+
+// Decode words from the receive buffer after requestFrom, false if a CRC does not match
+template <class Port>
+inline bool sensirionReadWords(Port &port, uint16_t *words, uint8_t count) {
+  bool valid = true;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t msb = port.read();
+    uint8_t lsb = port.read();
+    uint8_t crc = pgm_read_byte(&sensirionCRC8Table[SENSIRION_CRC8_INIT ^ msb]);
+    crc = pgm_read_byte(&sensirionCRC8Table[crc ^ lsb]);
+    if (crc != (uint8_t)port.read()) { valid = false; }   // keep reading so the buffer is drained
+    words[i] = ((uint16_t)msb << 8) | lsb;
+  }
+  return valid;
+}
+
+// Big endian values spanning two words
+inline uint32_t sensirionUint32(const uint16_t *words) { return ((uint32_t)words[0] << 16) | words[1]; }
+
+inline float sensirionFloat(const uint16_t *words) {
+  uint32_t value = sensirionUint32(words);
+  float result;
+  memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+// Decode floats from the receive buffer, two words each, false if a CRC does not match
+template <class Port>
+inline bool sensirionReadFloats(Port &port, float *values, uint8_t count) {
+  bool valid = true;
+  uint16_t words[2];
+  for (uint8_t i = 0; i < count; i++) {
+    if (!sensirionReadWords(port, words, 2)) { valid = false; }
+    values[i] = sensirionFloat(words);
+  }
+  return valid;
+}
+
+#endif
@@ -313,7 +313,7 @@ int16_t IRTherm::calcRawTemp(float calcTemp)
 	}
 	else
 	{
-		float tempFloat;
+		float tempFloat = calcTemp; // Kelvin unless converted below
 		// First convert each temperature to Kelvin:
 		if (_defaultUnit == TEMP_F)
 		{
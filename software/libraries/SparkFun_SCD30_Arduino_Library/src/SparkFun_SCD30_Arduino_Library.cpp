@@ -291,13 +291,6 @@ bool SCD30::readMeasurement()
   if (dataAvailable() == false)
     return (false);
 
-  ByteToFl tempCO2;
-  tempCO2.value = 0;
-  ByteToFl tempHumidity;
-  tempHumidity.value = 0;
-  ByteToFl tempTemperature;
-  tempTemperature.value = 0;
-
   _i2cPort->beginTransmission(SCD30_ADDRESS);
   _i2cPort->write(COMMAND_READ_MEASUREMENT >> 8);   // MSB
   _i2cPort->write(COMMAND_READ_MEASUREMENT & 0xFF); // LSB
@@ -306,59 +299,10 @@ bool SCD30::readMeasurement()
 
   delayMicroseconds(3000);
 
+  // CO2, temperature and humidity, each float in two words with CRC
+  float values[3];
   const uint8_t receivedBytes = _i2cPort->requestFrom((uint8_t)SCD30_ADDRESS, (uint8_t)18);
-  bool error = false;
-  if (_i2cPort->available())
-  {
-    uint8_t bytesToCrc[2];
-    for (uint8_t x = 0; x < 18; x++)
-    {
-      uint8_t incoming = _i2cPort->read();
-
-      switch (x)
-      {
-      case 0:
-      case 1:
-      case 3:
-      case 4:
-        tempCO2.array[x < 3 ? 3 - x : 4 - x] = incoming;
-        bytesToCrc[x % 3] = incoming;
-        break;
-      case 6:
-      case 7:
-      case 9:
-      case 10:
-        tempTemperature.array[x < 9 ? 9 - x : 10 - x] = incoming;
-        bytesToCrc[x % 3] = incoming;
-        break;
-      case 12:
-      case 13:
-      case 15:
-      case 16:
-        tempHumidity.array[x < 15 ? 15 - x : 16 - x] = incoming;
-        bytesToCrc[x % 3] = incoming;
-        break;
-      default:
-        // Validate CRC
-        uint8_t foundCrc = computeCRC8(bytesToCrc, 2);
-        if (foundCrc != incoming)
-        {
-          if (_printDebug == true)
-          {
-            _debugPort->print(F("readMeasurement: found CRC in byte "));
-            _debugPort->print(x);
-            _debugPort->print(F(", expected 0x"));
-            _debugPort->print(foundCrc, HEX);
-            _debugPort->print(F(", got 0x"));
-            _debugPort->println(incoming, HEX);
-          }
-          error = true;
-        }
-        break;
-      }
-    }
-  }
-  else
+  if (receivedBytes != 18)
   {
     if (_printDebug == true)
     {
@@ -369,16 +313,15 @@ bool SCD30::readMeasurement()
     return false;
   }
 
-  if (error)
+  if (sensirionReadFloats(*_i2cPort, values, 3) == false)
   {
     if (_printDebug == true)
-      _debugPort->println(F("readMeasurement: encountered error reading SCD30 data."));
+      _debugPort->println(F("readMeasurement: encountered CRC error reading SCD30 data."));
     return false;
   }
-  // Now copy the uint32s into their associated floats
-  co2 = tempCO2.value;
-  temperature = tempTemperature.value;
-  humidity = tempHumidity.value;
+  co2 = values[0];
+  temperature = values[1];
+  humidity = values[2];
 
   // Mark our global variables as fresh
   co2HasBeenReported = false;
@@ -400,24 +343,12 @@ bool SCD30::getSettingValue(uint16_t registerAddress, uint16_t *val)
 
   delayMicroseconds(3000);
 
-  _i2cPort->requestFrom((uint8_t)SCD30_ADDRESS, (uint8_t)3); // Request data and CRC
-  if (_i2cPort->available())
+  if (_i2cPort->requestFrom((uint8_t)SCD30_ADDRESS, (uint8_t)3) == 3) // Request data and CRC
   {
-    uint8_t data[2];
-    data[0] = _i2cPort->read();
-    data[1] = _i2cPort->read();
-    uint8_t crc = _i2cPort->read();
-    *val = (uint16_t)data[0] << 8 | data[1];
-    uint8_t expectedCRC = computeCRC8(data, 2);
-    if (crc == expectedCRC) // Return true if CRC check is OK
+    if (sensirionReadWords(*_i2cPort, val, 1)) // Return true if CRC check is OK
       return (true);
     if (_printDebug == true)
-    {
-      _debugPort->print(F("getSettingValue: CRC fail: expected 0x"));
-      _debugPort->print(expectedCRC, HEX);
-      _debugPort->print(F(", got 0x"));
-      _debugPort->println(crc, HEX);
-    }
+      _debugPort->println(F("getSettingValue: CRC fail"));
   }
   return (false);
 }
@@ -446,17 +377,10 @@ uint16_t SCD30::readRegister(uint16_t registerAddress)
 // Sends a command along with arguments and CRC
 bool SCD30::sendCommand(uint16_t command, uint16_t arguments)
 {
-  uint8_t data[2];
-  data[0] = arguments >> 8;
-  data[1] = arguments & 0xFF;
-  uint8_t crc = computeCRC8(data, 2); // Calc CRC on the arguments only, not the command
-
   _i2cPort->beginTransmission(SCD30_ADDRESS);
   _i2cPort->write(command >> 8);     // MSB
   _i2cPort->write(command & 0xFF);   // LSB
-  _i2cPort->write(arguments >> 8);   // MSB
-  _i2cPort->write(arguments & 0xFF); // LSB
-  _i2cPort->write(crc);
+  sensirionWriteWord(*_i2cPort, arguments); // CRC on the arguments only, not the command
   if (_i2cPort->endTransmission() != 0)
     return (false); // Sensor did not ACK
 
@@ -477,25 +401,8 @@ bool SCD30::sendCommand(uint16_t command)
 
 // Given an array and a number of bytes, this calculate CRC8 for those bytes
 // CRC is only calc'd on the data portion (two bytes) of the four bytes being sent
-// From: http://www.sunshine2k.de/articles/coding/crc/understanding_crc.html
-// Tested with: http://www.sunshine2k.de/coding/javascript/crc/crc_js.html
-// x^8+x^5+x^4+1 = 0x31
+// x^8+x^5+x^4+1 = 0x31, shared lookup table of the Sensirion protocol
 uint8_t SCD30::computeCRC8(uint8_t data[], uint8_t len)
 {
-  uint8_t crc = 0xFF; // Init with 0xFF
-
-  for (uint8_t x = 0; x < len; x++)
-  {
-    crc ^= data[x]; // XOR-in the next input byte
-
-    for (uint8_t i = 0; i < 8; i++)
-    {
-      if ((crc & 0x80) != 0)
-        crc = (uint8_t)((crc << 1) ^ 0x31);
-      else
-        crc <<= 1;
-    }
-  }
-
-  return crc; // No output reflection
+  return sensirionCRC8(data, len);
 }
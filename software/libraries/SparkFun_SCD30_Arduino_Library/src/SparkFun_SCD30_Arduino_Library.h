@@ -39,6 +39,7 @@
 #else
 #include <Wire.h>
 #endif
+#include <SensirionProtocol.h>
 
 // The default I2C address for the SCD30 is 0x61.
 #define SCD30_ADDRESS 0x61
@@ -98,18 +98,11 @@ SGP30ERR SGP30::getAirQuality(void)
   toRead = _i2cPort->requestFrom(_SGP30Address, (uint8_t)6);
   if (toRead != 6)
     return SGP30_ERR_I2C_TIMEOUT;              //Error out
-  uint16_t _CO2 = _i2cPort->read() << 8; //store MSB in CO2
-  _CO2 |= _i2cPort->read();              //store LSB in CO2
-  uint8_t checkSum = _i2cPort->read();   //verify checksum
-  if (checkSum != _CRC8(_CO2))
+  uint16_t words[2];                           //CO2, TVOC
+  if (!sensirionReadWords(*_i2cPort, words, 2))
     return SGP30_ERR_BAD_CRC;                   //checksum failed
-  uint16_t _TVOC = _i2cPort->read() << 8; //store MSB in TVOC
-  _TVOC |= _i2cPort->read();              //store LSB in TVOC
-  checkSum = _i2cPort->read();            //verify checksum
-  if (checkSum != _CRC8(_TVOC))
-    return SGP30_ERR_BAD_CRC; //checksum failed
-  CO2 = _CO2;           //publish valid data
-  TVOC = _TVOC;         //publish valid data
+  CO2 = words[0];       //publish valid data
+  TVOC = words[1];      //publish valid data
   return SGP30_SUCCESS;
 }
 
@@ -308,48 +301,9 @@ SGP30ERR SGP30::measureTest(void)
   return SGP30_SUCCESS;
 }
 
-#ifndef SGP30_LOOKUP_TABLE
-//Given an array and a number of bytes, this calculate CRC8 for those bytes
-//CRC is only calc'd on the data portion (two bytes) of the four bytes being sent
-//From: http://www.sunshine2k.de/articles/coding/crc/understanding_crc.html
-//Tested with: http://www.sunshine2k.de/coding/javascript/crc/crc_js.html
+//Generates CRC8 for SGP30 from the lookup table shared by the Sensirion drivers
 //x^8+x^5+x^4+1 = 0x31
 uint8_t SGP30::_CRC8(uint16_t data)
 {
-  uint8_t crc = 0xFF; //Init with 0xFF
-
-  crc ^= (data >> 8); // XOR-in the first input byte
-
-  for (uint8_t i = 0; i < 8; i++)
-  {
-    if ((crc & 0x80) != 0)
-      crc = (uint8_t)((crc << 1) ^ 0x31);
-    else
-      crc <<= 1;
-  }
-  crc ^= (uint8_t)data; // XOR-in the last input byte
-
-  for (uint8_t i = 0; i < 8; i++)
-  {
-    if ((crc & 0x80) != 0)
-      crc = (uint8_t)((crc << 1) ^ 0x31);
-    else
-      crc <<= 1;
-  }
-
-  return crc; //No output reflection
-}
-#endif
-
-#ifdef SGP30_LOOKUP_TABLE
-//Generates CRC8 for SGP30 from lookup table
-uint8_t SGP30::_CRC8(uint16_t data)
-{
-  uint8_t CRC = 0xFF;                          //inital value
-  CRC ^= (uint8_t)(data >> 8);                 //start with MSB
-  CRC = _CRC8LookupTable[CRC >> 4][CRC & 0xF]; //look up table [MSnibble][LSnibble]
-  CRC ^= (uint8_t)data;                        //use LSB
-  CRC = _CRC8LookupTable[CRC >> 4][CRC & 0xF]; //look up table [MSnibble][LSnibble]
-  return CRC;
+  return sensirionCRC8(data);
 }
-#endif